@@ -20,6 +20,8 @@
 #include "VS/Graphics/VS_Screen.h"
 #include "VS/Graphics/VS_Sprite.h"
 #include "VS/Graphics/VS_DynamicBatchManager.h"
+#include "VS/Graphics/VS_TextureStreamer.h"
+#include "VS/Memory/VS_FrameArena.h"
 #include "VS/Utils/VS_System.h"
 
 //REGISTER_GAME("Empty", coreGame)
@@ -213,6 +215,8 @@ coreGame::Go()
 
 	DrawFrame();
 	vsDynamicBatchManager::Instance()->FrameRendered();
+	vsFrameArena::Instance()->FrameRendered();
+	vsTextureStreamer::Instance()->FrameRendered();
 }
 
 void
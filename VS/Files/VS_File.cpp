@@ -53,6 +53,40 @@ namespace
 	{
 		return ++s_tempFileCount;
 	}
+
+	std::atomic<uint64_t> s_compressedReadFiles;
+	std::atomic<uint64_t> s_compressedReadLegacyFiles;
+	std::atomic<uint64_t> s_compressedReadBytesIn;
+	std::atomic<uint64_t> s_compressedReadBytesOut;
+	std::atomic<uint64_t> s_compressedReadMicroseconds;
+
+	// MODE_WriteCompressed files end with a little trailer after the zlib
+	// stream, recording how large the data will be once it's inflated.  That
+	// lets us allocate our buffer once and inflate straight into it.  zlib
+	// stops reading at the end of its stream, so older builds which don't
+	// know about the trailer can still read these files.
+	const uint32_t c_compressedTrailerMagic = 0x76735a31; // 'vsZ1'
+	const size_t c_compressedTrailerSize = 12; // magic, then size as two uint32s (high, low)
+
+	bool ReadCompressedTrailer( vsStore *compressedData, uint64_t *uncompressedSize )
+	{
+		if ( compressedData->BytesLeftForReading() < c_compressedTrailerSize )
+			return false;
+
+		char *trailerStart = compressedData->GetWriteHead() - c_compressedTrailerSize;
+		vsStore trailer( trailerStart, c_compressedTrailerSize );
+		if ( trailer.ReadUint32() != c_compressedTrailerMagic )
+			return false;
+		uint64_t high = trailer.ReadUint32();
+		uint64_t low = trailer.ReadUint32();
+		*uncompressedSize = (high << 32) | low;
+		return true;
+	}
+
+	uint64_t ProfileMicroseconds()
+	{
+		return (SDL_GetPerformanceCounter() * 1000000) / SDL_GetPerformanceFrequency();
+	}
 }
 
 // #define PROFILE_FILE_SYSTEM
@@ -136,7 +170,9 @@ vsFile::vsFile( const vsString &filename_in, vsFile::Mode mode ):
 	m_zipData(nullptr),
 	m_mode(mode),
 	m_length(0),
-	m_moveOnDestruction(false)
+	m_moveOnDestruction(false),
+	m_writeFailed(false),
+	m_uncompressedBytesWritten(0)
 {
 	vsString filename(filename_in);
 
@@ -150,14 +186,13 @@ vsFile::vsFile( const vsString &filename_in, vsFile::Mode mode ):
 
 	// vsAssert( !DirectoryExists(filename), vsFormatString("Attempted to open directory '%s' as a plain file", filename.c_str()) );
 
-	if ( (mode == MODE_Read || mode == MODE_ReadCompressed) &&
-			vsFileCache::IsFileInCache( filename ) )
+	if ( mode == MODE_Read || mode == MODE_ReadCompressed )
+		m_cachedFile = vsFileCache::GetFile( filename );
+
+	if ( m_cachedFile.IsValid() )
 	{
 		PROFILE_CACHED(filename);
-		vsStore *c = vsFileCache::GetFileContents( filename );
-		m_store = new vsStore(*c);
-		m_mode = MODE_Read;
-		m_length = m_store->BufferLength();
+		_ReadFromCachedFile();
 	}
 	else
 	{
@@ -224,6 +259,11 @@ vsFile::vsFile( const vsString &filename_in, vsFile::Mode mode ):
 			if ( vsFile::Exists(errorFilename) )
 				errorFilename = GetFullFilename(filename);
 
+			if ( mode != MODE_Read && mode != MODE_ReadCompressed && mode != MODE_ReadCompressed_Progressive )
+			{
+				m_writeFailed = true;
+				m_moveOnDestruction = false;
+			}
 			if ( s_openFailureHandler )
 				(*s_openFailureHandler)( errorFilename, errorMsg );
 			vsAssert( m_file != nullptr, STR("Error opening file '%s' (trying '%s'):  %s", filename, errorFilename, errorMsg) );
@@ -246,94 +286,36 @@ vsFile::vsFile( const vsString &filename_in, vsFile::Mode mode ):
 			m_file = nullptr;
 
 			if ( shouldCache )
-				vsFileCache::SetFileContents( filename, *m_store );
+			{
+				m_cachedFile = vsFileCache::SetFileContents( filename, m_store );
+				_ReadFromCachedFile();
+			}
 		}
 		else if ( mode == MODE_ReadCompressed )
 		{
-			// in COMPRESSED read mode, we can't do the clever thing we did above
-			// where we just made a single store and loaded the whole file into it
-			// all at once, because we don't know how big the file is going to wind
-			// up being.
-			//
-			// So here's what we're going to do;  we're going to load all the data
-			// into a store (as above), decompress it once just to figure out how
-			// big it's going to be, then decompress it AGAIN, into a store that's
-			// the right size to hold it.
+			// in COMPRESSED read mode, we load all the compressed data into a
+			// store (as above) and then inflate it into a second store.  If the
+			// file carries a size trailer, that second store is exactly the
+			// right size from the start;  otherwise it grows as we go.
 
 			vsStore *compressedData = new vsStore( m_length );
 			Store(compressedData);
 			PHYSFS_close(m_file);
 			m_file = nullptr;
 
-			// we're going to read the compressed data TWICE.
-			// First, we're just going to count how many bytes we inflate into.
-			m_zipData = new zipdata;
-			m_zipData->m_zipStream.zalloc = Z_NULL;
-			m_zipData->m_zipStream.zfree = Z_NULL;
-			m_zipData->m_zipStream.opaque = Z_NULL;
-			int ret = inflateInit(&m_zipData->m_zipStream);
-			if ( ret != Z_OK )
-			{
-				vsAssert( ret == Z_OK, vsFormatString("inflateInit error: %d", ret) );
-				return;
-			}
-
-			uint32_t decompressedSize = 0;
-			const uint32_t zipBufferSize = 1024 * 100;
-			char zipBuffer[zipBufferSize];
-			m_zipData->m_zipStream.avail_in = (uInt)compressedData->BytesLeftForReading();
-			m_zipData->m_zipStream.next_in = (Bytef*)compressedData->GetReadHead();
-			do
-			{
-				m_zipData->m_zipStream.avail_out = zipBufferSize;
-				m_zipData->m_zipStream.next_out = (Bytef*)zipBuffer;
-				int ret = inflate(&m_zipData->m_zipStream, Z_NO_FLUSH);
-				vsAssert(ret != Z_STREAM_ERROR, "Zip State not clobbered in destructor");
-				vsAssertF(ret != Z_DATA_ERROR, "File '%s' is corrupt on disk (zlib reports Z_DATA_ERROR)", filename);
-				vsAssertF(ret != Z_MEM_ERROR, "Out of memory loading file '%s' (zlib reports Z_MEM_ERROR)", filename);
-				// [NOTE] Z_BUF_ERROR is not fatal, according to https://www.zlib.net/manual.html
-				// vsAssert(ret != Z_BUF_ERROR, "File is corrupt on disk (zlib reports Z_BUF_ERROR)");
-				vsAssertF(ret != Z_VERSION_ERROR, "File '%s' is incompatible (zlib reports Z_VERSION_ERROR)", filename);
-
-				uint32_t decompressedBytes = zipBufferSize - m_zipData->m_zipStream.avail_out;
-				decompressedSize += decompressedBytes;
-
-			}while( m_zipData->m_zipStream.avail_out == 0 );
-			inflateEnd(&m_zipData->m_zipStream);
-
-			m_store = new vsStore( decompressedSize );
-
-			// Now let's decompress it FOR REAL.
-			ret = inflateInit(&m_zipData->m_zipStream);
-			if ( ret != Z_OK )
-			{
-				vsAssertF( ret == Z_OK, "File '%s': inflateInit error: %d", filename, ret );
-				return;
-			}
-
-			m_zipData->m_zipStream.avail_in = (uInt)compressedData->BytesLeftForReading();
-			m_zipData->m_zipStream.next_in = (Bytef*)compressedData->GetReadHead();
-			do
-			{
-				m_zipData->m_zipStream.avail_out = zipBufferSize;
-				m_zipData->m_zipStream.next_out = (Bytef*)zipBuffer;
-				int ret = inflate(&m_zipData->m_zipStream, Z_NO_FLUSH);
-				vsAssert(ret != Z_STREAM_ERROR, "Zip State not clobbered in destructor");
-
-				int decompressedBytes = zipBufferSize - m_zipData->m_zipStream.avail_out;
-				m_store->WriteBuffer( zipBuffer, decompressedBytes );
-
-			}while( m_zipData->m_zipStream.avail_out == 0 );
-			inflateEnd(&m_zipData->m_zipStream);
+			_InflateCompressedStore( compressedData );
+			vsDelete( compressedData );
 
 			// and now that we've decompressed all the data, we can drop into
 			// regular 'Read' mode to serve the data to our clients.
 			m_mode = MODE_Read;
-			m_length = decompressedSize;
-			vsDelete( compressedData );
+			m_length = m_store->Length();
 
 			if ( shouldCache )
-				vsFileCache::SetFileContents( filename, *m_store );
+			{
+				m_cachedFile = vsFileCache::SetFileContents( filename, m_store );
+				_ReadFromCachedFile();
+			}
 		}
 		else if ( mode == MODE_ReadCompressed_Progressive )
 		{
@@ -376,12 +358,23 @@ vsFile::vsFile( const vsString &filename_in, vsFile::Mode mode ):
 	}
 }
 
+void
+vsFile::_ReadFromCachedFile()
+{
+	// the cache owns the data;  we just read out of it in place, rather than
+	// making our own copy.
+	m_store = new vsStore( const_cast<char*>(m_cachedFile.GetData()), (int)m_cachedFile.GetLength() );
+	m_mode = MODE_Read;
+	m_length = m_cachedFile.GetLength();
+}
+
 vsFile::~vsFile()
 {
 	if ( m_mode == MODE_WriteCompressed )
 	{
 		_PumpCompression( nullptr, 0, true );
 		deflateEnd(&m_zipData->m_zipStream);
+		_WriteCompressedTrailer();
 	}
 	else if ( m_mode == MODE_ReadCompressed_Progressive )
 	{
@@ -418,6 +411,12 @@ vsFile::FlushBufferedWrites()
 void
 vsFile::_DoWriteLiteralBytes( const void* bytes, size_t byteCount )
 {
+	if ( !m_file )
+	{
+		m_writeFailed = true;
+		return;
+	}
+
 	PHYSFS_uint64 bytesToWrite = byteCount;
 	PHYSFS_sint64 bytesWritten = PHYSFS_writeBytes( m_file, bytes, bytesToWrite );
 	if ( bytesWritten != (PHYSFS_sint64)bytesToWrite )
@@ -430,6 +429,9 @@ vsFile::_DoWriteLiteralBytes( const void* bytes, size_t byteCount )
 		// bool successfullyDeleted = false;
 
 		PHYSFS_close(m_file);
+		m_file = nullptr;
+		m_writeFailed = true;
+		m_moveOnDestruction = false;
 		if ( vsFile::Exists(m_tempFilename) )
 			vsFile::Delete( m_tempFilename );
 		if ( vsFile::Exists(m_filename) )
@@ -867,41 +869,12 @@ vsFile::Record_Binary( vsRecord *r )
 bool
 vsFile::ReadLine( vsString *line )
 {
-	// const int c_bufSize = 1024;
-	// char buf[c_bufSize];
-
-	size_t filePos = m_store->GetReadHeadPosition();
-	char peekChar = 'a';
-
-	while ( !AtEnd() && peekChar != '\n' && peekChar != 0 )
+	const char *start;
+	size_t length;
+	if ( ReadLineSpan( &start, &length ) )
 	{
-		peekChar = m_store->ReadInt8();
-	}
-	size_t afterFilePos = m_store->GetReadHeadPosition();
-	size_t bytes = afterFilePos - filePos;
-	m_store->SeekReadHeadTo(filePos);
-	if ( bytes > 0 )
-	{
-		char* buffer = (char*)malloc(bytes+1);
-		m_store->ReadBuffer(buffer, bytes);
-
-		// if we read a newline, let's just ignore it.
-		if ( peekChar == '\n' )
-		{
-			bytes--;
-		}
-
-		buffer[bytes] = 0;
-
-		*line = buffer;
-		size_t i;
-		while ( (i = line->find('\r')) != vsString::npos)
-		{
-			line->erase(i,1);
-		}
-
-		free(buffer);
-
+		line->assign( start, length );
+		line->erase( std::remove( line->begin(), line->end(), '\r' ), line->end() );
 		return true;
 	}
 	return false;
@@ -914,10 +887,36 @@ vsFile::PeekLine( vsString *line )
 	bool result = ReadLine(line);
 	m_store->SeekReadHeadTo(filePos);
 	return result;
-	// PHYSFS_sint64 filePos = PHYSFS_tell(m_file);
-	// bool result = ReadLine(line);
-	// PHYSFS_seek(m_file, filePos);
-	// return result;
+}
+
+bool
+vsFile::ReadLineSpan( const char **line, size_t *length )
+{
+	size_t bytesLeft = m_store->BytesLeftForReading();
+	if ( bytesLeft == 0 )
+		return false;
+
+	// a line ends at a newline or a NUL, either of which we consume but
+	// don't include in the line.
+	const char *start = m_store->GetReadHead();
+	const char *end = start;
+	const char *bufferEnd = start + bytesLeft;
+	while ( end < bufferEnd && *end != '\n' && *end != 0 )
+		end++;
+
+	*line = start;
+	*length = end - start;
+	m_store->AdvanceReadHead( (end < bufferEnd) ? *length + 1 : *length );
+	return true;
+}
+
+bool
+vsFile::PeekLineSpan( const char **line, size_t *length )
+{
+	size_t filePos = m_store->GetReadHeadPosition();
+	bool result = ReadLineSpan(line, length);
+	m_store->SeekReadHeadTo(filePos);
+	return result;
 }
 
 void
@@ -1127,6 +1126,7 @@ vsFile::_PumpCompression( const void* bytes, size_t byteCount, bool finish )
 
 	const int zipBufferSize = 1024 * 100;
 	char zipBuffer[zipBufferSize];
+	m_uncompressedBytesWritten += byteCount;
 	m_zipData->m_zipStream.avail_in = byteCount;
 	m_zipData->m_zipStream.next_in = (Bytef*)bytes;
 	do
@@ -1144,6 +1144,121 @@ vsFile::_PumpCompression( const void* bytes, size_t byteCount, bool finish )
 	vsAssert( m_zipData->m_zipStream.avail_in == 0, "Didn't compress all the available input data?" );
 }
 
+void
+vsFile::_WriteCompressedTrailer()
+{
+	char trailerBuffer[c_compressedTrailerSize];
+	vsStore trailer( trailerBuffer, c_compressedTrailerSize );
+	trailer.Clear();
+	trailer.WriteUint32( c_compressedTrailerMagic );
+	trailer.WriteUint32( (uint32_t)(m_uncompressedBytesWritten >> 32) );
+	trailer.WriteUint32( (uint32_t)(m_uncompressedBytesWritten & 0xffffffff) );
+	_WriteFinalBytes_Buffered( trailer.GetReadHead(), trailer.BytesLeftForReading() );
+}
+
+void
+vsFile::_InflateCompressedStore( vsStore *compressedData )
+{
+	uint64_t startTime = ProfileMicroseconds();
+	size_t compressedBytes = compressedData->BytesLeftForReading();
+
+	uint64_t expectedSize = 0;
+	bool hasTrailer = ReadCompressedTrailer( compressedData, &expectedSize );
+
+	// deflate can't do better than about 1032:1, so anything claiming more
+	// than that is a legacy file whose last bytes just happened to look like
+	// our trailer.
+	if ( hasTrailer && expectedSize > (uint64_t)compressedBytes * 1032 )
+		hasTrailer = false;
+
+	// Without a trailer, we have to guess.  Start at 4x the compressed size
+	// and double whenever we run out.
+	size_t bufferSize = hasTrailer ? (size_t)expectedSize : vsMax( compressedBytes * 4, (size_t)1024 );
+	m_store = new vsStore( bufferSize );
+
+	m_zipData = new zipdata;
+	m_zipData->m_zipStream.zalloc = Z_NULL;
+	m_zipData->m_zipStream.zfree = Z_NULL;
+	m_zipData->m_zipStream.opaque = Z_NULL;
+	m_zipData->m_zipStream.avail_in = (uInt)compressedBytes;
+	m_zipData->m_zipStream.next_in = (Bytef*)compressedData->GetReadHead();
+	int ret = inflateInit(&m_zipData->m_zipStream);
+	if ( ret != Z_OK )
+	{
+		vsAssertF( ret == Z_OK, "File '%s': inflateInit error: %d", m_filename, ret );
+		return;
+	}
+
+	do
+	{
+		if ( m_store->BytesLeftForWriting() == 0 )
+		{
+			// out of room;  either this is a legacy file, or the trailer lied
+			// to us.  Move into a bigger buffer and keep going.
+			vsStore *bigger = new vsStore( vsMax( m_store->BufferLength() * 2, (size_t)1024 ) );
+			bigger->Append( m_store );
+			vsDelete( m_store );
+			m_store = bigger;
+		}
+
+		size_t bytesLeftForWriting = m_store->BytesLeftForWriting();
+		m_zipData->m_zipStream.avail_out = (uInt)bytesLeftForWriting;
+		m_zipData->m_zipStream.next_out = (Bytef*)m_store->GetWriteHead();
+		ret = inflate(&m_zipData->m_zipStream, Z_NO_FLUSH);
+		vsAssert(ret != Z_STREAM_ERROR, "Zip State not clobbered in destructor");
+		vsAssertF(ret != Z_DATA_ERROR, "File '%s' is corrupt on disk (zlib reports Z_DATA_ERROR)", m_filename);
+		vsAssertF(ret != Z_MEM_ERROR, "Out of memory loading file '%s' (zlib reports Z_MEM_ERROR)", m_filename);
+		vsAssertF(ret != Z_VERSION_ERROR, "File '%s' is incompatible (zlib reports Z_VERSION_ERROR)", m_filename);
+
+		m_store->AdvanceWriteHead( bytesLeftForWriting - m_zipData->m_zipStream.avail_out );
+
+		// [NOTE] Z_BUF_ERROR is not fatal, according to https://www.zlib.net/manual.html
+		// but if it happens while we still have output space, there's no more
+		// input to give it, and we're done.
+	}while( ret == Z_OK || (ret == Z_BUF_ERROR && m_store->BytesLeftForWriting() == 0) );
+	inflateEnd(&m_zipData->m_zipStream);
+	vsDelete( m_zipData );
+
+	if ( m_store->BytesLeftForWriting() > 0 )
+	{
+		// The rest of the engine (and the file cache) expects our store's
+		// buffer to be exactly the size of the file, so trim it down.
+		vsStore *exact = new vsStore( m_store->Length() );
+		exact->Append( m_store );
+		vsDelete( m_store );
+		m_store = exact;
+	}
+
+	s_compressedReadFiles++;
+	if ( !hasTrailer )
+		s_compressedReadLegacyFiles++;
+	s_compressedReadBytesIn += compressedBytes;
+	s_compressedReadBytesOut += m_store->Length();
+	s_compressedReadMicroseconds += ProfileMicroseconds() - startTime;
+}
+
+vsFile::CompressedReadStats
+vsFile::GetCompressedReadStats()
+{
+	CompressedReadStats stats;
+	stats.files = s_compressedReadFiles;
+	stats.legacyFiles = s_compressedReadLegacyFiles;
+	stats.compressedBytes = s_compressedReadBytesIn;
+	stats.decompressedBytes = s_compressedReadBytesOut;
+	stats.microseconds = s_compressedReadMicroseconds;
+	return stats;
+}
+
+void
+vsFile::ResetCompressedReadStats()
+{
+	s_compressedReadFiles = 0;
+	s_compressedReadLegacyFiles = 0;
+	s_compressedReadBytesIn = 0;
+	s_compressedReadBytesOut = 0;
+	s_compressedReadMicroseconds = 0;
+}
+
 void
 vsFile::StoreBytes( vsStore *s, size_t bytes )
 {
@@ -17,6 +17,7 @@ class vsStore;
 
 #include "VS/Utils/VS_Array.h"
 #include "VS/Utils/VS_String.h"
+#include "VS_FileCache.h"
 
 struct zipdata;
 
@@ -50,6 +51,11 @@ private:
 
 	size_t		m_length;
 	bool m_moveOnDestruction;
+	bool m_writeFailed;	// we couldn't open the file for writing, or a write didn't complete
+
+	uint64_t	m_uncompressedBytesWritten; // in MODE_WriteCompressed, how many bytes we've been asked to write
+
+	vsCachedFile	m_cachedFile; // if our data came from (or went into) the file cache
 
 	void _DoWriteLiteralBytes( const void* bytes, size_t byteCount );
 
@@ -58,6 +64,13 @@ private:
 
 	// do some processing of file compression.
 	void _PumpCompression( const void* bytes, size_t byteCount, bool finish );
+	void _WriteCompressedTrailer();
+
+	// inflate 'compressedData' into m_store in a single pass.
+	void _InflateCompressedStore( vsStore *compressedData );
+
+	// point m_store at m_cachedFile's data, without copying it.
+	void _ReadFromCachedFile();
 
 public:
 
@@ -110,6 +123,13 @@ public:
 	bool		PeekLine( vsString *line );
 	bool		ReadLine( vsString *line );
 
+	// ONLY IN READ OPERATIONS.  As above, but instead of copying the line into
+	// a vsString, points 'line' straight into our buffer.  The line doesn't
+	// include its newline, and isn't NUL-terminated;  it stays valid until
+	// this vsFile is destroyed.
+	bool		PeekLineSpan( const char **line, size_t *length );
+	bool		ReadLineSpan( const char **line, size_t *length );
+
 	bool		Record_Binary( vsRecord *record );		// returns true if we found or successfully wrote another record
 
 	int			ShallowRecord_Binary( vsRecord *record );// returns the number of child records inside this record.  Caller is expected to call ShallowRecord_Binary() that many times to get the next records
@@ -125,6 +145,10 @@ public:
 	void		WriteBytes( const void* data, size_t bytes ); // this is a more direct version of 'Store'.  Will assert if we're not in a Write mode.
 
 	void		FlushBufferedWrites();
+
+	// In write modes, true if anything we've actually written so far has
+	// failed.  Writes are buffered, so call FlushBufferedWrites() first.
+	bool		WriteFailed() const { return m_writeFailed; }
 	/*  These functions are probably deprecated;  use vsRecord objects instead!
 	 *
 	vsString	ReadLabel();
@@ -137,6 +161,21 @@ public:
 
 	typedef void (*openFailureHandler)(const vsString& filename, const vsString& errorMessage);
 	static void SetFileOpenFailureHandler( openFailureHandler handler );
+
+	// Running totals for files opened in MODE_ReadCompressed, across all
+	// threads.  Files which were written before we started recording their
+	// uncompressed size are counted as 'legacyFiles';  those need to inflate
+	// into a growing buffer, and so are a little slower to load.
+	struct CompressedReadStats
+	{
+		uint64_t files;
+		uint64_t legacyFiles;
+		uint64_t compressedBytes;
+		uint64_t decompressedBytes;
+		uint64_t microseconds;
+	};
+	static CompressedReadStats GetCompressedReadStats();
+	static void ResetCompressedReadStats();
 };
 
 #endif // FS_FILE_H
@@ -10,46 +10,269 @@
 #include "VS_FileCache.h"
 #include "VS_HashTable.h"
 #include "VS_Store.h"
+#include "VS_Mutex.h"
 
-static vsHashTable<vsStore> *s_cache = nullptr;
+#include <atomic>
+
+struct vsFileCacheEntry
+{
+	vsString m_filename;
+	vsStore *m_store;
+	std::atomic<int> m_refCount;
+
+	// least-recently-used list.  Only touched while holding s_mutex, and only
+	// while the entry is still in the cache.
+	vsFileCacheEntry *m_newer;
+	vsFileCacheEntry *m_older;
+
+	vsFileCacheEntry( const vsString& filename, vsStore *store ):
+		m_filename(filename),
+		m_store(store),
+		m_refCount(0),
+		m_newer(nullptr),
+		m_older(nullptr)
+	{
+		m_store->Rewind();
+	}
+
+	~vsFileCacheEntry()
+	{
+		vsDelete( m_store );
+	}
+
+	void AddReference() { m_refCount++; }
+	void ReleaseReference()
+	{
+		if ( --m_refCount == 0 )
+			delete this;
+	}
+};
+
+static const size_t c_defaultBudget = 64 * 1024 * 1024;
+
+static vsHashTable<vsFileCacheEntry*> *s_cache = nullptr;
+static vsMutex s_mutex;
+static vsFileCacheEntry *s_newest = nullptr;
+static vsFileCacheEntry *s_oldest = nullptr;
+static size_t s_files = 0;
+static size_t s_bytes = 0;
+static size_t s_budget = c_defaultBudget;
+static uint64_t s_hits = 0;
+static uint64_t s_misses = 0;
+static uint64_t s_evictions = 0;
+
+vsCachedFile::vsCachedFile():
+	m_entry(nullptr)
+{
+}
+
+vsCachedFile::vsCachedFile( vsFileCacheEntry *entry ):
+	m_entry(entry)
+{
+	if ( m_entry )
+		m_entry->AddReference();
+}
+
+vsCachedFile::vsCachedFile( const vsCachedFile& other ):
+	m_entry(other.m_entry)
+{
+	if ( m_entry )
+		m_entry->AddReference();
+}
+
+vsCachedFile::~vsCachedFile()
+{
+	if ( m_entry )
+		m_entry->ReleaseReference();
+}
+
+vsCachedFile&
+vsCachedFile::operator=( const vsCachedFile& other )
+{
+	// add before release, in case we're being assigned to ourselves.
+	if ( other.m_entry )
+		other.m_entry->AddReference();
+	if ( m_entry )
+		m_entry->ReleaseReference();
+	m_entry = other.m_entry;
+	return *this;
+}
+
+const char*
+vsCachedFile::GetData() const
+{
+	vsAssert( m_entry, "Tried to read from an invalid vsCachedFile" );
+	return m_entry->m_store->GetReadHead();
+}
+
+size_t
+vsCachedFile::GetLength() const
+{
+	vsAssert( m_entry, "Tried to read from an invalid vsCachedFile" );
+	return m_entry->m_store->Length();
+}
+
+static void
+UnlinkEntry( vsFileCacheEntry *entry )
+{
+	if ( entry->m_newer )
+		entry->m_newer->m_older = entry->m_older;
+	else
+		s_newest = entry->m_older;
+
+	if ( entry->m_older )
+		entry->m_older->m_newer = entry->m_newer;
+	else
+		s_oldest = entry->m_newer;
+
+	entry->m_newer = entry->m_older = nullptr;
+}
+
+static void
+LinkEntryAsNewest( vsFileCacheEntry *entry )
+{
+	entry->m_newer = nullptr;
+	entry->m_older = s_newest;
+	if ( s_newest )
+		s_newest->m_newer = entry;
+	s_newest = entry;
+	if ( !s_oldest )
+		s_oldest = entry;
+}
+
+static void
+RemoveEntry( vsFileCacheEntry *entry )
+{
+	UnlinkEntry( entry );
+	s_cache->RemoveItemWithKey( entry, entry->m_filename );
+	s_files--;
+	s_bytes -= entry->m_store->Length();
+
+	// drop the cache's own reference.  Anybody still holding a handle keeps
+	// the data alive until they're done with it.
+	entry->ReleaseReference();
+}
+
+static void
+EnforceBudget()
+{
+	if ( s_budget == 0 )
+		return;
+
+	// never evict the newest file, even if it's larger than our whole budget
+	// by itself;  somebody almost certainly wants to read it right now.
+	while ( s_bytes > s_budget && s_oldest && s_oldest != s_newest )
+	{
+		RemoveEntry( s_oldest );
+		s_evictions++;
+	}
+}
+
+static void
+RemoveAllEntries()
+{
+	while ( s_oldest )
+		RemoveEntry( s_oldest );
+}
 
 void
 vsFileCache::Startup()
 {
-	s_cache = new vsHashTable<vsStore>(128);
+	vsScopedLock lock(s_mutex);
+	s_cache = new vsHashTable<vsFileCacheEntry*>(128);
 }
 
 void
 vsFileCache::Shutdown()
 {
+	vsScopedLock lock(s_mutex);
+	RemoveAllEntries();
 	vsDelete( s_cache );
 }
 
 void
 vsFileCache::Purge()
 {
-	Shutdown();
-	Startup();
+	vsScopedLock lock(s_mutex);
+	RemoveAllEntries();
+}
+
+void
+vsFileCache::SetBudget( size_t bytes )
+{
+	vsScopedLock lock(s_mutex);
+	s_budget = bytes;
+	EnforceBudget();
 }
 
 bool
 vsFileCache::IsFileInCache(const vsString& filename)
 {
-	vsStore *s = s_cache->FindItem(filename);
+	vsScopedLock lock(s_mutex);
+	vsFileCacheEntry **e = s_cache->FindItem(filename);
+
+	return nullptr != e;
+}
+
+vsCachedFile
+vsFileCache::GetFile(const vsString& filename)
+{
+	vsScopedLock lock(s_mutex);
+	vsFileCacheEntry **e = s_cache->FindItem(filename);
+	if ( !e )
+	{
+		s_misses++;
+		return vsCachedFile();
+	}
+
+	s_hits++;
+	UnlinkEntry( *e );
+	LinkEntryAsNewest( *e );
+	return vsCachedFile( *e );
+}
+
+vsCachedFile
+vsFileCache::SetFileContents(const vsString& filename, vsStore *store)
+{
+	vsFileCacheEntry *entry = new vsFileCacheEntry( filename, store );
+	vsCachedFile result( entry );
+
+	vsScopedLock lock(s_mutex);
+	vsFileCacheEntry **existing = s_cache->FindItem(filename);
+	if ( existing )
+		RemoveEntry( *existing );
+
+	entry->AddReference(); // the cache's own reference
+	s_cache->AddItemWithKey( entry, filename );
+	LinkEntryAsNewest( entry );
+	s_files++;
+	s_bytes += store->Length();
+
+	EnforceBudget();
 
-	return nullptr != s;
+	return result;
 }
 
-vsStore*
-vsFileCache::GetFileContents(const vsString& filename)
+vsFileCache::Stats
+vsFileCache::GetStats()
 {
-	vsStore *s = s_cache->FindItem(filename);
-	return s;
+	vsScopedLock lock(s_mutex);
+	Stats stats;
+	stats.hits = s_hits;
+	stats.misses = s_misses;
+	stats.evictions = s_evictions;
+	stats.files = s_files;
+	stats.bytes = s_bytes;
+	stats.budget = s_budget;
+	return stats;
 }
 
 void
-vsFileCache::SetFileContents(const vsString& filename, const vsStore &store)
+vsFileCache::ResetStats()
 {
-	s_cache->AddItemWithKey(store, filename);
+	vsScopedLock lock(s_mutex);
+	s_hits = 0;
+	s_misses = 0;
+	s_evictions = 0;
 }
 
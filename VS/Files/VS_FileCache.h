@@ -11,18 +11,62 @@
 #define VS_FILECACHE_H
 
 class vsStore;
+struct vsFileCacheEntry;
+
+// vsCachedFile is a read-only, reference-counted handle onto the contents of
+// a cached file.  Any number of handles can share the same data;  it stays
+// alive until the last handle is gone, even if the cache has since evicted or
+// purged it.  Handles may be copied and released from any thread.
+class vsCachedFile
+{
+	vsFileCacheEntry *m_entry;
+
+public:
+	vsCachedFile();
+	explicit vsCachedFile( vsFileCacheEntry *entry );
+	vsCachedFile( const vsCachedFile& other );
+	~vsCachedFile();
+
+	vsCachedFile& operator=( const vsCachedFile& other );
+
+	bool IsValid() const { return m_entry != nullptr; }
+	const char* GetData() const;
+	size_t GetLength() const;
+};
 
 class vsFileCache
 {
 public:
 
+	struct Stats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+		size_t   files;   // files currently held by the cache
+		size_t   bytes;   // bytes currently held by the cache
+		size_t   budget;  // maximum bytes the cache will hold;  0 means no limit
+	};
+
 	static void Startup();
 	static void Shutdown();
 	static void Purge();
 
+	// When the cache holds more than 'bytes' of file data, the least recently
+	// used files are evicted until it fits again.  0 means no limit.
+	static void SetBudget( size_t bytes );
+
 	static bool IsFileInCache(const vsString& filename);
-	static vsStore* GetFileContents(const vsString& filename);
-	static void SetFileContents(const vsString& filename, const vsStore &store);
+
+	// Returns an invalid handle if the file isn't in the cache.
+	static vsCachedFile GetFile(const vsString& filename);
+
+	// The cache takes ownership of 'store' and its buffer;  the caller should
+	// read from the returned handle instead.
+	static vsCachedFile SetFileContents(const vsString& filename, vsStore *store);
+
+	static Stats GetStats();
+	static void ResetStats();
 };
 
 #endif // VS_FILECACHE_H
@@ -0,0 +1,131 @@
+/*
+ *  VS_MappedFile.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#include "VS_MappedFile.h"
+#include "VS_File.h"
+#include "VS_Store.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#define UTF_CPP_CPLUSPLUS (201703L)
+#include "Utils/utfcpp/utf8.h"
+#undef UTF_CPP_CPLUSPLUS
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+vsMappedFile::vsMappedFile( const vsString &filename ):
+	m_data(nullptr),
+	m_length(0),
+	m_mapped(false),
+	m_store(nullptr)
+#if defined(_WIN32)
+	,
+	m_fileHandle(nullptr),
+	m_mappingHandle(nullptr)
+#endif
+{
+	if ( !vsFile::Exists(filename) )
+	{
+		vsLog( "vsMappedFile:  No such file: %s", filename );
+		return;
+	}
+
+	if ( Map( filename ) )
+		return;
+
+	// Couldn't map it (probably because it's inside an archive), so just
+	// read it all in.
+	vsFile file( filename, vsFile::MODE_Read );
+	m_store = new vsStore( file.GetLength() );
+	file.Store( m_store );
+	m_data = m_store->GetReadHead();
+	m_length = m_store->Length();
+}
+
+vsMappedFile::~vsMappedFile()
+{
+	if ( m_mapped )
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile( m_data );
+		CloseHandle( (HANDLE)m_mappingHandle );
+		CloseHandle( (HANDLE)m_fileHandle );
+#else
+		munmap( (void*)m_data, m_length );
+#endif
+	}
+	vsDelete( m_store );
+}
+
+bool
+vsMappedFile::Map( const vsString &filename )
+{
+	// GetFullFilename() gives us the archive's path if the file lives inside
+	// one, which we'll then fail to open;  that's fine.
+	vsString path = vsFile::GetFullFilename( filename );
+
+#if defined(_WIN32)
+	std::u16string widePath = utf8::utf8to16( path.c_str() );
+	HANDLE file = CreateFileW( (LPCWSTR)widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if ( file == INVALID_HANDLE_VALUE )
+		return false;
+
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 )
+	{
+		CloseHandle( file );
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if ( !mapping )
+	{
+		CloseHandle( file );
+		return false;
+	}
+
+	void *data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if ( !data )
+	{
+		CloseHandle( mapping );
+		CloseHandle( file );
+		return false;
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_length = (size_t)size.QuadPart;
+#else
+	int fd = open( path.c_str(), O_RDONLY );
+	if ( fd < 0 )
+		return false;
+
+	struct stat st;
+	if ( fstat( fd, &st ) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 )
+	{
+		close( fd );
+		return false;
+	}
+
+	void *data = mmap( nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );	// the mapping keeps the file open for us
+	if ( data == MAP_FAILED )
+		return false;
+
+	m_length = (size_t)st.st_size;
+#endif
+
+	m_data = (const char*)data;
+	m_mapped = true;
+	return true;
+}
@@ -0,0 +1,59 @@
+/*
+ *  VS_MappedFile.h
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#ifndef VS_MAPPEDFILE_H
+#define VS_MAPPEDFILE_H
+
+#include "VS/Utils/VS_String.h"
+
+class vsStore;
+
+// vsMappedFile gives read-only access to a whole file's contents without
+// copying them, by mapping the file into memory.  Pages are only read from
+// disk as they're touched, and are shared with the OS's file cache.
+//
+// Only files which are sitting loose on disk can be mapped.  If the file is
+// inside an archive (or mapping fails for any other reason), we quietly fall
+// back to reading the whole thing into memory through vsFile, so callers
+// don't need to care which happened.
+//
+// Mapped data starts on a page boundary;  data we had to read starts
+// wherever the heap put it.  vsMappedFile may be created and destroyed on
+// any thread.
+
+class vsMappedFile
+{
+	const char *	m_data;
+	size_t			m_length;
+	bool			m_mapped;
+	vsStore *		m_store;	// if we couldn't map the file
+#if defined(_WIN32)
+	void *			m_fileHandle;
+	void *			m_mappingHandle;
+#endif
+
+	bool			Map( const vsString &filename );
+
+	vsMappedFile( const vsMappedFile& other ) = delete;
+	vsMappedFile& operator=( const vsMappedFile& other ) = delete;
+
+public:
+
+	vsMappedFile( const vsString &filename );
+	~vsMappedFile();
+
+	bool			IsOK() const { return m_data != nullptr; }
+	bool			IsMapped() const { return m_mapped; }
+
+	const char *	GetData() const { return m_data; }
+	size_t			GetLength() const { return m_length; }
+};
+
+#endif // VS_MAPPEDFILE_H
+
@@ -440,27 +440,36 @@ vsRecord::Parse( vsFile *file )
 	{
 		done = true;
 
-		vsString parseString;
-		haveLine = file->ReadLine(&parseString);
+		// tokenize straight out of the file's buffer;  only the tokens we
+		// keep get copied into vsStrings.
+		const char *line;
+		size_t lineLength;
+		haveLine = file->ReadLineSpan(&line, &lineLength);
 
 		if ( haveLine )
 		{
-			vsString nextLine;
-			bool haveNextLine = file->PeekLine( &nextLine );
+			vsTokenizer tokenizer( line, lineLength );
+			valid = ParseTokens( tokenizer );
+
+			const char *nextLine;
+			size_t nextLineLength;
+			bool haveNextLine = file->PeekLineSpan( &nextLine, &nextLineLength );
 			if ( haveNextLine )
 			{
-				vsToken t;
-				t.ExtractFrom(nextLine);
-				if( t.GetType() == vsToken::Type_OpenBrace )
+				vsTokenizer nextTokenizer( nextLine, nextLineLength );
+				vsTokenSpan t;
+				if( nextTokenizer.Next(&t) && t.type == vsToken::Type_OpenBrace )
 				{
-					// next line starts with an open brace -- append the next line to this one, for the purposes of parsing!
+					// next line starts with an open brace -- treat the next line as part of this one, for the purposes of parsing!
 
-					file->ReadLine( &nextLine );
-					parseString = parseString + nextLine;
+					file->ReadLineSpan( &nextLine, &nextLineLength );
+					nextTokenizer = vsTokenizer( nextLine, nextLineLength );
+					if ( ParseTokens( nextTokenizer ) )
+						valid = true;
 				}
 			}
+			AppendToken( vsToken( vsToken::Type_NewLine ) );
 
-			valid = ParseString( parseString );
 			if ( m_inBlock )
 			{
 				done = false;
@@ -480,23 +489,29 @@ vsRecord::Parse( vsFile *file )
 
 bool
 vsRecord::ParseString( vsString parseString )
+{
+	vsTokenizer tokenizer( parseString.c_str(), parseString.length() );
+	bool valid = ParseTokens( tokenizer );
+
+	AppendToken( vsToken( vsToken::Type_NewLine ) );
+	return valid;
+}
+
+bool
+vsRecord::ParseTokens( vsTokenizer& tokenizer )
 {
 	vsToken t;
+	vsTokenSpan span;
 
 	bool valid = false;
 
-
-	while ( !parseString.empty() )
+	while ( tokenizer.Next(&span) )
 	{
-		t.ExtractFrom(parseString);
-		if( t.GetType() != vsToken::Type_None )
-		{
-			valid = true;
-		}
+		span.ToToken(&t);
+		valid = true;
 		AppendToken(t);
 	}
 
-	AppendToken( vsToken( vsToken::Type_NewLine ) );
 	return valid;
 }
 
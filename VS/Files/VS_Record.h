@@ -52,6 +52,8 @@ class vsRecord
 	void		PopulateStringTable( vsStringTable& array );
 	void		Clean();
 
+	bool		ParseTokens( vsTokenizer& tokenizer );	// append every token left in 'tokenizer'
+
 public:
 	vsRecord();
 	vsRecord( const char* fromString );
@@ -10,8 +10,8 @@
 #include "VS_Token.h"
 
 #include "VS/Memory/VS_Serialiser.h"
-#include <stdexcept>
 #include <sstream>
+#include <errno.h>
 
 // #ifdef MSVC
 // visual studio defines its own "secure" sscanf.  So use that to keep
@@ -30,20 +30,9 @@
 
 static bool IsWhitespace( char c )
 {
-	char whiteSpace[] =
-	{
-		' ',
-		'\t',
-		','
-	};
-	int whiteSpaceTypes = sizeof(whiteSpace);
-
-	for ( int i = 0; i < whiteSpaceTypes; i++ )
-	{
-		if ( whiteSpace[i] == c )
-			return true;
-	}
-	return false;
+	// '\r' only ever shows up as part of a Windows line ending, so we just
+	// treat it as whitespace.
+	return ( c == ' ' || c == '\t' || c == ',' || c == '\r' );
 }
 
 static bool IsAlpha( char c )
@@ -63,161 +52,216 @@ static bool IsAlphaNumeric( char c )
 	return IsAlpha(c) || IsNumeric(c);
 }
 
-
-static void RemoveLeadingWhitespace( vsString &string )
+vsTokenizer::vsTokenizer( const char *begin, size_t length ):
+	m_cursor(begin),
+	m_end(begin + length)
 {
-	bool done = false;
+}
 
-	while(!done)
+bool
+vsTokenizer::ExtractNumber( vsTokenSpan *token )
+{
+	// strtof() and strtol() need a terminated string, and our buffer might
+	// not be, so copy out just the characters which could be part of a
+	// number.
+	const int c_maxNumberLength = 64;
+	char buffer[c_maxNumberLength];
+	int bufferLength = 0;
+	bool isFloat = false;
+	bool inPlainNumber = true;
+	for ( const char *c = m_cursor; c < m_end && bufferLength < c_maxNumberLength-1; c++ )
 	{
-		done = true;
+		if ( !IsAlphaNumeric(*c) )
+			break;
+		// only a '.' in the plain run of digits and signs at the start makes
+		// this a float;  "1e5" is the integer 1 followed by the label "e5".
+		if ( !::IsNumeric(*c) )
+			inPlainNumber = false;
+		else if ( inPlainNumber && *c == '.' )
+			isFloat = true;
+		buffer[bufferLength++] = *c;
+	}
+	buffer[bufferLength] = 0;
 
-		if ( !string.empty() && IsWhitespace(string[0]) )
+	char *end = nullptr;
+	if ( isFloat )
+	{
+		errno = 0;
+		float val = strtof( buffer, &end );
+		if ( end != buffer )
 		{
-			string.erase(0,1);
-			done = false;
+			if ( errno == ERANGE )
+			{
+				vsLog("Token '%s' out of float range", vsString(buffer, end-buffer));
+				val = 0.f;
+			}
+			token->type = vsToken::Type_Float;
+			token->f = val;
+			token->length = end-buffer;
+			m_cursor += token->length;
+			return true;
 		}
 	}
-}
 
+	errno = 0;
+	long val = strtol( buffer, &end, 10 );
+	if ( end != buffer )
+	{
+		if ( errno == ERANGE || val < INT32_MIN || val > INT32_MAX )
+		{
+			vsLog("Token '%s' out of int range", vsString(buffer, end-buffer));
+			val = 0;
+		}
+		token->type = vsToken::Type_Integer;
+		token->i = (int32_t)val;
+		token->length = end-buffer;
+		m_cursor += token->length;
+		return true;
+	}
+	return false;
+}
 
-static vsString ExtractStringToken( vsString &string )
+bool
+vsTokenizer::Next( vsTokenSpan *token )
 {
-	vsAssert(string[0] == '\"', "Tried to extract a string that didn't start with \"!");
+	while ( m_cursor < m_end )
+	{
+		while ( m_cursor < m_end && IsWhitespace(*m_cursor) )
+			m_cursor++;
 
-	vsString result;
+		if ( m_cursor >= m_end || *m_cursor == 0 )
+		{
+			// a NUL means the text ends here, same as the end of the buffer.
+			m_cursor = m_end;
+			return false;
+		}
 
-	//result.append( 1, string[0] );	// get first '"'
-	string.erase(0,1);
+		token->start = m_cursor;
+		token->length = 1;
+		token->needsDecoding = false;
 
-	bool escaped = false;
-	while( !string.empty() && string[0] ){
-		if ( escaped )
+		char c = *m_cursor;
+		switch ( c )
 		{
-			if ( string[0] == 'n' )
-			{
-				result.append( 1, '\n' );
-			}
-			else
-			{
-				result.append( 1, string[0] );
-			}
-			escaped = false;
+			case '\"':
+				{
+					token->type = vsToken::Type_String;
+					token->start = ++m_cursor;
+					bool escaped = false;
+					while ( m_cursor < m_end && *m_cursor )
+					{
+						if ( escaped )
+							escaped = false;
+						else if ( *m_cursor == '\"' )
+							break; // end of string!
+						else if ( *m_cursor == '\\' )
+							escaped = token->needsDecoding = true;
+						else if ( *m_cursor == '\r' )
+							token->needsDecoding = true;
+						m_cursor++;
+					}
+					token->length = m_cursor - token->start;
+					if ( m_cursor < m_end && *m_cursor == '\"' )
+						m_cursor++;	// consume the closing '"'
+					return true;
+				}
+			case '{':
+				token->type = vsToken::Type_OpenBrace;
+				m_cursor++;
+				return true;
+			case '}':
+				token->type = vsToken::Type_CloseBrace;
+				m_cursor++;
+				return true;
+			case ';':
+				token->type = vsToken::Type_Semicolon;
+				m_cursor++;
+				return true;
+			case '\n':
+				token->type = vsToken::Type_NewLine;
+				m_cursor++;
+				return true;
+			case '=':
+				token->type = vsToken::Type_Equals;
+				m_cursor++;
+				return true;
+			case '#':
+				// comment!  Skip the rest of the line, and keep looking.
+				while ( m_cursor < m_end && *m_cursor != '\n' && *m_cursor != 0 )
+					m_cursor++;
+				continue;
+			default:
+				break;
 		}
-		else
+
+		if ( IsAlpha(c) )
 		{
-			if ( string[0] == '\"' )
-			{
-				break; // end of string!
-			}
-			else if ( string[0] == '\\' )
-			{
-				escaped = true;
-			}
-			else
-			{
-				result.append( 1, string[0] );
-			}
+			while ( m_cursor < m_end && IsAlphaNumeric(*m_cursor) )
+				m_cursor++;
+			token->type = vsToken::Type_Label;
+			token->length = m_cursor - token->start;
+			return true;
 		}
-		string.erase(0,1);
-	}
-	//result.append( 1, string[0] );	// get last '"'
-	string.erase(0,1);
 
-	return result;
+		if ( ::IsNumeric(c) && ExtractNumber(token) )
+			return true;
+
+		// no clue what it was!  Just treat it as a string, breaking at the next whitespace
+		while ( m_cursor < m_end && !IsWhitespace(*m_cursor) && *m_cursor != '\n' && *m_cursor != 0 )
+			m_cursor++;
+		token->type = vsToken::Type_String;
+		token->length = m_cursor - token->start;
+		return true;
+	}
+	return false;
 }
 
-static vsString ExtractWhitespaceStringToken( vsString &string )	// pull out a string defined by whitespace
+vsString
+vsTokenSpan::AsString() const
 {
-	vsString label;
+	if ( !needsDecoding )
+		return vsString( start, length );
 
-	size_t len = string.length();
-	size_t index = 0;
-
-	for ( index = 0; index < len; index++ )
+	vsString result;
+	result.reserve( length );
+	bool escaped = false;
+	for ( size_t i = 0; i < length; i++ )
 	{
-		if ( IsWhitespace(string[index]) )	// this character is whitespace, so isn't part of the label
+		char c = start[i];
+		if ( escaped )
 		{
-			index--;					// back up one character
-			break;						// exit the loop
+			result.append( 1, c == 'n' ? '\n' : c );
+			escaped = false;
 		}
+		else if ( c == '\\' )
+			escaped = true;
+		else if ( c != '\r' )
+			result.append( 1, c );
 	}
-
-	label = string.substr(0, index+1);
-	string.erase(0,index+1);
-
-	return label;
+	return result;
 }
 
-// static vsString ExtractLabelToken( vsString &string )
-// {
-// 	vsAssert(IsAlpha(string[0]), "Tried to extract a label from something that isn't alpha!");
-// 	// okay.  We need to find
-// 	vsString label;
-//
-// 	size_t len = string.length();
-// 	size_t index = 0;
-//
-// 	for ( index = 0; index < len; index++ )
-// 	{
-// 		if ( !IsAlphaNumeric(string[index]) )	// this character isn't alphanumeric, so isn't part of the label
-// 		{
-// 			index--;					// back up one character
-// 			break;						// exit the loop
-// 		}
-// 	}
-//
-// 	label = string.substr(0, index+1);
-// 	string.erase(0,index+1);
-//
-// 	return label;
-// }
-//
-// static vsString ExtractNumberToken( vsString &string )
-// {
-// 	vsAssert(IsNumeric(string[0]), "Tried to extract a number from something that isn't a number!");
-// 	// okay.  We need to find
-// 	vsString numberString;
-//
-// 	size_t len = string.length();
-// 	size_t index = 0;
-//
-// 	for ( index = 0; index < len; index++ )
-// 	{
-// 		if ( !IsNumeric(string[index]) )	// this character isn't alphabetic, so isn't part of the label
-// 		{
-// 			index--;					// back up one character
-// 			break;						// exit the loop
-// 		}
-// 	}
-//
-// 	numberString = string.substr(0, index+1);
-// 	string.erase(0,index+1);
-//
-// 	return numberString;
-// }
-//
-
-static vsString PeekNumberToken( vsString &string )
+void
+vsTokenSpan::ToToken( vsToken *token ) const
 {
-	vsAssert(::IsNumeric(string[0]), "Tried to extract a number from something that isn't a number!");
-	// okay.  We need to find
-	vsString numberString;
-
-	size_t len = string.length();
-	size_t index = 0;
-
-	for ( index = 0; index < len; index++ )
+	switch ( type )
 	{
-		if ( !IsNumeric(string[index]) )	// this character isn't alphabetic, so isn't part of the label
-		{
-			index--;					// back up one character
-			break;						// exit the loop
-		}
+		case vsToken::Type_Label:
+			token->SetLabel( AsString() );
+			break;
+		case vsToken::Type_String:
+			token->SetString( AsString() );
+			break;
+		case vsToken::Type_Float:
+			token->SetFloat( f );
+			break;
+		case vsToken::Type_Integer:
+			token->SetInteger( i );
+			break;
+		default:
+			token->SetType( type );
+			break;
 	}
-
-	numberString = string.substr(0, index+1);
-	return numberString;
 }
 
 
@@ -282,158 +326,21 @@ vsToken::~vsToken()
 	SetInteger(0); // cleanup any string data we had lying around
 }
 
-bool
-vsToken::ExtractLabelString( vsString* output, vsString& input )
-{
-	if ( !::IsAlpha( input[0] ) )
-		return false;
-
-	while ( ::IsAlphaNumeric( input[0] ) )
-	{
-		output->push_back(input[0]);
-		input.erase(0,1);
-	}
-	return true;
-}
-
-bool
-vsToken::ExtractFloat( float* output, vsString& input )
-{
-	if (!::IsNumeric(input[0]))
-		return false;
-
-	vsString numberToken = PeekNumberToken(input);
-	if ( numberToken.find('.') == vsString::npos )
-		return false;
-
-	size_t bytesProcessed = 0;
-	float val = 0.f;
-	try
-	{
-		val = std::stof( input.c_str(), &bytesProcessed );
-
-		*output = val;
-		input.erase(0,bytesProcessed);
-		return true;
-	}
-	catch(std::out_of_range& oor)
-	{
-		vsLog("Token '%s' out of float range", input);
-		*output = 0;
-		return true;
-	}
-	catch(std::exception& e)
-	{
-	}
-	return false;
-}
-
-bool
-vsToken::ExtractInteger( int* output, vsString& input )
-{
-	if (!::IsNumeric(input[0]))
-		return false;
-
-	size_t bytesProcessed = 0;
-	int val = 0;
-	try
-	{
-		val = std::stoi( input.c_str(), &bytesProcessed );
-
-		*output = val;
-		input.erase(0,bytesProcessed);
-		return true;
-	}
-	catch(std::out_of_range& oor)
-	{
-		vsLog("Token '%s' out of int range", input);
-		*output = 0;
-		return true;
-	}
-	catch(std::exception& e)
-	{
-	}
-	return false;
-}
-
 bool
 vsToken::ExtractFrom( vsString &string )
 {
-	vsString labelResult;
-	float floatResult;
-	int intResult;
-
 	SetType( Type_None );
 
-	RemoveLeadingWhitespace(string);
-
-	if ( !string.empty() )
-	{
-		if ( string[0] == '\"' )
-		{
-			SetString( ExtractStringToken(string) );
-			return true;
-		}
-		else if ( string[0] == '{' )
-		{
-			SetType( Type_OpenBrace );
-			string.erase(0,1);
-			return true;
-		}
-		else if ( string[0] == '}' )
-		{
-			SetType( Type_CloseBrace );
-			string.erase(0,1);
-			return true;
-		}
-		else if ( string[0] == ';' )
-		{
-			SetType( Type_Semicolon );
-			string.erase(0,1);
-			return true;
-		}
-		else if ( string[0] == '\n' )
-		{
-			SetType( Type_NewLine );
-			string.erase(0,1);
-			return true;
-		}
-		else if ( ExtractLabelString(&labelResult, string) )
-		{
-			SetLabel( labelResult );
-			return true;
-		}
-		else if ( ExtractFloat(&floatResult, string) )
-		{
-			SetFloat(floatResult);
-			return true;
-		}
-		else if ( ExtractInteger(&intResult, string) )
-		{
-			SetInteger(intResult);
-			return true;
-		}
-		else if ( string[0] == '#' )
-		{
-			// comment!  Consume the rest of the line!
-			string = vsEmptyString;
-		}
-		else if ( string[0] == '=' )
-		{
-			SetType( Type_Equals );
-			string.erase(0,1);
-			return true;
-		}
-		else
-		{
-			// no clue what it was!  Just treat it as a string, breaking at the next whitespace
-
-			SetString( ExtractWhitespaceStringToken(string) );
-			return true;
-		}
-	}
+	vsTokenizer tokenizer( string.c_str(), string.length() );
+	vsTokenSpan span;
+	bool found = tokenizer.Next( &span );
+	if ( found )
+		span.ToToken( this );
 
-	return false;
+	// only erase what we consumed once we're done with the span, since it
+	// points into 'string'.
+	string.erase( 0, tokenizer.GetCursor() - string.c_str() );
+	return found;
 }
 
 namespace
@@ -42,10 +42,6 @@ private:
 	};
 	void SetStringField( const vsString& s );
 
-	bool ExtractLabelString( vsString* output, vsString& input );
-	bool ExtractFloat( float* output, vsString& input );
-	bool ExtractInteger( int* output, vsString& input );
-
 public:
 
 	vsToken();
@@ -92,5 +88,47 @@ public:
 	bool operator!=( const vsString& str ) const { return ! ((*this) == str); }
 };
 
+// vsTokenSpan is a lightweight token found by a vsTokenizer.  Label and
+// String tokens just point back into the tokenizer's buffer instead of owning
+// a copy of their text, so they're only valid for as long as that buffer is.
+// Nothing is copied into a vsString until somebody calls AsString() or
+// ToToken().
+struct vsTokenSpan
+{
+	vsToken::Type	type;
+	const char *	start;			// for String tokens, excludes the quotes
+	size_t			length;
+	bool			needsDecoding;	// String token contains escapes or '\r's
+	union
+	{
+		float		f;
+		int32_t		i;
+	};
+
+	vsString	AsString() const;
+	void		ToToken( vsToken *token ) const;
+};
+
+// vsTokenizer walks a cursor over a buffer of text, pulling out one token at
+// a time.  It never modifies or copies the buffer.
+class vsTokenizer
+{
+	const char *	m_cursor;
+	const char *	m_end;
+
+	bool	ExtractNumber( vsTokenSpan *token );
+
+public:
+
+	vsTokenizer( const char *begin, size_t length );
+
+	// returns false once there are no more tokens in the buffer.  Comments
+	// are skipped up to the end of their line.
+	bool		Next( vsTokenSpan *token );
+
+	const char*	GetCursor() const { return m_cursor; }
+	bool		AtEnd() const { return m_cursor >= m_end; }
+};
+
 #endif // FS_TOKEN_H
 
@@ -204,7 +204,7 @@ static const float c_kerningFactor = 0.6f;
 static const float c_spaceKerning = 0.8f;	// space width, compared to a regular character
 static const float c_lineMarginFactor = 0.4f;	// extra space between lines, relative to caps size
 
-static vsDisplayList s_tempFontList(1024*10);
+static vsDisplayList s_tempFontList(1024*10, true);
 
 static bool IsCap( char c )
 {
@@ -314,7 +314,7 @@ vsDisplayList *
 vsBuiltInFont::CreateString_Internal(const char* string, float size, float capSize, JustificationType j, float maxWidth)
 {
 	vsDisplayList *result = nullptr;
-	vsDisplayList loader(1024 * 10);
+	vsDisplayList loader(1024 * 10, true);
 
 	CreateStringInDisplayList( &loader, string, size, capSize, j, maxWidth );
 
@@ -450,7 +450,7 @@ vsBuiltInFont::CreateCharacter(char c, float size, float capSize)
 	if ( capSize < 0 )	// default param
 		capSize = size;
 
-	vsDisplayList loader(1024);
+	vsDisplayList loader(1024, true);
 
 	BuildDisplayListFromCharacter( &loader, c, size, capSize );
 
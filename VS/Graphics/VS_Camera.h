@@ -82,6 +82,7 @@ public:
 	const vsVector3D &		GetPosition() const { return m_transform.GetTranslation(); }
 	const vsQuaternion &	GetOrientation() const { return m_transform.GetRotation(); }
 	const vsTransform3D &	GetTransform() const { return m_transform; }
+	const vsFrustum &		GetFrustum() const { return m_frustum; }
 	float					GetFieldOfView() const { return m_fov; }
 	float					GetFOV() const { return GetFieldOfView(); } // deprecated
 	float					GetNearPlane() const { return m_nearPlane; }
@@ -0,0 +1,452 @@
+/*
+ *  VS_CookedTexture.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#include "VS_CookedTexture.h"
+
+#include "VS_Color.h"
+#include "VS_FloatImage.h"
+#include "VS_Image.h"
+
+#include "VS/Files/VS_File.h"
+#include "VS/Files/VS_MappedFile.h"
+
+#include "VS_OpenGL.h"
+
+#include <zlib.h>
+#include <string.h>
+
+namespace
+{
+	const char c_magic[4] = { 'V', 'S', 'T', 'X' };
+	const int c_maxLevels = 32;
+	const size_t c_levelAlignment = 16;
+
+	int BytesPerPixel( vsCookedTexture::Format format )
+	{
+		return ( format == vsCookedTexture::Format_RGBA16F ) ? 8 : 4;
+	}
+
+	size_t Align( size_t offset )
+	{
+		return (offset + c_levelAlignment - 1) & ~(c_levelAlignment - 1);
+	}
+
+	uint16_t FloatToHalf( float f )
+	{
+		uint32_t bits;
+		memcpy( &bits, &f, sizeof(bits) );
+
+		uint16_t sign = (bits >> 16) & 0x8000;
+		int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+		uint32_t mantissa = bits & 0x7fffff;
+
+		if ( ((bits >> 23) & 0xff) == 0xff )	// inf or nan
+			return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+		if ( exponent >= 0x1f )					// too big;  inf
+			return sign | 0x7c00;
+		if ( exponent <= 0 )					// denormal or zero
+		{
+			if ( exponent < -10 )
+				return sign;
+			mantissa |= 0x800000;
+			int shift = 14 - exponent;
+			uint32_t half = mantissa >> shift;
+			if ( (mantissa >> (shift-1)) & 1 )	// round
+				half++;
+			return sign | (uint16_t)half;
+		}
+
+		uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+		if ( mantissa & 0x1000 )	// round;  carrying into the exponent is fine
+			half++;
+		return sign | (uint16_t)half;
+	}
+
+	// Box filters 'source' down to half its size (rounding down, but never
+	// below 1).  Odd edges fold their last row/column into the one before.
+	void Downsample( const float *source, int sourceWidth, int sourceHeight, float *dest, int destWidth, int destHeight )
+	{
+		for ( int y = 0; y < destHeight; y++ )
+		{
+			int y0 = vsMin( y*2, sourceHeight-1 );
+			int y1 = vsMin( y*2+1, sourceHeight-1 );
+			for ( int x = 0; x < destWidth; x++ )
+			{
+				int x0 = vsMin( x*2, sourceWidth-1 );
+				int x1 = vsMin( x*2+1, sourceWidth-1 );
+				for ( int c = 0; c < 4; c++ )
+				{
+					float sum = source[(y0*sourceWidth + x0)*4 + c] +
+						source[(y0*sourceWidth + x1)*4 + c] +
+						source[(y1*sourceWidth + x0)*4 + c] +
+						source[(y1*sourceWidth + x1)*4 + c];
+					dest[(y*destWidth + x)*4 + c] = sum * 0.25f;
+				}
+			}
+		}
+	}
+
+	void Encode( vsCookedTexture::Format format, const float *rgba, int pixelCount, char *out )
+	{
+		if ( format == vsCookedTexture::Format_RGBA16F )
+		{
+			uint16_t *half = (uint16_t*)out;
+			for ( int i = 0; i < pixelCount*4; i++ )
+				half[i] = FloatToHalf( rgba[i] );
+		}
+		else
+		{
+			uint8_t *byte = (uint8_t*)out;
+			for ( int i = 0; i < pixelCount*4; i++ )
+				byte[i] = (uint8_t)( vsClamp( rgba[i], 0.f, 1.f ) * 255.f + 0.5f );
+		}
+	}
+};
+
+vsString
+vsCookedTexture::GetCookedFilename( const vsString &sourceFilename )
+{
+	return sourceFilename + ".vstex";
+}
+
+vsCookedTexture *
+vsCookedTexture::OpenFor( const vsString &sourceFilename )
+{
+	vsString cookedFilename = GetCookedFilename( sourceFilename );
+	if ( !vsFile::Exists( cookedFilename ) )
+		return nullptr;
+
+	vsCookedTexture *cooked = new vsCookedTexture( cookedFilename );
+	if ( !cooked->IsOK() )
+		vsDelete( cooked );
+	return cooked;
+}
+
+vsCookedTexture::vsCookedTexture( const vsString &filename ):
+	m_file( nullptr ),
+	m_format( Format_RGBA8 ),
+	m_width( 0 ),
+	m_height( 0 ),
+	m_totalBytes( 0 ),
+	m_ok( false )
+{
+	m_file = new vsMappedFile( filename );
+	m_ok = Load();
+	if ( !m_ok )
+	{
+		vsLog( "vsCookedTexture:  %s is not a valid cooked texture", filename );
+		Unload();
+	}
+}
+
+vsCookedTexture::~vsCookedTexture()
+{
+	Unload();
+}
+
+void
+vsCookedTexture::Unload()
+{
+	for ( int i = 0; i < m_level.ItemCount(); i++ )
+		vsDeleteArray( m_level[i].inflated );
+	m_level.Clear();
+	vsDelete( m_file );
+}
+
+bool
+vsCookedTexture::Load()
+{
+	if ( !m_file->IsOK() )
+		return false;
+
+	const char *data = m_file->GetData();
+	size_t length = m_file->GetLength();
+
+	FileHeader header;
+	if ( length < sizeof(header) )
+		return false;
+	memcpy( &header, data, sizeof(header) );
+
+	if ( memcmp( header.magic, c_magic, sizeof(c_magic) ) != 0 ||
+			header.version != c_version ||
+			header.format >= Format_MAX ||
+			header.width == 0 || header.height == 0 ||
+			header.levelCount == 0 || header.levelCount > c_maxLevels )
+		return false;
+
+	if ( length < sizeof(header) + sizeof(LevelHeader) * header.levelCount )
+		return false;
+
+	m_format = (Format)header.format;
+	m_width = header.width;
+	m_height = header.height;
+	bool compressed = (header.flags & Flag_Compressed) != 0;
+	int bytesPerPixel = BytesPerPixel( m_format );
+
+	for ( uint32_t i = 0; i < header.levelCount; i++ )
+	{
+		LevelHeader levelHeader;
+		memcpy( &levelHeader, data + sizeof(header) + sizeof(LevelHeader) * i, sizeof(levelHeader) );
+
+		if ( levelHeader.offset > length || levelHeader.storedBytes > length - levelHeader.offset )
+			return false;
+		if ( levelHeader.width == 0 || levelHeader.height == 0 ||
+				levelHeader.bytes != (uint64_t)levelHeader.width * levelHeader.height * bytesPerPixel )
+			return false;
+
+		Level level;
+		level.width = levelHeader.width;
+		level.height = levelHeader.height;
+		level.bytes = (size_t)levelHeader.bytes;
+		level.inflated = nullptr;
+
+		if ( compressed )
+		{
+			level.inflated = new char[level.bytes];
+			level.data = level.inflated;
+			m_level.AddItem( level );	// so Unload() will clean it up if we fail
+
+			uLongf inflatedBytes = (uLongf)level.bytes;
+			int result = uncompress( (Bytef*)level.inflated, &inflatedBytes, (const Bytef*)(data + levelHeader.offset), (uLong)levelHeader.storedBytes );
+			if ( result != Z_OK || inflatedBytes != level.bytes )
+				return false;
+		}
+		else
+		{
+			if ( levelHeader.storedBytes != levelHeader.bytes )
+				return false;
+			level.data = data + levelHeader.offset;
+			m_level.AddItem( level );
+		}
+
+		m_totalBytes += level.bytes;
+	}
+
+	// If we inflated everything, we don't need the file any more.
+	if ( compressed )
+		vsDelete( m_file );
+
+	return true;
+}
+
+uint32_t
+vsCookedTexture::Upload() const
+{
+	vsAssert( m_ok, "Uploading an invalid cooked texture??" );
+
+	GLuint t;
+	glGenTextures(1, &t);
+	glBindTexture(GL_TEXTURE_2D, t);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (m_level.ItemCount() > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_level.ItemCount()-1);
+
+	bool half = ( m_format == Format_RGBA16F );
+	for ( int i = 0; i < m_level.ItemCount(); i++ )
+	{
+		const Level &level = m_level[i];
+		glTexImage2D(GL_TEXTURE_2D,
+				i,
+				half ? GL_RGBA16F : GL_RGBA,
+				level.width, level.height,
+				0,
+				GL_RGBA,
+				half ? GL_HALF_FLOAT : GL_UNSIGNED_INT_8_8_8_8_REV,
+				level.data);
+	}
+	return t;
+}
+
+bool
+vsCookedTexture::Cook( const vsImage &image, const vsString &filename, bool compress )
+{
+	int width = image.GetWidth();
+	int height = image.GetHeight();
+	int count = width * height * 4;
+	const uint8_t *bytes = (const uint8_t*)image.RawData();
+	if ( !bytes )
+		return false;
+
+	float *rgba = new float[count];
+	for ( int i = 0; i < count; i++ )
+		rgba[i] = bytes[i] / 255.f;
+
+	bool result = Write( filename, Format_RGBA8, rgba, width, height, compress );
+	vsDeleteArray( rgba );
+	return result;
+}
+
+bool
+vsCookedTexture::Cook( const vsFloatImage &image, const vsString &filename, bool compress )
+{
+	int width = image.GetWidth();
+	int height = image.GetHeight();
+	float *rgba = new float[width * height * 4];
+	for ( int v = 0; v < height; v++ )
+	{
+		for ( int u = 0; u < width; u++ )
+		{
+			vsColor c = image.GetPixel(u,v);
+			float *out = &rgba[(v*width + u)*4];
+			out[0] = c.r;
+			out[1] = c.g;
+			out[2] = c.b;
+			out[3] = c.a;
+		}
+	}
+
+	bool result = Write( filename, Format_RGBA16F, rgba, width, height, compress );
+	vsDeleteArray( rgba );
+	return result;
+}
+
+bool
+vsCookedTexture::CookFile( const vsString &sourceFilename, Format format, bool compress )
+{
+	if ( !vsFile::Exists( sourceFilename ) )
+	{
+		vsLog( "vsCookedTexture:  No such file: %s", sourceFilename );
+		return false;
+	}
+
+	vsString cookedFilename = GetCookedFilename( sourceFilename );
+	if ( format == Format_RGBA16F )
+	{
+		vsFloatImage image( sourceFilename );
+		if ( !image.IsOK() )
+			return false;
+		return Cook( image, cookedFilename, compress );
+	}
+
+	vsImage image( sourceFilename );
+	if ( !image.IsOK() )
+		return false;
+	return Cook( image, cookedFilename, compress );
+}
+
+bool
+vsCookedTexture::Write( const vsString &filename, Format format, const float *rgba, int width, int height, bool compress )
+{
+	if ( width <= 0 || height <= 0 )
+		return false;
+
+	struct CookedLevel
+	{
+		char *		data;
+		size_t		storedBytes;
+		size_t		bytes;
+		int			width;
+		int			height;
+	};
+	vsArray<CookedLevel> levels;
+
+	// Build the whole chain in floats, encoding each level as we go.
+	int bytesPerPixel = BytesPerPixel( format );
+	const float *source = rgba;
+	float *scratch = nullptr;
+	int w = width, h = height;
+	while ( levels.ItemCount() < c_maxLevels )
+	{
+		CookedLevel level;
+		level.width = w;
+		level.height = h;
+		level.bytes = (size_t)w * h * bytesPerPixel;
+		char *encoded = new char[level.bytes];
+		Encode( format, source, w*h, encoded );
+
+		if ( compress )
+		{
+			uLongf compressedBytes = compressBound( (uLong)level.bytes );
+			level.data = new char[compressedBytes];
+			compress2( (Bytef*)level.data, &compressedBytes, (const Bytef*)encoded, (uLong)level.bytes, Z_BEST_COMPRESSION );
+			level.storedBytes = compressedBytes;
+			vsDeleteArray( encoded );
+		}
+		else
+		{
+			level.data = encoded;
+			level.storedBytes = level.bytes;
+		}
+		levels.AddItem( level );
+
+		if ( w == 1 && h == 1 )
+			break;
+
+		int nextW = vsMax( w/2, 1 );
+		int nextH = vsMax( h/2, 1 );
+		float *next = new float[nextW * nextH * 4];
+		Downsample( source, w, h, next, nextW, nextH );
+		vsDeleteArray( scratch );
+		source = scratch = next;
+		w = nextW;
+		h = nextH;
+	}
+	vsDeleteArray( scratch );
+
+	FileHeader header;
+	memcpy( header.magic, c_magic, sizeof(c_magic) );
+	header.version = c_version;
+	header.format = format;
+	header.flags = compress ? Flag_Compressed : 0;
+	header.width = width;
+	header.height = height;
+	header.levelCount = levels.ItemCount();
+	header.reserved = 0;
+
+	size_t offset = Align( sizeof(FileHeader) + sizeof(LevelHeader) * levels.ItemCount() );
+	LevelHeader *levelHeader = new LevelHeader[levels.ItemCount()];
+	for ( int i = 0; i < levels.ItemCount(); i++ )
+	{
+		levelHeader[i].offset = offset;
+		levelHeader[i].storedBytes = levels[i].storedBytes;
+		levelHeader[i].bytes = levels[i].bytes;
+		levelHeader[i].width = levels[i].width;
+		levelHeader[i].height = levels[i].height;
+		offset = Align( offset + levels[i].storedBytes );
+	}
+
+	bool ok;
+	{
+		const char padding[c_levelAlignment] = { 0 };
+		vsFile file( filename, vsFile::MODE_Write );
+		file.WriteBytes( &header, sizeof(header) );
+		file.WriteBytes( levelHeader, sizeof(LevelHeader) * levels.ItemCount() );
+
+		size_t written = sizeof(header) + sizeof(LevelHeader) * levels.ItemCount();
+		for ( int i = 0; i < levels.ItemCount(); i++ )
+		{
+			file.WriteBytes( padding, levelHeader[i].offset - written );
+			file.WriteBytes( levels[i].data, levels[i].storedBytes );
+			written = levelHeader[i].offset + levels[i].storedBytes;
+		}
+		file.FlushBufferedWrites();
+		ok = !file.WriteFailed();
+	}
+	// (the finished file is only moved into place once 'file' is closed)
+	ok = ok && vsFile::Exists( filename );
+
+	size_t totalBytes = offset;
+	for ( int i = 0; i < levels.ItemCount(); i++ )
+		vsDeleteArray( levels[i].data );
+	vsDeleteArray( levelHeader );
+
+	if ( !ok )
+	{
+		vsLog( "vsCookedTexture:  Failed to write %s", filename );
+		return false;
+	}
+
+#ifdef _WIN32
+	vsLog( "vsCookedTexture:  Cooked %s (%dx%d, %d levels, %lu bytes)", filename, width, height, header.levelCount, totalBytes );
+#else
+	vsLog( "vsCookedTexture:  Cooked %s (%dx%d, %d levels, %zu bytes)", filename, width, height, header.levelCount, totalBytes );
+#endif
+	return true;
+}
+
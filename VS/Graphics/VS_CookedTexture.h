@@ -0,0 +1,146 @@
+/*
+ *  VS_CookedTexture.h
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#ifndef VS_COOKEDTEXTURE_H
+#define VS_COOKEDTEXTURE_H
+
+#include "VS/Utils/VS_Array.h"
+#include "VS/Utils/VS_String.h"
+
+class vsImage;
+class vsFloatImage;
+class vsMappedFile;
+
+// A cooked texture is a texture which has already been decoded and had its
+// whole mip chain built offline, so that loading it is just a matter of
+// mapping the file and handing each level straight to OpenGL.
+//
+// Cooked files live alongside their source image, with ".vstex" appended
+// to the source's filename (so "foo.png" cooks to "foo.png.vstex").  When
+// one exists, vsTextureInternal and vsTextureStreamer load it instead of the
+// source image.  Nothing checks whether the cooked file is older than its
+// source;  re-cook when the source changes!
+//
+// File layout (all values little-endian):
+//
+//    FileHeader
+//    LevelHeader[levelCount]		-- largest level first
+//    level data					-- each level starts on a 16 byte boundary
+//
+// Level data is rows of RGBA8 or RGBA16F pixels, bottom row first, just as
+// glTexImage2D wants it.  If the file was cooked with compression, each
+// level is a separate zlib stream, and levels are inflated into memory as
+// the file is opened.  Uncompressed levels are used straight from the
+// mapped file, without being copied.
+
+class vsCookedTexture
+{
+public:
+
+	enum Format
+	{
+		Format_RGBA8,
+		Format_RGBA16F,
+
+		Format_MAX
+	};
+
+private:
+
+	struct FileHeader
+	{
+		char		magic[4];		// "VSTX"
+		uint32_t	version;
+		uint32_t	format;
+		uint32_t	flags;
+		uint32_t	width;
+		uint32_t	height;
+		uint32_t	levelCount;
+		uint32_t	reserved;
+	};
+
+	struct LevelHeader
+	{
+		uint64_t	offset;			// from the start of the file
+		uint64_t	storedBytes;	// size in the file
+		uint64_t	bytes;			// size once inflated
+		uint32_t	width;
+		uint32_t	height;
+	};
+
+	enum
+	{
+		Flag_Compressed = BIT(0)
+	};
+
+	static const uint32_t c_version = 1;
+
+	struct Level
+	{
+		const char *	data;
+		size_t			bytes;
+		int				width;
+		int				height;
+		char *			inflated;	// owned by us, if the level was compressed
+	};
+
+	vsMappedFile *	m_file;
+	vsArray<Level>	m_level;
+	Format			m_format;
+	int				m_width;
+	int				m_height;
+	size_t			m_totalBytes;
+	bool			m_ok;
+
+	bool			Load();
+	void			Unload();
+
+	static bool		Write( const vsString &filename, Format format, const float *rgba, int width, int height, bool compress );
+
+	vsCookedTexture( const vsCookedTexture& other ) = delete;
+	vsCookedTexture& operator=( const vsCookedTexture& other ) = delete;
+
+public:
+
+	static vsString	GetCookedFilename( const vsString &sourceFilename );
+
+	// Returns the cooked version of 'sourceFilename' if there's a valid one,
+	// or nullptr if not.  The caller must delete it.
+	static vsCookedTexture *	OpenFor( const vsString &sourceFilename );
+
+	// Opens and validates a cooked file, logging and leaving IsOK() false if
+	// anything's wrong with it.  Safe to do on any thread.
+	vsCookedTexture( const vsString &filename );
+	~vsCookedTexture();
+
+	bool		IsOK() const { return m_ok; }
+
+	Format		GetFormat() const { return m_format; }
+	int			GetWidth() const { return m_width; }
+	int			GetHeight() const { return m_height; }
+	int			GetLevelCount() const { return m_level.ItemCount(); }
+	size_t		GetTotalBytes() const { return m_totalBytes; }	// pixel data across all levels
+
+	// Creates a GL texture from all our levels, and returns its name.  Needs a
+	// GL context;  either the main one or the loading one.
+	uint32_t	Upload() const;
+
+	// Cooking.  These build the full mip chain on the CPU (box filtering
+	// down to 1x1) and write it out to 'filename', returning false if we
+	// couldn't.  vsImages cook to RGBA8, vsFloatImages to RGBA16F.
+	static bool	Cook( const vsImage &image, const vsString &filename, bool compress = false );
+	static bool	Cook( const vsFloatImage &image, const vsString &filename, bool compress = false );
+
+	// Cooks the image file 'sourceFilename' to GetCookedFilename(sourceFilename),
+	// for use by offline tools (build with VS_TOOL).
+	static bool	CookFile( const vsString &sourceFilename, Format format = Format_RGBA8, bool compress = false );
+};
+
+#endif // VS_COOKEDTEXTURE_H
+
@@ -124,7 +124,7 @@ vsDisplayList::GetOpCodeString( OpCode code )
 vsDisplayList *
 vsDisplayList::Load_Vec( const vsString &filename )
 {
-	vsDisplayList *loader = new vsDisplayList(1024 * 50);	// 50k should be enough to load in just about anything.  (famous  last words)
+	vsDisplayList *loader = new vsDisplayList(1024 * 50, true);	// 50k should be enough to load in just about anything.  (famous  last words)
 
 	vsFile *file = new vsFile(filename + vsString(".vec"));
 	vsRecord r;
@@ -155,7 +155,7 @@ vsDisplayList::Load_Vec( const vsString &filename )
 vsDisplayList *
 vsDisplayList::Load_Vec( vsRecord *record )
 {
-	vsDisplayList *loader = new vsDisplayList(1024 * 50);	// 50k should be enough to load in just about anything.  (famous  last words)
+	vsDisplayList *loader = new vsDisplayList(1024 * 50, true);	// 50k should be enough to load in just about anything.  (famous  last words)
 
 	for( int i = 0; i < record->GetChildCount(); i++ )
 	{
@@ -341,7 +341,7 @@ vsDisplayList::Load_Obj( const vsString &filename )
 {
 	int vertCount = 0;
 	int faceIndexCount = 0;
-	vsDisplayList *loader = new vsDisplayList(1024 * 200);	// 50k should be enough to load in just about anything.  (famous  last words)
+	vsDisplayList *loader = new vsDisplayList(1024 * 200, true);	// 50k should be enough to load in just about anything.  (famous  last words)
 
 	vsFile *file = new vsFile(filename + vsString(".obj"));
 	vsRecord r;
@@ -398,6 +398,8 @@ vsDisplayList::Load_Obj( const vsString &filename )
 	return result;
 }
 /*
+// [NOTE] .cvec files are now written in network order (see SerialiseOp), so
+// this would need to decode them rather than loading them straight into our fifo.
 vsDisplayList *
 vsDisplayList::Load_CVec( const vsString &filename )
 {
@@ -411,12 +413,135 @@ vsDisplayList::Load_CVec( const vsString &filename )
 	return result;
 }*/
 
+// Writes an op in our portable, network-order format, for .cvec files.
+static void
+SerialiseOp( vsStore *s, vsDisplayList::op *o )
+{
+	vsDisplayList::Data &data = o->data;
+	s->WriteUint8( o->type );
+
+	switch( o->type )
+	{
+		case vsDisplayList::OpCode_SetColor:
+		case vsDisplayList::OpCode_ClearRenderTargetColor:
+			s->WriteColor( data.color );
+			break;
+		case vsDisplayList::OpCode_SetLinear:
+			s->WriteUint8( data.i );
+			break;
+		case vsDisplayList::OpCode_SetColors:
+		case vsDisplayList::OpCode_SetMatrices4x4:
+			s->WriteUint32( data.i );
+			s->WriteVoidStar( data.p );
+			break;
+		case vsDisplayList::OpCode_PushTranslation:
+			s->WriteVector3D( data.vector );
+			break;
+		case vsDisplayList::OpCode_VertexArray:
+		case vsDisplayList::OpCode_NormalArray:
+			s->WriteUint32( data.i );
+			for ( uint32_t i = 0; i < data.i; i++ )
+				s->WriteVector3D( ((vsVector3D*)data.p)[i] );
+			break;
+		case vsDisplayList::OpCode_TexelArray:
+			s->WriteUint32( data.i );
+			for ( uint32_t i = 0; i < data.i; i++ )
+				s->WriteVector2D( ((vsVector2D*)data.p)[i] );
+			break;
+		case vsDisplayList::OpCode_ColorArray:
+			s->WriteUint32( data.i );
+			for ( uint32_t i = 0; i < data.i; i++ )
+				s->WriteColor( ((vsColor*)data.p)[i] );
+			break;
+		case vsDisplayList::OpCode_LineListArray:
+		case vsDisplayList::OpCode_LineStripArray:
+		case vsDisplayList::OpCode_TriangleListArray:
+		case vsDisplayList::OpCode_TriangleStripArray:
+		case vsDisplayList::OpCode_TriangleFanArray:
+		case vsDisplayList::OpCode_PointsArray:
+			s->WriteUint32( data.i );
+			for ( uint32_t i = 0; i < data.i; i++ )
+				s->WriteUint16( ((uint16_t*)data.p)[i] );
+			break;
+		case vsDisplayList::OpCode_SetShaderValues:
+		case vsDisplayList::OpCode_SetColorsBuffer:
+		case vsDisplayList::OpCode_VertexBuffer:
+		case vsDisplayList::OpCode_NormalBuffer:
+		case vsDisplayList::OpCode_TexelBuffer:
+		case vsDisplayList::OpCode_ColorBuffer:
+		case vsDisplayList::OpCode_BindBuffer:
+		case vsDisplayList::OpCode_UnbindBuffer:
+		case vsDisplayList::OpCode_LineListBuffer:
+		case vsDisplayList::OpCode_LineStripBuffer:
+		case vsDisplayList::OpCode_TriangleStripBuffer:
+		case vsDisplayList::OpCode_TriangleListBuffer:
+		case vsDisplayList::OpCode_TriangleFanBuffer:
+		case vsDisplayList::OpCode_SetMatrices4x4Buffer:
+		case vsDisplayList::OpCode_SetMaterial:
+		case vsDisplayList::OpCode_SetRenderTarget:
+			s->WriteVoidStar( data.p );
+			break;
+		case vsDisplayList::OpCode_PushShaderOptions:
+			s->WriteUint32( data.shaderOptions.mask );
+			s->WriteUint32( data.shaderOptions.value );
+			break;
+		case vsDisplayList::OpCode_PushTransform:
+		case vsDisplayList::OpCode_SetCameraTransform:
+			s->WriteTransform2D( data.transform );
+			break;
+		case vsDisplayList::OpCode_PushMatrix4x4:
+		case vsDisplayList::OpCode_SetMatrix4x4:
+		case vsDisplayList::OpCode_SetWorldToViewMatrix4x4:
+		case vsDisplayList::OpCode_SetProjectionMatrix4x4:
+			s->WriteMatrix4x4( data.matrix4x4 );
+			break;
+		case vsDisplayList::OpCode_Set3DProjection:
+			s->WriteFloat( data.fov );
+			s->WriteFloat( data.nearPlane );
+			s->WriteFloat( data.farPlane );
+			break;
+		case vsDisplayList::OpCode_BlitRenderTarget:
+			s->WriteVoidStar( data.p );
+			s->WriteVoidStar( data.p2 );
+			break;
+		case vsDisplayList::OpCode_BlitRenderTargetRect:
+			s->WriteVoidStar( data.p );
+			s->WriteVoidStar( data.p2 );
+			s->WriteBox2D( data.box2D );
+			s->WriteBox2D( data.box2D2 );
+			break;
+		case vsDisplayList::OpCode_Light:
+			s->WriteLight( data.light );
+			break;
+		case vsDisplayList::OpCode_Fog:
+			s->WriteFog( data.fog );
+			break;
+		case vsDisplayList::OpCode_SetViewport:
+		case vsDisplayList::OpCode_EnableScissor:
+			s->WriteBox2D( data.box2D );
+			break;
+		case vsDisplayList::OpCode_Debug:
+			s->WriteString( data.string );
+			break;
+		default:
+			break;
+	}
+}
+
 void
 vsDisplayList::Write_CVec( const vsString &filename )
 {
+	// our in-memory command encoding is native-endian and full of padding;
+	// on disk we use the compact, network-order format instead.
+	vsStore serialised( GetSize() );
+	serialised.SetResizable();
+	Rewind();
+	for ( op *o = PopOp(); o; o = PopOp() )
+		SerialiseOp( &serialised, o );
+
 	vsFile *file = new vsFile(filename + vsString(".cvec"), vsFile::MODE_Write);
 
-	file->Store(m_fifo);
+	file->Store(&serialised);
 
 	vsDelete( file );
 }
@@ -469,6 +594,16 @@ vsDisplayList::vsDisplayList( size_t memSize, bool resizable ):
 	Clear();
 }
 
+vsDisplayList::vsDisplayList( char *buffer, size_t bufferLength ):
+	m_instanceParent(nullptr),
+	m_instanceCount(0),
+	m_materialCount(0),
+	m_colorSet(false)
+{
+	m_fifo = new vsStore(buffer, (int)bufferLength);
+	Clear();
+}
+
 void
 vsDisplayList::SetResizable()
 {
@@ -537,8 +672,7 @@ vsDisplayList::Rewind()
 void
 vsDisplayList::SetColor( const vsColor &color )
 {
-	m_fifo->WriteUint8( OpCode_SetColor );
-	m_fifo->WriteColor( color );
+	*_AddCommand<vsColor>( OpCode_SetColor ) = color;
 	m_nextLineColor = color;
 	m_colorSet = true;
 }
@@ -562,8 +696,7 @@ vsDisplayList::LineTo( const vsVector3D &pos )
 
 	if ( m_colorSet )
 	{
-		m_fifo->WriteUint8( OpCode_SetColor );
-		m_fifo->WriteColor( c_white );
+		*_AddCommand<vsColor>( OpCode_SetColor ) = c_white;
 
 		c[0] = m_cursorColor;
 		c[1] = m_nextLineColor;
@@ -620,8 +753,10 @@ vsDisplayList::DrawLine( const vsVector3D &from, const vsVector3D &to )
 void
 vsDisplayList::PushTransform( const vsTransform2D &t )
 {
-	m_fifo->WriteUint8( OpCode_PushTransform );
-	m_fifo->WriteTransform2D( t );
+	TransformData *d = _AddCommand<TransformData>( OpCode_PushTransform );
+	d->position = t.GetTranslation();
+	d->angle = t.GetAngle().Get();
+	d->scale = t.GetScale();
 //    PushMatrix4x4( t.GetMatrix() );
 }
 
@@ -641,142 +776,136 @@ vsDisplayList::PushTransform( const vsTransform3D &t )
 void
 vsDisplayList::PushMatrix4x4( const vsMatrix4x4 &m )
 {
-	m_fifo->WriteUint8( OpCode_PushMatrix4x4 );
-	m_fifo->WriteMatrix4x4( m );
+	*_AddCommand<vsMatrix4x4>( OpCode_PushMatrix4x4 ) = m;
 }
 
 void
 vsDisplayList::SetMatrix4x4( const vsMatrix4x4 &m )
 {
-	m_fifo->WriteUint8( OpCode_SetMatrix4x4 );
-	m_fifo->WriteMatrix4x4( m );
+	*_AddCommand<vsMatrix4x4>( OpCode_SetMatrix4x4 ) = m;
 }
 
 void
 vsDisplayList::SetMatrices4x4( const vsMatrix4x4 *m, int count )
 {
-	m_fifo->WriteUint8( OpCode_SetMatrices4x4 );
-	m_fifo->WriteUint32( count );
-	m_fifo->WriteVoidStar( (char*)m );
+	CountedPointerData *d = _AddCommand<CountedPointerData>( OpCode_SetMatrices4x4 );
+	d->p = (void*)m;
+	d->count = count;
 }
 
 void
 vsDisplayList::SetMatrices4x4Buffer( vsRenderBuffer *buffer )
 {
-	m_fifo->WriteUint8( OpCode_SetMatrices4x4Buffer );
-	m_fifo->WriteVoidStar( (char*)buffer );
+	_AddCommand<PointerData>( OpCode_SetMatrices4x4Buffer )->p = (void*)buffer;
 }
 
 void
 vsDisplayList::SetColors( const vsColor *c, int count )
 {
-	m_fifo->WriteUint8( OpCode_SetColors );
-	m_fifo->WriteUint32( count );
-	m_fifo->WriteVoidStar( (char*)c );
+	CountedPointerData *d = _AddCommand<CountedPointerData>( OpCode_SetColors );
+	d->p = (void*)c;
+	d->count = count;
 }
 
 void
 vsDisplayList::SetColorsBuffer( const vsRenderBuffer *b )
 {
-	m_fifo->WriteUint8( OpCode_SetColorsBuffer );
-	m_fifo->WriteVoidStar( (char*)b );
+	_AddCommand<PointerData>( OpCode_SetColorsBuffer )->p = (void*)b;
 }
 
 void
 vsDisplayList::SnapMatrix()
 {
-	m_fifo->WriteUint8( OpCode_SnapMatrix );
+	_AddCommand( OpCode_SnapMatrix, 0 );
 }
 
 void
 vsDisplayList::SetShaderValues( vsShaderValues *values )
 {
-	m_fifo->WriteUint8( OpCode_SetShaderValues );
-	m_fifo->WriteVoidStar( (char*)values );
+	_AddCommand<PointerData>( OpCode_SetShaderValues )->p = (void*)values;
 }
 
 void
 vsDisplayList::ClearShaderValues()
 {
-	m_fifo->WriteUint8( OpCode_ClearShaderValues );
+	_AddCommand( OpCode_ClearShaderValues, 0 );
 }
 
 void
 vsDisplayList::PushShaderOptions( const vsShaderOptions &options )
 {
-	m_fifo->WriteUint8( OpCode_PushShaderOptions );
-	m_fifo->WriteUint32( options.mask );
-	m_fifo->WriteUint32( options.value );
+	*_AddCommand<vsShaderOptions>( OpCode_PushShaderOptions ) = options;
 }
 
 void
 vsDisplayList::PopShaderOptions()
 {
-	m_fifo->WriteUint8( OpCode_PopShaderOptions );
+	_AddCommand( OpCode_PopShaderOptions, 0 );
 }
 
 void
 vsDisplayList::SetWorldToViewMatrix4x4( const vsMatrix4x4 &m )
 {
-	m_fifo->WriteUint8( OpCode_SetWorldToViewMatrix4x4 );
-	m_fifo->WriteMatrix4x4( m );
+	*_AddCommand<vsMatrix4x4>( OpCode_SetWorldToViewMatrix4x4 ) = m;
 }
 
 void
 vsDisplayList::PushTranslation( const vsVector3D &offset )
 {
-	m_fifo->WriteUint8( OpCode_PushTranslation );
-	m_fifo->WriteVector3D( offset );
+	*_AddCommand<vsVector3D>( OpCode_PushTranslation ) = offset;
 }
 
 void
 vsDisplayList::SetCameraTransform( const vsTransform2D &t )
 {
-	m_fifo->WriteUint8( OpCode_SetCameraTransform );
-	m_fifo->WriteTransform2D( t );
+	TransformData *d = _AddCommand<TransformData>( OpCode_SetCameraTransform );
+	d->position = t.GetTranslation();
+	d->angle = t.GetAngle().Get();
+	d->scale = t.GetScale();
 }
 
 void
 vsDisplayList::Set3DProjection( float fov, float nearPlane, float farPlane )
 {
-	m_fifo->WriteUint8( OpCode_Set3DProjection );
-	m_fifo->WriteFloat(fov);
-	m_fifo->WriteFloat(nearPlane);
-	m_fifo->WriteFloat(farPlane);
+	ProjectionData *d = _AddCommand<ProjectionData>( OpCode_Set3DProjection );
+	d->fov = fov;
+	d->nearPlane = nearPlane;
+	d->farPlane = farPlane;
 }
 
 void
 vsDisplayList::SetProjectionMatrix4x4( const vsMatrix4x4 &m )
 {
-	m_fifo->WriteUint8( OpCode_SetProjectionMatrix4x4 );
-	m_fifo->WriteMatrix4x4( m );
+	*_AddCommand<vsMatrix4x4>( OpCode_SetProjectionMatrix4x4 ) = m;
 }
 
 void
 vsDisplayList::PopTransform()
 {
-	m_fifo->WriteUint8( OpCode_PopTransform );
+	_AddCommand( OpCode_PopTransform, 0 );
 }
 
 void
 vsDisplayList::VertexArray( const vsVector2D *array, int arrayCount )
 {
-	m_fifo->WriteUint8( OpCode_VertexArray );
-	m_fifo->WriteUint32( arrayCount );
+	ArrayData *d = _AddCommand<ArrayData>( OpCode_VertexArray, sizeof(vsVector3D) * arrayCount );
+	d->count = arrayCount;
+	vsVector3D *v = reinterpret_cast<vsVector3D*>( d->Elements() );
 	for ( int i = 0; i < arrayCount; i++ )
 	{
-		m_fifo->WriteVector3D( array[i] );
+		v[i] = array[i];
 	}
 }
 
 void
 vsDisplayList::VertexArray( const vsVector3D *array, int arrayCount )
 {
-	m_fifo->WriteUint8( OpCode_VertexArray );
-	m_fifo->WriteUint32( arrayCount );
+	ArrayData *d = _AddCommand<ArrayData>( OpCode_VertexArray, sizeof(vsVector3D) * arrayCount );
+	d->count = arrayCount;
+	vsVector3D *v = reinterpret_cast<vsVector3D*>( d->Elements() );
 	for ( int i = 0; i < arrayCount; i++ )
 	{
-		m_fifo->WriteVector3D( array[i] );
+		v[i] = array[i];
 	}
 }
 
@@ -786,19 +915,15 @@ vsDisplayList::VertexBuffer( vsRenderBuffer *buffer )
 	vsAssert(buffer->GetContentType() == vsRenderBuffer::ContentType_Custom ||
 			buffer->GetContentType() == vsRenderBuffer::ContentType_P,
 			"Known render buffer types should use ::BindBuffer");
-	m_fifo->WriteUint8( OpCode_VertexBuffer );
-	m_fifo->WriteVoidStar( buffer );
+	_AddCommand<PointerData>( OpCode_VertexBuffer )->p = (void*)buffer;
 }
 
 void
 vsDisplayList::NormalArray( const vsVector3D *array, int arrayCount )
 {
-	m_fifo->WriteUint8( OpCode_NormalArray );
-	m_fifo->WriteUint32( arrayCount );
-	for ( int i = 0; i < arrayCount; i++ )
-	{
-		m_fifo->WriteVector3D( array[i] );
-	}
+	ArrayData *d = _AddCommand<ArrayData>( OpCode_NormalArray, sizeof(vsVector3D) * arrayCount );
+	d->count = arrayCount;
+	memcpy( d->Elements(), array, sizeof(vsVector3D) * arrayCount );
 }
 
 void
@@ -806,8 +931,7 @@ vsDisplayList::NormalBuffer( vsRenderBuffer *buffer )
 {
 	vsAssert(buffer->GetContentType() == vsRenderBuffer::ContentType_Custom,
 			"Non-custom render buffer types should use ::BindBuffer");
-	m_fifo->WriteUint8( OpCode_NormalBuffer );
-	m_fifo->WriteVoidStar( buffer );
+	_AddCommand<PointerData>( OpCode_NormalBuffer )->p = (void*)buffer;
 }
 
 void
@@ -815,8 +939,7 @@ vsDisplayList::TexelBuffer( vsRenderBuffer *buffer )
 {
 	vsAssert(buffer->GetContentType() == vsRenderBuffer::ContentType_Custom,
 			"Non-custom render buffer types should use ::BindBuffer");
-	m_fifo->WriteUint8( OpCode_TexelBuffer );
-	m_fifo->WriteVoidStar( buffer );
+	_AddCommand<PointerData>( OpCode_TexelBuffer )->p = (void*)buffer;
 }
 
 void
@@ -824,222 +947,169 @@ vsDisplayList::ColorBuffer( vsRenderBuffer *buffer )
 {
 	vsAssert(buffer->GetContentType() == vsRenderBuffer::ContentType_Custom,
 			"Non-custom render buffer types should use ::BindBuffer");
-	m_fifo->WriteUint8( OpCode_ColorBuffer );
-	m_fifo->WriteVoidStar( buffer );
+	_AddCommand<PointerData>( OpCode_ColorBuffer )->p = (void*)buffer;
 }
 
 void
 vsDisplayList::BindBuffer( vsRenderBuffer *buffer )
 {
-	m_fifo->WriteUint8( OpCode_BindBuffer );
-	m_fifo->WriteVoidStar( buffer );
+	_AddCommand<PointerData>( OpCode_BindBuffer )->p = (void*)buffer;
 }
 
 void
 vsDisplayList::UnbindBuffer( vsRenderBuffer *buffer )
 {
-	m_fifo->WriteUint8( OpCode_UnbindBuffer );
-	m_fifo->WriteVoidStar( buffer );
+	_AddCommand<PointerData>( OpCode_UnbindBuffer )->p = (void*)buffer;
 }
 
 void
 vsDisplayList::SetLinear( bool linear )
 {
-	m_fifo->WriteUint8( OpCode_SetLinear );
-	m_fifo->WriteUint8( linear );
+	*_AddCommand<uint32_t>( OpCode_SetLinear ) = linear;
 }
 
 void
 vsDisplayList::ClearVertexArray(  )
 {
-	m_fifo->WriteUint8( OpCode_ClearVertexArray );
+	_AddCommand( OpCode_ClearVertexArray, 0 );
 }
 
 void
 vsDisplayList::ClearNormalArray(  )
 {
-	m_fifo->WriteUint8( OpCode_ClearNormalArray );
+	_AddCommand( OpCode_ClearNormalArray, 0 );
 }
 
 void
 vsDisplayList::ClearTexelArray(  )
 {
-	m_fifo->WriteUint8( OpCode_ClearTexelArray );
+	_AddCommand( OpCode_ClearTexelArray, 0 );
 }
 
 void
 vsDisplayList::ClearColorArray(  )
 {
-	m_fifo->WriteUint8( OpCode_ClearColorArray );
+	_AddCommand( OpCode_ClearColorArray, 0 );
 }
 
 void
 vsDisplayList::ClearArrays()
 {
-	m_fifo->WriteUint8( OpCode_ClearArrays );
+	_AddCommand( OpCode_ClearArrays, 0 );
 }
 
 void
 vsDisplayList::TexelArray( const vsVector2D *array, int arrayCount )
 {
-	m_fifo->WriteUint8( OpCode_TexelArray );
-	m_fifo->WriteUint32( arrayCount );
-	for ( int i = 0; i < arrayCount; i++ )
-	{
-		m_fifo->WriteVector2D( array[i] );
-	}
+	ArrayData *d = _AddCommand<ArrayData>( OpCode_TexelArray, sizeof(vsVector2D) * arrayCount );
+	d->count = arrayCount;
+	memcpy( d->Elements(), array, sizeof(vsVector2D) * arrayCount );
 }
 
 void
 vsDisplayList::ColorArray( const vsColor *array, int arrayCount )
 {
-	m_fifo->WriteUint8( OpCode_ColorArray );
-	m_fifo->WriteUint32( arrayCount );
+	ArrayData *d = _AddCommand<ArrayData>( OpCode_ColorArray, sizeof(vsColor) * arrayCount );
+	d->count = arrayCount;
+	memcpy( d->Elements(), array, sizeof(vsColor) * arrayCount );
 	m_colorSet = true;
-	for ( int i = 0; i < arrayCount; i++ )
-	{
-		m_fifo->WriteColor( array[i] );
-	}
 }
 
 void
 vsDisplayList::LineListArray( int *idArray, int vertexCount )
 {
-	m_fifo->WriteUint8( OpCode_LineListArray );
-	m_fifo->WriteUint32( vertexCount );
-	for ( int i = 0; i < vertexCount; i++ )
-	{
-		m_fifo->WriteUint16Native( idArray[i] );
-	}
+	_AddIndexArray( OpCode_LineListArray, idArray, vertexCount );
 }
 
 void
 vsDisplayList::LineStripArray( uint16_t *idArray, int vertexCount )
 {
-	m_fifo->WriteUint8( OpCode_LineStripArray );
-	m_fifo->WriteUint32( vertexCount );
-	for ( int i = 0; i < vertexCount; i++ )
-	{
-		m_fifo->WriteUint16Native( idArray[i] );
-	}
+	_AddIndexArray( OpCode_LineStripArray, idArray, vertexCount );
 }
 
 void
 vsDisplayList::LineStripArray( int *idArray, int vertexCount )
 {
-	m_fifo->WriteUint8( OpCode_LineStripArray );
-	m_fifo->WriteUint32( vertexCount );
-	for ( int i = 0; i < vertexCount; i++ )
-	{
-		m_fifo->WriteUint16Native( idArray[i] );
-	}
+	_AddIndexArray( OpCode_LineStripArray, idArray, vertexCount );
 }
 
 void
 vsDisplayList::TriangleListArray( int *idArray, int vertexCount )
 {
-	m_fifo->WriteUint8( OpCode_TriangleListArray );
-	m_fifo->WriteUint32( vertexCount );
-	for ( int i = 0; i < vertexCount; i++ )
-	{
-		m_fifo->WriteUint16Native( idArray[i] );
-	}
+	_AddIndexArray( OpCode_TriangleListArray, idArray, vertexCount );
 }
 
 void
 vsDisplayList::TriangleStripArray( int *idArray, int vertexCount )
 {
-	m_fifo->WriteUint8( OpCode_TriangleStripArray );
-	m_fifo->WriteUint32( vertexCount );
-	for ( int i = 0; i < vertexCount; i++ )
-	{
-		m_fifo->WriteUint16Native( idArray[i] );
-	}
+	_AddIndexArray( OpCode_TriangleStripArray, idArray, vertexCount );
 }
 
 void
 vsDisplayList::TriangleStripBuffer( vsRenderBuffer *buffer )
 {
-	m_fifo->WriteUint8( OpCode_TriangleStripBuffer );
-	m_fifo->WriteVoidStar(buffer);
+	_AddCommand<PointerData>( OpCode_TriangleStripBuffer )->p = (void*)buffer;
 }
 
 void
 vsDisplayList::TriangleListBuffer( vsRenderBuffer *buffer )
 {
-	m_fifo->WriteUint8( OpCode_TriangleListBuffer );
-	m_fifo->WriteVoidStar(buffer);
+	_AddCommand<PointerData>( OpCode_TriangleListBuffer )->p = (void*)buffer;
 }
 
 void
 vsDisplayList::TriangleFanBuffer( vsRenderBuffer *buffer )
 {
-	m_fifo->WriteUint8( OpCode_TriangleFanBuffer );
-	m_fifo->WriteVoidStar(buffer);
+	_AddCommand<PointerData>( OpCode_TriangleFanBuffer )->p = (void*)buffer;
 }
 
 void
 vsDisplayList::LineListBuffer( vsRenderBuffer *buffer )
 {
-	m_fifo->WriteUint8( OpCode_LineListBuffer );
-	m_fifo->WriteVoidStar(buffer);
+	_AddCommand<PointerData>( OpCode_LineListBuffer )->p = (void*)buffer;
 }
 
 void
 vsDisplayList::LineStripBuffer( vsRenderBuffer *buffer )
 {
-	m_fifo->WriteUint8( OpCode_LineStripBuffer );
-	m_fifo->WriteVoidStar(buffer);
+	_AddCommand<PointerData>( OpCode_LineStripBuffer )->p = (void*)buffer;
 }
 
 void
 vsDisplayList::PointsArray( int *idArray, int vertexCount )
 {
-	m_fifo->WriteUint8( OpCode_PointsArray );
-	m_fifo->WriteUint32( vertexCount );
-	for ( int i = 0; i < vertexCount; i++ )
-	{
-		m_fifo->WriteUint16Native( idArray[i] );
-	}
+	_AddIndexArray( OpCode_PointsArray, idArray, vertexCount );
 }
 
 void
 vsDisplayList::TriangleFanArray( int *idArray, int vertexCount )
 {
-	m_fifo->WriteUint8( OpCode_TriangleFanArray );
-	m_fifo->WriteUint32( vertexCount );
-	for ( int i = 0; i < vertexCount; i++ )
-	{
-		m_fifo->WriteUint16Native( idArray[i] );
-	}
+	_AddIndexArray( OpCode_TriangleFanArray, idArray, vertexCount );
 }
 
 void
 vsDisplayList::SetMaterial( vsMaterial *material )
 {
-	m_fifo->WriteUint8( OpCode_SetMaterial );
-	m_fifo->WriteVoidStar( material );
+	_AddCommand<PointerData>( OpCode_SetMaterial )->p = (void*)material;
 }
 
 
 void
 vsDisplayList::SetRenderTarget( vsRenderTarget *target )
 {
-	m_fifo->WriteUint8( OpCode_SetRenderTarget );
-	m_fifo->WriteVoidStar( target );
+	_AddCommand<PointerData>( OpCode_SetRenderTarget )->p = (void*)target;
 }
 
 void
 vsDisplayList::ClearRenderTarget()
 {
-	m_fifo->WriteUint8( OpCode_ClearRenderTarget );
+	_AddCommand( OpCode_ClearRenderTarget, 0 );
 }
 
 void
 vsDisplayList::ClearRenderTargetColor( const vsColor& c )
 {
-	m_fifo->WriteUint8( OpCode_ClearRenderTargetColor );
-	m_fifo->WriteColor( c );
+	*_AddCommand<vsColor>( OpCode_ClearRenderTargetColor ) = c;
 }
 
 void
@@ -1054,116 +1124,162 @@ vsDisplayList::ResolveRenderTarget( vsRenderTarget *target )
 void
 vsDisplayList::BlitRenderTarget( vsRenderTarget *from, vsRenderTarget *to )
 {
-	m_fifo->WriteUint8( OpCode_BlitRenderTarget );
-	m_fifo->WriteVoidStar( from );
-	m_fifo->WriteVoidStar( to );
+	PointerPairData *d = _AddCommand<PointerPairData>( OpCode_BlitRenderTarget );
+	d->p = from;
+	d->p2 = to;
 }
 
 void
 vsDisplayList::BlitRenderTargetRect( vsRenderTarget *from, vsRenderTarget *to, const vsBox2D& fromRect, const vsBox2D& toRect )
 {
-	m_fifo->WriteUint8( OpCode_BlitRenderTargetRect );
-	m_fifo->WriteVoidStar( from );
-	m_fifo->WriteVoidStar( to );
-	m_fifo->WriteVector2D( fromRect.GetMin() );
-	m_fifo->WriteVector2D( fromRect.GetMax() );
-	m_fifo->WriteVector2D( toRect.GetMin() );
-	m_fifo->WriteVector2D( toRect.GetMax() );
+	BlitRectData *d = _AddCommand<BlitRectData>( OpCode_BlitRenderTargetRect );
+	d->from = from;
+	d->to = to;
+	d->fromRect.min = fromRect.GetMin();
+	d->fromRect.max = fromRect.GetMax();
+	d->toRect.min = toRect.GetMin();
+	d->toRect.max = toRect.GetMax();
 }
 
 void
 vsDisplayList::Light( const vsLight &light )
 {
-	m_fifo->WriteUint8( OpCode_Light );
-	m_fifo->WriteLight( light );
+	LightData *d = _AddCommand<LightData>( OpCode_Light );
+	d->type = light.GetType();
+	d->position = light.GetPosition();
+	d->direction = light.GetDirection();
+	d->color = light.GetColor();
+	d->ambient = light.GetAmbientColor();
+	d->specular = light.GetSpecularColor();
 }
 
 void
 vsDisplayList::ClearLights()
 {
-	m_fifo->WriteUint8( OpCode_ClearLights );
+	_AddCommand( OpCode_ClearLights, 0 );
 }
 
 void
 vsDisplayList::Fog( const vsFog &fog )
 {
-	m_fifo->WriteUint8( OpCode_Fog );
-	m_fifo->WriteFog( fog );
+	FogData *d = _AddCommand<FogData>( OpCode_Fog );
+	d->color = fog.GetColor();
+	d->linear = fog.IsLinear();
+	d->density = fog.GetDensity();
+	d->start = fog.GetStart();
+	d->end = fog.GetEnd();
 }
 
 void
 vsDisplayList::ClearFog()
 {
-	m_fifo->WriteUint8( OpCode_ClearFog );
+	_AddCommand( OpCode_ClearFog, 0 );
 }
 
 void
 vsDisplayList::FlatShading()
 {
-	m_fifo->WriteUint8( OpCode_FlatShading );
+	_AddCommand( OpCode_FlatShading, 0 );
 }
 
 void
 vsDisplayList::SmoothShading()
 {
-	m_fifo->WriteUint8( OpCode_SmoothShading );
+	_AddCommand( OpCode_SmoothShading, 0 );
 }
 
 void
 vsDisplayList::EnableStencil()
 {
-	m_fifo->WriteUint8( OpCode_EnableStencil );
+	_AddCommand( OpCode_EnableStencil, 0 );
 }
 
 void
 vsDisplayList::DisableStencil()
 {
-	m_fifo->WriteUint8( OpCode_DisableStencil );
+	_AddCommand( OpCode_DisableStencil, 0 );
 }
 
 void
 vsDisplayList::EnableScissor( const vsBox2D& box )
 {
-	m_fifo->WriteUint8( OpCode_EnableScissor );
-	m_fifo->WriteBox2D( box );
+	BoxData *d = _AddCommand<BoxData>( OpCode_EnableScissor );
+	d->min = box.GetMin();
+	d->max = box.GetMax();
 }
 
 void
 vsDisplayList::DisableScissor()
 {
-	m_fifo->WriteUint8( OpCode_DisableScissor );
+	_AddCommand( OpCode_DisableScissor, 0 );
 }
 
 void
 vsDisplayList::ClearStencil()
 {
-	m_fifo->WriteUint8( OpCode_ClearStencil );
+	_AddCommand( OpCode_ClearStencil, 0 );
 }
 
 void
 vsDisplayList::ClearDepth()
 {
-	m_fifo->WriteUint8( OpCode_ClearDepth );
+	_AddCommand( OpCode_ClearDepth, 0 );
 }
 
 void
 vsDisplayList::SetViewport( const vsBox2D &box )
 {
-	m_fifo->WriteUint8( OpCode_SetViewport );
-	m_fifo->WriteBox2D( box );
+	BoxData *d = _AddCommand<BoxData>( OpCode_SetViewport );
+	d->min = box.GetMin();
+	d->max = box.GetMax();
 }
 
 void
 vsDisplayList::ClearViewport()
 {
-	m_fifo->WriteUint8( OpCode_ClearViewport );
+	_AddCommand( OpCode_ClearViewport, 0 );
 }
 
 void
 vsDisplayList::Debug(const vsString &string )
 {
-	m_fifo->WriteUint8( OpCode_Debug );
-	m_fifo->WriteString(string);
+	ArrayData *d = _AddCommand<ArrayData>( OpCode_Debug, string.size() );
+	d->count = (uint32_t)string.size();
+	memcpy( d->Elements(), string.c_str(), string.size() );
+}
+
+char *
+vsDisplayList::_AddCommand( OpCode type, size_t payloadSize, size_t arraySize )
+{
+	const size_t mask = c_commandAlignment - 1;
+	size_t payloadBytes = (payloadSize + mask) & ~mask;
+	size_t arrayBytes = (arraySize + mask) & ~mask;
+	size_t size = sizeof(Command) + payloadBytes + arrayBytes;
+
+	Command *command = reinterpret_cast<Command*>( m_fifo->ReserveForWriting( size ) );
+	command->type = (uint8_t)type;
+	command->size = (uint32_t)size;
+	return reinterpret_cast<char*>(command + 1);
+}
+
+void
+vsDisplayList::_AddIndexArray( OpCode type, const int *idArray, int vertexCount )
+{
+	ArrayData *d = _AddCommand<ArrayData>( type, sizeof(uint16_t) * vertexCount );
+	d->count = vertexCount;
+	uint16_t *indices = reinterpret_cast<uint16_t*>( d->Elements() );
+	for ( int i = 0; i < vertexCount; i++ )
+	{
+		indices[i] = (uint16_t)idArray[i];
+	}
+}
+
+void
+vsDisplayList::_AddIndexArray( OpCode type, const uint16_t *idArray, int vertexCount )
+{
+	ArrayData *d = _AddCommand<ArrayData>( type, sizeof(uint16_t) * vertexCount );
+	d->count = vertexCount;
+	memcpy( d->Elements(), idArray, sizeof(uint16_t) * vertexCount );
 }
 
 vsDisplayList::OpCode
@@ -1178,233 +1294,163 @@ vsDisplayList::PeekOpType()
 	return result;
 }
 
-static vsColor		s_color;
-static vsVector2D	s_vector;
-static vsVector3D	s_vector3d;
-static vsTransform2D	s_transform;
+const vsDisplayList::Command *
+vsDisplayList::PopCommand()
+{
+	if ( m_fifo->AtEnd() )
+		return nullptr;
+
+	const Command *command = reinterpret_cast<const Command*>( m_fifo->GetReadHead() );
+	m_fifo->AdvanceReadHead( command->size );
+	return command;
+}
 
 vsDisplayList::op *
 vsDisplayList::PopOp()
 {
-	if ( !m_fifo->AtEnd() )
-	{
-		m_currentOp.type = (OpCode)m_fifo->ReadUint8();
+	const Command *command = PopCommand();
+	if ( !command )
+		return nullptr;
 
-		switch( m_currentOp.type )
-		{
-			case OpCode_SetColor:
-			case OpCode_ClearRenderTargetColor:
-				m_fifo->ReadColor(&m_currentOp.data.color);
-				break;
-			case OpCode_SetLinear:
-				{
-					m_currentOp.data.i = m_fifo->ReadUint8();
-				}
-				break;
-			case OpCode_SetColors:
-				{
-					int count = m_fifo->ReadUint32();
-					m_currentOp.data.Set( count );
-					m_currentOp.data.SetPointer( (char*)m_fifo->ReadVoidStar() );
-					break;
-				}
-			case OpCode_PushTranslation:
-				m_fifo->ReadVector3D(&m_currentOp.data.vector);
-				break;
-			case OpCode_VertexArray:
-			{
-				int count = m_fifo->ReadUint32();
-				m_currentOp.data.Set( count );
-				m_currentOp.data.SetPointer( m_fifo->GetReadHead() );
-
-				m_fifo->AdvanceReadHead( sizeof(s_vector3d) * count );
-				//for ( int i = 0; i < count; i++ )
-				//	m_fifo->ReadVector3D(&s_vector3d);
+	m_currentOp.type = command->GetType();
+	Data &data = m_currentOp.data;
 
+	switch( m_currentOp.type )
+	{
+		case OpCode_SetColor:
+		case OpCode_ClearRenderTargetColor:
+			data.color = command->Payload<vsColor>();
+			break;
+		case OpCode_SetLinear:
+			data.i = command->Payload<uint32_t>();
+			break;
+		case OpCode_SetColors:
+		case OpCode_SetMatrices4x4:
+			{
+				const CountedPointerData &d = command->Payload<CountedPointerData>();
+				data.Set( d.count );
+				data.SetPointer( (char*)d.p );
 				break;
 			}
-			case OpCode_NormalArray:
+		case OpCode_PushTranslation:
+			data.vector = command->Payload<vsVector3D>();
+			break;
+		case OpCode_VertexArray:
+		case OpCode_NormalArray:
+		case OpCode_TexelArray:
+		case OpCode_ColorArray:
+		case OpCode_LineListArray:
+		case OpCode_LineStripArray:
+		case OpCode_TriangleListArray:
+		case OpCode_TriangleStripArray:
+		case OpCode_TriangleFanArray:
+		case OpCode_PointsArray:
 			{
-				int count = m_fifo->ReadUint32();
-				m_currentOp.data.Set( count );
-				m_currentOp.data.SetPointer( m_fifo->GetReadHead() );
-
-				m_fifo->AdvanceReadHead( sizeof(s_vector3d) * count );
-//				for ( int i = 0; i < count; i++ )
-//					m_fifo->ReadVector3D(&s_vector3d);
-
+				// point straight at the array data inside our fifo, so callers
+				// like ApplyOffset() can modify it in place.
+				const ArrayData &d = command->Payload<ArrayData>();
+				data.Set( d.count );
+				data.SetPointer( const_cast<char*>( d.Elements() ) );
 				break;
 			}
-			case OpCode_SetShaderValues:
-			case OpCode_SetColorsBuffer:
-			case OpCode_VertexBuffer:
-			case OpCode_NormalBuffer:
-			case OpCode_TexelBuffer:
-			case OpCode_ColorBuffer:
-			case OpCode_BindBuffer:
-			case OpCode_UnbindBuffer:
+		case OpCode_SetShaderValues:
+		case OpCode_SetColorsBuffer:
+		case OpCode_VertexBuffer:
+		case OpCode_NormalBuffer:
+		case OpCode_TexelBuffer:
+		case OpCode_ColorBuffer:
+		case OpCode_BindBuffer:
+		case OpCode_UnbindBuffer:
+		case OpCode_LineListBuffer:
+		case OpCode_LineStripBuffer:
+		case OpCode_TriangleStripBuffer:
+		case OpCode_TriangleListBuffer:
+		case OpCode_TriangleFanBuffer:
+		case OpCode_SetMatrices4x4Buffer:
+		case OpCode_SetMaterial:
+		case OpCode_SetRenderTarget:
+			data.SetPointer( (char*)command->Payload<PointerData>().p );
+			break;
+		case OpCode_PushShaderOptions:
+			data.shaderOptions = command->Payload<vsShaderOptions>();
+			break;
+		case OpCode_PushTransform:
+		case OpCode_SetCameraTransform:
 			{
-				m_currentOp.data.SetPointer( (char *)m_fifo->ReadVoidStar() );
+				const TransformData &d = command->Payload<TransformData>();
+				data.transform.SetTranslation( d.position );
+				data.transform.SetAngle( d.angle );
+				data.transform.SetScale( d.scale );
 				break;
 			}
-			case OpCode_PushShaderOptions:
+		case OpCode_PushMatrix4x4:
+		case OpCode_SetMatrix4x4:
+		case OpCode_SetWorldToViewMatrix4x4:
+		case OpCode_SetProjectionMatrix4x4:
+			data.matrix4x4 = command->Payload<vsMatrix4x4>();
+			break;
+		case OpCode_Set3DProjection:
 			{
-				m_currentOp.data.shaderOptions.mask = m_fifo->ReadInt32();
-				m_currentOp.data.shaderOptions.value = m_fifo->ReadInt32();
+				const ProjectionData &d = command->Payload<ProjectionData>();
+				data.fov = d.fov;
+				data.nearPlane = d.nearPlane;
+				data.farPlane = d.farPlane;
 				break;
 			}
-			case OpCode_TexelArray:
+		case OpCode_BlitRenderTarget:
 			{
-				int count = m_fifo->ReadUint32();
-				m_currentOp.data.Set( count );
-				m_currentOp.data.SetPointer( m_fifo->GetReadHead() );
-
-				m_fifo->AdvanceReadHead( sizeof(s_vector) * count );
-//				for ( int i = 0; i < count; i++ )
-//					m_fifo->ReadVector2D(&s_vector);
-
+				const PointerPairData &d = command->Payload<PointerPairData>();
+				data.SetPointer( (char*)d.p );
+				data.SetPointer2( (char*)d.p2 );
 				break;
 			}
-			case OpCode_ColorArray:
+		case OpCode_BlitRenderTargetRect:
 			{
-				int count = m_fifo->ReadUint32();
-				m_currentOp.data.Set( count );
-				m_currentOp.data.SetPointer( m_fifo->GetReadHead() );
-
-				m_fifo->AdvanceReadHead( sizeof(s_color) * count );
-//				for ( int i = 0; i < count; i++ )
-//				{
-//					m_fifo->ReadColor(&s_color);
-//				}
+				const BlitRectData &d = command->Payload<BlitRectData>();
+				data.SetPointer( (char*)d.from );
+				data.SetPointer2( (char*)d.to );
+				data.box2D.Set( d.fromRect.min, d.fromRect.max );
+				data.box2D2.Set( d.toRect.min, d.toRect.max );
 				break;
 			}
-			case OpCode_LineListArray:
-			case OpCode_LineStripArray:
-			case OpCode_TriangleListArray:
-			case OpCode_TriangleStripArray:
-			case OpCode_TriangleFanArray:
-			case OpCode_PointsArray:
+		case OpCode_Light:
 			{
-				int count = m_fifo->ReadUint32();
-				m_currentOp.data.Set( count );
-				m_currentOp.data.SetPointer( m_fifo->GetReadHead() );
-
-				m_fifo->AdvanceReadHead( sizeof(uint16_t) * count );
-//				for ( int i = 0; i < count; i++ )
-//					m_fifo->Readuint16_t();
-
+				const LightData &d = command->Payload<LightData>();
+				data.light.SetType( (vsLight::Type)d.type );
+				data.light.SetPosition( d.position );
+				data.light.SetDirection( d.direction );
+				data.light.SetColor( d.color );
+				data.light.SetAmbientColor( d.ambient );
+				data.light.SetSpecularColor( d.specular );
 				break;
 			}
-			case OpCode_LineListBuffer:
-			case OpCode_LineStripBuffer:
-			case OpCode_TriangleStripBuffer:
-			case OpCode_TriangleListBuffer:
-			case OpCode_TriangleFanBuffer:
+		case OpCode_Fog:
 			{
-				m_currentOp.data.SetPointer( (char *)m_fifo->ReadVoidStar() );
+				const FogData &d = command->Payload<FogData>();
+				if ( d.linear )
+					data.fog.SetLinear( d.color, d.start, d.end );
+				else
+					data.fog.SetExponential( d.color, d.density );
 				break;
 			}
-			case OpCode_PushTransform:
-			case OpCode_SetCameraTransform:
-				m_fifo->ReadTransform2D( &m_currentOp.data.transform );
-				break;
-			case OpCode_PushMatrix4x4:
-			case OpCode_SetMatrix4x4:
-			case OpCode_SetWorldToViewMatrix4x4:
-				m_fifo->ReadMatrix4x4( &m_currentOp.data.matrix4x4 );
-				break;
-			case OpCode_SetMatrices4x4:
-				{
-					int count = m_fifo->ReadUint32();
-					m_currentOp.data.SetPointer( (char*)m_fifo->ReadVoidStar() );
-					m_currentOp.data.i = count;
-					break;
-				}
-			case OpCode_SetMatrices4x4Buffer:
-				{
-					m_currentOp.data.SetPointer( (char*)m_fifo->ReadVoidStar() );
-					break;
-				}
-			case OpCode_Set3DProjection:
-				m_currentOp.data.fov = m_fifo->ReadFloat();
-				m_currentOp.data.nearPlane = m_fifo->ReadFloat();
-				m_currentOp.data.farPlane = m_fifo->ReadFloat();
-				break;
-			case OpCode_SetProjectionMatrix4x4:
-				m_fifo->ReadMatrix4x4( &m_currentOp.data.matrix4x4 );
-				break;
-			case OpCode_SetMaterial:
-				m_currentOp.data.SetPointer( (char *)m_fifo->ReadVoidStar() );
-				break;
-			case OpCode_SetRenderTarget:
-				m_currentOp.data.SetPointer( (char *)m_fifo->ReadVoidStar() );
-				break;
-			// case OpCode_ResolveRenderTarget:
-			// 	m_currentOp.data.SetPointer( (char *)m_fifo->ReadVoidStar() );
-			// 	break;
-			case OpCode_BlitRenderTarget:
-				m_currentOp.data.SetPointer( (char *)m_fifo->ReadVoidStar() );
-				m_currentOp.data.SetPointer2( (char *)m_fifo->ReadVoidStar() );
-				break;
-			case OpCode_BlitRenderTargetRect:
-				m_currentOp.data.SetPointer( (char *)m_fifo->ReadVoidStar() );
-				m_currentOp.data.SetPointer2( (char *)m_fifo->ReadVoidStar() );
-				m_currentOp.data.box2D.Clear();
-				m_currentOp.data.box2D2.Clear();
-				{
-					vsVector2D v;
-
-					m_fifo->ReadVector2D(&v);
-					m_currentOp.data.box2D.ExpandToInclude( v );
-					m_fifo->ReadVector2D(&v);
-					m_currentOp.data.box2D.ExpandToInclude( v );
-					m_fifo->ReadVector2D(&v);
-					m_currentOp.data.box2D2.ExpandToInclude( v );
-					m_fifo->ReadVector2D(&v);
-					m_currentOp.data.box2D2.ExpandToInclude( v );
-				}
-				break;
-			case OpCode_Light:
-				m_fifo->ReadLight( &m_currentOp.data.light );
-				break;
-			case OpCode_Fog:
-				m_fifo->ReadFog( &m_currentOp.data.fog );
-				break;
-			case OpCode_SetViewport:
-				m_fifo->ReadBox2D( &m_currentOp.data.box2D );
-				break;
-			case OpCode_Debug:
-				 m_currentOp.data.string = m_fifo->ReadString();
-				break;
-			case OpCode_EnableScissor:
-				m_fifo->ReadBox2D( &m_currentOp.data.box2D );
+		case OpCode_SetViewport:
+		case OpCode_EnableScissor:
+			{
+				const BoxData &d = command->Payload<BoxData>();
+				data.box2D.Set( d.min, d.max );
 				break;
-			case OpCode_ClearRenderTarget:
-			case OpCode_ClearLights:
-			case OpCode_PopTransform:
-			case OpCode_ClearVertexArray:
-			case OpCode_ClearNormalArray:
-			case OpCode_ClearTexelArray:
-			case OpCode_ClearColorArray:
-			case OpCode_ClearArrays:
-			case OpCode_FlatShading:
-			case OpCode_SmoothShading:
-			case OpCode_EnableStencil:
-			case OpCode_DisableStencil:
-			case OpCode_DisableScissor:
-			case OpCode_ClearStencil:
-			case OpCode_ClearShaderValues:
-			case OpCode_ClearDepth:
-			case OpCode_ClearViewport:
-			case OpCode_PopShaderOptions:
-			default:
+			}
+		case OpCode_Debug:
+			{
+				const ArrayData &d = command->Payload<ArrayData>();
+				data.string.assign( d.Elements(), d.count );
 				break;
-		}
-
-		return &m_currentOp;
+			}
+		default:
+			break;
 	}
 
-	return nullptr;
+	return &m_currentOp;
 }
 
 void
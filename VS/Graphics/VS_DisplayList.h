@@ -178,6 +178,101 @@ public:
 		Data	data;
 	};
 
+	// In memory, each command is a Command header followed by a fixed-layout
+	// payload in native byte order.  Every command (and any array it carries)
+	// is padded out to c_commandAlignment bytes, so the renderer can read
+	// payloads and arrays in place.  PopOp() decodes the same data into an
+	// 'op' for code which wants the convenience.  Only Write_CVec() uses the
+	// portable network-order encoding.
+	static const size_t c_commandAlignment = 8;
+
+	struct Command
+	{
+		uint8_t		type;
+		uint8_t		padding[3];
+		uint32_t	size;	// total bytes in this command, including header and any trailing array
+
+		OpCode GetType() const { return (OpCode)type; }
+
+		template<typename T>
+		const T& Payload() const { return *reinterpret_cast<const T*>(this+1); }
+	};
+
+	struct PointerData
+	{
+		void *p;
+	};
+
+	struct PointerPairData
+	{
+		void *p;
+		void *p2;
+	};
+
+	struct CountedPointerData
+	{
+		void *p;
+		uint32_t count;
+		uint32_t padding;
+	};
+
+	// ArrayData is followed directly by 'count' array elements.
+	struct ArrayData
+	{
+		uint32_t count;
+		uint32_t padding;
+
+		const char* Elements() const { return reinterpret_cast<const char*>(this+1); }
+		char* Elements() { return reinterpret_cast<char*>(this+1); }
+	};
+
+	struct TransformData
+	{
+		vsVector2D position;
+		float angle;
+		vsVector2D scale;
+	};
+
+	struct ProjectionData
+	{
+		float fov;
+		float nearPlane;
+		float farPlane;
+	};
+
+	struct BoxData
+	{
+		vsVector2D min;
+		vsVector2D max;
+	};
+
+	struct BlitRectData
+	{
+		void *from;
+		void *to;
+		BoxData fromRect;
+		BoxData toRect;
+	};
+
+	struct LightData
+	{
+		uint32_t type;
+		vsVector3D position;
+		vsVector3D direction;
+		vsColor color;
+		vsColor ambient;
+		vsColor specular;
+	};
+
+	struct FogData
+	{
+		vsColor color;
+		uint32_t linear;
+		float density;
+		float start;
+		float end;
+	};
+
 private:
 
 	vsStore *	m_fifo;
@@ -202,6 +297,14 @@ private:
 	static vsDisplayList *	Load_Obj(const vsString &);
 	void					Write_CVec( const vsString &filename );
 
+	// reserves space for a new command with 'payloadSize' bytes of payload,
+	// followed by 'arraySize' bytes of array data.  Returns the payload.
+	char *					_AddCommand( OpCode type, size_t payloadSize, size_t arraySize = 0 );
+	template<typename T>
+	T *						_AddCommand( OpCode type, size_t arraySize = 0 ) { return reinterpret_cast<T*>( _AddCommand( type, sizeof(T), arraySize ) ); }
+	void					_AddIndexArray( OpCode type, const int *idArray, int vertexCount );
+	void					_AddIndexArray( OpCode type, const uint16_t *idArray, int vertexCount );
+
 public:
 
 	// for use by vsFragment.
@@ -211,6 +314,7 @@ public:
 	static vsDisplayList *	Load( vsRecord *record );
 
 			vsDisplayList(size_t memSize = 50 * 1024, bool autoResize = false );
+			vsDisplayList(char *buffer, size_t bufferLength );	// use an external buffer, which must outlive us
 	virtual	~vsDisplayList();
 
 	vsStore *		GetFifo() { return m_fifo; }
@@ -359,6 +463,10 @@ public:
 	op *	PopOp();
 	void	AppendOp(op *);
 
+	// PopCommand() returns the next command in place, without decoding it.
+	// The result is only valid until the display list is next modified.
+	const Command *	PopCommand();
+
 	static const vsString& GetOpCodeString( OpCode code );
 
 	void operator= ( const vsDisplayList &list ) { Clear(); Append(list); }
@@ -11,6 +11,53 @@
 #include "VS_DisplayList.h"
 #include "VS_Fragment.h"
 
+#include <stddef.h>
+
+namespace
+{
+	// How big each vertex is, and where in it the normal lives (-1 if it
+	// hasn't got one).  Positions are always at the start.
+	void GetVertexLayout( vsRenderBuffer::ContentType type, size_t *vertexSize, int *normalOffset )
+	{
+		*normalOffset = -1;
+		switch( type )
+		{
+			case vsRenderBuffer::ContentType_P:
+				*vertexSize = sizeof(vsRenderBuffer::P);
+				break;
+			case vsRenderBuffer::ContentType_PC:
+				*vertexSize = sizeof(vsRenderBuffer::PC);
+				break;
+			case vsRenderBuffer::ContentType_PT:
+				*vertexSize = sizeof(vsRenderBuffer::PT);
+				break;
+			case vsRenderBuffer::ContentType_PCT:
+				*vertexSize = sizeof(vsRenderBuffer::PCT);
+				break;
+			case vsRenderBuffer::ContentType_PN:
+				*vertexSize = sizeof(vsRenderBuffer::PN);
+				*normalOffset = offsetof(vsRenderBuffer::PN, normal);
+				break;
+			case vsRenderBuffer::ContentType_PNT:
+				*vertexSize = sizeof(vsRenderBuffer::PNT);
+				*normalOffset = offsetof(vsRenderBuffer::PNT, normal);
+				break;
+			case vsRenderBuffer::ContentType_PCN:
+				*vertexSize = sizeof(vsRenderBuffer::PCN);
+				*normalOffset = offsetof(vsRenderBuffer::PCN, normal);
+				break;
+			case vsRenderBuffer::ContentType_PCNT:
+				*vertexSize = sizeof(vsRenderBuffer::PCNT);
+				*normalOffset = offsetof(vsRenderBuffer::PCNT, normal);
+				break;
+			default:
+				vsAssert(0, "Unsupported content type");
+				*vertexSize = sizeof(vsRenderBuffer::P);
+				break;
+		}
+	}
+};
+
 vsDynamicBatch::vsDynamicBatch():
 	m_vbo(vsRenderBuffer::Type_Stream),
 	m_ibo(vsRenderBuffer::Type_Stream)
@@ -32,6 +79,7 @@ vsDynamicBatch::Supports( vsRenderBuffer::ContentType type )
 		case vsRenderBuffer::ContentType_PC:
 		case vsRenderBuffer::ContentType_PT:
 		case vsRenderBuffer::ContentType_PN:
+		case vsRenderBuffer::ContentType_PNT:
 		case vsRenderBuffer::ContentType_PCT:
 		case vsRenderBuffer::ContentType_PCNT:
 		case vsRenderBuffer::ContentType_PCN:
@@ -71,122 +119,26 @@ vsDynamicBatch::AddToBatch_Internal( vsRenderBuffer *fvbo, vsRenderBuffer *fibo,
 	//
 	// vertices
 
-	int indexOfFirstVertex = 0;//m_vbo.GetPositionCount();
+	size_t vertexSize;
+	int normalOffset;
+	GetVertexLayout( fvbo->GetContentType(), &vertexSize, &normalOffset );
 
-	if ( fvbo->GetContentType() == vsRenderBuffer::ContentType_P )
-	{
-		int size = first ? 0 : m_vbo.GetGenericArraySize();
-		indexOfFirstVertex = size / sizeof(vsRenderBuffer::P);
-		m_vbo.ResizeArray( size + fvbo->GetGenericArraySize() );
-		vsRenderBuffer::P* i = fvbo->GetPArray();
-		vsRenderBuffer::P* o = m_vbo.GetPArray();
+	int size = first ? 0 : m_vbo.GetGenericArraySize();
+	int indexOfFirstVertex = size / vertexSize;
+	int vertexCount = fvbo->GetPositionCount();
+	m_vbo.ResizeArray( size + fvbo->GetGenericArraySize() );
 
-		int oo = size / sizeof(vsRenderBuffer::P);
-		for (int ii = 0; ii < fvbo->GetPositionCount(); ii++)
-		{
-			o[oo].position = mat.ApplyTo( i[ii].position );
-			oo++;
-		}
-	}
-	if ( fvbo->GetContentType() == vsRenderBuffer::ContentType_PN )
-	{
-		int size = first ? 0 : m_vbo.GetGenericArraySize();
-		indexOfFirstVertex = size / sizeof(vsRenderBuffer::PN);
-		m_vbo.ResizeArray( size + fvbo->GetGenericArraySize() );
-		vsRenderBuffer::PN* i = fvbo->GetPNArray();
-		vsRenderBuffer::PN* o = m_vbo.GetPNArray();
+	// Copy the vertices across whole, then transform their positions and
+	// normals in place;  colors and texels are used as they are.
+	char *vertices = (char*)m_vbo.GetGenericArray() + size;
+	memcpy( vertices, fvbo->GetGenericArray(), vertexCount * vertexSize );
 
-		int oo = size / sizeof(vsRenderBuffer::PN);
-		for (int ii = 0; ii < fvbo->GetPositionCount(); ii++)
-		{
-			o[oo].position = mat.ApplyTo( i[ii].position );
-			o[oo].normal = mat.ApplyRotationTo( i[ii].normal );
-			oo++;
-		}
-	}
-	if ( fvbo->GetContentType() == vsRenderBuffer::ContentType_PT )
+	vsVector3D *position = (vsVector3D*)vertices;
+	mat.ApplyToArray( position, position, vertexCount, vertexSize );
+	if ( normalOffset >= 0 )
 	{
-		int size = first ? 0 : m_vbo.GetGenericArraySize();
-		indexOfFirstVertex = size / sizeof(vsRenderBuffer::PT);
-		m_vbo.ResizeArray( size + fvbo->GetGenericArraySize() );
-		vsRenderBuffer::PT* i = fvbo->GetPTArray();
-		vsRenderBuffer::PT* o = m_vbo.GetPTArray();
-
-		int oo = size / sizeof(vsRenderBuffer::PT);
-		for (int ii = 0; ii < fvbo->GetPositionCount(); ii++)
-		{
-			o[oo].position = mat.ApplyTo( i[ii].position );
-			o[oo].texel = i[ii].texel;
-			oo++;
-		}
-	}
-	else if ( fvbo->GetContentType() == vsRenderBuffer::ContentType_PC )
-	{
-		int size = first ? 0 : m_vbo.GetGenericArraySize();
-		indexOfFirstVertex = size / sizeof(vsRenderBuffer::PC);
-		m_vbo.ResizeArray( size + fvbo->GetGenericArraySize() );
-		vsRenderBuffer::PC* i = fvbo->GetPCArray();
-		vsRenderBuffer::PC* o = m_vbo.GetPCArray();
-
-		int oo = size / sizeof(vsRenderBuffer::PC);
-		for (int ii = 0; ii < fvbo->GetPositionCount(); ii++)
-		{
-			o[oo].position = mat.ApplyTo( i[ii].position );
-			o[oo].color = i[ii].color;
-			oo++;
-		}
-	}
-	else if ( fvbo->GetContentType() == vsRenderBuffer::ContentType_PCT )
-	{
-		int size = first ? 0 : m_vbo.GetGenericArraySize();
-		indexOfFirstVertex = size / sizeof(vsRenderBuffer::PCT);
-		m_vbo.ResizeArray( size + fvbo->GetGenericArraySize() );
-		vsRenderBuffer::PCT* i = fvbo->GetPCTArray();
-		vsRenderBuffer::PCT* o = m_vbo.GetPCTArray();
-
-		int oo = size / sizeof(vsRenderBuffer::PCT);
-		for (int ii = 0; ii < fvbo->GetPositionCount(); ii++)
-		{
-			o[oo].position = mat.ApplyTo( i[ii].position );
-			o[oo].color = i[ii].color;
-			o[oo].texel = i[ii].texel;
-			oo++;
-		}
-	}
-	else if ( fvbo->GetContentType() == vsRenderBuffer::ContentType_PCN )
-	{
-		int size = first ? 0 : m_vbo.GetGenericArraySize();
-		indexOfFirstVertex = size / sizeof(vsRenderBuffer::PCN);
-		m_vbo.ResizeArray( size + fvbo->GetGenericArraySize() );
-		vsRenderBuffer::PCN* i = fvbo->GetPCNArray();
-		vsRenderBuffer::PCN* o = m_vbo.GetPCNArray();
-
-		int oo = size / sizeof(vsRenderBuffer::PCN);
-		for (int ii = 0; ii < fvbo->GetPositionCount(); ii++)
-		{
-			o[oo].position = mat.ApplyTo( i[ii].position );
-			o[oo].normal = mat.ApplyRotationTo( i[ii].normal );
-			o[oo].color = i[ii].color;
-			oo++;
-		}
-	}
-	else if ( fvbo->GetContentType() == vsRenderBuffer::ContentType_PCNT )
-	{
-		int size = first ? 0 : m_vbo.GetGenericArraySize();
-		indexOfFirstVertex = size / sizeof(vsRenderBuffer::PCNT);
-		m_vbo.ResizeArray( size + fvbo->GetGenericArraySize() );
-		vsRenderBuffer::PCNT* i = fvbo->GetPCNTArray();
-		vsRenderBuffer::PCNT* o = m_vbo.GetPCNTArray();
-
-		int oo = size / sizeof(vsRenderBuffer::PCNT);
-		for (int ii = 0; ii < fvbo->GetPositionCount(); ii++)
-		{
-			o[oo].position = mat.ApplyTo( i[ii].position );
-			o[oo].normal = mat.ApplyRotationTo( i[ii].normal );
-			o[oo].color = i[ii].color;
-			o[oo].texel = i[ii].texel;
-			oo++;
-		}
+		vsVector3D *normal = (vsVector3D*)(vertices + normalOffset);
+		mat.ApplyRotationToArray( normal, normal, vertexCount, vertexSize );
 	}
 	m_vbo.SetContentType(fvbo->GetContentType());
 
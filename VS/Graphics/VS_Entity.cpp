@@ -13,6 +13,8 @@
 #include "VS_Screen.h"
 #include "VS_System.h"
 
+bool vsEntity::s_deferExtracts = false;
+
 vsEntity::vsEntity():
 	m_name( vsEmptyString ),
 	m_parent(nullptr),
@@ -20,7 +22,10 @@ vsEntity::vsEntity():
 	m_registeredScene(nullptr),
 	m_visible(true),
 	m_processing(false),
-	m_extractQueued(false)
+	m_extractQueued(false),
+	m_threadSafeUpdate(false),
+	m_hasBounds(false),
+	m_worldBoundsDirty(true)
 {
 	m_next = m_prev = this;
 	m_clickable = true;
@@ -124,7 +129,7 @@ vsEntity::DoExtract()
 void
 vsEntity::Extract()
 {
-	if ( m_processing )
+	if ( m_processing || ( s_deferExtracts && !m_parent ) )
 		m_extractQueued = true;
 	else
 		DoExtract();
@@ -152,6 +157,20 @@ vsEntity::DrawChildren( vsRenderQueue *queue )
 	}
 }
 
+const vsBox3D &
+vsEntity::GetWorldBounds()
+{
+	if ( m_worldBoundsDirty )
+	{
+		vsMatrix4x4 mat = GetBoundsMatrix();
+		m_worldBounds.Clear();
+		for ( int i = 0; i < 8; i++ )
+			m_worldBounds.ExpandToInclude( mat.ApplyTo( m_localBounds.Corner(i) ) );
+		m_worldBoundsDirty = false;
+	}
+	return m_worldBounds;
+}
+
 void
 vsEntity::Draw( vsRenderQueue *queue )
 {
@@ -182,7 +201,7 @@ vsEntity::Update( float timeStep )
 	}
 
 	m_processing = false;
-	if ( m_extractQueued )
+	if ( m_extractQueued && ( m_parent || !s_deferExtracts ) )
 		DoExtract();
 }
 
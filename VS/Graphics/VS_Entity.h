@@ -17,6 +17,7 @@ class vsScene;
 class vsSceneDraw;
 
 #include "VS/Math/VS_Transform.h"
+#include "VS/Math/VS_Box.h"
 
 class vsEntity
 {
@@ -37,9 +38,27 @@ protected:
 
 	bool			m_processing;
 	bool			m_extractQueued;
+	bool			m_threadSafeUpdate;
+
+	// While set, scene-level entities which want to be extracted at the end
+	// of their Update() leave that for vsScene to do afterwards.
+	static bool		s_deferExtracts;
+
+	// Optional bounds used for 3D culling.  'm_localBounds' is in our own
+	// coordinate space;  'm_worldBounds' is derived from it lazily, and is
+	// only valid while 'm_worldBoundsDirty' is false.
+	vsBox3D			m_localBounds;
+	vsBox3D			m_worldBounds;
+	bool			m_hasBounds;
+	bool			m_worldBoundsDirty;
 
 	void			DrawChildren( vsRenderQueue *queue );
 
+	// Subclasses with a 3D transform should override this to return their
+	// local-to-world matrix, and call DirtyWorldBounds() whenever it changes.
+	virtual vsMatrix4x4	GetBoundsMatrix() const { return vsMatrix4x4::Identity; }
+	void			DirtyWorldBounds() { m_worldBoundsDirty = true; }
+
 	void			DoExtract();
 
 public:
@@ -52,6 +71,14 @@ public:
 
 	virtual bool	OnScreen(const vsTransform2D & /*cameraTrans*/) const { return true; }
 
+	// Entities with no bounds set are never culled from 3D scenes.  When set,
+	// the bounds must include anything drawn by our children, too.
+	void			SetLocalBounds( const vsBox3D &box ) { m_localBounds = box; m_hasBounds = true; m_worldBoundsDirty = true; }
+	void			ClearLocalBounds() { m_hasBounds = false; }
+	bool			HasBounds() const { return m_hasBounds; }
+	const vsBox3D &	GetLocalBounds() const { return m_localBounds; }
+	const vsBox3D &	GetWorldBounds();
+
 	void			RegisterOnScene(int scene);
 	void			RegisterOnScene(vsScene *scene);
 #if defined(_DEBUG)
@@ -65,6 +92,14 @@ public:
 
 	void			SetClickable(bool clickable) { m_clickable = clickable; }
 
+	// Entities whose Update() (including their children's) touches nothing
+	// but themselves and their own children may be flagged as thread-safe.
+	// Scenes with parallel update enabled will update those entities on
+	// worker threads.  They may still Extract() or QueueExtract()
+	// themselves;  that's deferred until all the updates have finished.
+	void			SetThreadSafeUpdate(bool threadSafe) { m_threadSafeUpdate = threadSafe; }
+	bool			IsThreadSafeUpdate() const { return m_threadSafeUpdate; }
+
 	vsEntity *		GetNext() const { return m_next; }
 	vsEntity *		GetPrev() const { return m_prev; }
 	vsEntity *		GetParent() const { return m_parent; }
@@ -88,6 +123,8 @@ public:
 
 	void			Extract();
 	void			QueueExtract();
+
+	friend class vsScene;
 };
 
 #endif // VS_ENTITY_H
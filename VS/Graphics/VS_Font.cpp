@@ -33,7 +33,10 @@ vsFontSize::vsFontSize( const vsString &filename ):
 	m_baseline(1.f),
 	m_capHeight(1.f),
 	m_kerning(nullptr),
-	m_kerningCount(0)
+	m_kerningCount(0),
+	m_glyphLookup(nullptr),
+	m_kerningTable(nullptr),
+	m_kerningTableMask(0)
 {
 	uint16_t indices[6] = { 0, 2, 1, 1, 2, 3 };
 	m_glyphTriangleList.SetArray( indices, 6 );
@@ -48,12 +51,16 @@ vsFontSize::vsFontSize( const vsString &filename ):
 	{
 		LoadBMFont(&fontData);
 	}
+
+	BuildLookupTables();
 }
 
 vsFontSize::~vsFontSize()
 {
 	vsDeleteArray( m_glyph );
 	vsDeleteArray( m_kerning );
+	vsDeleteArray( m_kerningTable );
+	vsDelete( m_glyphLookup );
 	vsDelete( m_material );
 	vsDelete( m_ptBuffer );
 }
@@ -359,16 +366,80 @@ vsFontSize::LoadBMFont( vsFile *file )
 	vsDeleteArray(pt);
 }
 
-vsGlyph *
-vsFontSize::FindGlyphForCharacter(uint32_t letter)
+static inline uint32_t
+KerningPairHash( uint32_t glyphA, uint32_t glyphB )
 {
-	for ( int i = 0; i < m_glyphCount; i++ )
+	// Codepoints fit into 21 bits, so mix the pair down into 32 bits and then
+	// scramble with a Fibonacci multiply, so that the low bits we mask off
+	// are well distributed.
+	const uint32_t factor = 2654435839U;
+	return ((glyphA << 11) ^ glyphB) * factor;
+}
+
+void
+vsFontSize::BuildLookupTables()
+{
+	for ( uint32_t i = 0; i < c_directGlyphCount; i++ )
+		m_directGlyph[i] = nullptr;
+
+	m_glyphLookup = new vsIntHashTable<vsGlyph*>( vsMax(m_glyphCount, 16) );
+
+	// Walk backward so that if a font lists the same codepoint twice, the
+	// first entry wins, same as the old linear search did.
+	for ( int i = m_glyphCount-1; i >= 0; i-- )
+	{
+		vsGlyph *g = &m_glyph[i];
+		if ( g->glyph < c_directGlyphCount )
+			m_directGlyph[g->glyph] = g;
+		else
+		{
+			vsGlyph **existing = m_glyphLookup->FindItem( g->glyph );
+			if ( existing )
+				*existing = g;
+			else
+				m_glyphLookup->AddItemWithKey( g, g->glyph );
+		}
+	}
+
+	if ( m_kerningCount > 0 )
 	{
-		if ( m_glyph[i].glyph == letter )
+		// keep the table at most half full, so probe sequences stay short.
+		uint32_t tableSize = vsNextPowerOfTwo( m_kerningCount * 2 );
+		m_kerningTable = new vsKerning[tableSize];
+		m_kerningTableMask = tableSize-1;
+		for ( uint32_t i = 0; i < tableSize; i++ )
 		{
-			return &m_glyph[i];
+			m_kerningTable[i].glyphA = 0;
+			m_kerningTable[i].glyphB = 0;
+			m_kerningTable[i].xAdvance = 0.f;
+		}
+
+		for ( int i = 0; i < m_kerningCount; i++ )
+		{
+			const vsKerning &k = m_kerning[i];
+			uint32_t slot = KerningPairHash( k.glyphA, k.glyphB ) & m_kerningTableMask;
+			while ( m_kerningTable[slot].glyphA != 0 || m_kerningTable[slot].glyphB != 0 )
+			{
+				if ( m_kerningTable[slot].glyphA == k.glyphA && m_kerningTable[slot].glyphB == k.glyphB )
+					break;
+				slot = (slot+1) & m_kerningTableMask;
+			}
+			// first entry for a pair wins, same as the old linear search.
+			if ( m_kerningTable[slot].glyphA == 0 && m_kerningTable[slot].glyphB == 0 )
+				m_kerningTable[slot] = k;
 		}
 	}
+}
+
+vsGlyph *
+vsFontSize::FindGlyphForCharacter(uint32_t letter)
+{
+	if ( letter < c_directGlyphCount )
+		return m_directGlyph[letter];
+
+	vsGlyph **result = m_glyphLookup->FindItem( letter );
+	if ( result )
+		return *result;
 	return nullptr;
 }
 
@@ -391,7 +462,7 @@ vsFontSize::GetStringWidth( const vsString &string_in, float size )
 		else
 		{
 			width += GetCharacterAdvance( cp, size ); // other characters, just use the distance we advance
-			// width += GetCharacterKerning( string[i], string[i+1], size ); // also, adjust for kerning
+			width += GetCharacterKerning( cp, utf8::peek_next(w, stringEnd), size ); // also, adjust for kerning
 		}
 	}
 	return width;
@@ -430,13 +501,17 @@ vsFontSize::GetCharacterAdvance( uint32_t c, float size )
 float
 vsFontSize::GetCharacterKerning( uint32_t pChar, uint32_t nChar, float size )
 {
-	// TODO:  Make less absurd than this linear search
-	for ( int i = 0; i < m_kerningCount; i++ )
+	if ( !m_kerningTable )
+		return 0.f;
+
+	uint32_t slot = KerningPairHash( pChar, nChar ) & m_kerningTableMask;
+	while ( m_kerningTable[slot].glyphA != 0 || m_kerningTable[slot].glyphB != 0 )
 	{
-		if ( m_kerning[i].glyphA == pChar && m_kerning[i].glyphB == nChar )
+		if ( m_kerningTable[slot].glyphA == pChar && m_kerningTable[slot].glyphB == nChar )
 		{
-			return m_kerning[i].xAdvance * size;
+			return m_kerningTable[slot].xAdvance * size;
 		}
+		slot = (slot+1) & m_kerningTableMask;
 	}
 	return 0.f;
 }
@@ -16,6 +16,7 @@
 #include "VS/Math/VS_Box.h"
 #include "VS/Utils/VS_Array.h"
 #include "VS/Utils/VS_ArrayStore.h"
+#include "VS/Utils/VS_IntHashTable.h"
 
 class vsDisplayList;
 class vsFragment;
@@ -82,12 +83,23 @@ class vsFontSize
 	vsKerning* m_kerning;
 	int m_kerningCount;
 
+	// Lookup tables, built once at load time.  Glyphs for codepoints below
+	// c_directGlyphCount (ASCII and Latin-1) are found by direct indexing;
+	// anything else goes through the hash table.  Kerning pairs live in an
+	// open-addressed table keyed by the pair of codepoints.
+	static const uint32_t c_directGlyphCount = 256;
+	vsGlyph *        m_directGlyph[c_directGlyphCount];
+	vsIntHashTable<vsGlyph*> *m_glyphLookup;
+	vsKerning *      m_kerningTable;
+	uint32_t         m_kerningTableMask;
+
 	vsRenderBuffer   m_glyphTriangleList;
 
 	vsGlyph *		FindGlyphForCharacter( uint32_t letter ); // in UTF8 codepoint format
 
 	void LoadOldFormat(vsFile *file);
 	void LoadBMFont(vsFile *file);
+	void BuildLookupTables();
 public:
 
 	vsFontSize( const vsString &filename );
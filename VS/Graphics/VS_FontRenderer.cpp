@@ -11,9 +11,10 @@
 #include "VS_DisplayList.h"
 #include "VS_Fragment.h"
 #include "Utils/utfcpp/utf8.h"
+#include "Utils/uni-algo/src/cpp_uni_break_word.h"
 
 static float s_globalFontScale = 1.f;
-static vsDisplayList s_tempFontList(1024*10);
+static vsDisplayList s_tempFontList(1024*10, true);
 
 void
 vsFontRenderer::SetGlobalFontScale( float scale )
@@ -468,7 +469,7 @@ vsDisplayList*
 vsFontRenderer::DisplayList2D( const vsString& string )
 {
 	m_texSize = m_size;
-	vsDisplayList *loader = new vsDisplayList(1024 * 10);
+	vsDisplayList *loader = new vsDisplayList(1024 * 10, true);
 	CreateString_InDisplayList(FontContext_2D, loader, string);
 
 	vsDisplayList *result = new vsDisplayList( loader->GetSize() );
@@ -482,7 +483,7 @@ vsDisplayList*
 vsFontRenderer::DisplayList3D( const vsString& string )
 {
 	m_texSize = m_font->MaxSize();
-	vsDisplayList *loader = new vsDisplayList(1024 * 10);
+	vsDisplayList *loader = new vsDisplayList(1024 * 10, true);
 	CreateString_InDisplayList(FontContext_3D, loader, string);
 
 	vsDisplayList *result = new vsDisplayList( loader->GetSize() );
@@ -496,7 +497,7 @@ void
 vsFontRenderer::DisplayList2D( vsDisplayList *list, const vsString& string )
 {
 	m_texSize = m_size;
-	vsDisplayList *loader = new vsDisplayList(1024 * 10);
+	vsDisplayList *loader = new vsDisplayList(1024 * 10, true);
 	CreateString_InDisplayList(FontContext_3D, loader, string);
 
 	list->Append(*loader);
@@ -507,7 +508,7 @@ void
 vsFontRenderer::DisplayList3D( vsDisplayList *list, const vsString& string )
 {
 	m_texSize = m_font->MaxSize();
-	vsDisplayList *loader = new vsDisplayList(1024 * 10);
+	vsDisplayList *loader = new vsDisplayList(1024 * 10, true);
 	CreateString_InDisplayList(FontContext_3D, loader, string);
 
 	list->Append(*loader);
@@ -519,7 +520,7 @@ vsFontRenderer::GetStringDimensions( const vsString& string )
 {
 // #define BOUNDING_BOX_METHOD
 #ifdef BOUNDING_BOX_METHOD
-	vsDisplayList *loader = new vsDisplayList(1024 * 10);
+	vsDisplayList *loader = new vsDisplayList(1024 * 10, true);
 	CreateString_InDisplayList(FontContext_2D, loader, string);
 	vsVector2D topLeft, bottomRight;
 	loader->GetBoundingBox( topLeft, bottomRight );
@@ -553,66 +554,160 @@ vsFontRenderer::GetLineCount( const vsString& string )
 }
 
 
-void
-vsFontRenderer::WrapLine(const vsString &string, float size)
+static bool
+IsWrapWhitespace( uint32_t cp )
+{
+	return ( cp == ' ' || cp == '\t' || cp == 0x200b || cp == 0x3000 ); // space, tab, zero-width space, ideographic space
+}
+
+static bool
+IsCJK( uint32_t cp )
+{
+	return ( (cp >= 0x2e80 && cp <= 0x9fff) ||	// CJK radicals, punctuation, kana, ideographs
+			(cp >= 0xf900 && cp <= 0xfaff) ||	// CJK compatibility ideographs
+			(cp >= 0xff00 && cp <= 0xffef) ||	// fullwidth forms
+			(cp >= 0x20000 && cp <= 0x3ffff) );	// supplementary ideographs
+}
+
+static bool
+IsNoBreakBefore( uint32_t cp )
+{
+	// characters which must never begin a line (closing punctuation, small
+	// kana, prolonged sound marks, and their friends)
+	switch ( cp )
+	{
+		case ',': case '.': case '!': case '?': case ':': case ';':
+		case ')': case ']': case '}':
+		case 0x3001: case 0x3002: case 0x300d: case 0x300f: case 0x3011:
+		case 0x30fc: case 0x3005: case 0x309d: case 0x309e: case 0x30fd: case 0x30fe:
+		case 0x3041: case 0x3043: case 0x3045: case 0x3047: case 0x3049: case 0x3063:
+		case 0x3083: case 0x3085: case 0x3087: case 0x30a1: case 0x30a3: case 0x30a5:
+		case 0x30a7: case 0x30a9: case 0x30c3: case 0x30e3: case 0x30e5: case 0x30e7:
+		case 0xff01: case 0xff09: case 0xff0c: case 0xff0e: case 0xff1a: case 0xff1b:
+		case 0xff1f: case 0xff3d: case 0xff5d:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static bool
+IsNoBreakAfter( uint32_t cp )
 {
-	vsString remainingString = string;
+	// characters which must never end a line (opening punctuation)
+	switch ( cp )
+	{
+		case '(': case '[': case '{':
+		case 0x300c: case 0x300e: case 0x3010: case 0xff08: case 0xff3b: case 0xff5b:
+			return true;
+		default:
+			return false;
+	}
+}
 
-	// okay, check where we need to wordwrap
-	size_t lineEnd = 0;
-	size_t seekPosition = 0;
+// Given a word boundary between 'prev' and 'next', may we wrap the line there?
+static bool
+IsWrapOpportunity( uint32_t prev, uint32_t next )
+{
+	if ( IsWrapWhitespace(prev) )
+		return true;
+	if ( IsCJK(prev) || IsCJK(next) )
+	{
+		// languages without spaces can wrap at any word boundary, as long
+		// as we don't strand punctuation.
+		if ( IsWrapWhitespace(next) || IsNoBreakBefore(next) || IsNoBreakAfter(prev) )
+			return false;
+		return true;
+	}
+	return false;
+}
 
+void
+vsFontRenderer::WrapLine(const vsString &string, float size)
+{
+	// We make a single pass across the string, visiting each word boundary
+	// in turn.  Rather than measuring candidate lines from scratch, we keep a
+	// running cursor position for the line we're building, and remember the
+	// cursor position at the last place where we're allowed to wrap.  When we
+	// wrap, everything after the wrap point shifts left by that amount.
+	vsFontSize *fontSize = m_font->Size(size);
 	float maxWidth = m_bounds.x;
 
 	m_wrappedLine.Clear();
 
-	while ( remainingString != vsEmptyString )
+	const char* str = string.c_str();
+	const char* strEnd = str + string.size();
+
+	size_t lineStart = 0;
+	size_t wrapPosition = 0;    // last place we can wrap this line.  (== lineStart means "nowhere yet")
+	float lineAdvance = 0.f;    // cursor position, relative to the start of the line
+	float lineWidth = 0.f;      // right edge of the last visible glyph on the line
+	float wrapAdvance = 0.f;    // cursor position at wrapPosition
+	uint32_t prevCp = 0;
+	bool hasPrev = false;
+
+	uni::breaks::word::utf8 begin{string.cbegin(), string.cend()};
+	uni::breaks::word::utf8 end{string.cend(), string.cend()};
+
+	auto it = begin;
+	while ( it != end )
 	{
-		vsString line = remainingString;
-		seekPosition = remainingString.find_first_of(" \n",seekPosition);
-//		newlinePosition = remainingString.find('\n',newlinePosition+1);
+		const char* w = str + (it - begin);
+		++it;
+		size_t segmentEnd = it - begin;
 
-		if ( seekPosition != vsString::npos )
+		while ( w < str + segmentEnd )
 		{
-			line.erase(seekPosition);
-		}
+			size_t cpPosition = w - str;
+			uint32_t cp = utf8::next(w, strEnd);
 
-		// check if we want to do a line break here!
-		bool outOfSpace = (maxWidth > 0.f && m_font->Size(size)->GetStringWidth(line, size) > maxWidth && lineEnd > 0) ;
-		bool wrapping = outOfSpace;
-		if ( seekPosition != vsString::npos )
-		{
-			if ( !outOfSpace && remainingString[seekPosition] == '\n' )	// newline?
+			if ( cp == '\n' )
 			{
-				lineEnd = seekPosition;
-				wrapping = true;
+				m_wrappedLine.AddItem( string.substr( lineStart, cpPosition - lineStart ) );
+				lineStart = wrapPosition = w - str;
+				lineAdvance = lineWidth = wrapAdvance = 0.f;
+				hasPrev = false;
+				continue;
 			}
-		}
 
-		if ( wrapping )
-		{
-			// time to wrap!
-			if ( line.size() > lineEnd )
-				line.erase(lineEnd+1);
-			remainingString.erase(0,lineEnd+1);
-			// we've gone too far, and need to wrap!  Wrap to the last safe wrap point we found.
-
-			m_wrappedLine.AddItem( line );
+			if ( hasPrev )
+			{
+				float kerning = fontSize->GetCharacterKerning( prevCp, cp, size );
+				lineAdvance += kerning;
+				if ( cpPosition == wrapPosition )
+					wrapAdvance += kerning; // if we wrap here, this kerning goes away too.
+			}
+			if ( !IsWrapWhitespace(cp) )
+				lineWidth = lineAdvance + fontSize->GetCharacterWidth( cp, size );
+			lineAdvance += fontSize->GetCharacterAdvance( cp, size );
 
-			lineEnd = 0;
-			seekPosition = 0;
+			prevCp = cp;
+			hasPrev = true;
 		}
-		else if ( seekPosition == vsString::npos )
+
+		// we're at a word boundary.  If we've run out of space, wrap back to
+		// the last place we were allowed to.
+		if ( maxWidth > 0.f && lineWidth > maxWidth && wrapPosition > lineStart )
 		{
-			m_wrappedLine.AddItem( remainingString );
-			remainingString = vsEmptyString;
+			m_wrappedLine.AddItem( string.substr( lineStart, wrapPosition - lineStart ) );
+			lineStart = wrapPosition;
+			lineAdvance -= wrapAdvance;
+			lineWidth -= wrapAdvance;
 		}
-		else
+
+		if ( hasPrev && segmentEnd < string.size() )
 		{
-			lineEnd = seekPosition;
-			seekPosition++;
+			uint32_t nextCp = utf8::peek_next( str + segmentEnd, strEnd );
+			if ( IsWrapOpportunity( prevCp, nextCp ) )
+			{
+				wrapPosition = segmentEnd;
+				wrapAdvance = lineAdvance;
+			}
 		}
 	}
+
+	if ( lineStart < string.size() )
+		m_wrappedLine.AddItem( string.substr( lineStart ) );
 }
 
 void
@@ -275,7 +275,7 @@ vsFragment::Load( vsRecord *record )
 		}
 		else if ( srLabel == "DisplayList" )
 		{
-			vsDisplayList *loader = new vsDisplayList(1024*50);
+			vsDisplayList *loader = new vsDisplayList(1024*50, true);
 
 			for ( int j = 0; j < sr->GetChildCount(); j++ )
 			{
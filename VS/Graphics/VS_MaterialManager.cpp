@@ -47,18 +47,12 @@ vsMaterialManager::ReloadAll()
 	// directly any more.
 	vsShader::ReloadAll();
 
-	for ( int b = 0; b < m_bucketCount; b++ )
+	for ( int i = 0; i < m_table.SlotCount(); i++ )
 	{
-		vsCacheEntry< vsMaterialInternal > *bucket = &m_bucket[b];
-		while( bucket )
+		if ( m_table.IsSlotUsed(i) )
 		{
-			if ( bucket->m_item )
-			{
-				vsMaterialInternal *m = static_cast<vsMaterialInternal*>(bucket->m_item);
-				m->Reload();
-			}
-
-			bucket = bucket->m_next;
+			vsMaterialInternal *m = static_cast<vsMaterialInternal*>(m_table.GetSlot(i).m_item);
+			m->Reload();
 		}
 	}
 }
@@ -54,6 +54,7 @@ protected:
 	void LoadFrom( vsRecord *record );
 
 	virtual void _TransformChangeCallback() {}
+	virtual vsMatrix4x4 GetBoundsMatrix() const { return m_transform.GetMatrix(); }
 
 public:
 
@@ -75,21 +76,22 @@ public:
 	void			SetMaterial( vsMaterial *material ) { vsDelete( m_material ); m_material = material; }
 	vsMaterial *	GetMaterial() { return m_material; }
 
-	void				SetPosition( const vsVector3D &pos ) { if ( pos != GetPosition() ) { m_transform.SetTranslation( pos ); _TransformChangeCallback(); } }
+	void				SetPosition( const vsVector3D &pos ) { if ( pos != GetPosition() ) { m_transform.SetTranslation( pos ); DirtyWorldBounds(); _TransformChangeCallback(); } }
 	const vsVector3D &	GetPosition() const { return m_transform.GetTranslation(); }
 
-	void					SetOrientation( const vsQuaternion &quat ) { if ( quat != GetOrientation() ) { m_transform.SetRotation( quat ); _TransformChangeCallback(); } }
+	void					SetOrientation( const vsQuaternion &quat ) { if ( quat != GetOrientation() ) { m_transform.SetRotation( quat ); DirtyWorldBounds(); _TransformChangeCallback(); } }
 	const vsQuaternion &	GetOrientation() const { return m_transform.GetRotation(); }
 
 	const vsMatrix4x4 &		GetMatrix() const { return m_transform.GetMatrix(); }
 
 	const vsVector3D &		GetScale() const { return m_transform.GetScale(); }
-	void					SetScale( const vsVector3D &s ) { if ( s != GetScale() ) { m_transform.SetScale(s); _TransformChangeCallback(); } }
-	void					SetScale( float s ) { m_transform.SetScale(s); }
+	void					SetScale( const vsVector3D &s ) { if ( s != GetScale() ) { m_transform.SetScale(s); DirtyWorldBounds(); _TransformChangeCallback(); } }
+	void					SetScale( float s ) { m_transform.SetScale(s); DirtyWorldBounds(); }
 
 	const vsBox3D &			GetBoundingBox() const { return m_boundingBox; }
 	void					SetBoundingBox(const vsBox3D &box) { m_boundingBox = box; }
 	void					BuildBoundingBox();
+	void					CullUsingBoundingBox() { SetLocalBounds( m_boundingBox ); } // opt into 3D scene culling
 
 	const vsBox3D &			GetLowBoundingBox() const { return m_lowBoundingBox; }
 	void					SetLowBoundingBox(const vsBox3D &box) { m_lowBoundingBox = box; }
@@ -101,7 +103,7 @@ public:
 
 	float					GetBoundingRadius() { return m_boundingRadius; }
 
-	void					SetTransform( const vsTransform3D &t ) { if ( t != m_transform ) { m_transform = t; _TransformChangeCallback(); } }
+	void					SetTransform( const vsTransform3D &t ) { if ( t != m_transform ) { m_transform = t; DirtyWorldBounds(); _TransformChangeCallback(); } }
 	const vsTransform3D&	GetTransform() const { return m_transform; }
 
 	void			SetDisplayList( vsDisplayList *list );
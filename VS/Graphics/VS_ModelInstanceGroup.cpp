@@ -10,13 +10,19 @@
 #include "VS_ModelInstanceGroup.h"
 #include "VS_ModelInstance.h"
 #include "VS_Model.h"
+#include "VS_Camera.h"
+#include "VS_RenderQueue.h"
+#include "VS_Scene.h"
 
 vsModelInstanceLodGroup::vsModelInstanceLodGroup( vsModelInstanceGroup *group, vsModel *model, size_t lodLevel ):
 	m_group(group),
 	m_model(model),
 	m_lodLevel(lodLevel),
 	m_values(nullptr),
-	m_options(nullptr)
+	m_options(nullptr),
+	m_currentVisibleSet(0),
+	m_frustumCulling(true),
+	m_drawnInstanceCount(0)
 #ifdef INSTANCED_MODEL_USES_LOCAL_BUFFER
 	,
 	m_matrixBuffer(vsRenderBuffer::Type_Dynamic),
@@ -67,6 +73,11 @@ vsModelInstanceLodGroup::UpdateInstance( vsModelInstance *inst, bool show )
 			m_matrix.AddItem( inst->matrix );
 			m_color.AddItem( inst->color );
 			m_matrixInstanceId.AddItem( inst->index );
+			m_sphereX.AddItem( 0.f );
+			m_sphereY.AddItem( 0.f );
+			m_sphereZ.AddItem( 0.f );
+			m_sphereRadius.AddItem( 0.f );
+			SetSphere( inst->matrixIndex, inst->matrix );
 #ifdef INSTANCED_MODEL_USES_LOCAL_BUFFER
 			m_bufferIsDirty = true;
 #endif
@@ -75,6 +86,7 @@ vsModelInstanceLodGroup::UpdateInstance( vsModelInstance *inst, bool show )
 		{
 			m_matrix[inst->matrixIndex] = inst->matrix;
 			m_color[inst->matrixIndex] = inst->color;
+			SetSphere( inst->matrixIndex, inst->matrix );
 #ifdef INSTANCED_MODEL_USES_LOCAL_BUFFER
 			m_bufferIsDirty = true;
 #endif
@@ -94,11 +106,19 @@ vsModelInstanceLodGroup::UpdateInstance( vsModelInstance *inst, bool show )
 			m_matrix[swapTo] = m_matrix[swapFrom];
 			m_color[swapTo] = m_color[swapFrom];
 			m_matrixInstanceId[swapTo] = m_matrixInstanceId[swapFrom];
+			m_sphereX[swapTo] = m_sphereX[swapFrom];
+			m_sphereY[swapTo] = m_sphereY[swapFrom];
+			m_sphereZ[swapTo] = m_sphereZ[swapFrom];
+			m_sphereRadius[swapTo] = m_sphereRadius[swapFrom];
 			swapper->matrixIndex = swapTo;
 		}
 		m_matrix.PopBack();
 		m_color.PopBack();
 		m_matrixInstanceId.PopBack();
+		m_sphereX.PopBack();
+		m_sphereY.PopBack();
+		m_sphereZ.PopBack();
+		m_sphereRadius.PopBack();
 		inst->matrixIndex = -1;
 #ifdef INSTANCED_MODEL_USES_LOCAL_BUFFER
 		m_bufferIsDirty = true;
@@ -179,30 +199,279 @@ vsModelInstanceLodGroup::RemoveInstance( vsModelInstance *inst )
 	inst->lodGroup = nullptr;
 }
 
+void
+vsModelInstanceLodGroup::SetSphere( int matrixIndex, const vsMatrix4x4& mat )
+{
+	// A sphere around the model's bounding box, moved and scaled by this
+	// instance's matrix.  We use the largest axis scale, so non-uniformly
+	// scaled instances get a conservative sphere.
+	vsVector3D center = mat.ApplyTo( m_sphereBox.Middle() );
+	float sqScale = vsMax( vsVector3D(mat.x).SqLength(), vsMax( vsVector3D(mat.y).SqLength(), vsVector3D(mat.z).SqLength() ) );
+	float radius = 0.5f * m_sphereBox.Extents().Length() * vsSqrt( sqScale );
+
+	m_sphereX[matrixIndex] = center.x;
+	m_sphereY[matrixIndex] = center.y;
+	m_sphereZ[matrixIndex] = center.z;
+	m_sphereRadius[matrixIndex] = radius;
+}
+
+void
+vsModelInstanceLodGroup::RebuildSpheres()
+{
+	m_sphereBox = m_model->GetBoundingBox();
+	for ( int i = 0; i < m_matrix.ItemCount(); i++ )
+		SetSphere( i, m_matrix[i] );
+}
+
+const vsFrustum *
+vsModelInstanceLodGroup::GetCullingFrustum( vsRenderQueue *queue )
+{
+	if ( !m_frustumCulling || !m_model->GetBoundingBox().IsSet() )
+		return nullptr;
+
+	vsScene *scene = queue->GetScene();
+	if ( !scene || !scene->Is3D() || !scene->GetCamera3D() )
+		return nullptr;
+
+	return &scene->GetCamera3D()->GetFrustum();
+}
+
+void
+vsModelInstanceLodGroup::UpdateSpheres()
+{
+	// If the model's bounds have changed since we built our spheres, they're
+	// all wrong now.
+	if ( m_sphereBox != m_model->GetBoundingBox() )
+		RebuildSpheres();
+}
+
+bool
+vsModelInstanceLodGroup::CullInstances( vsRenderQueue *queue )
+{
+	const VisibleSet &last = m_visibleSet[m_currentVisibleSet];
+	m_currentVisibleSet = 1 - m_currentVisibleSet;
+	VisibleSet &set = m_visibleSet[m_currentVisibleSet];
+
+	int count = m_matrix.ItemCount();
+	const vsFrustum *frustum = GetCullingFrustum( queue );
+	if ( frustum )
+	{
+		UpdateSpheres();
+
+		if ( set.index.ItemCount() < count )
+			set.index.SetArraySize( count );
+
+		set.count = frustum->CullSpheres( &m_sphereX[0], &m_sphereY[0], &m_sphereZ[0], &m_sphereRadius[0], count, &set.index[0] );
+		set.all = ( set.count == count );
+	}
+	else
+	{
+		set.count = count;
+		set.all = true;
+	}
+
+	if ( set.all || last.all )
+		return set.all != last.all;
+	if ( set.count != last.count )
+		return true;
+	return memcmp( &set.index[0], &last.index[0], sizeof(int) * set.count ) != 0;
+}
+
+void
+vsModelInstanceLodGroup::CompactVisibleInstances()
+{
+	const VisibleSet &set = m_visibleSet[m_currentVisibleSet];
+	m_drawMatrix.Clear();
+	m_drawColor.Clear();
+	m_drawMatrix.Reserve( set.count );
+	m_drawColor.Reserve( set.count );
+	for ( int i = 0; i < set.count; i++ )
+	{
+		int id = set.index[i];
+		m_drawMatrix.AddItem( m_matrix[id] );
+		m_drawColor.AddItem( m_color[id] );
+	}
+}
+
 void
 vsModelInstanceLodGroup::Draw( vsRenderQueue *queue )
 {
+	m_drawnInstanceCount = 0;
 	if ( m_matrix.IsEmpty() )
 		return;
 
+	bool visibleSetChanged = CullInstances( queue );
+	const VisibleSet &set = m_visibleSet[m_currentVisibleSet];
+	if ( set.count == 0 )
+		return;
+	m_drawnInstanceCount = set.count;
+
+	const vsMatrix4x4 *matrix = &m_matrix[0];
+	const vsColorPacked *color = &m_color[0];
+
 	// int preLodLevel = m_model->GetLodLevel();
 	// m_model->SetLodLevel( m_lodLevel );
 #ifdef INSTANCED_MODEL_USES_LOCAL_BUFFER
-	if ( m_bufferIsDirty )
+	if ( m_bufferIsDirty || visibleSetChanged )
 	{
 		vsAssert(m_matrix.ItemCount() == m_color.ItemCount(), "Non-equal instance buffers??");
-		m_matrixBuffer.SetArray(&m_matrix[0], m_matrix.ItemCount() );
-		m_colorBuffer.SetArray(&m_color[0], m_color.ItemCount() );
+		if ( !set.all )
+		{
+			CompactVisibleInstances();
+			matrix = &m_drawMatrix[0];
+			color = &m_drawColor[0];
+		}
+		m_matrixBuffer.SetArray(matrix, set.count );
+		m_colorBuffer.SetArray(color, set.count );
 		m_bufferIsDirty = false;
 	}
 	m_model->DrawInstanced( queue, &m_matrixBuffer, &m_colorBuffer, m_values, m_options, m_lodLevel );
 #else
-	m_model->DrawInstanced( queue, &m_matrix[0], &m_color[0], m_matrix.ItemCount(), m_values, m_options, m_lodLevel );
+	UNUSED(visibleSetChanged);
+	if ( !set.all )
+	{
+		CompactVisibleInstances();
+		matrix = &m_drawMatrix[0];
+		color = &m_drawColor[0];
+	}
+	m_model->DrawInstanced( queue, matrix, color, set.count, m_values, m_options, m_lodLevel );
 #endif // INSTANCED_MODEL_USES_LOCAL_BUFFER
 
 	// m_model->SetLodLevel( preLodLevel );
 }
 
+int
+vsModelInstanceLodGroup::ChooseLods( const vsVector3D& cameraPosition, bool useDistance, bool useRadius, const float *sqThresholdUp, const float *sqThresholdDown, int thresholdCount )
+{
+	UpdateSpheres();
+
+	int currentLevel = vsMin( (int)m_lodLevel, thresholdCount );
+	int migrating = 0;
+	for ( int i = 0; i < m_matrix.ItemCount(); i++ )
+	{
+		float sqMetric = 1.f;
+		if ( useDistance )
+		{
+			float dx = m_sphereX[i] - cameraPosition.x;
+			float dy = m_sphereY[i] - cameraPosition.y;
+			float dz = m_sphereZ[i] - cameraPosition.z;
+			sqMetric = dx*dx + dy*dy + dz*dz;
+		}
+		float sqScale = useRadius ? m_sphereRadius[i] * m_sphereRadius[i] : 1.f;
+
+		int level = currentLevel;
+		while ( level < thresholdCount && sqMetric > sqThresholdUp[level] * sqScale )
+			level++;
+		while ( level > 0 && sqMetric < sqThresholdDown[level-1] * sqScale )
+			level--;
+
+		if ( level != (int)m_lodLevel )
+		{
+			m_instance[ m_matrixInstanceId[i] ]->lodLevel = level;
+			migrating++;
+		}
+	}
+	return migrating;
+}
+
+void
+vsModelInstanceLodGroup::RemoveMigratingInstances()
+{
+	// Only visible instances are ever migrated, so first squeeze the leavers
+	// out of our matrix arrays, keeping everybody else in order.
+	int matrixCount = m_matrix.ItemCount();
+	int write = 0;
+	for ( int read = 0; read < matrixCount; read++ )
+	{
+		vsModelInstance *inst = m_instance[ m_matrixInstanceId[read] ];
+		if ( inst->lodLevel != m_lodLevel )
+		{
+			inst->matrixIndex = -1;
+			continue;
+		}
+		if ( write != read )
+		{
+			m_matrix[write] = m_matrix[read];
+			m_color[write] = m_color[read];
+			m_matrixInstanceId[write] = m_matrixInstanceId[read];
+			m_sphereX[write] = m_sphereX[read];
+			m_sphereY[write] = m_sphereY[read];
+			m_sphereZ[write] = m_sphereZ[read];
+			m_sphereRadius[write] = m_sphereRadius[read];
+		}
+		inst->matrixIndex = write;
+		write++;
+	}
+
+	if ( write == matrixCount )
+		return;
+
+	m_matrix.SetArraySize( write );
+	m_color.SetArraySize( write );
+	m_matrixInstanceId.SetArraySize( write );
+	m_sphereX.SetArraySize( write );
+	m_sphereY.SetArraySize( write );
+	m_sphereZ.SetArraySize( write );
+	m_sphereRadius.SetArraySize( write );
+
+	// Now do the same to the instance array, handing each leaver over to the
+	// lod group it's moving to.
+	int instanceCount = m_instance.ItemCount();
+	write = 0;
+	for ( int read = 0; read < instanceCount; read++ )
+	{
+		vsModelInstance *inst = m_instance[read];
+		if ( inst->lodLevel != m_lodLevel )
+		{
+			m_group->GetLodGroup( (int)inst->lodLevel )->m_incoming.AddItem( inst );
+			continue;
+		}
+		m_instance[write] = inst;
+		inst->index = write;
+		if ( inst->matrixIndex >= 0 )
+			m_matrixInstanceId[ inst->matrixIndex ] = write;
+		write++;
+	}
+	m_instance.SetArraySize( write );
+
+#ifdef INSTANCED_MODEL_USES_LOCAL_BUFFER
+	m_bufferIsDirty = true;
+#endif
+}
+
+void
+vsModelInstanceLodGroup::AddIncomingInstances()
+{
+	if ( m_incoming.IsEmpty() )
+		return;
+
+	int incoming = m_incoming.ItemCount();
+	m_instance.Reserve( m_instance.ItemCount() + incoming );
+	m_matrix.Reserve( m_matrix.ItemCount() + incoming );
+	m_color.Reserve( m_color.ItemCount() + incoming );
+	m_matrixInstanceId.Reserve( m_matrixInstanceId.ItemCount() + incoming );
+	m_sphereX.Reserve( m_sphereX.ItemCount() + incoming );
+	m_sphereY.Reserve( m_sphereY.ItemCount() + incoming );
+	m_sphereZ.Reserve( m_sphereZ.ItemCount() + incoming );
+	m_sphereRadius.Reserve( m_sphereRadius.ItemCount() + incoming );
+
+	for ( int i = 0; i < incoming; i++ )
+	{
+		vsModelInstance *inst = m_incoming[i];
+		inst->lodGroup = this;
+		inst->index = m_instance.ItemCount();
+		inst->matrixIndex = -1;
+		m_instance.AddItem( inst );
+		if ( inst->visible )
+			UpdateInstance( inst, true );
+	}
+	m_incoming.Clear();
+
+#ifdef INSTANCED_MODEL_USES_LOCAL_BUFFER
+	m_bufferIsDirty = true;
+#endif
+}
+
 void
 vsModelInstanceLodGroup::CalculateMatrixBounds( vsBox3D& out )
 {
@@ -236,7 +505,10 @@ vsModelInstanceLodGroup::CalculateBounds( vsBox3D& out )
 
 vsModelInstanceGroup::vsModelInstanceGroup( vsModel *model ):
 	m_model( model ),
-	m_lod( model->GetLodCount() )
+	m_lod( model->GetLodCount() ),
+	m_automaticLod( false ),
+	m_lodMetric( LodMetric_Distance ),
+	m_lodHysteresis( 0.1f )
 {
 	for ( int i = 0; i < model->GetLodCount(); i++ )
 	{
@@ -368,9 +640,112 @@ vsModelInstanceGroup::CalculateBounds( vsBox3D& out )
 	}
 }
 
+void
+vsModelInstanceGroup::SetFrustumCulling( bool cull )
+{
+	for ( int i = 0; i < m_lod.ItemCount(); i++ )
+	{
+		m_lod[i]->SetFrustumCulling(cull);
+	}
+}
+
+int
+vsModelInstanceGroup::GetDrawnInstanceCount() const
+{
+	int count = 0;
+	for ( int i = 0; i < m_lod.ItemCount(); i++ )
+	{
+		count += m_lod[i]->GetDrawnInstanceCount();
+	}
+	return count;
+}
+
+void
+vsModelInstanceGroup::SetAutomaticLod( LodMetric metric, const float *thresholds, int thresholdCount, float hysteresis )
+{
+	m_automaticLod = true;
+	m_lodMetric = metric;
+	m_lodHysteresis = hysteresis;
+	m_lodThreshold.Clear();
+	for ( int i = 0; i < thresholdCount; i++ )
+	{
+		vsAssert( thresholds[i] > 0.f, "Automatic lod thresholds must be positive" );
+		m_lodThreshold.AddItem( thresholds[i] );
+	}
+}
+
+void
+vsModelInstanceGroup::UpdateLods( vsRenderQueue *queue )
+{
+	vsScene *scene = queue->GetScene();
+	if ( !scene || !scene->Is3D() || !scene->GetCamera3D() )
+		return;
+	const vsCamera3D *camera = scene->GetCamera3D();
+
+	int thresholdCount = vsMin( m_lodThreshold.ItemCount(), m_lod.ItemCount()-1 );
+	if ( thresholdCount <= 0 )
+		return;
+
+	// Everything below compares squared values, so we never need a square
+	// root per instance.  For distance thresholds, we compare each instance's
+	// distance from the camera directly.  For screen size thresholds, an
+	// instance with bounding radius 'r' at distance 'd' covers roughly
+	// 'r / (d * tan(fov/2))' of half the screen height, so we convert each
+	// threshold into a limit on 'd / r' instead.
+	bool useDistance = true;
+	bool useRadius = false;
+	float scale = 1.f;
+	if ( m_lodMetric == LodMetric_ScreenSize )
+	{
+		if ( !m_model->GetBoundingBox().IsSet() )
+			return;
+		useRadius = true;
+		if ( camera->GetProjectionType() == vsCamera3D::PT_Perspective )
+		{
+			scale = 1.f / vsTan( camera->GetFieldOfView() * 0.5f );
+		}
+		else
+		{
+			// orthographic cameras use their 'field of view' as half the
+			// height of the view, and distance doesn't matter.
+			useDistance = false;
+			scale = 1.f / camera->GetFieldOfView();
+		}
+	}
+
+	vsArray<float> sqThresholdUp( thresholdCount );
+	vsArray<float> sqThresholdDown( thresholdCount );
+	for ( int i = 0; i < thresholdCount; i++ )
+	{
+		float threshold = m_lodThreshold[i];
+		if ( m_lodMetric == LodMetric_ScreenSize )
+			threshold = scale / threshold;
+		float up = threshold * (1.f + m_lodHysteresis);
+		float down = threshold * (1.f - m_lodHysteresis);
+		sqThresholdUp.AddItem( up * up );
+		sqThresholdDown.AddItem( down * down );
+	}
+
+	vsVector3D cameraPosition = camera->GetPosition();
+	int migrating = 0;
+	for ( int i = 0; i < m_lod.ItemCount(); i++ )
+		migrating += m_lod[i]->ChooseLods( cameraPosition, useDistance, useRadius, &sqThresholdUp[0], &sqThresholdDown[0], thresholdCount );
+
+	if ( migrating == 0 )
+		return;
+
+	for ( int i = 0; i < m_lod.ItemCount(); i++ )
+		m_lod[i]->RemoveMigratingInstances();
+	for ( int i = 0; i < m_lod.ItemCount(); i++ )
+		m_lod[i]->AddIncomingInstances();
+}
+
 void
 vsModelInstanceGroup::Draw( vsRenderQueue *queue )
 {
+	if ( m_automaticLod )
+		UpdateLods( queue );
+
 	for ( int i = 0; i < m_lod.ItemCount(); i++ )
 	{
 		m_lod[i]->Draw(queue);
@@ -18,6 +18,7 @@
 #include "VS/Utils/VS_Array.h"
 #include "VS/Utils/VS_ArrayStore.h"
 
+class vsFrustum;
 class vsModel;
 struct vsModelInstance;
 class vsModelInstanceGroup;
@@ -37,11 +38,44 @@ class vsModelInstanceLodGroup : public vsEntity
 	vsArray<vsColorPacked> m_color;
 	vsArray<int> m_matrixInstanceId;
 	vsArray<vsModelInstance*> m_instance;
+
+	// World-space bounding spheres of the instances in m_matrix, stored as
+	// separate arrays (and in the same order) so we can cull them in bulk.
+	vsArray<float> m_sphereX;
+	vsArray<float> m_sphereY;
+	vsArray<float> m_sphereZ;
+	vsArray<float> m_sphereRadius;
+	vsBox3D m_sphereBox; // the model bounds our spheres were built from
+
+	// Which entries of m_matrix survived culling.  We keep the previous
+	// frame's set as well, so we only re-upload when the set changes.
+	struct VisibleSet
+	{
+		vsArray<int> index;
+		int count;
+		bool all;
+		VisibleSet(): count(0), all(true) {}
+	};
+	VisibleSet m_visibleSet[2];
+	int m_currentVisibleSet;
+	vsArray<vsMatrix4x4> m_drawMatrix; // compacted copies of the visible instances
+	vsArray<vsColorPacked> m_drawColor;
+	bool m_frustumCulling;
+	int m_drawnInstanceCount;
 #ifdef INSTANCED_MODEL_USES_LOCAL_BUFFER
 	vsRenderBuffer m_matrixBuffer;
 	vsRenderBuffer m_colorBuffer;
 	bool m_bufferIsDirty;
 #endif // INSTANCED_MODEL_USES_LOCAL_BUFFER
+
+	vsArray<vsModelInstance*> m_incoming; // instances migrating into this lod during an automatic lod pass
+
+	void SetSphere( int matrixIndex, const vsMatrix4x4& mat );
+	void RebuildSpheres();
+	void UpdateSpheres(); // rebuilds our spheres if the model's bounds have changed
+	const vsFrustum * GetCullingFrustum( vsRenderQueue *queue );
+	bool CullInstances( vsRenderQueue *queue ); // returns true if the visible set changed since last frame
+	void CompactVisibleInstances();
 public:
 
 	vsModelInstanceLodGroup( vsModelInstanceGroup *group, vsModel *model, size_t lodLevel );
@@ -63,13 +97,44 @@ public:
 	void CalculateMatrixBounds( vsBox3D& out );
 	void CalculateBounds( vsBox3D& out );
 
+	// When drawn in a 3D scene, instances whose bounds are entirely outside
+	// the camera frustum are skipped.  On by default.
+	void SetFrustumCulling( bool cull ) { m_frustumCulling = cull; }
+	int GetDrawnInstanceCount() const { return m_drawnInstanceCount; } // as of the last Draw()
+	int GetInstanceCount() const { return m_instance.ItemCount(); }
+	int GetVisibleInstanceCount() const { return m_matrix.ItemCount(); }
+
+	// Automatic lod support.  ChooseLods() picks a new lod level for each of
+	// our visible instances, and returns how many need to move to a different
+	// lod group.  Once every group has chosen, RemoveMigratingInstances() and
+	// AddIncomingInstances() move them all across in a single pass per group,
+	// rather than one swap-remove at a time.
+	int ChooseLods( const vsVector3D& cameraPosition, bool useDistance, bool useRadius, const float *sqThresholdUp, const float *sqThresholdDown, int thresholdCount );
+	void RemoveMigratingInstances();
+	void AddIncomingInstances();
+
 	virtual void Draw( vsRenderQueue *queue );
 };
 
 class vsModelInstanceGroup: public vsEntity
 {
+public:
+	enum LodMetric
+	{
+		LodMetric_Distance,		// thresholds are distances from the camera, in increasing order
+		LodMetric_ScreenSize	// thresholds are projected bounding radii as a fraction of half the screen height, in decreasing order
+	};
+
+private:
 	vsModel *m_model;
 	vsArrayStore<vsModelInstanceLodGroup> m_lod;
+
+	bool m_automaticLod;
+	LodMetric m_lodMetric;
+	vsArray<float> m_lodThreshold;
+	float m_lodHysteresis;
+
+	void UpdateLods( vsRenderQueue *queue );
 public:
 
 	vsModelInstanceGroup( vsModel *model );
@@ -90,6 +155,23 @@ public:
 	void CalculateMatrixBounds( vsBox3D& out );
 	void CalculateBounds( vsBox3D& out );
 
+	void SetFrustumCulling( bool cull );
+	int GetDrawnInstanceCount() const;
+
+	// Automatic lod selection.  When enabled, each Draw() in a 3D scene picks
+	// a lod level for every visible instance, overriding SetLodLevel().
+	// Threshold 'i' is the boundary between lod 'i' and lod 'i+1'.  To avoid
+	// instances flickering back and forth, an instance only crosses a
+	// threshold once it's 'hysteresis' (as a fraction of the threshold) past it.
+	void SetAutomaticLod( LodMetric metric, const float *thresholds, int thresholdCount, float hysteresis = 0.1f );
+	void ClearAutomaticLod() { m_automaticLod = false; }
+	bool IsAutomaticLod() const { return m_automaticLod; }
+
+	vsModelInstanceLodGroup * GetLodGroup( int lod ) { return m_lod[lod]; }
+	int GetLodInstanceCount( int lod ) const { return m_lod[lod]->GetInstanceCount(); }
+	int GetLodVisibleInstanceCount( int lod ) const { return m_lod[lod]->GetVisibleInstanceCount(); }
+	int GetLodDrawnInstanceCount( int lod ) const { return m_lod[lod]->GetDrawnInstanceCount(); }
+
 	virtual void Draw( vsRenderQueue *queue );
 };
 
@@ -10,6 +10,8 @@
 #include "VS_RenderBuffer.h"
 
 #include "VS_RendererState.h"
+#include "VS_RenderThread.h"
+#include "VS_StreamingBuffer.h"
 
 #include "VS_OpenGL.h"
 #include "VS_Profile.h"
@@ -32,6 +34,8 @@ static int s_glBufferType[vsRenderBuffer::TYPE_MAX] =
 #endif
 };
 
+vsRenderBuffer * vsRenderBuffer::s_pendingList = nullptr;
+
 vsRenderBuffer::vsRenderBuffer(vsRenderBuffer::Type type):
     m_array(nullptr),
     m_arrayBytes(0),
@@ -41,7 +45,16 @@ vsRenderBuffer::vsRenderBuffer(vsRenderBuffer::Type type):
     m_contentType(ContentType_Custom),
     m_bufferID(-1),
     m_vbo(false),
-    m_bindType(BindType_Array)
+    m_bindType(BindType_Array),
+    m_glBufferID(-1),
+    m_glOffset(0),
+    m_glActiveBytes(0),
+    m_streamFrame(0),
+    m_filledFrame(0),
+    m_pendingOffset(0),
+    m_pendingBytes(0),
+    m_pending(false),
+    m_nextPending(nullptr)
 {
 	vsAssert( sizeof( uint16_t ) == 2, "I've gotten the size wrong??" );
 
@@ -50,6 +63,7 @@ vsRenderBuffer::vsRenderBuffer(vsRenderBuffer::Type type):
 	if ( glGenBuffers && m_type != Type_NoVBO )
 	{
 		glGenBuffers(1, (GLuint*)&m_bufferID);
+		m_glBufferID = m_bufferID;
 		m_vbo = true;
 	}
 #endif
@@ -57,6 +71,10 @@ vsRenderBuffer::vsRenderBuffer(vsRenderBuffer::Type type):
 
 vsRenderBuffer::~vsRenderBuffer()
 {
+	// A pipelined frame might still be drawing from us.
+	vsRenderThread::Sync();
+	vsAssert( !m_pending, "Render buffer destroyed with an upload pending??" );
+
 	if ( m_vbo )
 	{
 		glDeleteBuffers( 1, (GLuint*)&m_bufferID );
@@ -77,12 +95,15 @@ void
 vsRenderBuffer::SetActiveSize( int size )
 {
 	// vsAssert(size != 0, "Zero-sized buffer??");
+	vsRenderThread::Sync();
 	m_activeBytes = size;
+	m_glActiveBytes = size;
 }
 
 void
 vsRenderBuffer::SetArraySize_Internal( int size )
 {
+	vsRenderThread::Sync();
 	if ( m_array && size > m_arrayBytes )
 	{
 		vsDeleteArray( m_array );
@@ -99,12 +120,17 @@ vsRenderBuffer::SetArraySize_Internal( int size )
 void
 vsRenderBuffer::ResizeArray_Internal( int size )
 {
+	vsRenderThread::Sync();
 	if ( m_array && size > m_arrayBytes )
 	{
-		char* newArray = new char[size];
-		memset(newArray, 0, size);
+		// Grow geometrically, so that callers which append a little at a time
+		// (vsDynamicBatch, vsLines) don't reallocate and copy the whole array
+		// every time they add to it.
+		int newBytes = vsMax( size, m_arrayBytes * 2 );
+		char* newArray = new char[newBytes];
 		memcpy(newArray, m_array, m_activeBytes);
-		m_arrayBytes = size;
+		memset(newArray + m_activeBytes, 0, newBytes - m_activeBytes);
+		m_arrayBytes = newBytes;
 		vsDeleteArray( m_array );
 		m_array = newArray;
 	}
@@ -112,47 +138,145 @@ vsRenderBuffer::ResizeArray_Internal( int size )
 }
 
 void
-vsRenderBuffer::SetArray_Internal( char *data, int size, vsRenderBuffer::BindType bindType )
+vsRenderBuffer::SetContentType( ContentType ct )
 {
-	vsAssert( size, "Error:  Tried to set a zero-length GPU buffer!" );
+	// The render thread reads this while it binds us.
+	if ( ct != m_contentType )
+	{
+		vsRenderThread::Sync();
+		m_contentType = ct;
+	}
+}
+
+bool
+vsRenderBuffer::SetArrayWithoutSync( char *data, int size, vsRenderBuffer::BindType bindType )
+{
+	// We can only do this where the main thread can write into the streaming
+	// buffer without the main GL context, and only for a buffer which was
+	// filled for the frame in flight;  the render thread won't touch our
+	// array or our size while drawing that frame, since it has no reason
+	// to re-upload us.
+	vsRenderThread *renderThread = vsRenderThread::Instance();
+	vsStreamingBuffer *stream = vsStreamingBuffer::Instance();
+	if ( !renderThread || !renderThread->IsFrameInFlight() || !stream || !stream->IsPersistent() )
+		return false;
+	if ( !m_vbo || m_type != Type_Stream || bindType != m_bindType || bindType == BindType_TextureBuffer )
+		return false;
+	if ( m_filledFrame != stream->GetDrawFrame() )
+		return false;
+
+	size_t streamOffset;
+	if ( !stream->UploadForNextFrame( data, size, &streamOffset ) )
+		return false;
+
+	m_pendingOffset = streamOffset;
+	m_pendingBytes = size;
+	m_filledFrame = stream->GetFrame();
+	if ( !m_pending )
+	{
+		m_pending = true;
+		m_nextPending = s_pendingList;
+		s_pendingList = this;
+	}
+
+	m_activeBytes = size;
+	if ( data != m_array )
+	{
+		if ( size > m_arrayBytes )
+		{
+			vsDeleteArray( m_array );
+			m_array = new char[size];
+			m_arrayBytes = size;
+		}
+		memcpy(m_array,data,size);
+	}
+	return true;
+}
 
+void
+vsRenderBuffer::CommitPendingUploads()
+{
+	vsStreamingBuffer *stream = vsStreamingBuffer::Instance();
+	while ( s_pendingList )
+	{
+		vsRenderBuffer *buffer = s_pendingList;
+		s_pendingList = buffer->m_nextPending;
+
+		buffer->m_glBufferID = stream->GetBufferID();
+		buffer->m_glOffset = buffer->m_pendingOffset;
+		buffer->m_glActiveBytes = buffer->m_pendingBytes;
+		buffer->m_streamFrame = buffer->m_filledFrame;
+		buffer->m_pending = false;
+		buffer->m_nextPending = nullptr;
+	}
+}
+
+void
+vsRenderBuffer::UploadToOwnBuffer( char *data, int size )
+{
 	int bindPoints[BindType_MAX] =
 	{
 		GL_ARRAY_BUFFER,
 		GL_ELEMENT_ARRAY_BUFFER,
 		GL_TEXTURE_BUFFER
 	};
-	int bindPoint = bindPoints[bindType];
+	int bindPoint = bindPoints[m_bindType];
 
-	m_bindType = bindType;
+	m_glBufferID = m_bufferID;
+	m_glOffset = 0;
 
-	if ( m_vbo )
+	glBindBuffer(bindPoint, m_bufferID);
+
+	if ( size > m_glArrayBytes )
 	{
-		glBindBuffer(bindPoint, m_bufferID);
+		glBufferData(bindPoint, size, data, s_glBufferType[m_type]);
+		m_glArrayBytes = size;
+	}
+	else
+	{
+		// glBufferData(bindPoint, size, nullptr, s_glBufferType[m_type]);
+		// glBufferData(bindPoint, size, data, s_glBufferType[m_type]);
+		void *ptr = glMapBufferRange(bindPoint, 0, m_glArrayBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
 
-		if ( size > m_glArrayBytes )
+		if ( ptr )
 		{
-			glBufferData(bindPoint, size, data, s_glBufferType[m_type]);
-			m_glArrayBytes = size;
-		}
-		else
-		{
-			// glBufferData(bindPoint, size, nullptr, s_glBufferType[m_type]);
-			// glBufferData(bindPoint, size, data, s_glBufferType[m_type]);
-			void *ptr = glMapBufferRange(bindPoint, 0, m_glArrayBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
-
-			if ( ptr )
-			{
-				memcpy(ptr, data, size);
-				glUnmapBuffer(bindPoint);
-			}
+			memcpy(ptr, data, size);
+			glUnmapBuffer(bindPoint);
 		}
+	}
 
 #ifdef VS_PRISTINE_BINDINGS
-		glBindBuffer(bindPoint, 0);
+	glBindBuffer(bindPoint, 0);
 #endif
+}
+
+void
+vsRenderBuffer::SetArray_Internal( char *data, int size, vsRenderBuffer::BindType bindType )
+{
+	vsAssert( size, "Error:  Tried to set a zero-length GPU buffer!" );
+	if ( SetArrayWithoutSync( data, size, bindType ) )
+		return;
+	vsRenderThread::Sync();
+
+	m_bindType = bindType;
+
+	vsStreamingBuffer *stream = vsStreamingBuffer::Instance();
+	size_t streamOffset;
+	if ( m_vbo && m_type == Type_Stream && bindType != BindType_TextureBuffer &&
+			stream && stream->UploadForNextFrame( data, size, &streamOffset ) )
+	{
+		m_glBufferID = stream->GetBufferID();
+		m_glOffset = streamOffset;
+		m_streamFrame = stream->GetFrame();
+	}
+	else if ( m_vbo )
+	{
+		UploadToOwnBuffer( data, size );
 	}
+	if ( stream )
+		m_filledFrame = stream->GetFrame();
 	m_activeBytes = size;
+	m_glActiveBytes = size;
 
 	if ( data != m_array )
 	{
@@ -161,10 +285,39 @@ vsRenderBuffer::SetArray_Internal( char *data, int size, vsRenderBuffer::BindTyp
 	}
 }
 
+char *
+vsRenderBuffer::BindGLBuffer( int bindPoint )
+{
+	if ( IsStreamed() )
+	{
+		vsStreamingBuffer *stream = vsStreamingBuffer::Instance();
+		if ( !stream || stream->GetDrawFrame() != m_streamFrame )
+		{
+			// We're being drawn in a later frame than the one we were filled
+			// for, and the streaming buffer may have reused our space since
+			// then.  Write our array out again, into the frame being drawn;
+			// this may be on the render thread, so we mustn't touch the
+			// region the main thread is filling.
+			size_t streamOffset;
+			if ( stream && stream->Upload( m_array, m_glActiveBytes, &streamOffset ) )
+			{
+				m_glOffset = streamOffset;
+				m_streamFrame = stream->GetDrawFrame();
+			}
+			else
+			{
+				UploadToOwnBuffer( m_array, m_glActiveBytes );
+			}
+		}
+	}
+	glBindBuffer(bindPoint, m_glBufferID);
+	return reinterpret_cast<char*>(m_glOffset);
+}
+
 void
 vsRenderBuffer::SetArray( const vsRenderBuffer::P *array, int size )
 {
-	m_contentType = ContentType_P;
+	SetContentType( ContentType_P );
 
 	SetArray_Internal((char *)array, size*sizeof(vsRenderBuffer::P), BindType_Array);
 }
@@ -172,7 +325,7 @@ vsRenderBuffer::SetArray( const vsRenderBuffer::P *array, int size )
 void
 vsRenderBuffer::SetArray( const vsRenderBuffer::PC *array, int size )
 {
-	m_contentType = ContentType_PC;
+	SetContentType( ContentType_PC );
 
 	SetArray_Internal((char *)array, size*sizeof(vsRenderBuffer::PC), BindType_Array);
 }
@@ -180,7 +333,7 @@ vsRenderBuffer::SetArray( const vsRenderBuffer::PC *array, int size )
 void
 vsRenderBuffer::SetArray( const vsRenderBuffer::PT *array, int size )
 {
-	m_contentType = ContentType_PT;
+	SetContentType( ContentType_PT );
 
 	SetArray_Internal((char *)array, size*sizeof(vsRenderBuffer::PT), BindType_Array);
 }
@@ -188,7 +341,7 @@ vsRenderBuffer::SetArray( const vsRenderBuffer::PT *array, int size )
 void
 vsRenderBuffer::SetArray( const vsRenderBuffer::PN *array, int size )
 {
-	m_contentType = ContentType_PN;
+	SetContentType( ContentType_PN );
 
 	SetArray_Internal((char *)array, size*sizeof(vsRenderBuffer::PN), BindType_Array);
 }
@@ -196,7 +349,7 @@ vsRenderBuffer::SetArray( const vsRenderBuffer::PN *array, int size )
 void
 vsRenderBuffer::SetArray( const vsRenderBuffer::PCT *array, int size )
 {
-	m_contentType = ContentType_PCT;
+	SetContentType( ContentType_PCT );
 
 	SetArray_Internal((char *)array, size*sizeof(vsRenderBuffer::PCT), BindType_Array);
 }
@@ -204,7 +357,7 @@ vsRenderBuffer::SetArray( const vsRenderBuffer::PCT *array, int size )
 void
 vsRenderBuffer::SetArray( const vsRenderBuffer::PNT *array, int size )
 {
-	m_contentType = ContentType_PNT;
+	SetContentType( ContentType_PNT );
 
 	SetArray_Internal((char *)array, size*sizeof(vsRenderBuffer::PNT), BindType_Array);
 }
@@ -212,7 +365,7 @@ vsRenderBuffer::SetArray( const vsRenderBuffer::PNT *array, int size )
 void
 vsRenderBuffer::SetArray( const vsRenderBuffer::PCN *array, int size )
 {
-	m_contentType = ContentType_PCN;
+	SetContentType( ContentType_PCN );
 
 	SetArray_Internal((char *)array, size*sizeof(vsRenderBuffer::PCN), BindType_Array);
 }
@@ -220,7 +373,7 @@ vsRenderBuffer::SetArray( const vsRenderBuffer::PCN *array, int size )
 void
 vsRenderBuffer::SetArray( const vsRenderBuffer::PCNT *array, int size )
 {
-	m_contentType = ContentType_PCNT;
+	SetContentType( ContentType_PCNT );
 
 	SetArray_Internal((char *)array, size*sizeof(vsRenderBuffer::PCNT), BindType_Array);
 }
@@ -228,21 +381,21 @@ vsRenderBuffer::SetArray( const vsRenderBuffer::PCNT *array, int size )
 void
 vsRenderBuffer::SetArray( const Slug *array, int size )
 {
-	m_contentType = ContentType_Slug;
+	SetContentType( ContentType_Slug );
 	SetArray_Internal((char *)array, size*sizeof(vsRenderBuffer::Slug), BindType_Array);
 }
 
 void
 vsRenderBuffer::SetArray( const vsMatrix4x4 *array, int size )
 {
-	m_contentType = ContentType_Matrix;
+	SetContentType( ContentType_Matrix );
 	SetArray_Internal((char *)array, size*sizeof(vsMatrix4x4), BindType_Array);
 }
 
 void
 vsRenderBuffer::SetArray( const vsVector3D *array, int size )
 {
-	m_contentType = ContentType_P;
+	SetContentType( ContentType_P );
 	SetArray_Internal((char *)array, size*sizeof(vsVector3D), BindType_Array);
 }
 
@@ -255,49 +408,49 @@ vsRenderBuffer::SetArray( const vsVector2D *array, int size )
 void
 vsRenderBuffer::SetArray( const vsColor *array, int size )
 {
-	m_contentType = ContentType_Color;
+	SetContentType( ContentType_Color );
 	SetArray_Internal((char *)array, size*sizeof(vsColor), BindType_Array);
 }
 
 void
 vsRenderBuffer::SetArray( const vsColorPacked *array, int size )
 {
-	m_contentType = ContentType_ColorPacked;
+	SetContentType( ContentType_ColorPacked );
 	SetArray_Internal((char *)array, size*sizeof(vsColorPacked), BindType_Array);
 }
 
 void
 vsRenderBuffer::SetArray( const uint16_t *array, int size )
 {
-	m_contentType = ContentType_UInt16;
+	SetContentType( ContentType_UInt16 );
 	SetArray_Internal((char *)array, size*sizeof(uint16_t), BindType_ElementArray);
 }
 
 void
 vsRenderBuffer::SetArray( const uint32_t *array, int size )
 {
-	m_contentType = ContentType_UInt32;
+	SetContentType( ContentType_UInt32 );
 	SetArray_Internal((char *)array, size*sizeof(uint32_t), BindType_ElementArray);
 }
 
 void
 vsRenderBuffer::SetArray( const float *array, int size )
 {
-	m_contentType = ContentType_Float;
+	SetContentType( ContentType_Float );
 	SetArray_Internal((char *)array, size*sizeof(float), BindType_TextureBuffer);
 }
 
 void
 vsRenderBuffer::SetArray( const vsVector4D_ui32 *array, int size )
 {
-	m_contentType = ContentType_UI32Vec4;
+	SetContentType( ContentType_UI32Vec4 );
 	SetArray_Internal((char *)array, size*sizeof(vsVector4D_ui32), BindType_TextureBuffer);
 }
 
 void
 vsRenderBuffer::SetArray( const vsVector4D_i32 *array, int size )
 {
-	m_contentType = ContentType_I32Vec4;
+	SetContentType( ContentType_I32Vec4 );
 	SetArray_Internal((char *)array, size*sizeof(vsVector4D_i32), BindType_TextureBuffer);
 }
 
@@ -342,27 +495,27 @@ vsRenderBuffer::BindAsAttribute( int attributeId )
 {
 	if ( m_contentType == ContentType_Matrix && m_vbo )
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
-		glVertexAttribPointer(attributeId, 4, GL_FLOAT, GL_FALSE, 64, 0);
-		glVertexAttribPointer(attributeId+1, 4, GL_FLOAT, GL_FALSE, 64, (void*)16);
-		glVertexAttribPointer(attributeId+2, 4, GL_FLOAT, GL_FALSE, 64, (void*)32);
-		glVertexAttribPointer(attributeId+3, 4, GL_FLOAT, GL_FALSE, 64, (void*)48);
+		char *base = BindGLBuffer(GL_ARRAY_BUFFER);
+		glVertexAttribPointer(attributeId, 4, GL_FLOAT, GL_FALSE, 64, base);
+		glVertexAttribPointer(attributeId+1, 4, GL_FLOAT, GL_FALSE, 64, base+16);
+		glVertexAttribPointer(attributeId+2, 4, GL_FLOAT, GL_FALSE, 64, base+32);
+		glVertexAttribPointer(attributeId+3, 4, GL_FLOAT, GL_FALSE, 64, base+48);
 #ifdef VS_PRISTINE_BINDINGS
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif
 	}
 	else if ( m_contentType == ContentType_Color && m_vbo )
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
-		glVertexAttribPointer(attributeId, 4, GL_FLOAT, GL_FALSE, 0, 0);
+		char *base = BindGLBuffer(GL_ARRAY_BUFFER);
+		glVertexAttribPointer(attributeId, 4, GL_FLOAT, GL_FALSE, 0, base);
 #ifdef VS_PRISTINE_BINDINGS
 		glBindBuffer(GL_ARRAY_BUFFER, 0 );
 #endif
 	}
 	else if ( m_contentType == ContentType_ColorPacked && m_vbo )
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
-		glVertexAttribPointer(attributeId, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, 0);
+		char *base = BindGLBuffer(GL_ARRAY_BUFFER);
+		glVertexAttribPointer(attributeId, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, base);
 #ifdef VS_PRISTINE_BINDINGS
 		glBindBuffer(GL_ARRAY_BUFFER, 0 );
 #endif
@@ -377,6 +530,7 @@ void
 vsRenderBuffer::BindAsTexture()
 {
 	GL_CHECK_SCOPED("BufferTexture");
+	vsAssert( !IsStreamed(), "Tried to bind a streamed buffer as a texture!" );
 	if ( m_contentType == ContentType_Float && m_vbo )
 	{
 		glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, m_bufferID);
@@ -422,8 +576,8 @@ vsRenderBuffer::BindVertexBuffer( vsRendererState *state )
 
 	if ( m_vbo )
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
-		glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, 0 );
+		char *base = BindGLBuffer(GL_ARRAY_BUFFER);
+		glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, base );
 #ifdef VS_PRISTINE_BINDINGS
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif
@@ -448,8 +602,8 @@ vsRenderBuffer::BindNormalBuffer( vsRendererState *state )
 
 	if ( m_vbo )
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
-		glVertexAttribPointer( NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, 0 );
+		char *base = BindGLBuffer(GL_ARRAY_BUFFER);
+		glVertexAttribPointer( NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, 0, base );
 #ifdef VS_PRISTINE_BINDINGS
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif //VS_PRISTINE_BINDINGS
@@ -473,8 +627,8 @@ vsRenderBuffer::BindTexelBuffer( vsRendererState *state )
 
 	if ( m_vbo )
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
-		glVertexAttribPointer( TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, 0, 0 );
+		char *base = BindGLBuffer(GL_ARRAY_BUFFER);
+		glVertexAttribPointer( TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, 0, base );
 #ifdef VS_PRISTINE_BINDINGS
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif // VS_PRISTINE_BINDINGS
@@ -499,8 +653,8 @@ vsRenderBuffer::BindColorBuffer( vsRendererState *state )
 
 	if ( m_vbo )
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
-		glVertexAttribPointer( COLOR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, 0, 0 );
+		char *base = BindGLBuffer(GL_ARRAY_BUFFER);
+		glVertexAttribPointer( COLOR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, 0, base );
 #ifdef VS_PRISTINE_BINDINGS
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif // VS_PRISTINE_BINDINGS
@@ -530,8 +684,8 @@ vsRenderBuffer::Bind( vsRendererState *state )
 
 			if ( m_vbo )
 			{
-				glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
-				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, 0 );
+				char *base = BindGLBuffer(GL_ARRAY_BUFFER);
+				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base );
 #ifdef VS_PRISTINE_BINDINGS
 				glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif // VS_PRISTINE_BINDINGS
@@ -547,17 +701,16 @@ vsRenderBuffer::Bind( vsRendererState *state )
 			PC dummyArray[2];
 			int stride = sizeof(PC);
 			size_t cStart = ((char*)&dummyArray[0].color.r - (char*)&dummyArray[0].position.x);
-			GLvoid* cStartPtr = (GLvoid*)cStart;
 
 			state->SetBool( vsRendererState::ClientBool_VertexArray, true );
 			state->SetBool( vsRendererState::ClientBool_ColorArray, true );
 
 			if ( m_vbo )
 			{
-				glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+				char *base = BindGLBuffer(GL_ARRAY_BUFFER);
 
-				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, 0 );
-				glVertexAttribPointer( COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, cStartPtr );
+				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base );
+				glVertexAttribPointer( COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + cStart );
 #ifdef VS_PRISTINE_BINDINGS
 				glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif // VS_PRISTINE_BINDINGS
@@ -574,17 +727,16 @@ vsRenderBuffer::Bind( vsRendererState *state )
 			PT dummyArray[2];
 			int stride = sizeof(PT);
 			size_t tStart = (&dummyArray[0].texel.x - &dummyArray[0].position.x) * sizeof(float);
-			GLvoid* tStartPtr = (GLvoid*)tStart;
 
 			state->SetBool( vsRendererState::ClientBool_VertexArray, true );
 			state->SetBool( vsRendererState::ClientBool_TextureCoordinateArray, true );
 
 			if ( m_vbo )
 			{
-				glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+				char *base = BindGLBuffer(GL_ARRAY_BUFFER);
 
-				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, 0 );
-				glVertexAttribPointer( TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, stride, tStartPtr );
+				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base );
+				glVertexAttribPointer( TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, stride, base + tStart );
 #ifdef VS_PRISTINE_BINDINGS
 				glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif // VS_PRISTINE_BINDINGS
@@ -601,17 +753,16 @@ vsRenderBuffer::Bind( vsRendererState *state )
 			PN dummyArray[2];
 			int stride = sizeof(PN);
 			size_t nStart = (&dummyArray[0].normal.x - &dummyArray[0].position.x) * sizeof(float);
-			GLvoid* nStartPtr = (GLvoid*)nStart;
 
 			state->SetBool( vsRendererState::ClientBool_VertexArray, true );
 			state->SetBool( vsRendererState::ClientBool_NormalArray, true );
 
 			if ( m_vbo )
 			{
-				glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+				char *base = BindGLBuffer(GL_ARRAY_BUFFER);
 
-				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, 0 );
-				glVertexAttribPointer( NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, nStartPtr );
+				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base );
+				glVertexAttribPointer( NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base + nStart );
 
 #ifdef VS_PRISTINE_BINDINGS
 				glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -630,8 +781,6 @@ vsRenderBuffer::Bind( vsRendererState *state )
 			int stride = sizeof(PNT);
 			size_t nStart = (&dummyArray[0].normal.x - &dummyArray[0].position.x) * sizeof(float);
 			size_t tStart = (&dummyArray[0].texel.x - &dummyArray[0].position.x) * sizeof(float);
-			GLvoid* nStartPtr = (GLvoid*)nStart;
-			GLvoid* tStartPtr = (GLvoid*)tStart;
 
 			state->SetBool( vsRendererState::ClientBool_VertexArray, true );
 			state->SetBool( vsRendererState::ClientBool_NormalArray, true );
@@ -639,11 +788,11 @@ vsRenderBuffer::Bind( vsRendererState *state )
 
 			if ( m_vbo )
 			{
-				glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+				char *base = BindGLBuffer(GL_ARRAY_BUFFER);
 
-				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, 0 );
-				glVertexAttribPointer( TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, stride, tStartPtr );
-				glVertexAttribPointer( NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, nStartPtr );
+				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base );
+				glVertexAttribPointer( TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, stride, base + tStart );
+				glVertexAttribPointer( NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base + nStart );
 
 #ifdef VS_PRISTINE_BINDINGS
 				glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -664,9 +813,6 @@ vsRenderBuffer::Bind( vsRendererState *state )
 			size_t nStart = (&dummyArray[0].normal.x - &dummyArray[0].position.x) * sizeof(float);
 			size_t tStart = (&dummyArray[0].texel.x - &dummyArray[0].position.x) * sizeof(float);
 			size_t cStart = ((char*)&dummyArray[0].color.r - (char*)&dummyArray[0].position.x);
-			GLvoid* cStartPtr = (GLvoid*)cStart;
-			GLvoid* nStartPtr = (GLvoid*)nStart;
-			GLvoid* tStartPtr = (GLvoid*)tStart;
 
 			state->SetBool( vsRendererState::ClientBool_VertexArray, true );
 			state->SetBool( vsRendererState::ClientBool_NormalArray, true );
@@ -675,12 +821,12 @@ vsRenderBuffer::Bind( vsRendererState *state )
 
 			if ( m_vbo )
 			{
-				glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+				char *base = BindGLBuffer(GL_ARRAY_BUFFER);
 
-				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, 0 );
-				glVertexAttribPointer( TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, stride, tStartPtr );
-				glVertexAttribPointer( NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, nStartPtr );
-				glVertexAttribPointer( COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, cStartPtr );
+				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base );
+				glVertexAttribPointer( TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, stride, base + tStart );
+				glVertexAttribPointer( NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base + nStart );
+				glVertexAttribPointer( COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + cStart );
 
 #ifdef VS_PRISTINE_BINDINGS
 				glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -701,8 +847,6 @@ vsRenderBuffer::Bind( vsRendererState *state )
 			int stride = sizeof(PCN);
 			size_t nStart = (&dummyArray[0].normal.x - &dummyArray[0].position.x) * sizeof(float);
 			size_t cStart = ((char*)&dummyArray[0].color.r - (char*)&dummyArray[0].position.x);
-			GLvoid* cStartPtr = (GLvoid*)cStart;
-			GLvoid* nStartPtr = (GLvoid*)nStart;
 
 			state->SetBool( vsRendererState::ClientBool_VertexArray, true );
 			state->SetBool( vsRendererState::ClientBool_NormalArray, true );
@@ -710,11 +854,11 @@ vsRenderBuffer::Bind( vsRendererState *state )
 
 			if ( m_vbo )
 			{
-				glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+				char *base = BindGLBuffer(GL_ARRAY_BUFFER);
 
-				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, 0 );
-				glVertexAttribPointer( NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, nStartPtr );
-				glVertexAttribPointer( COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, cStartPtr );
+				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base );
+				glVertexAttribPointer( NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base + nStart );
+				glVertexAttribPointer( COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + cStart );
 
 #ifdef VS_PRISTINE_BINDINGS
 				glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -734,8 +878,6 @@ vsRenderBuffer::Bind( vsRendererState *state )
 			int stride = sizeof(PCT);
 			size_t cStart = ((char*)&dummyArray[0].color.r - (char*)&dummyArray[0].position.x);
 			size_t tStart = (&dummyArray[0].texel.x - &dummyArray[0].position.x) * sizeof(float);
-			GLvoid* cStartPtr = (GLvoid*)cStart;
-			GLvoid* tStartPtr = (GLvoid*)tStart;
 
 			state->SetBool( vsRendererState::ClientBool_VertexArray, true );
 			state->SetBool( vsRendererState::ClientBool_ColorArray, true );
@@ -743,11 +885,11 @@ vsRenderBuffer::Bind( vsRendererState *state )
 
 			if ( m_vbo )
 			{
-				glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+				char *base = BindGLBuffer(GL_ARRAY_BUFFER);
 
-				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, 0 );
-				glVertexAttribPointer( TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, stride, tStartPtr );
-				glVertexAttribPointer( COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, cStartPtr );
+				glVertexAttribPointer( POS_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, base );
+				glVertexAttribPointer( TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, stride, base + tStart );
+				glVertexAttribPointer( COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + cStart );
 
 #ifdef VS_PRISTINE_BINDINGS
 				glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -773,13 +915,13 @@ vsRenderBuffer::Bind( vsRendererState *state )
 
 			if ( m_vbo )
 			{
-				glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+				char *base = BindGLBuffer(GL_ARRAY_BUFFER);
 
-				glVertexAttribPointer( 0, 4, GL_FLOAT, GL_FALSE, stride, 0 );
-				glVertexAttribPointer( 1, 4, GL_FLOAT, GL_FALSE, stride, (char*)16 );
-				glVertexAttribPointer( 2, 4, GL_FLOAT, GL_FALSE, stride, (char*)32 );
-				glVertexAttribPointer( 3, 4, GL_FLOAT, GL_FALSE, stride, (char*)48 );
-				glVertexAttribPointer( 4, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (char*)64 );
+				glVertexAttribPointer( 0, 4, GL_FLOAT, GL_FALSE, stride, base );
+				glVertexAttribPointer( 1, 4, GL_FLOAT, GL_FALSE, stride, base + 16 );
+				glVertexAttribPointer( 2, 4, GL_FLOAT, GL_FALSE, stride, base + 32 );
+				glVertexAttribPointer( 3, 4, GL_FLOAT, GL_FALSE, stride, base + 48 );
+				glVertexAttribPointer( 4, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + 64 );
 
 				glVertexAttribDivisor(4, 0);
 
@@ -1088,10 +1230,10 @@ vsRenderBuffer::TriStripBuffer(int instanceCount)
 {
 	if ( m_vbo )
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufferID);
+		char *base = BindGLBuffer(GL_ELEMENT_ARRAY_BUFFER);
 		//glDrawElements(GL_TRIANGLE_STRIP, m_activeBytes/sizeof(int), GL_UNSIGNED_INT, 0);
 		// glDrawElements(GL_TRIANGLE_STRIP, m_activeBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, 0 );
-		glDrawElementsInstanced(GL_TRIANGLE_STRIP, m_activeBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, 0, instanceCount);
+		glDrawElementsInstanced(GL_TRIANGLE_STRIP, m_glActiveBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, base, instanceCount);
 #ifdef VS_PRISTINE_BINDINGS
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 #endif // VS_PRISTINE_BINDINGS
@@ -1108,7 +1250,7 @@ vsRenderBuffer::TriListBuffer(int instanceCount)
 {
 	if ( m_vbo )
 	{
-		int elements = m_activeBytes/sizeof(uint16_t);
+		int elements = m_glActiveBytes/sizeof(uint16_t);
 		// vsString prf;// = "TriListBuffer";
 		// if ( elements <= 6 )
 		// 	prf = "TriListBufferTiny";
@@ -1119,14 +1261,14 @@ vsRenderBuffer::TriListBuffer(int instanceCount)
 		// {
 		// PROFILE_GL(prf);
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufferID);
+		char *base = BindGLBuffer(GL_ELEMENT_ARRAY_BUFFER);
 		if ( instanceCount == 1 )
 		{
-			glDrawElements(GL_TRIANGLES, elements, GL_UNSIGNED_SHORT, 0);
+			glDrawElements(GL_TRIANGLES, elements, GL_UNSIGNED_SHORT, base);
 		}
 		else
 		{
-			glDrawElementsInstanced(GL_TRIANGLES, elements, GL_UNSIGNED_SHORT, 0, instanceCount);
+			glDrawElementsInstanced(GL_TRIANGLES, elements, GL_UNSIGNED_SHORT, base, instanceCount);
 		}
 		// }
 		//glDrawRangeElements(GL_TRIANGLES, 0, m_activeBytes/sizeof(uint16_t), m_activeBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, 0);
@@ -1144,9 +1286,9 @@ vsRenderBuffer::TriFanBuffer(int instanceCount)
 {
 	if ( m_vbo )
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufferID);
+		char *base = BindGLBuffer(GL_ELEMENT_ARRAY_BUFFER);
 		// glDrawElements(GL_TRIANGLE_FAN, m_activeBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, 0);
-		glDrawElementsInstanced(GL_TRIANGLE_FAN, m_activeBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, 0, instanceCount);
+		glDrawElementsInstanced(GL_TRIANGLE_FAN, m_glActiveBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, base, instanceCount);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 	else
@@ -1161,8 +1303,8 @@ vsRenderBuffer::LineStripBuffer(int instanceCount)
 {
 	if ( m_vbo )
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufferID);
-		glDrawElementsInstanced(GL_LINE_STRIP, m_activeBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, 0, instanceCount);
+		char *base = BindGLBuffer(GL_ELEMENT_ARRAY_BUFFER);
+		glDrawElementsInstanced(GL_LINE_STRIP, m_glActiveBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, base, instanceCount);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 	else
@@ -1177,8 +1319,8 @@ vsRenderBuffer::LineListBuffer(int instanceCount)
 {
 	if ( m_vbo )
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufferID);
-		glDrawElementsInstanced(GL_LINES, m_activeBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, 0, instanceCount);
+		char *base = BindGLBuffer(GL_ELEMENT_ARRAY_BUFFER);
+		glDrawElementsInstanced(GL_LINES, m_glActiveBytes/sizeof(uint16_t), GL_UNSIGNED_SHORT, base, instanceCount);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 	else
@@ -1195,6 +1337,16 @@ static int g_vboCursor = VBO_SIZE;
 void
 vsRenderBuffer::BindArrayToAttribute( void* buffer, size_t bufferSize, int attribute, int elementCount )
 {
+	vsStreamingBuffer *stream = vsStreamingBuffer::Instance();
+	size_t offset;
+	if ( stream && stream->Upload( buffer, bufferSize, &offset ) )
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, stream->GetBufferID());
+		glVertexAttribPointer( attribute, elementCount, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid*>(offset) );
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return;
+	}
+
 	vsAssert(bufferSize < VBO_SIZE, "Tried to bind too large an array for VBO_SIZE?");
 	if ( g_vbo == 0xffffffff )
 	{
@@ -1280,6 +1432,19 @@ void
 vsRenderBuffer::DrawElementsImmediate( int type, void* buffer, int count, int instanceCount )
 {
 	int bufferSize = count * sizeof(uint16_t);
+
+	vsStreamingBuffer *stream = vsStreamingBuffer::Instance();
+	size_t offset;
+	if ( stream && stream->Upload( buffer, bufferSize, &offset ) )
+	{
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, stream->GetBufferID());
+		glDrawElementsInstanced(type, count, GL_UNSIGNED_SHORT, reinterpret_cast<GLvoid*>(offset), instanceCount );
+#ifdef VS_PRISTINE_BINDINGS
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+#endif // VS_PRISTINE_BINDINGS
+		return;
+	}
+
 	if ( g_evbo == 0xffffffff )
 	{
 		glGenBuffers(1, &g_evbo);
@@ -1306,6 +1471,8 @@ vsRenderBuffer::DrawElementsImmediate( int type, void* buffer, int count, int in
 void*
 vsRenderBuffer::BindRange(int startByte, int length)
 {
+	vsAssert( m_type != Type_Stream, "BindRange() isn't supported on Type_Stream buffers" );
+	vsRenderThread::Sync();
 	GL_CHECK_SCOPED("BindRange");
 	if ( m_vbo )
 	{
@@ -48,7 +48,7 @@ public:
 
 		Type_Static,		// we're going to set this only once, then render over and over again
 		Type_Dynamic,		// we're going to change these values from time to time
-		Type_Stream,		// we're going to write data into here once per render.
+		Type_Stream,		// we're going to write data into here once per render.  (Lives in the vsStreamingBuffer, if there's room)
 
 		TYPE_MAX
 	};
@@ -89,6 +89,31 @@ private:
 	bool			m_vbo;
 	BindType		m_bindType;
 
+	// Type_Stream buffers put their data into the vsStreamingBuffer when they
+	// can, rather than into m_bufferID.  These say where the data we draw
+	// from actually is right now, and how much of it there is.
+	unsigned int	m_glBufferID;
+	size_t			m_glOffset;
+	int				m_glActiveBytes;
+	uint32_t		m_streamFrame;		// vsStreamingBuffer frame our data was written in
+
+	// While a pipelined frame is in flight, the main thread can refill a
+	// Type_Stream buffer which was filled for that frame without waiting for
+	// it.  The new data goes into the streaming buffer's region for the next
+	// frame, and where to find it waits here until that frame is submitted.
+	uint32_t		m_filledFrame;		// vsStreamingBuffer frame we were last filled for;  main thread only
+	size_t			m_pendingOffset;
+	int				m_pendingBytes;
+	bool			m_pending;
+	vsRenderBuffer *m_nextPending;
+
+	static vsRenderBuffer *s_pendingList;
+
+	bool	IsStreamed() const { return m_glBufferID != m_bufferID; }
+	char *	BindGLBuffer( int bindPoint );	// returns our data's offset within the bound buffer
+
+	bool	SetArrayWithoutSync( char *data, int bytes, BindType bindType );
+	void	UploadToOwnBuffer( char *data, int bytes );
 	void	SetArray_Internal( char *data, int bytes, BindType bindType);
 	void	SetArraySize_Internal( int bytes );
 	void	ResizeArray_Internal( int bytes ); // like the above, but retain saved array data.
@@ -204,7 +229,7 @@ public:
 	int				GetGenericArraySize() const { return m_activeBytes; }
 
 	int				GetMatrix4x4ArraySize() const { return m_activeBytes/sizeof(vsMatrix4x4); }
-	int				GetActiveMatrix4x4ArraySize() const { return m_activeBytes/sizeof(vsMatrix4x4); }
+	int				GetActiveMatrix4x4ArraySize() const { return m_glActiveBytes/sizeof(vsMatrix4x4); }	// as drawn;  for the renderer
 
 	P *				GetPArray() { return (P*)m_array; }
 	PN *			GetPNArray() { return (PN*)m_array; }
@@ -228,7 +253,7 @@ public:
 	// Probably only useful for santity checking that the correct drawing
 	// functions are being called, for our known buffer types.
 	ContentType	GetContentType() const { return m_contentType; }
-	void	SetContentType(ContentType ct) { m_contentType = ct; }
+	void	SetContentType(ContentType ct);
 
 	void	BindAsAttribute( int attributeId );
 	void	BindAsTexture();
@@ -257,6 +282,10 @@ public:
 
 	static void DrawElementsImmediate( int type, void* buffer, int count, int instanceCount );
 
+	// vsRenderThread calls this once it knows the frame in flight is done,
+	// to point buffers refilled without syncing at their new data.
+	static void CommitPendingUploads();
+
 	void	TriStripBuffer(int instanceCount);
 	void	TriListBuffer(int instanceCount);
 	void	TriFanBuffer(int instanceCount);
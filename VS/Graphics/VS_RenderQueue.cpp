@@ -18,31 +18,55 @@
 #include "VS_DynamicBatchManager.h"
 
 #include "VS_MaterialInternal.h"
+#include "VS_RenderThread.h"
 
-#include "VS/VS_DisableDebugNew.h"
-#include <map>
-#include "VS/VS_EnableDebugNew.h"
+#include "VS/Memory/VS_FrameArena.h"
+#include "VS/Utils/VS_OpenHashTable.h"
 
 #include "VS_Profile.h"
 
 class vsRenderQueueStage
 {
 public:
-	struct BatchMap;
 	struct BatchElement;
 	struct Batch;
+	struct SortItem
+	{
+		uint64_t		key;
+		BatchElement *	element;
+	};
 private:
 
-	BatchMap*			m_batchMap;
+	// Batches and BatchElements live in the frame arena, so we just forget
+	// about them in EndRender().  m_batchLookup finds this frame's batch for
+	// each material.
+	vsOpenHashTable<Batch*>	m_batchLookup;
 	Batch*				m_batch;
+	Batch*				m_lastBatch;
 	int					m_batchCount;
 
-	Batch *				m_batchPool;
-	BatchElement * 		m_batchElementPool;
-
+	// temporary display lists' buffers are in the frame arena too, but the
+	// lists themselves need to be destroyed.
 	vsLinkedListStore<vsDisplayList>	m_temporaryLists;
 
+	// the camera this frame's elements are sorted against.  Without a view
+	// direction (that is, in 2D) we don't sort by depth.
+	vsVector3D			m_viewPosition;
+	vsVector3D			m_viewDirection;
+	bool				m_sortByDepth;
+
+	// flat arrays of every element in this stage.  Each element's sort key
+	// is calculated as it's added, while the element is still in cache, and
+	// then we sort them during Draw(), ping-ponging between the two arrays.
+	vsArray<SortItem>	m_sortItem;
+	vsArray<SortItem>	m_sortScratch;
+
+	int					m_elidedOpCount;	// redundant display list ops we skipped during the last Draw()
+
 	Batch *			FindBatch( vsMaterial *material );
+	BatchElement *	NewBatchElement();
+	void			AddElement( Batch *batch, BatchElement *element );
+	void			SortItems();
 
 
 public:
@@ -50,10 +74,12 @@ public:
 	vsRenderQueueStage();
 	~vsRenderQueueStage();
 
-	void			StartRender();
+	void			StartRender( const vsVector3D &viewPosition, const vsVector3D &viewDirection );
 	void			Draw( vsDisplayList *list );	// write our batches into here.
 	void			EndRender();
 
+	int				GetElidedOpCount() const { return m_elidedOpCount; }
+
 	// Add a batch to this stage
 	void			AddBatch( vsMaterial *material, const vsMatrix4x4 &matrix, vsDisplayList *batch );
 	void			AddSimpleBatch( vsMaterial *material, const vsMatrix4x4 &matrix, vsRenderBuffer* vbo, vsRenderBuffer* ibo, vsFragment::SimpleType type );
@@ -105,23 +131,6 @@ struct vsRenderQueueStage::BatchElement
 		batch(nullptr)
 	{
 	}
-
-	void Clear()
-	{
-		material = nullptr;
-		shaderValues = nullptr;
-		shaderOptions = nullptr;
-		instanceMatrix = nullptr;
-		instanceMatrixCount = 0;
-		instanceMatrixBuffer = nullptr;
-		instanceColorBuffer = nullptr;
-		instanceColor = nullptr;
-		list = nullptr;
-		vbo = nullptr;
-		ibo = nullptr;
-		batch = nullptr;
-	}
-
 };
 
 struct vsRenderQueueStage::Batch
@@ -129,111 +138,184 @@ struct vsRenderQueueStage::Batch
 	vsMaterialInternal*	material;
 	BatchElement*		elementList;
 	Batch*				next;
+	uint64_t			sortKey;	// the material's contribution to its elements' sort keys
+	int					index;		// the order this batch was created in, this frame
 
 	Batch();
-	~Batch();
-};
-
-struct vsRenderQueueStage::BatchMap
-{
-	std::map<vsMaterialInternal*,vsRenderQueueStage::Batch*> map;
 };
 
 vsRenderQueueStage::Batch::Batch():
 	material(nullptr),
 	elementList(nullptr),
-	next(nullptr)
-{
-}
-
-vsRenderQueueStage::Batch::~Batch()
+	next(nullptr),
+	sortKey(0),
+	index(0)
 {
 }
 
 vsRenderQueueStage::vsRenderQueueStage():
-	m_batchMap(new BatchMap),
+	m_batchLookup(64),
 	m_batch(nullptr),
+	m_lastBatch(nullptr),
 	m_batchCount(0),
-	m_batchPool(nullptr),
-	m_batchElementPool(nullptr)
+	m_viewPosition(vsVector3D::Zero),
+	m_viewDirection(vsVector3D::Zero),
+	m_sortByDepth(false),
+	m_elidedOpCount(0)
 {
 }
 
 vsRenderQueueStage::~vsRenderQueueStage()
 {
-	vsDelete( m_batchMap );
-	while( m_batchPool )
+}
+
+// Sort keys are laid out like this, from the most significant bit down:
+//
+//   opaque:   [ layer:8 ][ 0 ][ shader:15 ][ texture:16 ][ depth:24 ]
+//   blended:  [ layer:8 ][ 1 ][ inverted depth:24 ][ batch index:31 ]
+//
+// So within each layer, everything opaque draws before everything blended.
+// Opaque elements are grouped by shader and texture to minimise state
+// changes, and then drawn front-to-back to minimise overdraw.  Blended
+// elements must draw back-to-front to blend correctly, so depth comes first
+// for them;  blended elements at the same depth then draw batch by batch,
+// since their order is visible.  (Stages are drawn in a fixed order by
+// vsRenderQueue, so each stage sorts its own elements independently)
+//
+// Without a view direction (that is, in 2D) every element has the same
+// depth, and we don't reorder by material either;  instead, keys are:
+//
+//   unsorted: [ layer:8 ][ batch index:56 ]
+//
+// which draws batches by layer and then in the order they were created,
+// exactly as we did before we sorted by key.
+static const int c_sortLayerShift = 56;
+static const int c_sortBlendShift = 55;
+static const int c_sortShaderShift = 40;
+static const int c_sortTextureShift = 24;
+static const int c_sortBlendedDepthShift = 31;
+
+// Below this many elements, a merge sort beats a radix sort which needs
+// more than a couple of passes.
+static const int c_radixSortMinCount = 1024;
+static const int c_radixSortMaxSmallPasses = 2;
+static const int c_mergeSortRunLength = 16;
+
+static uint64_t
+HashPointerBits( const void *p, int bits )
+{
+	// Fibonacci hashing;  we only need pointers to the same object to group
+	// together, so the occasional collision is harmless.
+	return ( (uint64_t)(uintptr_t)p * 0x9E3779B97F4A7C15ull ) >> (64 - bits);
+}
+
+static uint64_t
+CalculateMaterialSortKey( const vsMaterialInternal *material )
+{
+	uint64_t layer = (uint64_t)vsClamp( material->m_layer, -128, 127 ) + 128;
+	uint64_t key = layer << c_sortLayerShift;
+	if ( material->m_blend )
 	{
-		Batch *b = m_batchPool;
-		m_batchPool = m_batchPool->next;
-		vsDelete(b);
+		key |= 1ull << c_sortBlendShift;
 	}
-	while( m_batchElementPool )
+	else
 	{
-		BatchElement *e = m_batchElementPool;
-		m_batchElementPool = m_batchElementPool->next;
-		vsDelete(e);
+		key |= HashPointerBits( material->m_shader, 15 ) << c_sortShaderShift;
+		key |= HashPointerBits( material->GetTexture(0), 16 ) << c_sortTextureShift;
 	}
+	return key;
+}
+
+static uint32_t
+CalculateDepthBits( float depth )
+{
+	// Flip the float's bits so that they sort correctly as an unsigned
+	// integer, then keep the top 24 bits (sign, exponent, and the top 15 bits
+	// of the mantissa).
+	uint32_t bits;
+	memcpy( &bits, &depth, sizeof(bits) );
+	if ( bits & 0x80000000 )
+		bits = ~bits;
+	else
+		bits |= 0x80000000;
+	return bits >> 8;
+}
+
+// When pipelining, the render thread doesn't read our display list until
+// we've moved on to the next frame, by which time the owners of instance
+// arrays may have changed them.  So give it a copy which lasts that long.
+template<typename T>
+static const T *
+FrameArray( const T *array, int count )
+{
+	if ( vsRenderThread::Instance() )
+		return vsFrameArena::Instance()->Copy( array, count );
+	return array;
 }
 
 vsRenderQueueStage::Batch *
 vsRenderQueueStage::FindBatch( vsMaterial *material )
 {
-	std::map<vsMaterialInternal*, vsRenderQueueStage::Batch*>::iterator it = m_batchMap->map.find(material->GetResource());
-	if ( it != m_batchMap->map.end() )
+	vsMaterialInternal *resource = material->GetResource();
+	uint32_t hash = (uint32_t)HashPointerBits( resource, 32 );
+	int slot = m_batchLookup.Find( hash, [resource]( Batch *b ) { return b->material == resource; } );
+	if ( slot >= 0 )
 	{
-		return it->second;
+		return m_batchLookup.GetSlot(slot);
 	}
 
-	if ( !m_batchPool )
-	{
-		m_batchPool = new Batch;
-	}
-	Batch *batch = m_batchPool;
-	m_batchPool = batch->next;
-	batch->next = nullptr;
-	batch->material = material->GetResource();
+	Batch *batch = vsFrameArena::Instance()->Alloc<Batch>();
+	batch->material = resource;
 
-	// insert this batch into our batch list, SORTED.
-	bool inserted = false;
+	batch->sortKey = CalculateMaterialSortKey( batch->material );
+	batch->index = m_batchCount;
 
-	if ( m_batch == nullptr )
-	{
+	// Batches are drawn in the order our sort keys dictate, so we just
+	// append this batch to the end of our list.
+	if ( m_lastBatch )
+		m_lastBatch->next = batch;
+	else
 		m_batch = batch;
+	m_lastBatch = batch;
+	m_batchCount++;
+	m_batchLookup.Insert( hash, batch );
+
+	return batch;
+}
+
+vsRenderQueueStage::BatchElement *
+vsRenderQueueStage::NewBatchElement()
+{
+	return vsFrameArena::Instance()->Alloc<BatchElement>();
+}
+
+void
+vsRenderQueueStage::AddElement( Batch *batch, BatchElement *element )
+{
+	element->next = batch->elementList;
+	batch->elementList = element;
+
+	SortItem item;
+	item.element = element;
+	if ( !m_sortByDepth )
+	{
+		item.key = ( batch->sortKey & (0xffull << c_sortLayerShift) ) | (uint64_t)batch->index;
 	}
 	else
 	{
-		if ( m_batch->material->m_layer > material->GetResource()->m_layer )
-		{
-			// we should sort before the first thing in the batch list.
-			batch->next = m_batch;
-			m_batch = batch;
-			inserted = true;
-		}
+		// instanced elements don't have a single position, so they sort
+		// as though they're at the camera.
+		float depth = 0.f;
+		if ( !element->instanceMatrix && !element->instanceMatrixBuffer )
+			depth = ( vsVector3D(element->matrix.w) - m_viewPosition ).Dot( m_viewDirection );
+
+		uint64_t depthBits = CalculateDepthBits( depth );
+		if ( batch->sortKey & (1ull << c_sortBlendShift) )
+			item.key = batch->sortKey | ( (uint64_t)(~depthBits & 0xffffff) << c_sortBlendedDepthShift ) | (uint64_t)batch->index;
 		else
-		{
-			Batch *lb;
-			for(lb = m_batch; lb->next; lb = lb->next)
-			{
-				if ( lb->next->material->m_layer > material->GetResource()->m_layer )
-				{
-					batch->next = lb->next;
-					lb->next = batch;
-					inserted = true;
-					break;
-				}
-			}
-
-			if ( !inserted )
-			{
-				lb->next = batch;
-			}
-		}
+			item.key = batch->sortKey | depthBits;
 	}
-	m_batchCount++;
-	m_batchMap->map[material->GetResource()] = batch;
-
-	return batch;
+	m_sortItem.AddItem( item );
 }
 
 
@@ -242,14 +324,7 @@ vsRenderQueueStage::AddBatch( vsMaterial *material, const vsMatrix4x4 &matrix, v
 {
 	Batch *batch = FindBatch(material);
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = nullptr;
-	element->Clear();
+	BatchElement *element = NewBatchElement();
 
 	element->material = material;
 	element->matrix = matrix;
@@ -258,8 +333,7 @@ vsRenderQueueStage::AddBatch( vsMaterial *material, const vsMatrix4x4 &matrix, v
 	element->instanceMatrixBuffer = nullptr;
 	element->instanceColorBuffer = nullptr;
 
-	element->next = batch->elementList;
-	batch->elementList = element;
+	AddElement( batch, element );
 }
 
 void
@@ -347,15 +421,7 @@ vsRenderQueueStage::AddSimpleBatch( vsMaterial *material, const vsMatrix4x4 &mat
 		}
 	}
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = nullptr;
-	element->Clear();
+	BatchElement *element = NewBatchElement();
 
 	element->material = material;
 	element->matrix = matrix;
@@ -367,8 +433,7 @@ vsRenderQueueStage::AddSimpleBatch( vsMaterial *material, const vsMatrix4x4 &mat
 	element->instanceMatrixBuffer = nullptr;
 	element->instanceColorBuffer = nullptr;
 
-	element->next = batch->elementList;
-	batch->elementList = element;
+	AddElement( batch, element );
 }
 
 void
@@ -376,14 +441,7 @@ vsRenderQueueStage::AddInstanceBatch( vsMaterial *material, const vsMatrix4x4 *m
 {
 	Batch *batch = FindBatch(material);
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = nullptr;
-	element->Clear();
+	BatchElement *element = NewBatchElement();
 
 	element->instanceMatrixCount = matrixCount;
 	element->instanceMatrix = matrix;
@@ -391,8 +449,7 @@ vsRenderQueueStage::AddInstanceBatch( vsMaterial *material, const vsMatrix4x4 *m
 	element->instanceColorBuffer = nullptr;
 	element->list = batchList;
 
-	element->next = batch->elementList;
-	batch->elementList = element;
+	AddElement( batch, element );
 }
 
 void
@@ -400,14 +457,7 @@ vsRenderQueueStage::AddInstanceBatch( vsMaterial *material, vsRenderBuffer *matr
 {
 	Batch *batch = FindBatch(material);
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = nullptr;
-	element->Clear();
+	BatchElement *element = NewBatchElement();
 
 	element->material = material;
 	element->shaderValues = values;
@@ -416,8 +466,7 @@ vsRenderQueueStage::AddInstanceBatch( vsMaterial *material, vsRenderBuffer *matr
 	element->instanceColorBuffer = colorBuffer;
 	element->list = batchList;
 
-	element->next = batch->elementList;
-	batch->elementList = element;
+	AddElement( batch, element );
 }
 
 void
@@ -425,14 +474,7 @@ vsRenderQueueStage::AddInstanceBatch( vsMaterial *material, const vsMatrix4x4 *m
 {
 	Batch *batch = FindBatch(material);
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = nullptr;
-	element->Clear();
+	BatchElement *element = NewBatchElement();
 
 	element->material = material;
 	element->shaderValues = values;
@@ -442,22 +484,14 @@ vsRenderQueueStage::AddInstanceBatch( vsMaterial *material, const vsMatrix4x4 *m
 	element->instanceColor = color;
 	element->list = batchList;
 
-	element->next = batch->elementList;
-	batch->elementList = element;
+	AddElement( batch, element );
 }
 void
 vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix, int matrixCount, vsRenderBuffer *vbo, vsRenderBuffer *ibo, vsFragment::SimpleType simpleType )
 {
 	Batch *batch = FindBatch(material);
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = nullptr;
-	element->Clear();
+	BatchElement *element = NewBatchElement();
 
 	element->instanceMatrixCount = matrixCount;
 	element->instanceMatrix = matrix;
@@ -467,8 +501,7 @@ vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix
 	element->ibo = ibo;
 	element->simpleType = simpleType;
 
-	element->next = batch->elementList;
-	batch->elementList = element;
+	AddElement( batch, element );
 }
 
 void
@@ -476,14 +509,7 @@ vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, vsRenderBuffer
 {
 	Batch *batch = FindBatch(material);
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = nullptr;
-	element->Clear();
+	BatchElement *element = NewBatchElement();
 
 	element->material = material;
 	element->shaderValues = values;
@@ -494,8 +520,7 @@ vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, vsRenderBuffer
 	element->ibo = ibo;
 	element->simpleType = simpleType;
 
-	element->next = batch->elementList;
-	batch->elementList = element;
+	AddElement( batch, element );
 }
 
 void
@@ -503,14 +528,7 @@ vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix
 {
 	Batch *batch = FindBatch(material);
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = nullptr;
-	element->Clear();
+	BatchElement *element = NewBatchElement();
 
 	element->material = material;
 	element->shaderValues = values;
@@ -522,8 +540,7 @@ vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix
 	element->ibo = ibo;
 	element->simpleType = simpleType;
 
-	element->next = batch->elementList;
-	batch->elementList = element;
+	AddElement( batch, element );
 }
 
 vsDisplayList *
@@ -531,126 +548,341 @@ vsRenderQueueStage::MakeTemporaryBatchList( vsMaterial *material, const vsMatrix
 {
 	Batch *batch = FindBatch(material);
 
-	if ( m_batchElementPool == nullptr )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = m_batchElementPool->next;
-	element->next = nullptr;
-	element->Clear();
+	BatchElement *element = NewBatchElement();
 
 	element->material = material;
 	element->matrix = matrix;
-	element->list = new vsDisplayList(size);
+	element->list = new vsDisplayList( (char*)vsFrameArena::Instance()->Alloc(size), size );
 
-	element->next = batch->elementList;
-	batch->elementList = element;
+	AddElement( batch, element );
 	m_temporaryLists.AddItem(element->list);
 
 	return element->list;
 }
 
 void
-vsRenderQueueStage::StartRender()
+vsRenderQueueStage::StartRender( const vsVector3D &viewPosition, const vsVector3D &viewDirection )
 {
 	m_batchCount = 0;
+	m_elidedOpCount = 0;
+	m_viewPosition = viewPosition;
+	m_viewDirection = viewDirection;
+	m_sortByDepth = ( viewDirection != vsVector3D::Zero );
 	vsAssert( m_batch == nullptr, "Batches not cleared?" );
 	//	m_batch = nullptr;
 
 
 }
 
+void
+vsRenderQueueStage::SortItems()
+{
+	int count = m_sortItem.ItemCount();
+	if ( count < 2 )
+		return;
+	if ( m_sortScratch.ItemCount() < count )
+		m_sortScratch.SetArraySize( count );
+
+	SortItem *from = &m_sortItem[0];
+	SortItem *to = &m_sortScratch[0];
+
+	// Our items are in the order they were added, but each batch's element
+	// list is newest first, and that's the order we've always drawn
+	// elements with identical keys in.  Our sorts are stable, so reverse the
+	// items before sorting to keep it that way.
+	for ( int i = 0, j = count-1; i < j; i++, j-- )
+	{
+		SortItem swap = from[i];
+		from[i] = from[j];
+		from[j] = swap;
+	}
+
+	// Most of our keys share most of their bytes (same layer, all blended,
+	// no depth in 2D, etc), so find out which bytes actually vary.  A radix
+	// sort only needs one pass for each of those.
+	uint64_t keyOr = 0;
+	uint64_t keyAnd = ~0ull;
+	for ( int i = 0; i < count; i++ )
+	{
+		keyOr |= from[i].key;
+		keyAnd &= from[i].key;
+	}
+	uint64_t varyingBits = keyOr ^ keyAnd;
+	if ( varyingBits == 0 )
+		return;	// every key is the same, so we're already in order.
+
+	int passCount = 0;
+	for ( int pass = 0; pass < 8; pass++ )
+	{
+		if ( (varyingBits >> (pass*8)) & 0xff )
+			passCount++;
+	}
+
+	if ( count < c_radixSortMinCount && passCount > c_radixSortMaxSmallPasses )
+	{
+		// Each radix pass has a fixed cost of walking its histogram, which
+		// is more than sorting a small stage costs, so we do a stable merge
+		// sort instead.  Start by insertion sorting short runs, then merge
+		// them together, ping-ponging between our two arrays.
+		for ( int start = 0; start < count; start += c_mergeSortRunLength )
+		{
+			int end = vsMin( start + c_mergeSortRunLength, count );
+			for ( int i = start+1; i < end; i++ )
+			{
+				SortItem value = from[i];
+				int j = i;
+				for ( ; j > start && from[j-1].key > value.key; j-- )
+					from[j] = from[j-1];
+				from[j] = value;
+			}
+		}
+		for ( int width = c_mergeSortRunLength; width < count; width *= 2 )
+		{
+			for ( int start = 0; start < count; start += width * 2 )
+			{
+				int mid = vsMin( start + width, count );
+				int end = vsMin( start + width * 2, count );
+				int a = start, b = mid, out = start;
+				while ( a < mid && b < end )
+					to[out++] = ( from[b].key < from[a].key ) ? from[b++] : from[a++];
+				while ( a < mid )
+					to[out++] = from[a++];
+				while ( b < end )
+					to[out++] = from[b++];
+			}
+			SortItem *swap = from;
+			from = to;
+			to = swap;
+		}
+	}
+	else
+	{
+		// Stable LSD radix sort, one byte at a time, skipping the bytes
+		// which don't vary.
+		int histogram[256];
+		for ( int pass = 0; pass < 8; pass++ )
+		{
+			int shift = pass * 8;
+			if ( ((varyingBits >> shift) & 0xff) == 0 )
+				continue;
+
+			memset( histogram, 0, sizeof(histogram) );
+			for ( int i = 0; i < count; i++ )
+				histogram[ (from[i].key >> shift) & 0xff ]++;
+
+			int offset = 0;
+			for ( int b = 0; b < 256; b++ )
+			{
+				int bucketCount = histogram[b];
+				histogram[b] = offset;
+				offset += bucketCount;
+			}
+			for ( int i = 0; i < count; i++ )
+				to[ histogram[ (from[i].key >> shift) & 0xff ]++ ] = from[i];
+
+			SortItem *swap = from;
+			from = to;
+			to = swap;
+		}
+	}
+
+	if ( from != &m_sortItem[0] )
+		memcpy( &m_sortItem[0], from, sizeof(SortItem) * count );
+}
+
 void
 vsRenderQueueStage::Draw( vsDisplayList *list )
 {
-	for (Batch *b = m_batch; b; b = b->next)
+	SortItems();
+
+	// Consecutive elements very often share state (especially once they've
+	// been sorted), so we remember what we last emitted into 'list' and skip
+	// anything which would be redundant.  Anything we're still holding when
+	// we're done gets cleaned up after the loop, so the list ends in the same
+	// state it would have if we'd emitted everything.
+	vsMaterial *lastMaterial = nullptr;
+
+	bool transformPushed = false;
+	bool transformKnown = true;
+	vsMatrix4x4 lastMatrix;
+	const vsMatrix4x4 *lastInstanceMatrix = nullptr;
+	int lastInstanceMatrixCount = 0;
+	vsRenderBuffer *lastInstanceMatrixBuffer = nullptr;
+
+	bool shaderValuesKnown = true;
+	vsShaderValues *lastShaderValues = nullptr;
+	vsShaderOptions *lastShaderOptions = nullptr;
+
+	// instance colors are reset by SetMaterial.
+	bool colorsSet = false;
+	const vsColor *lastColors = nullptr;
+	int lastColorsCount = 0;
+	vsRenderBuffer *lastColorsBuffer = nullptr;
+
+	for ( int i = 0; i < m_sortItem.ItemCount(); i++ )
 	{
-		for (BatchElement *e = b->elementList; e; e = e->next)
+		BatchElement *e = m_sortItem[i].element;
+		bool hasColors = !e->batch && ( e->instanceColorBuffer || e->instanceColor );
+
+		// If the last element left instance colors set and we don't want
+		// them, SetMaterial is the only way to clear them.
+		if ( e->material != lastMaterial || (colorsSet && !hasColors) )
 		{
 			list->SetMaterial( e->material );
-			if ( e->batch )
+			lastMaterial = e->material;
+			colorsSet = false;
+		}
+		else
+			m_elidedOpCount++;
+
+		// Work out which transform this element wants.
+		const vsMatrix4x4 *instanceMatrix = nullptr;
+		int instanceMatrixCount = 0;
+		vsRenderBuffer *instanceMatrixBuffer = nullptr;
+		const vsMatrix4x4 &matrix = e->batch ? vsMatrix4x4::Identity : e->matrix;
+		if ( !e->batch )
+		{
+			instanceMatrixBuffer = e->instanceMatrixBuffer;
+			if ( !instanceMatrixBuffer && e->instanceMatrix )
 			{
-				list->SetMatrix4x4( vsMatrix4x4::Identity );
-				e->batch->Draw(list);
+				instanceMatrix = e->instanceMatrix;
+				instanceMatrixCount = e->instanceMatrixCount;
+			}
+		}
+
+		bool sameTransform = transformPushed && transformKnown &&
+			instanceMatrixBuffer == lastInstanceMatrixBuffer &&
+			instanceMatrix == lastInstanceMatrix &&
+			instanceMatrixCount == lastInstanceMatrixCount &&
+			( instanceMatrixBuffer || instanceMatrix || matrix == lastMatrix );
+		if ( sameTransform )
+		{
+			m_elidedOpCount += 2; // the previous PopTransform and this Set
+		}
+		else
+		{
+			if ( transformPushed )
 				list->PopTransform();
+			if ( instanceMatrixBuffer )
+				list->SetMatrices4x4Buffer( instanceMatrixBuffer );
+			else if ( instanceMatrix )
+				list->SetMatrices4x4( FrameArray( instanceMatrix, instanceMatrixCount ), instanceMatrixCount );
+			else
+				list->SetMatrix4x4( matrix );
+			transformPushed = true;
+			transformKnown = true;
+			lastMatrix = matrix;
+			lastInstanceMatrix = instanceMatrix;
+			lastInstanceMatrixCount = instanceMatrixCount;
+			lastInstanceMatrixBuffer = instanceMatrixBuffer;
+		}
+
+		// merged dynamic batches don't use shader values or options.
+		vsShaderValues *shaderValues = e->batch ? nullptr : e->shaderValues;
+		vsShaderOptions *shaderOptions = e->batch ? nullptr : e->shaderOptions;
+
+		if ( !shaderValuesKnown || shaderValues != lastShaderValues )
+		{
+			if ( shaderValues )
+				list->SetShaderValues( shaderValues );
+			else
+				list->ClearShaderValues();
+			lastShaderValues = shaderValues;
+			shaderValuesKnown = true;
+		}
+		else if ( shaderValues )
+			m_elidedOpCount += 2; // Set, and the matching Clear
+
+		if ( shaderOptions != lastShaderOptions )
+		{
+			if ( lastShaderOptions )
+				list->PopShaderOptions();
+			if ( shaderOptions )
+				list->PushShaderOptions( *shaderOptions );
+			lastShaderOptions = shaderOptions;
+		}
+		else if ( shaderOptions )
+			m_elidedOpCount += 2; // Push, and the matching Pop
+
+		if ( e->batch )
+		{
+			e->batch->Draw(list);
+			continue;
+		}
+
+		if ( e->instanceColorBuffer )
+		{
+			if ( colorsSet && lastColorsBuffer == e->instanceColorBuffer )
+				m_elidedOpCount++;
+			else
+			{
+				list->SetColorsBuffer( e->instanceColorBuffer );
+				colorsSet = true;
+				lastColorsBuffer = e->instanceColorBuffer;
+				lastColors = nullptr;
+				lastColorsCount = 0;
 			}
+		}
+		else if ( e->instanceColor )
+		{
+			if ( colorsSet && lastColors == e->instanceColor && lastColorsCount == e->instanceMatrixCount )
+				m_elidedOpCount++;
 			else
 			{
-				if ( e->instanceMatrixBuffer )
-					list->SetMatrices4x4Buffer( e->instanceMatrixBuffer );
-				else if ( e->instanceMatrix )
-					list->SetMatrices4x4( e->instanceMatrix, e->instanceMatrixCount );
-				else
-					list->SetMatrix4x4( e->matrix );
-
-				// We need to set shader values even if it's nullptr, to remove whatever
-				// shader values object was last used.  If we were smart we would
-				// remember what went in last so we weren't re-setting nullptrs, but
-				// maybe I'll leave that as a [TODO] rather than worrying about it
-				// riht now while I'm working on shader options.  -- Trevor 24/6/2020
-				if ( e->shaderValues )
-					list->SetShaderValues( e->shaderValues );
-				if ( e->shaderOptions )
-					list->PushShaderOptions( *e->shaderOptions );
-				if ( e->instanceColorBuffer )
-					list->SetColorsBuffer( e->instanceColorBuffer );
-				else if ( e->instanceColor )
-					list->SetColors( e->instanceColor, e->instanceMatrixCount );
-
-				if ( e->list )
-					list->Append( *e->list );
-				else if ( e->vbo && e->ibo )
-				{
-					list->BindBuffer( e->vbo );
-					if ( e->simpleType == vsFragment::SimpleType_TriangleList )
-						list->TriangleListBuffer( e->ibo );
-					else if ( e->simpleType == vsFragment::SimpleType_TriangleFan )
-						list->TriangleFanBuffer( e->ibo );
-					else if ( e->simpleType == vsFragment::SimpleType_TriangleStrip )
-						list->TriangleStripBuffer( e->ibo );
-					list->ClearArrays();
-				}
-				if ( e->shaderOptions )
-					list->PopShaderOptions();
-				if ( e->shaderValues )
-					list->ClearShaderValues();
-				list->PopTransform();
+				list->SetColors( FrameArray( e->instanceColor, e->instanceMatrixCount ), e->instanceMatrixCount );
+				colorsSet = true;
+				lastColorsBuffer = nullptr;
+				lastColors = e->instanceColor;
+				lastColorsCount = e->instanceMatrixCount;
 			}
 		}
+
+		if ( e->list )
+		{
+			list->Append( *e->list );
+
+			// We've no idea what that list did to the material, shader
+			// values or transform (a Pop inside it resets the renderer's
+			// instance matrices, for example), so don't trust what we think
+			// is set any more.
+			lastMaterial = nullptr;
+			colorsSet = false;
+			shaderValuesKnown = false;
+			transformKnown = false;
+		}
+		else if ( e->vbo && e->ibo )
+		{
+			list->BindBuffer( e->vbo );
+			if ( e->simpleType == vsFragment::SimpleType_TriangleList )
+				list->TriangleListBuffer( e->ibo );
+			else if ( e->simpleType == vsFragment::SimpleType_TriangleFan )
+				list->TriangleFanBuffer( e->ibo );
+			else if ( e->simpleType == vsFragment::SimpleType_TriangleStrip )
+				list->TriangleStripBuffer( e->ibo );
+			list->ClearArrays();
+		}
 	}
+
+	if ( lastShaderOptions )
+		list->PopShaderOptions();
+	if ( lastShaderValues || !shaderValuesKnown )
+		list->ClearShaderValues();
+	if ( transformPushed )
+		list->PopTransform();
 }
 
 void
 vsRenderQueueStage::EndRender()
 {
+	// Our batches and their elements are all in the frame arena, and so
+	// go away by themselves.
 	m_batchCount = 0;
-	Batch *last = nullptr;
-	for (Batch *b = m_batch; b; b = b->next)
-	{
-		last = b;
-		BatchElement *lastElement = b->elementList;
-		while ( lastElement->next )
-		{
-			lastElement->instanceMatrix = nullptr;
-			lastElement->instanceMatrixCount = 0;
-			lastElement = lastElement->next;
-		}
-		lastElement->instanceMatrix = nullptr;
-		lastElement->instanceMatrixCount = 0;
-		lastElement->next = m_batchElementPool;
-		m_batchElementPool = b->elementList;
-		b->elementList = nullptr;
-	}
-	if ( last )
-	{
-		last->next = m_batchPool;
-		m_batchPool = m_batch;
-	}
 	m_batch = nullptr;
+	m_lastBatch = nullptr;
+	m_sortItem.Clear();
 
 	m_temporaryLists.Clear();
-	m_batchMap->map.clear();
+	m_batchLookup.Clear();
 }
 
 vsRenderQueue::vsRenderQueue():
@@ -680,9 +912,21 @@ vsRenderQueue::StartRender(vsScene *parent, int materialHideFlags)
 
 	InitialiseTransformStack();
 
+	// Only 3D scenes sort by depth;  in 2D, everything has the same depth
+	// and we leave the drawing order to material layers.  Our elements
+	// calculate their sort keys as they're added, so we need to know the
+	// camera now.
+	vsVector3D viewPosition = vsVector3D::Zero;
+	vsVector3D viewDirection = vsVector3D::Zero;
+	if ( m_scene->Is3D() && m_scene->GetCamera3D() )
+	{
+		viewPosition = m_scene->GetCamera3D()->GetPosition();
+		viewDirection = m_scene->GetCamera3D()->GetTransform().GetMatrix().z;
+	}
+
 	for ( int i = 0; i < m_stageCount; i++ )
 	{
-		m_stage[i].StartRender();
+		m_stage[i].StartRender( viewPosition, viewDirection );
 	}
 	m_genericList->Clear();
 }
@@ -698,9 +942,10 @@ vsRenderQueue::StartRender( const vsMatrix4x4& projection, const vsMatrix4x4& wo
 	m_transformStack[0] = iniMatrix;
 	m_transformStackLevel = 1;
 
+	// no scene, so no camera to sort against.
 	for ( int i = 0; i < m_stageCount; i++ )
 	{
-		m_stage[i].StartRender();
+		m_stage[i].StartRender( vsVector3D::Zero, vsVector3D::Zero );
 	}
 	m_genericList->Clear();
 }
@@ -891,6 +1136,15 @@ vsRenderQueue::MakeTemporaryBatchList( vsMaterial *material, int size )
 	return m_stage[stageId].MakeTemporaryBatchList( material, m_transformStack[0], size );
 }
 
+int
+vsRenderQueue::GetElidedOpCount() const
+{
+	int count = 0;
+	for ( int i = 0; i < m_stageCount; i++ )
+		count += m_stage[i].GetElidedOpCount();
+	return count;
+}
+
 vsRenderQueueStage *
 vsRenderQueue::GetStage( int i )
 {
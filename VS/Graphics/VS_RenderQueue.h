@@ -120,6 +120,9 @@ public:
 
 	bool WouldMaterialBeHidden( vsMaterial *material ) const;
 
+	// How many redundant display list ops were skipped by the last Draw().
+	int GetElidedOpCount() const;
+
 	vsRenderQueueStage * GetStage( int i = 0 );
 };
 
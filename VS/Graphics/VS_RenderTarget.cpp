@@ -11,6 +11,7 @@
 #include "VS_Color.h"
 #include "VS_OpenGL.h"
 #include "VS_RendererState.h"
+#include "VS_RenderThread.h"
 #include <atomic>
 
 namespace
@@ -94,6 +95,9 @@ vsRenderTarget::vsRenderTarget( Type t, const vsSurface::Settings &settings, boo
 void
 vsRenderTarget::Create()
 {
+	// framebuffer objects aren't shared between GL contexts, so we have to
+	// make ours on the main one.
+	vsRenderThread::Sync();
 	GL_CHECK_SCOPED("RenderTarget");
 	bool isDepth = ( m_type == Type_Depth || m_type == Type_DepthCompare );
 
@@ -128,6 +132,7 @@ vsRenderTarget::Create()
 
 vsRenderTarget::~vsRenderTarget()
 {
+	vsRenderThread::Sync();
 	GL_CHECK_SCOPED("vsRenderTarget::~vsRenderTarget");
 
 	for ( int i = 0; i < m_bufferCount; i++ )
@@ -508,9 +513,10 @@ vsSurface::~vsSurface()
 void
 vsRenderTarget::Resize( int width, int height )
 {
-	GL_CHECK_SCOPED("vsRenderTarget::Resize");
 	if ( m_settings.width == width && m_settings.height == height )
 		return;
+	vsRenderThread::Sync();
+	GL_CHECK_SCOPED("vsRenderTarget::Resize");
 	m_viewportWidth = width;
 	m_viewportHeight = height;
 	m_settings.width = width;
@@ -0,0 +1,142 @@
+/*
+ *  VS_RenderThread.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#include "VS_RenderThread.h"
+
+#include "VS_Renderer_OpenGL3.h"
+#include "VS_RenderBuffer.h"
+#include "VS_StreamingBuffer.h"
+#include "VS_Profile.h"
+
+#include <SDL2/SDL.h>
+
+vsRenderThread * vsRenderThread::s_instance = nullptr;
+
+vsRenderThread::vsRenderThread( vsRenderer_OpenGL3 *renderer ):
+	vsTask( "Render thread" ),
+	m_renderer( renderer ),
+	m_mainThreadId( vsTask::GetCurrentThreadId() ),
+	m_frameReady( 0 ),
+	m_frameDone( 0 ),
+	m_list( nullptr ),
+	m_renderDrawTicks( 0 ),
+	m_renderSwapTicks( 0 ),
+	m_inFlight( false ),
+	m_frames( 0 ),
+	m_waitTicks( 0 ),
+	m_drawTicks( 0 ),
+	m_swapTicks( 0 )
+{
+	vsAssert(s_instance == nullptr, "Multiple vsRenderThreads created??");
+	s_instance = this;
+
+	Start();
+}
+
+vsRenderThread::~vsRenderThread()
+{
+	WaitForFrame();
+
+	m_frameReady.Release();
+	Join();
+	m_frameDone.Release();
+
+	if ( m_frames > 0 )
+		vsLog("Render thread: %d frames, main thread waited %0.2f ms/frame on average",
+				(int)m_frames, (1000.0 * m_waitTicks) / (SDL_GetPerformanceFrequency() * (double)m_frames));
+
+	vsAssert(s_instance == this, "vsRenderThread instance isn't me??");
+	s_instance = nullptr;
+}
+
+int
+vsRenderThread::Run()
+{
+	while ( m_frameReady.Wait() )
+	{
+		uint64_t start = SDL_GetPerformanceCounter();
+		m_renderer->SetMainContext();
+		{
+			PROFILE_GL("PreRender");
+			m_renderer->PreRender( m_settings );
+		}
+		m_renderer->RenderDisplayList( m_list );
+		uint64_t drawn = SDL_GetPerformanceCounter();
+		m_renderer->PostRender();
+		m_renderer->ClearMainContext();
+
+		m_renderDrawTicks = drawn - start;
+		m_renderSwapTicks = SDL_GetPerformanceCounter() - drawn;
+		m_frameDone.Post();
+	}
+	return 0;
+}
+
+void
+vsRenderThread::Submit( vsDisplayList *list, const vsRenderer::Settings &settings )
+{
+	vsAssert( vsTask::GetCurrentThreadId() == m_mainThreadId, "vsRenderThread::Submit() called from off the main thread??" );
+
+	// Don't get more than one frame ahead.  We don't need the main context
+	// back for this, though.
+	WaitForRenderThread();
+	vsStreamingBuffer::Instance()->FrameSubmitted();
+
+	// Hand over the main context, if we had it.  If we didn't, this fences
+	// whatever we've done on the update context, so that the render thread
+	// waits for it.
+	m_renderer->SetUpdateContext();
+
+	m_list = list;
+	m_settings = settings;
+	m_inFlight = true;
+	m_frames++;
+	m_frameReady.Post();
+}
+
+void
+vsRenderThread::WaitForFrame()
+{
+	if ( vsTask::GetCurrentThreadId() != m_mainThreadId || !m_inFlight )
+		return;
+
+	WaitForRenderThread();
+	m_renderer->SetMainContext();
+}
+
+void
+vsRenderThread::WaitForRenderThread()
+{
+	if ( !m_inFlight )
+		return;
+
+	PROFILE("WaitForRenderThread");
+	uint64_t start = SDL_GetPerformanceCounter();
+	m_frameDone.Wait();
+	m_waitTicks += SDL_GetPerformanceCounter() - start;
+	m_inFlight = false;
+
+	// Anything refilled while that frame was drawing can be drawn now.
+	vsRenderBuffer::CommitPendingUploads();
+
+	m_drawTicks = m_renderDrawTicks;
+	m_swapTicks = m_renderSwapTicks;
+}
+
+uint64_t
+vsRenderThread::GetDrawMicroseconds() const
+{
+	return (m_drawTicks * 1000000) / SDL_GetPerformanceFrequency();
+}
+
+uint64_t
+vsRenderThread::GetSwapMicroseconds() const
+{
+	return (m_swapTicks * 1000000) / SDL_GetPerformanceFrequency();
+}
@@ -0,0 +1,108 @@
+/*
+ *  VS_RenderThread.h
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#ifndef VS_RENDERTHREAD_H
+#define VS_RENDERTHREAD_H
+
+#include "VS/Graphics/VS_Renderer.h"
+#include "VS/Threads/VS_Semaphore.h"
+#include "VS/Threads/VS_Task.h"
+
+class vsDisplayList;
+class vsRenderer_OpenGL3;
+
+// vsRenderThread lets the main thread get on with building the next frame
+// while the last one is still being submitted to OpenGL.  When pipelined
+// rendering is turned on, vsScreen hands each frame's display list to us,
+// and we make the renderer's main GL context current on our own thread to
+// draw and swap it.
+//
+// While we have a frame in flight, the main thread has the renderer's
+// 'update' context instead, which shares its textures, buffers and shaders
+// with the main one;  so code which only creates those can carry on as
+// normal.  But anything which changes or destroys something a display list
+// can point at (render buffers, shader values and materials, textures,
+// render targets, shaders), or which reads back from the GPU, has to call
+// Sync() first.  The engine's own classes do that for you.  Sync() waits
+// for the frame in flight to finish and gives the main context back to the
+// main thread;  from then until the next frame is handed over, everything
+// works exactly as it does without pipelining.
+//
+// The one exception is refilling a Type_Stream render buffer through
+// SetArray(), when it was also filled for the frame in flight and the
+// streaming buffer is persistently mapped;  its new data goes straight into
+// the next frame's part of the streaming buffer, without waiting.
+//
+// Plain values set on shader values and materials aren't synced;  if you
+// change one while a frame is in flight, that frame may or may not see it.
+// Nor is writing straight into a render buffer's array (through GetPArray()
+// and friends) until you bake it;  call Sync() yourself before doing that.
+//
+// Submit() and Sync() are for the main thread.  Sync() does nothing if
+// called from any other thread, or if pipelining is turned off.
+
+class vsRenderThread : public vsTask
+{
+	static vsRenderThread *	s_instance;
+
+	vsRenderer_OpenGL3 *	m_renderer;
+	int						m_mainThreadId;
+
+	vsSemaphore				m_frameReady;	// main thread -> render thread
+	vsSemaphore				m_frameDone;	// render thread -> main thread
+
+	// Only touched by the main thread, or by the render thread between
+	// m_frameReady and m_frameDone.
+	vsDisplayList *			m_list;
+	vsRenderer::Settings	m_settings;
+
+	// How long the last frame took us to draw, and to swap.  Written by the
+	// render thread before m_frameDone, and copied out by the main thread
+	// after it.
+	uint64_t				m_renderDrawTicks;
+	uint64_t				m_renderSwapTicks;
+
+	bool					m_inFlight;		// main thread only;  submitted, but not yet waited for
+	uint64_t				m_frames;
+	uint64_t				m_waitTicks;	// time the main thread has spent waiting for us
+	uint64_t				m_drawTicks;	// main thread's copies of the last finished frame's timings
+	uint64_t				m_swapTicks;
+
+	void	WaitForFrame();			// and take the main context back
+	void	WaitForRenderThread();
+
+protected:
+
+	virtual int Run();
+
+public:
+
+	static vsRenderThread * Instance() { return s_instance; }
+
+	// Call before touching anything which the frame in flight might be
+	// drawing from.
+	static void Sync() { if ( s_instance ) s_instance->WaitForFrame(); }
+
+	vsRenderThread( vsRenderer_OpenGL3 *renderer );
+	~vsRenderThread();
+
+	// Hands 'list' over to be drawn and swapped.  It mustn't be touched again
+	// until after the next Submit() or Sync().
+	void	Submit( vsDisplayList *list, const vsRenderer::Settings &settings );
+
+	bool	IsFrameInFlight() const { return m_inFlight; }
+
+	// Main thread only.  Timings for the most recent frame we know has
+	// finished;  usually the one before the last one submitted.
+	uint64_t	GetDrawMicroseconds() const;
+	uint64_t	GetSwapMicroseconds() const;
+};
+
+#endif // VS_RENDERTHREAD_H
+
@@ -21,6 +21,7 @@
 #include "VS_RenderTarget.h"
 #include "VS_Screen.h"
 #include "VS_Shader.h"
+#include "VS_StreamingBuffer.h"
 // #include "VS_ShaderRef.h"
 #include "VS_ShaderSuite.h"
 #include "VS_System.h"
@@ -32,9 +33,6 @@
 
 #include "VS_OpenGL.h"
 
-#include "VS_DynamicBatchManager.h"
-#include "VS_TimerSystem.h"
-
 #include "VS_Input.h" // flag event queue to ignore resize events while we're changing window type
 #ifdef TRACY_ENABLE
 #include "tracy/Tracy.hpp"
@@ -78,6 +76,8 @@ SDL_Window *g_sdlWindow = nullptr;
 static SDL_GLContext m_sdlGlContext;
 static SDL_GLContext m_loadingGlContext;
 static vsMutex m_loadingGlContextMutex;
+static SDL_GLContext m_updateGlContext = nullptr;
+static GLsync m_updateContextFence = nullptr;	// work done on the update context, which the main context must wait for
 
 bool g_crashOnTextureStateUsageWarning = false;
 
@@ -278,7 +278,8 @@ vsRenderer_OpenGL3::vsRenderer_OpenGL3(int width, int height, int depth, int fla
 	m_currentTexelBuffer(nullptr),
 	m_currentColorBuffer(nullptr),
 	m_lastShaderId(0),
-	m_bufferCount(bufferCount)
+	m_bufferCount(bufferCount),
+	m_streamingBuffer(nullptr)
 {
 	vsLog("SDL Compiled Version: %d.%d.%d", SDL_MAJOR_VERSION, SDL_MINOR_VERSION, SDL_PATCHLEVEL);
 	SDL_version sdlVersion;
@@ -580,6 +581,9 @@ vsRenderer_OpenGL3::vsRenderer_OpenGL3(int width, int height, int depth, int fla
 	glBindVertexArray(m_vao);
 	GL_CHECK("Initialising OpenGL rendering");
 
+	m_streamingBuffer = new vsStreamingBuffer;
+	GL_CHECK("Initialising OpenGL rendering");
+
 	ResizeRenderTargetsToMatchWindow();
 
 	GL_CHECK("Initialising OpenGL rendering");
@@ -616,7 +620,18 @@ vsRenderer_OpenGL3::~vsRenderer_OpenGL3()
 		GL_CHECK_SCOPED("vsRenderer_OpenGL3 destructor");
 		vsDelete(m_window);
 		vsDelete(m_scene);
+
+		const vsStreamingBuffer::Stats &stats = m_streamingBuffer->GetStats();
+		if ( stats.frames > 0 )
+		{
+			vsLog("Streaming buffer: %d KB/frame average, %d KB peak, %d overflows, %d stalls",
+					(int)(stats.totalBytes / stats.frames / 1024), (int)(stats.peakFrameBytes / 1024),
+					(int)stats.overflows, (int)stats.stalls);
+		}
+		vsDelete(m_streamingBuffer);
 	}
+	if ( m_updateGlContext )
+		SDL_GL_DeleteContext( m_updateGlContext );
 	SDL_GL_DeleteContext( m_sdlGlContext );
 	SDL_GL_DeleteContext( m_loadingGlContext );
 	SDL_DestroyWindow( g_sdlWindow );
@@ -973,8 +988,6 @@ vsRenderer_OpenGL3::PostRender()
 		PROFILE_GL("FinishPostRender");
 
 		ClearState();
-
-		vsTimerSystem::Instance()->EndGPUTime();
 	}
 	// {
 	// 	int nowWidth, nowHeight;
@@ -983,7 +996,10 @@ vsRenderer_OpenGL3::PostRender()
 	// 	vsLog("Viewport:  %dx%d", m_viewportWidthPixels, m_viewportHeightPixels);
 	// }
 
-	vsDynamicBatchManager::Instance()->FrameRendered();
+	m_streamingBuffer->FrameRendered();
+#ifdef VS_TRACY
+	TracyPlot("Streamed bytes", (int64_t)m_streamingBuffer->GetStats().bytesLastFrame);
+#endif
 
 }
 
@@ -1248,7 +1264,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 	PROFILE("RawRenderDisplayList");
 	m_currentCameraPosition = vsVector3D::Zero;
 
-	vsDisplayList::op *op = list->PopOp();
+	const vsDisplayList::Command *cmd = list->PopCommand();
 	//vsVector3D	cursorPos;
 	//vsColor		cursorColor;
 	//vsColor		currentColor(-1,-1,-1,0);
@@ -1263,17 +1279,17 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 	//bool		usingVertexArray = false;
 	ClearState();
 
-	while(op)
+	while(cmd)
 	{
 // #define LOG_OPS
 #ifdef LOG_OPS
-		vsLog("%s", vsDisplayList::GetOpCodeString(op->type).c_str());
+		vsLog("%s", vsDisplayList::GetOpCodeString(cmd->GetType()).c_str());
 #endif // LOG_OPS
-		switch( op->type )
+		switch( cmd->GetType() )
 		{
 			case vsDisplayList::OpCode_SetLinear:
 				{
-					if ( op->data.i )
+					if ( cmd->Payload<uint32_t>() )
 						glEnable( GL_FRAMEBUFFER_SRGB );
 					else
 						glDisable( GL_FRAMEBUFFER_SRGB );
@@ -1281,7 +1297,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetColor:
 				{
-					m_currentColor = op->data.GetColor();
+					m_currentColor = cmd->Payload<vsColor>();
 					m_currentColors = nullptr;
 					m_currentColorsBuffer = nullptr;
 					break;
@@ -1289,7 +1305,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 			case vsDisplayList::OpCode_SetColors:
 				{
 					// m_currentColor = c_white;
-					m_currentColors = (vsColor*)op->data.p;
+					m_currentColors = (vsColor*)cmd->Payload<vsDisplayList::CountedPointerData>().p;
 					m_currentColorsBuffer = nullptr;
 					break;
 				}
@@ -1297,12 +1313,12 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					// m_currentColor = c_white;
 					m_currentColors = nullptr;
-					m_currentColorsBuffer = (vsRenderBuffer*)op->data.p;
+					m_currentColorsBuffer = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					break;
 				}
 			case vsDisplayList::OpCode_SetMaterial:
 				{
-					vsMaterial *material = (vsMaterial *)op->data.p;
+					vsMaterial *material = (vsMaterial *)cmd->Payload<vsDisplayList::PointerData>().p;
 					vsAssert(material, "SetMaterial called with no material?");
 					SetMaterialInternal( material->GetResource() );
 					SetMaterial( material );
@@ -1313,7 +1329,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 			case vsDisplayList::OpCode_SetRenderTarget:
 				{
 					PROFILE_GL("SetRenderTarget");
-					vsRenderTarget *target = (vsRenderTarget*)op->data.p;
+					vsRenderTarget *target = (vsRenderTarget*)cmd->Payload<vsDisplayList::PointerData>().p;
 					SetRenderTarget(target);
 					break;
 				}
@@ -1336,7 +1352,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					m_state.SetBool( vsRendererState::Bool_DepthMask, true ); // when we're clearing a render target, make sure we're writing to depth!
 					m_state.SetBool( vsRendererState::Bool_StencilTest, true ); // when we're clearing a render target, make sure we're not testing stencil bits!
 					m_state.Flush();
-					m_currentRenderTarget->ClearColor( op->data.color );
+					m_currentRenderTarget->ClearColor( cmd->Payload<vsColor>() );
 					break;
 				};
 			// case vsDisplayList::OpCode_ResolveRenderTarget:
@@ -1356,8 +1372,9 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE_GL("Blit");
 					m_state.Flush(); // flush our renderer state before blitting!
-					vsRenderTarget *from = (vsRenderTarget*)op->data.p;
-					vsRenderTarget *to = (vsRenderTarget*)op->data.p2;
+					const vsDisplayList::PointerPairData &d = cmd->Payload<vsDisplayList::PointerPairData>();
+					vsRenderTarget *from = (vsRenderTarget*)d.p;
+					vsRenderTarget *to = (vsRenderTarget*)d.p2;
 					from->BlitTo(to);
 					break;
 				}
@@ -1365,17 +1382,19 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE_GL("Blit");
 					m_state.Flush(); // flush our renderer state before blitting!
-					vsRenderTarget *from = (vsRenderTarget*)op->data.p;
-					vsRenderTarget *to = (vsRenderTarget*)op->data.p2;
-					vsBox2D fromRect = op->data.box2D;
-					vsBox2D toRect = op->data.box2D2;
+					const vsDisplayList::BlitRectData &d = cmd->Payload<vsDisplayList::BlitRectData>();
+					vsRenderTarget *from = (vsRenderTarget*)d.from;
+					vsRenderTarget *to = (vsRenderTarget*)d.to;
+					vsBox2D fromRect( d.fromRect.min, d.fromRect.max );
+					vsBox2D toRect( d.toRect.min, d.toRect.max );
 					from->BlitRect(to, fromRect, toRect);
 
 					break;
 				}
 			case vsDisplayList::OpCode_PushTransform:
 				{
-					vsTransform2D t = op->data.GetTransform();
+					const vsDisplayList::TransformData &d = cmd->Payload<vsDisplayList::TransformData>();
+					vsTransform2D t( d.position, d.angle, d.scale );
 
 					vsMatrix4x4 localToWorld = m_transformStack[m_currentTransformStackLevel] * t.GetMatrix();
 					m_transformStack[++m_currentTransformStackLevel] = localToWorld;
@@ -1387,7 +1406,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_PushTranslation:
 				{
-					vsVector3D &v = op->data.vector;
+					const vsVector3D &v = cmd->Payload<vsVector3D>();
 
 					vsMatrix4x4 m;
 					m.SetTranslation(v);
@@ -1400,7 +1419,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_PushMatrix4x4:
 				{
-					vsMatrix4x4 m = op->data.GetMatrix4x4();
+					const vsMatrix4x4 &m = cmd->Payload<vsMatrix4x4>();
 					vsMatrix4x4 localToWorld = m_transformStack[m_currentTransformStackLevel] * m;
 					m_transformStack[++m_currentTransformStackLevel] = localToWorld;
 					m_currentLocalToWorld = &m_transformStack[m_currentTransformStackLevel];
@@ -1410,7 +1429,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetMatrix4x4:
 				{
-					const vsMatrix4x4& m = op->data.matrix4x4;
+					const vsMatrix4x4& m = cmd->Payload<vsMatrix4x4>();
 					m_transformStack[++m_currentTransformStackLevel] = m;
 					m_currentLocalToWorld = &m_transformStack[m_currentTransformStackLevel];
 					m_currentLocalToWorldCount = 1;
@@ -1419,8 +1438,9 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetMatrices4x4:
 				{
-					vsMatrix4x4 *m = (vsMatrix4x4*)op->data.p;
-					int count = op->data.i;
+					const vsDisplayList::CountedPointerData &d = cmd->Payload<vsDisplayList::CountedPointerData>();
+					vsMatrix4x4 *m = (vsMatrix4x4*)d.p;
+					int count = d.count;
 					m_transformStack[++m_currentTransformStackLevel] = m[0];
 					m_currentLocalToWorld = m;
 					m_currentLocalToWorldCount = count;
@@ -1429,7 +1449,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetMatrices4x4Buffer:
 				{
-					vsRenderBuffer *b = (vsRenderBuffer*)op->data.p;
+					vsRenderBuffer *b = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					m_transformStack[++m_currentTransformStackLevel] = vsMatrix4x4::Identity;
 					m_currentLocalToWorld = nullptr;
 					m_currentLocalToWorldCount = b->GetActiveMatrix4x4ArraySize();
@@ -1438,7 +1458,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetShaderValues:
 				{
-					vsShaderValues *sv = (vsShaderValues*)op->data.p;
+					vsShaderValues *sv = (vsShaderValues*)cmd->Payload<vsDisplayList::PointerData>().p;
 					m_currentShaderValues = sv;
 					break;
 				}
@@ -1449,7 +1469,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_PushShaderOptions:
 				{
-					m_optionsStack.AddItem( op->data.shaderOptions );
+					m_optionsStack.AddItem( cmd->Payload<vsShaderOptions>() );
 					break;
 				}
 			case vsDisplayList::OpCode_PopShaderOptions:
@@ -1472,7 +1492,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetWorldToViewMatrix4x4:
 				{
-					m_currentWorldToView = op->data.GetMatrix4x4();
+					m_currentWorldToView = cmd->Payload<vsMatrix4x4>();
 					break;
 				}
 			case vsDisplayList::OpCode_PopTransform:
@@ -1490,20 +1510,21 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetProjectionMatrix4x4:
 				{
-					vsMatrix4x4 &m = op->data.GetMatrix4x4();
+					const vsMatrix4x4 &m = cmd->Payload<vsMatrix4x4>();
 					m_currentViewToProjection = m;
 					break;
 				}
 			case vsDisplayList::OpCode_VertexArray:
 				{
-					m_currentVertexArray = (vsVector3D*)op->data.p;
-					m_currentVertexArrayCount = op->data.i;
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					m_currentVertexArray = (vsVector3D*)d.Elements();
+					m_currentVertexArrayCount = d.count;
 					m_currentVertexBuffer = nullptr;
 					break;
 				}
 			case vsDisplayList::OpCode_VertexBuffer:
 				{
-					m_currentVertexBuffer = (vsRenderBuffer *)op->data.p;
+					m_currentVertexBuffer = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					m_currentVertexArray = nullptr;
 					m_currentVertexArrayCount = 0;
 					m_currentVertexBuffer->BindVertexBuffer( &m_state );
@@ -1511,13 +1532,14 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_NormalArray:
 				{
-					m_currentNormalArray = (vsVector3D*)op->data.p;
-					m_currentNormalArrayCount = op->data.i;
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					m_currentNormalArray = (vsVector3D*)d.Elements();
+					m_currentNormalArrayCount = d.count;
 					break;
 				}
 			case vsDisplayList::OpCode_NormalBuffer:
 				{
-					m_currentNormalBuffer = (vsRenderBuffer *)op->data.p;
+					m_currentNormalBuffer = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					m_currentNormalBuffer->BindNormalBuffer( &m_state );
 					m_currentNormalArray = nullptr;
 					m_currentNormalArrayCount = 0;
@@ -1542,15 +1564,16 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_TexelArray:
 				{
-					m_currentTexelArray = (vsVector2D*)op->data.p;
-					m_currentTexelArrayCount = op->data.i;
-					vsRenderBuffer::BindTexelArray( &m_state, op->data.p, op->data.i );
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					m_currentTexelArray = (vsVector2D*)d.Elements();
+					m_currentTexelArrayCount = d.count;
+					vsRenderBuffer::BindTexelArray( &m_state, (void*)d.Elements(), d.count );
 					m_state.SetBool( vsRendererState::ClientBool_TextureCoordinateArray, true );
 					break;
 				}
 			case vsDisplayList::OpCode_TexelBuffer:
 				{
-					m_currentTexelBuffer = (vsRenderBuffer *)op->data.p;
+					m_currentTexelBuffer = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					m_currentTexelArray = nullptr;
 					m_currentTexelArrayCount = 0;
 					m_currentTexelBuffer->BindTexelBuffer( &m_state );
@@ -1563,13 +1586,14 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_ColorArray:
 				{
-					m_currentColorArray = (vsColor*)op->data.p;
-					m_currentColorArrayCount = op->data.i;
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					m_currentColorArray = (vsColor*)d.Elements();
+					m_currentColorArrayCount = d.count;
 					break;
 				}
 			case vsDisplayList::OpCode_ColorBuffer:
 				{
-					m_currentColorBuffer = (vsRenderBuffer *)op->data.p;
+					m_currentColorBuffer = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					m_currentColorBuffer->BindColorBuffer( &m_state );
 					m_currentColorArray = 0;
 					m_currentColorArrayCount = 0;
@@ -1627,14 +1651,14 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					m_currentVertexArray = nullptr;
 					m_currentVertexArrayCount = 0;
 
-					vsRenderBuffer *buffer = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *buffer = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					buffer->Bind( &m_state );
 					break;
 				}
 			case vsDisplayList::OpCode_UnbindBuffer:
 				{
 					PROFILE_GL("UnbindBuffer");
-					vsRenderBuffer *buffer = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *buffer = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					buffer->Unbind( &m_state );
 					break;
 				}
@@ -1642,14 +1666,16 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE("LineListArray");
 					FlushRenderState();
-					vsRenderBuffer::DrawElementsImmediate( GL_LINES, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					vsRenderBuffer::DrawElementsImmediate( GL_LINES, (void*)d.Elements(), d.count, m_currentLocalToWorldCount );
 					break;
 				}
 			case vsDisplayList::OpCode_LineStripArray:
 				{
 					PROFILE("LineStripArray");
 					FlushRenderState();
-					vsRenderBuffer::DrawElementsImmediate( GL_LINE_STRIP, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					vsRenderBuffer::DrawElementsImmediate( GL_LINE_STRIP, (void*)d.Elements(), d.count, m_currentLocalToWorldCount );
 					break;
 				}
 			case vsDisplayList::OpCode_TriangleListArray:
@@ -1658,7 +1684,8 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					PROFILE("TriangleListArray");
 					FlushRenderState();
 
-					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLES, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLES, (void*)d.Elements(), d.count, m_currentLocalToWorldCount );
 					break;
 				}
 			case vsDisplayList::OpCode_TriangleStripArray:
@@ -1666,14 +1693,15 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					// PROFILE_GL("TriangleStripArray");
 					PROFILE("TriangleStripArray");
 					FlushRenderState();
-					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLE_STRIP, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLE_STRIP, (void*)d.Elements(), d.count, m_currentLocalToWorldCount );
 					break;
 				}
 			case vsDisplayList::OpCode_TriangleStripBuffer:
 				{
 					PROFILE("TriangleStripBuffer");
 					FlushRenderState();
-					vsRenderBuffer *ib = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *ib = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					ib->TriStripBuffer(m_currentLocalToWorldCount);
 					break;
 				}
@@ -1682,7 +1710,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					PROFILE("TriangleListBuffer");
 					// PROFILE_GL("TriangleListBuffer");
 					FlushRenderState();
-					vsRenderBuffer *ib = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *ib = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					ib->TriListBuffer(m_currentLocalToWorldCount);
 					// m_currentShader->ValidateCache( m_currentMaterial );
 					break;
@@ -1691,7 +1719,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE("TriangleFanBuffer");
 					FlushRenderState();
-					vsRenderBuffer *ib = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *ib = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					ib->TriFanBuffer(m_currentLocalToWorldCount);
 					break;
 				}
@@ -1699,7 +1727,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE("LineListBuffer");
 					FlushRenderState();
-					vsRenderBuffer *ib = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *ib = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					ib->LineListBuffer(m_currentLocalToWorldCount);
 					break;
 				}
@@ -1707,7 +1735,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE("LineStripBuffer");
 					FlushRenderState();
-					vsRenderBuffer *ib = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *ib = (vsRenderBuffer *)cmd->Payload<vsDisplayList::PointerData>().p;
 					ib->LineStripBuffer(m_currentLocalToWorldCount);
 					break;
 				}
@@ -1715,16 +1743,16 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE("TriangleFanArray");
 					FlushRenderState();
-					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLE_FAN, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
-					// glDrawElements( GL_TRIANGLE_FAN, op->data.GetUInt(), GL_UNSIGNED_SHORT, op->data.p );
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLE_FAN, (void*)d.Elements(), d.count, m_currentLocalToWorldCount );
 					break;
 				}
 			case vsDisplayList::OpCode_PointsArray:
 				{
 					PROFILE("PointsArray");
 					FlushRenderState();
-					vsRenderBuffer::DrawElementsImmediate( GL_POINTS, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
-					// glDrawElements( GL_POINTS, op->data.GetUInt(), GL_UNSIGNED_SHORT, op->data.p );
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					vsRenderBuffer::DrawElementsImmediate( GL_POINTS, (void*)d.Elements(), d.count, m_currentLocalToWorldCount );
 					break;
 				}
 			case vsDisplayList::OpCode_Light:
@@ -1732,24 +1760,24 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					PROFILE("Light");
 					if ( m_lightCount < MAX_LIGHTS - 1 )
 					{
-						vsLight &l = op->data.light;
-						if ( l.m_type == vsLight::Type_Ambient )
+						const vsDisplayList::LightData &l = cmd->Payload<vsDisplayList::LightData>();
+						if ( l.type == vsLight::Type_Ambient )
 						{
 							m_lightStatus[m_lightCount].type = 1;
 						}
-						if ( l.m_type == vsLight::Type_Directional )
+						if ( l.type == vsLight::Type_Directional )
 						{
 							m_lightStatus[m_lightCount].type = 2;
-							m_lightStatus[m_lightCount].position = l.m_direction;
+							m_lightStatus[m_lightCount].position = l.direction;
 						}
-						if ( l.m_type == vsLight::Type_Point )
+						if ( l.type == vsLight::Type_Point )
 						{
 							m_lightStatus[m_lightCount].type = 3;
-							m_lightStatus[m_lightCount].position = l.m_position;
+							m_lightStatus[m_lightCount].position = l.position;
 						}
-						m_lightStatus[m_lightCount].ambient = l.m_ambient;
-						m_lightStatus[m_lightCount].diffuse = l.m_color;
-						m_lightStatus[m_lightCount].specular = l.m_specular;
+						m_lightStatus[m_lightCount].ambient = l.ambient;
+						m_lightStatus[m_lightCount].diffuse = l.color;
+						m_lightStatus[m_lightCount].specular = l.specular;
 
 						m_lightCount++;
 					}
@@ -1766,9 +1794,9 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_Fog:
 				{
-					vsColor fogColor = op->data.fog.GetColor();
-					m_currentFogColor = fogColor;
-					m_currentFogDensity = op->data.fog.GetDensity();
+					const vsDisplayList::FogData &fog = cmd->Payload<vsDisplayList::FogData>();
+					m_currentFogColor = fog.color;
+					m_currentFogDensity = fog.density;
 					break;
 				}
 			case vsDisplayList::OpCode_ClearFog:
@@ -1822,7 +1850,8 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 			case vsDisplayList::OpCode_EnableScissor:
 				{
 					m_state.SetBool( vsRendererState::Bool_ScissorTest, true );
-					const vsBox2D& box = op->data.box2D;
+					const vsDisplayList::BoxData &d = cmd->Payload<vsDisplayList::BoxData>();
+					vsBox2D box( d.min, d.max );
 					GLsizei x = (GLsizei)(box.GetMin().x * m_currentViewportPixels.Width());
 					GLsizei y = (GLsizei)(box.GetMin().y * m_currentViewportPixels.Height());
 					GLsizei wid = (GLsizei)(box.Width() * m_currentViewportPixels.Width());
@@ -1842,7 +1871,8 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 						int currentTargetWidth = m_currentRenderTarget->GetViewportWidth();
 						int currentTargetHeight = m_currentRenderTarget->GetViewportHeight();
 
-						const vsBox2D& box = op->data.box2D;
+						const vsDisplayList::BoxData &d = cmd->Payload<vsDisplayList::BoxData>();
+						vsBox2D box( d.min, d.max );
 						m_currentViewportPixels.Set(
 									vsVector2D( box.GetMin().x * currentTargetWidth, box.GetMin().y * currentTargetHeight ),
 									vsVector2D( box.GetMax().x * currentTargetWidth, box.GetMax().y * currentTargetHeight )
@@ -1868,14 +1898,16 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_Debug:
 				{
-					if ( op->data.string == "screenshot" )
+					const vsDisplayList::ArrayData &d = cmd->Payload<vsDisplayList::ArrayData>();
+					vsString message( d.Elements(), d.count );
+					if ( message == "screenshot" )
 					{
 						static int foo = 0;
 						vsImage img(m_currentRenderTarget->Resolve(0));
 						img.SavePNG_FullAlpha(vsFormatString("screenshot-%d.png", foo++));
 					}
 					else
-						vsRenderDebug( op->data.string );
+						vsRenderDebug( message );
 					break;
 				}
 			default:
@@ -1883,8 +1915,8 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 		}
 		// GL_CHECK("RenderOp");
 		{
-			PROFILE("PopOp");
-			op = list->PopOp();
+			PROFILE("PopCommand");
+			cmd = list->PopCommand();
 		}
 	}
 }
@@ -2594,6 +2626,60 @@ vsRenderer_OpenGL3::FenceLoadingContext()
 	glDeleteSync(fenceId);
 }
 
+void
+vsRenderer_OpenGL3::SetMainContext()
+{
+	if ( m_updateGlContext && SDL_GL_GetCurrentContext() == m_updateGlContext )
+		SetUpdateContext();	// fences it
+	SDL_GL_MakeCurrent( g_sdlWindow, m_sdlGlContext );
+
+	if ( m_updateContextFence )
+	{
+		// Anything the update context did has to happen before we use it.
+		glWaitSync( m_updateContextFence, 0, GL_TIMEOUT_IGNORED );
+		glDeleteSync( m_updateContextFence );
+		m_updateContextFence = nullptr;
+	}
+	GL_CHECK("SetMainContext");
+}
+
+void
+vsRenderer_OpenGL3::ClearMainContext()
+{
+	GL_CHECK("ClearMainContext");
+	SDL_GL_MakeCurrent( g_sdlWindow, nullptr );
+}
+
+void
+vsRenderer_OpenGL3::SetUpdateContext()
+{
+	if ( !m_updateGlContext )
+	{
+		// We only make this the first time somebody asks for it.  The main
+		// context is current, so SDL_GL_SHARE_WITH_CURRENT_CONTEXT (which is
+		// still set from when we made it) shares objects with it.
+		m_updateGlContext = SDL_GL_CreateContext(g_sdlWindow);
+		if ( !m_updateGlContext )
+		{
+			vsAssertF(0, "Failed to create an OpenGL context for pipelined rendering.  SDL2 error message: %s", SDL_GetError() );
+			exit(1);
+		}
+	}
+	else if ( SDL_GL_GetCurrentContext() != m_updateGlContext )
+	{
+		SDL_GL_MakeCurrent( g_sdlWindow, m_updateGlContext );
+	}
+	else
+	{
+		// We already had it, so somebody's about to take the main context;
+		// make them wait for anything we've done here.
+		vsAssert( m_updateContextFence == nullptr, "Update context fenced twice??" );
+		m_updateContextFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+		glFlush();
+	}
+	GL_CHECK("SetUpdateContext");
+}
+
 vsShader*
 vsRenderer_OpenGL3::DefaultShaderFor( vsMaterialInternal *mat )
 {
@@ -29,6 +29,7 @@ class vsMaterialInternal;
 class vsOverlay;
 class vsRenderBuffer;
 class vsShaderValues;
+class vsStreamingBuffer;
 class vsTransform2D;
 class vsVector2D;
 struct SDL_Surface;
@@ -112,6 +113,8 @@ class vsRenderer_OpenGL3: public vsRenderer
 	// we'll treat our rendering like OpenGL2 and just continually reconfigure
 	// a single global Vertex Array Object..
 
+	vsStreamingBuffer *	m_streamingBuffer;
+
 	WindowType m_windowType;
 
 	void				FlushRenderState();
@@ -156,6 +159,14 @@ public:
 	// contents have all become available from the main thread.
 	void	FenceLoadingContext();
 
+	// Pipelined rendering (see vsRenderThread) passes our main GL context
+	// back and forth between the main thread and the render thread.  While
+	// the render thread has it, the main thread has our 'update' context
+	// instead, which shares objects with the main one.
+	void	SetMainContext();
+	void	ClearMainContext();
+	void	SetUpdateContext();	// main thread only
+
 	int		GetWidthPixels() const { return m_widthPixels; }
 	int		GetHeightPixels() const { return m_heightPixels; }
 	void	SetViewportWidthPixels( int width ) { m_widthPixels = width; }
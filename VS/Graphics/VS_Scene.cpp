@@ -16,6 +16,7 @@
 #include "VS_Screen.h"
 #include "VS_System.h"
 #include "VS_Profile.h"
+#include "VS_JobSystem.h"
 //#include "VS_Transform.h"
 
 #include "VS_OpenGL.h"
@@ -78,7 +79,11 @@ vsScene::vsScene( const vsString& name ):
 	m_stencilTest( false ),
 	m_hasViewport( false ),
 	m_enabled( true ),
-	m_clearDepth( false )
+	m_clearDepth( false ),
+	m_parallelUpdate( false ),
+	m_drawnEntityCount( 0 ),
+	m_culledEntityCount( 0 ),
+	m_elidedOpCount( 0 )
 {
 	// m_queue->GetGenericList()->SetResizable();
 	m_camera = m_defaultCamera;
@@ -187,9 +192,18 @@ vsScene::Update( float timeStep )
 		return;
 	PROFILE("Scene::Update");
 
+	vsJobSystem *jobs = vsJobSystem::Instance();
+	bool parallel = m_parallelUpdate && jobs && jobs->GetWorkerCount() > 0;
+
 	vsEntity *entity = m_entityList->GetNext();
 	while ( entity != m_entityList )
 	{
+		if ( parallel && entity->IsThreadSafeUpdate() )
+		{
+			// we'll get to this one in UpdateParallelEntities().
+			entity = entity->GetNext();
+			continue;
+		}
 #ifdef DEBUG_UPDATE
 		const char* type = typeid(*entity ).name();
 		if (entity->GetNext() == entity)
@@ -226,6 +240,9 @@ vsScene::Update( float timeStep )
 		entity = entity->GetNext();
 	}
 
+	if ( parallel )
+		UpdateParallelEntities( timeStep );
+
 	if ( m_camera && !m_cameraIsReference )
 	{
 		m_camera->Update( timeStep );
@@ -236,6 +253,40 @@ vsScene::Update( float timeStep )
 	}
 }
 
+void
+vsScene::UpdateParallelEntities( float timeStep )
+{
+	PROFILE("Scene::UpdateParallel");
+
+	// Gather the list now, after the serial updates, since those may have
+	// added or removed entities.
+	m_parallelEntities.Clear();
+	for ( vsEntity *entity = m_entityList->GetNext(); entity != m_entityList; entity = entity->GetNext() )
+	{
+		if ( entity->IsThreadSafeUpdate() )
+			m_parallelEntities.AddItem( entity );
+	}
+
+	// Entities can't unlink themselves from our list while other threads
+	// are walking past them, so any extractions get queued up for us to do
+	// once everybody's finished.
+	vsEntity::s_deferExtracts = true;
+	vsJobSystem::Instance()->ParallelForRange( 0, m_parallelEntities.ItemCount(), 64,
+		[this, timeStep]( int begin, int end )
+		{
+			for ( int i = begin; i < end; i++ )
+				m_parallelEntities[i]->Update( timeStep );
+		} );
+	vsEntity::s_deferExtracts = false;
+
+	for ( int i = 0; i < m_parallelEntities.ItemCount(); i++ )
+	{
+		vsEntity *entity = m_parallelEntities[i];
+		if ( entity->m_extractQueued )
+			entity->DoExtract();
+	}
+}
+
 void
 vsScene::Draw( vsDisplayList *list, int flags )
 {
@@ -299,18 +350,33 @@ vsScene::Draw( vsDisplayList *list, int flags )
 
 	{
 		PROFILE("Scene::DrawEntities");
+		m_drawnEntityCount = 0;
+		m_culledEntityCount = 0;
+
 		vsEntity *entity = m_entityList->GetNext();
 		while ( entity != m_entityList )
 		{
-			if ( m_is3d || (!m_camera || entity->OnScreen( m_camera->GetCameraTransform() )) )
+			bool visible;
+			if ( m_is3d )
+				visible = !m_camera3D || !entity->HasBounds() || m_camera3D->IsBox3DVisible( entity->GetWorldBounds() );
+			else
+				visible = !m_camera || entity->OnScreen( m_camera->GetCameraTransform() );
+
+			if ( visible )
 			{
 				entity->Draw( &s_renderQueue );
+				m_drawnEntityCount++;
+			}
+			else
+			{
+				m_culledEntityCount++;
 			}
 			entity = entity->GetNext();
 		}
 	}
 
 	s_renderQueue.Draw(list);
+	m_elidedOpCount = s_renderQueue.GetElidedOpCount();
 	s_renderQueue.EndRender();
 
 	if ( m_stencilTest )
@@ -50,6 +50,15 @@ class vsScene
 	bool			m_hasViewport;
 	bool			m_enabled;	// if false, we won't automatically draw this scene
 	bool			m_clearDepth;
+	bool			m_parallelUpdate;
+
+	vsArray<vsEntity*>	m_parallelEntities;	// scratch list for UpdateParallelEntities()
+
+	int				m_drawnEntityCount;		// counts from the most recent Draw()
+	int				m_culledEntityCount;
+	int				m_elidedOpCount;
+
+	void			UpdateParallelEntities( float timeStep );
 
 public:
 
@@ -100,6 +109,19 @@ public:
 	void			Update( float timeStep );
 	void			Draw( vsDisplayList *list, int flags = 0 );
 
+	// With parallel update enabled, entities flagged with
+	// vsEntity::SetThreadSafeUpdate() are updated across the job system's
+	// worker threads, after all the other entities have been updated in the
+	// usual way.
+	void			SetParallelUpdate( bool parallel ) { m_parallelUpdate = parallel; }
+	bool			IsParallelUpdate() const { return m_parallelUpdate; }
+
+	// In 3D scenes, entities with bounds which lie entirely outside the
+	// camera frustum are skipped.  These report what the last Draw() did.
+	int				GetDrawnEntityCount() const { return m_drawnEntityCount; }
+	int				GetCulledEntityCount() const { return m_culledEntityCount; }
+	int				GetElidedOpCount() const { return m_elidedOpCount; }	// redundant display list ops skipped by the last Draw()
+
 	void			RegisterEntityOnTop( vsEntity *sprite );
 	void			RegisterEntityOnBottom( vsEntity *sprite );
 
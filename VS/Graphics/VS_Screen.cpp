@@ -15,7 +15,9 @@
 #include "VS_RenderPipelineStageScenes.h"
 #include "VS_Renderer_OpenGL3.h"
 #include "VS_RenderTarget.h"
+#include "VS_RenderThread.h"
 #include "VS_Scene.h"
+#include "VS_StreamingBuffer.h"
 #include "VS_System.h"
 #include "VS_TextureManager.h"
 #include "VS_Profile.h"
@@ -32,6 +34,8 @@ vsScreen::vsScreen(int width, int height, int depth, vsRenderer::WindowType wind
 	m_sceneCount(0),
 	m_fifoUsageLastFrame(0),
 	m_fifoHighWater(0),
+	m_fifoBack(nullptr),
+	m_renderThread(nullptr),
 	m_width(width),
 	m_height(height),
 	m_bufferCount(bufferCount),
@@ -75,6 +79,7 @@ vsScreen::vsScreen(int width, int height, int depth, vsRenderer::WindowType wind
 vsScreen::~vsScreen()
 {
 	vsLog(" >> FIFO High water mark:  %d of %d (%0.2f%% usage)", m_fifoHighWater, c_fifoSize, 100.f * (float)m_fifoHighWater / c_fifoSize);
+	SetPipelinedRendering(false);
 	DestroyScenes();
 	vsDelete( m_renderer );
 	vsDelete( m_fifo );
@@ -84,6 +89,7 @@ vsScreen::~vsScreen()
 void
 vsScreen::NotifyResized(int width, int height)
 {
+	vsRenderThread::Sync();
 	m_width = width;
 	m_height = height;
 	m_renderer->NotifyResized(width, height);
@@ -116,6 +122,8 @@ vsScreen::UpdateVideoMode(int width, int height, int depth, vsRenderer::WindowTy
 			vsync == m_vsync )
 		return;
 
+	vsRenderThread::Sync();
+
 	m_bufferCount = bufferCount;
 	m_aspectRatio = ((float)m_width)/((float)m_height);
 	m_depth = depth;
@@ -147,6 +155,7 @@ vsScreen::CheckVideoMode()
 {
 	// note that we might move and resize at the same time.  We don't ever
 	// want to set 'm_resized' to false, except in 'Update'!
+	vsRenderThread::Sync();
 	m_resized |= m_renderer->CheckVideoMode();
 
 	if ( m_resized )
@@ -158,6 +167,27 @@ vsScreen::CheckVideoMode()
 	}
 }
 
+void
+vsScreen::SetPipelinedRendering( bool pipelined )
+{
+	if ( pipelined == IsPipelinedRendering() )
+		return;
+
+	if ( pipelined )
+	{
+		m_fifoBack = new vsDisplayList(c_fifoSize);
+		m_fifoBack->SetResizable();
+		m_renderThread = new vsRenderThread( vsRenderer_OpenGL3::Instance() );
+	}
+	else
+	{
+		// gives us back the main GL context, once it's done.
+		vsDelete( m_renderThread );
+		vsDelete( m_fifoBack );
+	}
+	vsLog("Pipelined rendering %s", pipelined ? "enabled" : "disabled");
+}
+
 void
 vsScreen::CreateScenes(int count)
 {
@@ -241,6 +271,7 @@ vsScreen::DrawPipeline( vsRenderPipeline *pipeline, vsShaderOptions *customOptio
 	PROFILE_GL("DrawPipeline");
 	m_currentSettings = &m_defaultRenderSettings;
 
+	if ( !m_renderThread )
 	{
 		PROFILE_GL("PreRender");
 		m_renderer->PreRender(m_defaultRenderSettings);
@@ -267,9 +298,27 @@ vsScreen::DrawPipeline( vsRenderPipeline *pipeline, vsShaderOptions *customOptio
 #ifdef DEBUG_SCENE
 	m_scene[m_sceneCount-1]->Draw(m_fifo);
 #endif
-	m_renderer->RenderDisplayList(m_fifo);
-	vsTimerSystem::Instance()->EndDrawTime();
-	m_renderer->PostRender();
+	if ( m_renderThread )
+	{
+		// The render thread draws and swaps this frame, while we start
+		// building the next one in the other fifo.  (So PostDraw() runs once
+		// the frame is handed over, not once it's been drawn)
+		m_renderThread->Submit(m_fifo, m_defaultRenderSettings);
+
+		vsDisplayList *submitted = m_fifo;
+		m_fifo = m_fifoBack;
+		m_fifoBack = submitted;
+
+		vsTimerSystem::Instance()->EndPipelinedFrame( m_renderThread->GetDrawMicroseconds(), m_renderThread->GetSwapMicroseconds() );
+	}
+	else
+	{
+		vsStreamingBuffer::Instance()->FrameSubmitted();
+		m_renderer->RenderDisplayList(m_fifo);
+		vsTimerSystem::Instance()->EndDrawTime();
+		m_renderer->PostRender();
+		vsTimerSystem::Instance()->EndGPUTime();
+	}
 
 	pipeline->PostDraw();
 
@@ -364,30 +413,35 @@ vsScreen::SupportsShaders()
 vsImage *
 vsScreen::Screenshot()
 {
+	vsRenderThread::Sync();
 	return m_renderer->Screenshot();
 }
 
 vsImage *
 vsScreen::Screenshot_Async()
 {
+	vsRenderThread::Sync();
 	return m_renderer->Screenshot_Async();
 }
 
 vsImage *
 vsScreen::ScreenshotBack()
 {
+	vsRenderThread::Sync();
 	return m_renderer->ScreenshotBack();
 }
 
 vsImage *
 vsScreen::ScreenshotDepth()
 {
+	vsRenderThread::Sync();
 	return m_renderer->ScreenshotDepth();
 }
 
 vsImage *
 vsScreen::ScreenshotAlpha()
 {
+	vsRenderThread::Sync();
 	return m_renderer->ScreenshotAlpha();
 }
 
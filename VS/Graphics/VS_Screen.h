@@ -20,6 +20,7 @@
 
 class vsDisplayList;
 class vsRenderPipeline;
+class vsRenderThread;
 class vsScene;
 class vsRenderTarget;
 class vsImage;
@@ -38,6 +39,9 @@ class vsScreen
 	size_t				m_fifoHighWater;
 
 	vsDisplayList *		m_fifo;			// our FIFO display list, for rendering
+	vsDisplayList *		m_fifoBack;		// when pipelining, the render thread may still be drawing this one
+
+	vsRenderThread *	m_renderThread;	// if we're pipelining
 
 	int					m_width;
 	int					m_height;
@@ -100,6 +104,13 @@ public:
 	// Ugh.  Need a nicer interface for this.
 	bool			Resized() { return m_resized; }
 
+	// Pipelined rendering draws each frame on a separate render thread,
+	// while the main thread gets on with the next one.  See vsRenderThread
+	// for what that means for code which touches GPU resources.  Off by
+	// default.
+	void			SetPipelinedRendering( bool pipelined );
+	bool			IsPipelinedRendering() const { return m_renderThread != nullptr; }
+
 	// Returns the maximum size of the fifo buffer containing our rendering
 	// commands, in bytes.
 	size_t			GetFifoSize() { return m_fifo->GetMaxSize(); }
@@ -8,14 +8,25 @@
  */
 
 #include "VS_ShaderValues.h"
+#include "VS_RenderThread.h"
 #include "VS_Shader.h"
 #include "VS_ShaderUniformRegistry.h"
 #include "VS_OpenGL.h"
 #include "VS_Matrix.h"
 
+#include <atomic>
+
+// Ids and generations both come from here, so every change to any
+// vsShaderValues produces a brand new generation number.  That means that
+// the largest generation along a chain of parents always goes up when
+// anything on that chain changes.
+static std::atomic<uint32_t> s_nextGeneration(1);
+
 vsShaderValues::vsShaderValues():
 	m_parent(nullptr),
-	m_value(16)
+	m_value(16),
+	m_id(s_nextGeneration++),
+	m_generation(s_nextGeneration++)
 {
 	for ( int i = 0; i < MAX_TEXTURE_SLOTS; i++ )
 	{
@@ -26,7 +37,9 @@ vsShaderValues::vsShaderValues():
 
 vsShaderValues::vsShaderValues( const vsShaderValues& other ):
 	m_parent(nullptr),
-	m_value(16)
+	m_value(16),
+	m_id(s_nextGeneration++),
+	m_generation(s_nextGeneration++)
 {
 	int valueCount = other.m_value.GetHashEntryCount();
 
@@ -43,11 +56,51 @@ vsShaderValues::vsShaderValues( const vsShaderValues& other ):
 	}
 }
 
+vsShaderValues::~vsShaderValues()
+{
+	// A pipelined frame might still be drawing with us.
+	vsRenderThread::Sync();
+}
+
+void
+vsShaderValues::Touch()
+{
+	m_generation = s_nextGeneration++;
+}
+
+void
+vsShaderValues::SetParent( vsShaderValues *parent )
+{
+	m_parent = parent;
+	Touch();
+}
+
+uint32_t
+vsShaderValues::GetGeneration() const
+{
+	if ( m_parent )
+	{
+		uint32_t parentGeneration = m_parent->GetGeneration();
+		return vsMax( m_generation, parentGeneration );
+	}
+	return m_generation;
+}
+
+const vsShaderValues::Value*
+vsShaderValues::FindValue( uint32_t uid ) const
+{
+	const Value* v = m_value.FindItem(uid);
+	if ( !v && m_parent )
+		return m_parent->FindValue(uid);
+	return v;
+}
+
 void
 vsShaderValues::SetUniformF( const vsString& name, float value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.f32 = value;
 		m_value[id].type = Value::Type_Float;
 		m_value[id].bound = false;
@@ -59,6 +112,7 @@ vsShaderValues::SetUniformB( const vsString& name, bool value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.b = value;
 		m_value[id].type = Value::Type_Bool;
 		m_value[id].bound = false;
@@ -70,6 +124,7 @@ vsShaderValues::SetUniformI( const vsString& name, int value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.i = value;
 		m_value[id].type = Value::Type_Int;
 		m_value[id].bound = false;
@@ -81,6 +136,7 @@ vsShaderValues::SetUniformColor( const vsString& name, const vsColor& value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.vec4[0] = value.r;
 		m_value[id].u.vec4[1] = value.g;
 		m_value[id].u.vec4[2] = value.b;
@@ -95,6 +151,7 @@ vsShaderValues::SetUniformVec2( const vsString& name, const vsVector2D& value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.vec4[0] = value.x;
 		m_value[id].u.vec4[1] = value.y;
 		m_value[id].u.vec4[2] = 0.0;
@@ -109,6 +166,7 @@ vsShaderValues::SetUniformVec3( const vsString& name, const vsVector3D& value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.vec4[0] = value.x;
 		m_value[id].u.vec4[1] = value.y;
 		m_value[id].u.vec4[2] = value.z;
@@ -123,6 +181,7 @@ vsShaderValues::SetUniformVec4( const vsString& name, const vsVector4D& value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.vec4[0] = value.x;
 		m_value[id].u.vec4[1] = value.y;
 		m_value[id].u.vec4[2] = value.z;
@@ -137,6 +196,7 @@ vsShaderValues::BindUniformF( const vsString& name, const float* value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.bind = value;
 		m_value[id].type = Value::Type_Bind;
 		m_value[id].bound = true;
@@ -150,6 +210,7 @@ vsShaderValues::BindUniformB( const vsString& name, const bool* value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.bind = value;
 		m_value[id].type = Value::Type_Bind;
 		m_value[id].bound = true;
@@ -163,6 +224,7 @@ vsShaderValues::BindUniformI( const vsString& name, const int* value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.bind = value;
 		m_value[id].type = Value::Type_Bind;
 		m_value[id].bound = true;
@@ -176,6 +238,7 @@ vsShaderValues::BindUniformColor( const vsString& name, const vsColor* value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.bind = value;
 		m_value[id].type = Value::Type_Bind;
 		m_value[id].bound = true;
@@ -189,6 +252,7 @@ vsShaderValues::BindUniformVec2( const vsString& name, const vsVector2D* value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.bind = value;
 		m_value[id].type = Value::Type_Bind;
 		m_value[id].bound = true;
@@ -202,6 +266,7 @@ vsShaderValues::BindUniformVec3( const vsString& name, const vsVector3D* value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.bind = value;
 		m_value[id].type = Value::Type_Bind;
 		m_value[id].bound = true;
@@ -215,6 +280,7 @@ vsShaderValues::BindUniformVec4( const vsString& name, const vsVector4D* value )
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.bind = value;
 		m_value[id].type = Value::Type_Bind;
 		m_value[id].bound = true;
@@ -228,6 +294,7 @@ vsShaderValues::BindUniformMat4( const vsString& name, const vsMatrix4x4* value
 {
 	{
 		uint32_t id = vsShaderUniformRegistry::UID(name);
+		Touch();
 		m_value[id].u.bind = value;
 		m_value[id].type = Value::Type_Bind;
 		m_value[id].bound = true;
@@ -438,6 +505,7 @@ vsShaderValues::operator=( const vsShaderValues& other )
 {
 	int valueCount = other.m_value.GetHashEntryCount();
 	m_value.Clear();
+	Touch();
 
 	for ( int i = 0; i < valueCount; i++ )
 	{
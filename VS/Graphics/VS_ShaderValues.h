@@ -23,6 +23,7 @@ class vsTexture;
 
 class vsShaderValues
 {
+public:
 	struct Value
 	{
 		enum Type
@@ -60,17 +61,35 @@ class vsShaderValues
 
 	};
 
+private:
 	vsShaderValues *m_parent;
 	vsIntHashTable<Value> m_value;
 	vsTexture *m_texture[48];
 	bool m_textureSet[48];
+
+	uint32_t m_id;			// unique for the life of the program
+	uint32_t m_generation;	// changes every time our uniform values change
+
+	void Touch();
 public:
 
 	vsShaderValues();
 	vsShaderValues( const vsShaderValues& other );
+	~vsShaderValues();
 
 	// a parent object will handle any uniforms which we don't set ourselves.
-	void SetParent( vsShaderValues *parent ) { m_parent = parent; }
+	void SetParent( vsShaderValues *parent );
+
+	uint32_t GetId() const { return m_id; }
+
+	// Returns a number which changes whenever any uniform value in us or in
+	// our parents is set, bound, or copied over.  (Values which are BOUND may
+	// still change without it, of course)
+	uint32_t GetGeneration() const;
+
+	// Returns the value for this uniform from us or our parents, or nullptr
+	// if nobody has one.  Only valid until GetGeneration() next changes.
+	const Value* FindValue( uint32_t uid ) const;
 
 	void SetUniformF( const vsString& name, float value );
 	void SetUniformB( const vsString& name, bool value );
@@ -19,10 +19,20 @@
 #include "VS_TimerSystem.h"
 #include "VS_Renderer_OpenGL3.h"
 #include "VS_RenderBuffer.h"
+#include "VS_RenderThread.h"
+#include "VS_StreamingBuffer.h"
 
 static bool m_localToWorldAttribIsActive = false;
 static bool m_colorAttribIsActive = false;
 
+// we only keep this many binding plans per variant;  past that, we throw them
+// all away and start over.  (Plans for materials which no longer exist are
+// never looked up again, so this is what eventually cleans those up)
+static const int c_maxBindingPlans = 256;
+
+uint64_t vsShaderVariant::s_uniformUploadCount = 0;
+uint64_t vsShaderVariant::s_uniformSkipCount = 0;
+
 	extern vsArray<vsShaderVariantDefinition> g_shaderVariantDefinitions;
 
 vsShaderVariant::vsShaderVariant( const vsString &vertexShader,
@@ -39,6 +49,9 @@ vsShaderVariant::vsShaderVariant( const vsString &vertexShader,
 	m_vertexShaderFile(vFilename),
 	m_fragmentShaderFile(fFilename),
 	m_system(false),
+	m_planLookup(32),
+	m_currentPlan(nullptr),
+	m_currentPlanGeneration(0),
 	m_shader(-1),
 	m_variantBits(variantBits),
 	m_litBool(lit),
@@ -356,6 +369,10 @@ vsShaderVariant::Compile( const vsString &vertexShader, const vsString &fragment
 	}
 
 	GL_CHECK("Shader::Other");
+
+	// our uniforms have all moved around, so any plans we had are useless.
+	ClearBindingPlans();
+
 	m_globalTimeUniformId = GetUniformId("globalTime");
 	m_globalSecondsUniformId = GetUniformId("globalSeconds");
 	m_globalMicrosecondsUniformId = GetUniformId("globalMicroseconds");
@@ -368,8 +385,10 @@ vsShaderVariant::Compile( const vsString &vertexShader, const vsString &fragment
 
 vsShaderVariant::~vsShaderVariant()
 {
+	vsRenderThread::Sync();
 	// vsLog("Destroyed shader %d", m_shader);
 	vsRenderer_OpenGL3::DestroyShader(m_shader);
+	ClearBindingPlans();
 	vsDeleteArray( m_uniform );
 	vsDeleteArray( m_attribute );
 }
@@ -388,6 +407,7 @@ vsShaderVariant::Reload( const vsString& vertexShader, const vsString &fragmentS
 
 	if ( !m_vertexShaderFile.empty() && !m_fragmentShaderFile.empty() )
 	{
+		vsRenderThread::Sync();
 		Compile( vertexShader, fragmentShader, m_litBool, m_textureBool, m_variantBits );
 	}
 }
@@ -474,30 +494,39 @@ vsShaderVariant::SetInstanceColors( const vsColor* color, int matCount )
 			}
 
 			GLuint size = sizeof(vsColor)*matCount;
-			static GLuint g_vbo = 0xffffffff;
-			static GLuint g_vboSize = 0;
-			// this could be a lot smarter.
-			if ( g_vbo == 0xffffffff )
-			{
-				glGenBuffers(1, &g_vbo);
-			}
-
-			glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
-			if ( size > g_vboSize )
+			vsStreamingBuffer *stream = vsStreamingBuffer::Instance();
+			size_t offset = 0;
+			if ( stream && stream->Upload( color, size, &offset ) )
 			{
-				glBufferData(GL_ARRAY_BUFFER, size, color, GL_STREAM_DRAW);
-				g_vboSize = size;
+				glBindBuffer(GL_ARRAY_BUFFER, stream->GetBufferID());
 			}
 			else
 			{
-				void *ptr = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
-				if ( ptr )
+				static GLuint g_vbo = 0xffffffff;
+				static GLuint g_vboSize = 0;
+				// this could be a lot smarter.
+				if ( g_vbo == 0xffffffff )
 				{
-					memcpy(ptr, color, size);
-					glUnmapBuffer(GL_ARRAY_BUFFER);
+					glGenBuffers(1, &g_vbo);
+				}
+
+				glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
+				if ( size > g_vboSize )
+				{
+					glBufferData(GL_ARRAY_BUFFER, size, color, GL_STREAM_DRAW);
+					g_vboSize = size;
+				}
+				else
+				{
+					void *ptr = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+					if ( ptr )
+					{
+						memcpy(ptr, color, size);
+						glUnmapBuffer(GL_ARRAY_BUFFER);
+					}
 				}
 			}
-			glVertexAttribPointer(m_instanceColorAttributeLoc, 4, GL_FLOAT, 0, 0, 0);
+			glVertexAttribPointer(m_instanceColorAttributeLoc, 4, GL_FLOAT, 0, 0, reinterpret_cast<GLvoid*>(offset));
 #ifdef VS_PRISTINE_BINDINGS
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif // VS_PRISTINE_BINDINGS
@@ -596,34 +625,44 @@ vsShaderVariant::SetLocalToWorld( const vsMatrix4x4* localToWorld, int matCount
 				m_localToWorldAttribIsActive = true;
 			}
 
-			static GLuint g_vbo = 0xffffffff;
-			static GLuint g_vboSize = 0;
 			GLuint size = sizeof(vsMatrix4x4) * matCount;
-			// this could be a lot smarter.
-			if ( g_vbo == 0xffffffff )
-			{
-				glGenBuffers(1, &g_vbo);
-			}
-			glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
-			if ( size > g_vboSize )
+			vsStreamingBuffer *stream = vsStreamingBuffer::Instance();
+			size_t offset = 0;
+			if ( stream && stream->Upload( localToWorld, size, &offset ) )
 			{
-				glBufferData(GL_ARRAY_BUFFER, size, localToWorld, GL_STREAM_DRAW);
-				g_vboSize = size;
+				glBindBuffer(GL_ARRAY_BUFFER, stream->GetBufferID());
 			}
 			else
 			{
-				void *ptr = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
-				if ( ptr )
+				static GLuint g_vbo = 0xffffffff;
+				static GLuint g_vboSize = 0;
+				// this could be a lot smarter.
+				if ( g_vbo == 0xffffffff )
+				{
+					glGenBuffers(1, &g_vbo);
+				}
+				glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
+				if ( size > g_vboSize )
+				{
+					glBufferData(GL_ARRAY_BUFFER, size, localToWorld, GL_STREAM_DRAW);
+					g_vboSize = size;
+				}
+				else
 				{
-					memcpy(ptr, localToWorld, size);
-					glUnmapBuffer(GL_ARRAY_BUFFER);
+					void *ptr = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+					if ( ptr )
+					{
+						memcpy(ptr, localToWorld, size);
+						glUnmapBuffer(GL_ARRAY_BUFFER);
+					}
 				}
 			}
 			vsAssert( sizeof(vsMatrix4x4) == 64, "Whaa?" );
-			glVertexAttribPointer(m_localToWorldAttributeLoc, 4, GL_FLOAT, 0, 64, 0);
-			glVertexAttribPointer(m_localToWorldAttributeLoc+1, 4, GL_FLOAT, 0, 64, (void*)16);
-			glVertexAttribPointer(m_localToWorldAttributeLoc+2, 4, GL_FLOAT, 0, 64, (void*)32);
-			glVertexAttribPointer(m_localToWorldAttributeLoc+3, 4, GL_FLOAT, 0, 64, (void*)48);
+			char *base = reinterpret_cast<char*>(offset);
+			glVertexAttribPointer(m_localToWorldAttributeLoc, 4, GL_FLOAT, 0, 64, base);
+			glVertexAttribPointer(m_localToWorldAttributeLoc+1, 4, GL_FLOAT, 0, 64, base+16);
+			glVertexAttribPointer(m_localToWorldAttributeLoc+2, 4, GL_FLOAT, 0, 64, base+32);
+			glVertexAttribPointer(m_localToWorldAttributeLoc+3, 4, GL_FLOAT, 0, 64, base+48);
 #ifdef VS_PRISTINE_BINDINGS
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 #endif // VS_PRISTINE_BINDINGS
@@ -709,93 +748,163 @@ vsShaderVariant::SetLight( int id, const vsColor& ambient, const vsColor& diffus
 	}
 }
 
+void
+vsShaderVariant::ClearBindingPlans()
+{
+	for ( int i = 0; i < m_plan.ItemCount(); i++ )
+		vsDelete( m_plan[i] );
+	m_plan.Clear();
+	m_planLookup.Clear();
+	m_currentPlan = nullptr;
+}
+
+vsShaderVariant::BindingPlan*
+vsShaderVariant::GetBindingPlan( const vsShaderValues *values )
+{
+	uint32_t id = values ? values->GetId() : 0;
+	uint32_t generation = values ? values->GetGeneration() : 0;
+
+	BindingPlan **existing = m_planLookup.FindItem(id);
+	BindingPlan *plan = existing ? *existing : nullptr;
+	if ( plan && plan->generation == generation )
+		return plan;
+
+	if ( !plan )
+	{
+		if ( m_plan.ItemCount() >= c_maxBindingPlans )
+			ClearBindingPlans();
+		plan = new BindingPlan;
+		m_plan.AddItem(plan);
+		m_planLookup.AddItemWithKey(plan, id);
+	}
+
+	plan->value.Clear();
+	plan->boundUniform.Clear();
+	plan->value.Reserve( m_uniformCount );
+	for ( int i = 0; i < m_uniformCount; i++ )
+	{
+		const vsShaderValues::Value *v = values ? values->FindValue( m_uniform[i].uid ) : nullptr;
+		plan->value.AddItem(v);
+		if ( v && v->bound )
+			plan->boundUniform.AddItem(i);
+	}
+	plan->generation = generation;
+	return plan;
+}
+
+void
+vsShaderVariant::ApplyUniformValue( int i, const vsShaderValues::Value *v )
+{
+	// a nullptr value means that nobody set this uniform, so it gets a
+	// default value.
+	switch( m_uniform[i].type )
+	{
+		case GL_BOOL:
+			{
+				bool b = false;
+				if ( v )
+					b = v->bound ? *(bool*)v->u.bind : v->u.b;
+				SetUniformValueB( i, b );
+				break;
+			}
+		case GL_FLOAT:
+			{
+				float f = 0.f;
+				if ( v )
+					f = v->bound ? *(float*)v->u.bind : v->u.f32;
+				SetUniformValueF( i, f );
+				break;
+			}
+		case GL_FLOAT_VEC2:
+		case GL_FLOAT_VEC3:
+		case GL_FLOAT_VEC4:
+			{
+				vsVector4D vec;
+				if ( v )
+					vec = v->bound ? *(vsVector4D*)v->u.bind : *(vsVector4D*)v->u.vec4;
+				if ( m_uniform[i].type == GL_FLOAT_VEC2 )
+					SetUniformValueVec2( i, vsVector2D(vec.x,vec.y) );
+				else if ( m_uniform[i].type == GL_FLOAT_VEC3 )
+					SetUniformValueVec3( i, vec );
+				else
+					SetUniformValueVec4( i, vec );
+				break;
+			}
+		case GL_FLOAT_MAT4:
+			{
+				vsMatrix4x4 m;
+				if ( v && v->bound )
+					m = *(vsMatrix4x4*)v->u.bind;
+				SetUniformValueMat4( i, m );
+				break;
+			}
+		case GL_INT:
+		case GL_SAMPLER_2D:
+		case GL_UNSIGNED_INT_SAMPLER_2D:
+		case GL_SAMPLER_2D_SHADOW:
+		case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+		case GL_INT_SAMPLER_BUFFER:
+		case GL_SAMPLER_BUFFER:
+			{
+				int b = 0;
+				if ( v )
+					b = v->bound ? *(int*)v->u.bind : v->u.i;
+				SetUniformValueI( i, b );
+				break;
+			}
+		case GL_UNSIGNED_INT:
+			{
+				GL_CHECK_SCOPED("UnsignedInt");
+				int b = 0;
+				if ( v )
+					b = v->bound ? *(int*)v->u.bind : v->u.i;
+				uint32_t ui = (uint32_t)b; // [TODO] make less horrible
+				SetUniformValueUI( i, ui );
+				break;
+			}
+
+		default:
+			// [TODO]  Handle more uniform types
+			break;
+	}
+}
+
 void
 vsShaderVariant::Prepare( vsMaterial *material, vsShaderValues *values, vsRenderTarget *target )
 {
 	// GLint current;
 	// glGetIntegerv(GL_CURRENT_PROGRAM, &current);
 	// vsAssert( current == (GLint)m_shader, "This shader isn't currently active??" );
-	for ( int i = 0; i < m_uniformCount; i++ )
+	BindingPlan *plan = GetBindingPlan( material ? material->GetShaderValues() : nullptr );
+
+	// If this plan's values are already uploaded and haven't changed since,
+	// the only uniforms which can need new values are the bound ones.
+	// Per-draw 'values' can override anything, though, so with those we
+	// need to check everything, and afterward we no longer know that the
+	// plan's values are the ones uploaded.
+	if ( !values && plan == m_currentPlan && plan->generation == m_currentPlanGeneration )
 	{
-		switch( m_uniform[i].type )
+		for ( int j = 0; j < plan->boundUniform.ItemCount(); j++ )
 		{
-			case GL_BOOL:
-				{
-					bool b = false;
-					if ( !values || !values->UniformB( m_uniform[i].uid, b ) )
-						 material->GetShaderValues()->UniformB( m_uniform[i].uid, b );
-					SetUniformValueB( i, b );
-					break;
-				}
-			case GL_FLOAT:
-				{
-					float f = 0.f;
-					if ( !values || !values->UniformF( m_uniform[i].uid, f ) )
-						material->GetShaderValues()->UniformF( m_uniform[i].uid, f );
-					SetUniformValueF( i, f );
-					break;
-				}
-			case GL_FLOAT_VEC2:
-				{
-					vsVector4D v;
-					if ( !values || !values->UniformVec4( m_uniform[i].uid, v ) )
-						material->GetShaderValues()->UniformVec4( m_uniform[i].uid, v );
-					SetUniformValueVec2( i, vsVector2D(v.x,v.y) );
-					break;
-				}
-			case GL_FLOAT_VEC3:
-				{
-					vsVector4D v;
-					if ( !values || !values->UniformVec4( m_uniform[i].uid, v ) )
-						material->GetShaderValues()->UniformVec4( m_uniform[i].uid, v );
-					SetUniformValueVec3( i, v );
-					break;
-				}
-			case GL_FLOAT_VEC4:
-				{
-					vsVector4D v;
-					if ( !values || !values->UniformVec4( m_uniform[i].uid, v ) )
-						material->GetShaderValues()->UniformVec4( m_uniform[i].uid, v );
-					SetUniformValueVec4( i, v );
-					break;
-				}
-			case GL_FLOAT_MAT4:
-				{
-					vsMatrix4x4 v;
-					if ( !values || !values->UniformMat4( m_uniform[i].uid, v ) )
-						material->GetShaderValues()->UniformMat4( m_uniform[i].uid, v );
-					SetUniformValueMat4( i, v );
-					break;
-				}
-			case GL_INT:
-			case GL_SAMPLER_2D:
-			case GL_UNSIGNED_INT_SAMPLER_2D:
-			case GL_SAMPLER_2D_SHADOW:
-			case GL_UNSIGNED_INT_SAMPLER_BUFFER:
-			case GL_INT_SAMPLER_BUFFER:
-			case GL_SAMPLER_BUFFER:
-				{
-					int b = 0;
-					if ( !values || !values->UniformI( m_uniform[i].uid, b ) )
-						material->GetShaderValues()->UniformI( m_uniform[i].uid, b);
-					SetUniformValueI( i, b );
-					break;
-				}
-			case GL_UNSIGNED_INT:
-				{
-					GL_CHECK_SCOPED("UnsignedInt");
-					int b = 0;
-					if ( !values || !values->UniformI( m_uniform[i].uid, b ) )
-						material->GetShaderValues()->UniformI( m_uniform[i].uid, b);
-					uint32_t ui = (uint32_t)b; // [TODO] make less horrible
-					SetUniformValueUI( i, ui );
-					break;
-				}
-
-			default:
-				// [TODO]  Handle more uniform types
-				break;
+			int i = plan->boundUniform[j];
+			ApplyUniformValue( i, plan->value[i] );
 		}
+		s_uniformSkipCount += m_uniformCount - plan->boundUniform.ItemCount();
+	}
+	else
+	{
+		bool overridden = false;
+		for ( int i = 0; i < m_uniformCount; i++ )
+		{
+			const vsShaderValues::Value *v = values ? values->FindValue( m_uniform[i].uid ) : nullptr;
+			if ( v )
+				overridden = true;
+			else
+				v = plan->value[i];
+			ApplyUniformValue( i, v );
+		}
+		m_currentPlan = overridden ? nullptr : plan;
+		m_currentPlanGeneration = plan->generation;
 	}
 
 	if ( m_resolutionLoc >= 0 )
@@ -846,7 +955,10 @@ vsShaderVariant::SetUniformValueF( int i, float value )
 	{
 		glUniform1f( m_uniform[i].loc, value );
 		m_uniform[i].f32 = value;
+		s_uniformUploadCount++;
 	}
+	else
+		s_uniformSkipCount++;
 }
 
 void
@@ -856,7 +968,10 @@ vsShaderVariant::SetUniformValueB( int i, bool value )
 	{
 		glUniform1i( m_uniform[i].loc, value );
 		m_uniform[i].b = value;
+		s_uniformUploadCount++;
 	}
+	else
+		s_uniformSkipCount++;
 }
 
 void
@@ -866,6 +981,7 @@ vsShaderVariant::SetUniformValueUI( int i, unsigned int value )
 	// {
 		glUniform1ui( m_uniform[i].loc, value );
 		m_uniform[i].u32 = value;
+		s_uniformUploadCount++;
 	// }
 }
 
@@ -875,49 +991,67 @@ vsShaderVariant::SetUniformValueI( int i, int value )
 	// for ( int j = 0; j < m_uniform[i].arraySize; j++ )
 	// {
 		glUniform1i( m_uniform[i].loc, value );
+		s_uniformUploadCount++;
 	// }
 }
 
 void
 vsShaderVariant::SetUniformValueVec2( int i, const vsVector2D& value )
 {
-	glUniform2f( m_uniform[i].loc, value.x, value.y );
-	m_uniform[i].vec4.x = value.x;
-	m_uniform[i].vec4.y = value.y;
+	if ( value.x != m_uniform[i].vec4.x || value.y != m_uniform[i].vec4.y )
+	{
+		glUniform2f( m_uniform[i].loc, value.x, value.y );
+		m_uniform[i].vec4.x = value.x;
+		m_uniform[i].vec4.y = value.y;
+		s_uniformUploadCount++;
+	}
+	else
+		s_uniformSkipCount++;
 }
 
 void
 vsShaderVariant::SetUniformValueVec3( int i, const vsVector3D& value )
 {
-	glUniform3f( m_uniform[i].loc, value.x, value.y, value.z );
-	m_uniform[i].vec4 = value;
+	if ( value.x != m_uniform[i].vec4.x || value.y != m_uniform[i].vec4.y ||
+			value.z != m_uniform[i].vec4.z )
+	{
+		glUniform3f( m_uniform[i].loc, value.x, value.y, value.z );
+		m_uniform[i].vec4 = value;
+		s_uniformUploadCount++;
+	}
+	else
+		s_uniformSkipCount++;
 }
 
 
 void
 vsShaderVariant::SetUniformValueVec3( int i, const vsColor& value )
 {
-	glUniform3f( m_uniform[i].loc, value.r, value.g, value.b );
-	m_uniform[i].vec4.Set(value.r, value.g, value.b, 0.f);
+	SetUniformValueVec3( i, vsVector3D(value.r, value.g, value.b) );
 }
 
 void
 vsShaderVariant::SetUniformValueVec4( int i, const vsVector4D& value )
 {
-	glUniform4f( m_uniform[i].loc, value.x, value.y, value.z, value.w );
-	m_uniform[i].vec4 = value;
+	if ( value != m_uniform[i].vec4 )
+	{
+		glUniform4f( m_uniform[i].loc, value.x, value.y, value.z, value.w );
+		m_uniform[i].vec4 = value;
+		s_uniformUploadCount++;
+	}
+	else
+		s_uniformSkipCount++;
 }
 
 void
 vsShaderVariant::SetUniformValueVec4( int i, const vsColor& value )
 {
-	glUniform4f( m_uniform[i].loc, value.r, value.g, value.b, value.a );
-	m_uniform[i].vec4.Set(value.r, value.g, value.b, value.a);
+	SetUniformValueVec4( i, vsVector4D(value.r, value.g, value.b, value.a) );
 }
 
 void
 vsShaderVariant::SetUniformValueMat4( int i, const vsMatrix4x4& value )
 {
 	glUniformMatrix4fv( m_uniform[i].loc, 1, GL_FALSE, (const GLfloat*)&value );
+	s_uniformUploadCount++;
 }
-
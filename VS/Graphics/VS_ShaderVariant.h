@@ -11,6 +11,8 @@
 #define VS_SHADERVARIANT_H
 
 #include "VS_Shader.h"
+#include "VS_ShaderValues.h"
+#include "VS/Utils/VS_IntHashTable.h"
 
 class vsShaderVariant
 {
@@ -58,6 +60,30 @@ private:
 
 	bool m_system; // system shader;  should not be reloaded!
 
+	// A binding plan remembers, for one material's vsShaderValues, which
+	// value feeds each of our uniforms, so that Prepare() doesn't need to
+	// search for them every time.  It's rebuilt whenever those values'
+	// generation changes.
+	struct BindingPlan
+	{
+		vsArray<const vsShaderValues::Value*> value; // one per uniform;  nullptr means 'default'
+		vsArray<int> boundUniform; // uniforms whose values are bound, and so may change at any time
+		uint32_t generation;
+	};
+	vsIntHashTable<BindingPlan*> m_planLookup; // keyed by vsShaderValues id
+	vsArray<BindingPlan*> m_plan;
+
+	// the plan whose values are currently uploaded, if any.
+	BindingPlan *m_currentPlan;
+	uint32_t m_currentPlanGeneration;
+
+	static uint64_t s_uniformUploadCount;
+	static uint64_t s_uniformSkipCount;
+
+	BindingPlan* GetBindingPlan( const vsShaderValues *values );
+	void ClearBindingPlans();
+	void ApplyUniformValue( int i, const vsShaderValues::Value *value );
+
 	void SetUniformValueF( int i, float value );
 	void SetUniformValueB( int i, bool value );
 	void SetUniformValueI( int i, int value );
@@ -110,6 +136,13 @@ public:
 			const vsColor& specular, const vsVector3D& position,
 			const vsVector3D& halfVector );
 
+	// How many uniform values we've uploaded to GL, and how many times we
+	// skipped a uniform because its value hadn't changed, across all
+	// variants.
+	static uint64_t GetUniformUploadCount() { return s_uniformUploadCount; }
+	static uint64_t GetUniformSkipCount() { return s_uniformSkipCount; }
+	static void ResetUniformCounts() { s_uniformUploadCount = s_uniformSkipCount = 0; }
+
 	friend class vsShader;
 };
 
@@ -0,0 +1,244 @@
+/*
+ *  VS_StreamingBuffer.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#include "VS_StreamingBuffer.h"
+
+#include "VS_OpenGL.h"
+
+vsStreamingBuffer * vsStreamingBuffer::s_instance = nullptr;
+
+namespace
+{
+	const size_t c_alignment = 16;
+
+	// We fill the buffer through GL_COPY_WRITE_BUFFER, so that we never disturb
+	// whatever's bound to GL_ARRAY_BUFFER, or the current vertex array's
+	// GL_ELEMENT_ARRAY_BUFFER.
+	const GLenum c_bindPoint = GL_COPY_WRITE_BUFFER;
+};
+
+vsStreamingBuffer::vsStreamingBuffer( size_t bytesPerFrame ):
+	m_bufferID( 0 ),
+	m_mapped( nullptr ),
+	m_regionBytes( (bytesPerFrame + c_alignment - 1) & ~(c_alignment - 1) ),
+	m_frame( 0 ),
+	m_drawFrame( 0 ),
+	m_warnedOverflow( false )
+{
+	vsAssert(s_instance == nullptr, "Multiple vsStreamingBuffers created??");
+	s_instance = this;
+
+	for ( int i = 0; i < c_regionCount; i++ )
+	{
+		m_cursor[i] = 0;
+		m_overflows[i] = 0;
+		m_fence[i] = nullptr;
+	}
+	ResetStats();
+
+	GL_CHECK_SCOPED("vsStreamingBuffer");
+
+	GLsizeiptr totalBytes = (GLsizeiptr)(m_regionBytes * c_regionCount);
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	m_bufferID = buffer;
+	glBindBuffer(c_bindPoint, m_bufferID);
+
+#if defined(GL_MAP_PERSISTENT_BIT)
+	if ( GLEW_ARB_buffer_storage && glBufferStorage )
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(c_bindPoint, totalBytes, nullptr, flags);
+		m_mapped = (char*)glMapBufferRange(c_bindPoint, 0, totalBytes, flags);
+		if ( !m_mapped )
+		{
+			// Buffer storage is immutable, so we need a new buffer to fall
+			// back onto the orphaning path.
+			vsLog("vsStreamingBuffer: persistent mapping failed;  falling back to orphaning");
+			glDeleteBuffers(1, &buffer);
+			glGenBuffers(1, &buffer);
+			m_bufferID = buffer;
+			glBindBuffer(c_bindPoint, m_bufferID);
+		}
+	}
+#endif
+	if ( !m_mapped )
+		glBufferData(c_bindPoint, totalBytes, nullptr, GL_STREAM_DRAW);
+
+	glBindBuffer(c_bindPoint, 0);
+
+	vsLog("vsStreamingBuffer: %d regions of %d KB, %s", c_regionCount, (int)(m_regionBytes / 1024),
+			m_mapped ? "persistently mapped" : "orphaned on wrap");
+}
+
+vsStreamingBuffer::~vsStreamingBuffer()
+{
+	GL_CHECK_SCOPED("~vsStreamingBuffer");
+
+	for ( int i = 0; i < c_regionCount; i++ )
+	{
+		if ( m_fence[i] )
+			glDeleteSync( (GLsync)m_fence[i] );
+	}
+
+	glBindBuffer(c_bindPoint, m_bufferID);
+	if ( m_mapped )
+		glUnmapBuffer(c_bindPoint);
+	glBindBuffer(c_bindPoint, 0);
+
+	GLuint buffer = m_bufferID;
+	glDeleteBuffers(1, &buffer);
+
+	vsAssert(s_instance == this, "vsStreamingBuffer instance isn't me??");
+	s_instance = nullptr;
+}
+
+bool
+vsStreamingBuffer::Allocate( uint32_t frame, size_t bytes, size_t *offset )
+{
+	if ( bytes == 0 )
+		return false;
+
+	int region = GetRegion( frame );
+	size_t start = (m_cursor[region] + c_alignment - 1) & ~(c_alignment - 1);
+	if ( start + bytes > m_regionBytes )
+	{
+		// We report these in FrameRendered(), on whichever thread is
+		// drawing, so that only one thread ever touches our stats.
+		m_overflows[region]++;
+		return false;
+	}
+
+	*offset = region * m_regionBytes + start;
+	m_cursor[region] = start + bytes;
+	return true;
+}
+
+bool
+vsStreamingBuffer::UploadTo( uint32_t frame, const void *data, size_t bytes, size_t *offset )
+{
+	if ( !Allocate( frame, bytes, offset ) )
+		return false;
+
+	if ( m_mapped )
+	{
+		memcpy( m_mapped + *offset, data, bytes );
+	}
+	else
+	{
+		glBindBuffer(c_bindPoint, m_bufferID);
+		glBufferSubData(c_bindPoint, *offset, bytes, data);
+		glBindBuffer(c_bindPoint, 0);
+	}
+	return true;
+}
+
+bool
+vsStreamingBuffer::Upload( const void *data, size_t bytes, size_t *offset )
+{
+	return UploadTo( m_drawFrame, data, bytes, offset );
+}
+
+bool
+vsStreamingBuffer::UploadForNextFrame( const void *data, size_t bytes, size_t *offset )
+{
+	return UploadTo( m_frame, data, bytes, offset );
+}
+
+void
+vsStreamingBuffer::FrameSubmitted()
+{
+	// Whoever draws the frame we've built carries on from wherever we got
+	// up to in its region.
+	m_drawFrame = m_frame;
+	m_frame++;
+
+	// The region we're about to build into was last drawn from a few frames
+	// ago;  FrameRendered() fenced it then, so make sure the GPU's done.
+	int region = GetRegion( m_frame );
+	if ( m_fence[region] )
+	{
+		GLsync fence = (GLsync)m_fence[region];
+		GLenum result = glClientWaitSync( fence, 0, 0 );
+		if ( result == GL_TIMEOUT_EXPIRED )
+		{
+			m_stats.stalls++;
+			int waitedSeconds = 0;
+			while ( (result = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(5000000000) )) == GL_TIMEOUT_EXPIRED )
+			{
+				waitedSeconds += 5;
+				vsLog("Waiting on streaming buffer fence timed out after %d seconds.  Resuming wait...", waitedSeconds);
+			}
+		}
+		glDeleteSync( fence );
+		m_fence[region] = nullptr;
+	}
+	m_cursor[region] = 0;
+	m_overflows[region] = 0;
+}
+
+void
+vsStreamingBuffer::FrameRendered()
+{
+	int region = GetRegion( m_drawFrame );
+	size_t used = m_cursor[region];
+	m_stats.bytesLastFrame = used;
+	m_stats.peakFrameBytes = vsMax( m_stats.peakFrameBytes, used );
+	m_stats.totalBytes += used;
+	m_stats.frames++;
+
+	if ( m_overflows[region] )
+	{
+		m_stats.overflows += m_overflows[region];
+		m_overflows[region] = 0;
+		if ( !m_warnedOverflow )
+		{
+			vsLog("vsStreamingBuffer: frame region full (%d KB);  falling back to per-buffer uploads", (int)(m_regionBytes / 1024));
+			m_warnedOverflow = true;
+		}
+	}
+
+	if ( m_mapped )
+	{
+		if ( m_fence[region] )
+			glDeleteSync( (GLsync)m_fence[region] );
+		m_fence[region] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+		// The main thread may wait on this from the update context, which
+		// can't flush ours for us.
+		glFlush();
+	}
+	else
+	{
+		// Without a persistent mapping, the main thread only writes into us
+		// while it has the main GL context.  So unless the region being
+		// built already has something in it, nobody needs anything in the
+		// buffer any more.
+		int nextRegion = GetRegion( m_frame );
+		if ( nextRegion == 0 && m_cursor[nextRegion] == 0 )
+		{
+			// orphan the buffer and start on the new one.
+			glBindBuffer(c_bindPoint, m_bufferID);
+			glBufferData(c_bindPoint, (GLsizeiptr)(m_regionBytes * c_regionCount), nullptr, GL_STREAM_DRAW);
+			glBindBuffer(c_bindPoint, 0);
+		}
+	}
+}
+
+void
+vsStreamingBuffer::ResetStats()
+{
+	m_stats.bytesLastFrame = 0;
+	m_stats.peakFrameBytes = 0;
+	m_stats.totalBytes = 0;
+	m_stats.frames = 0;
+	m_stats.overflows = 0;
+	m_stats.stalls = 0;
+}
+
@@ -0,0 +1,113 @@
+/*
+ *  VS_StreamingBuffer.h
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#ifndef VS_STREAMINGBUFFER_H
+#define VS_STREAMINGBUFFER_H
+
+// vsStreamingBuffer is one big GL buffer which we suballocate from, for
+// vertex and index data which is only going to be drawn in the frame it's
+// written.  Type_Stream vsRenderBuffers, immediate-mode arrays and
+// per-draw instance arrays all put their data here, instead of each
+// owning a buffer and re-specifying it every time it changes.
+//
+// The buffer is split into one region per frame in flight.  Each frame
+// we write into the next region in turn;  when we wrap back around to a
+// region, we wait on the fence we placed after the last frame which used
+// it, so we never overwrite data the GPU might still be reading.
+//
+// Where ARB_buffer_storage is available, the whole buffer is mapped
+// persistently and writing into it is just a memcpy.  Otherwise we fall
+// back to glBufferSubData for each allocation, and orphan the whole buffer
+// each time we wrap around to the first region.
+//
+// Allocations are 16-byte aligned.  When a frame's region is full,
+// Upload() fails, and callers should use their own buffer instead.
+//
+// With pipelined rendering (see vsRenderThread), the main thread builds one
+// frame while the render thread draws the one before it, so we keep track
+// of both:  UploadForNextFrame() writes into the region of the frame being
+// built, and Upload() into the region of the frame being drawn.  Without
+// pipelining, these are the same frame by the time it's drawn.  The main
+// thread may only call UploadForNextFrame() without holding the main GL
+// context if IsPersistent();  everything else must be called by whichever
+// thread currently has it.
+
+class vsStreamingBuffer
+{
+public:
+
+	struct Stats
+	{
+		size_t		bytesLastFrame;		// bytes used by the last completed frame, including alignment
+		size_t		peakFrameBytes;		// the most bytes used by any single frame
+		uint64_t	totalBytes;
+		uint64_t	frames;
+		uint64_t	overflows;			// allocations which didn't fit in their frame's region
+		uint64_t	stalls;				// times we had to wait for the GPU to release a region
+	};
+
+private:
+
+	static vsStreamingBuffer *s_instance;
+
+	static const int c_regionCount = 3;
+
+	uint32_t	m_bufferID;
+	char *		m_mapped;		// the whole buffer, if it's persistently mapped
+	size_t		m_regionBytes;
+	size_t		m_cursor[c_regionCount];	// next free byte in each region
+	uint32_t	m_overflows[c_regionCount];	// allocations which didn't fit in each region, since it was last reused
+	uint32_t	m_frame;		// the frame being built;  main thread only
+	uint32_t	m_drawFrame;	// the frame being drawn
+	void *		m_fence[c_regionCount];	// GLsync, placed after the last frame which wrote each region
+	bool		m_warnedOverflow;
+
+	Stats		m_stats;
+
+	int			GetRegion( uint32_t frame ) const { return frame % c_regionCount; }
+	bool		Allocate( uint32_t frame, size_t bytes, size_t *offset );
+	bool		UploadTo( uint32_t frame, const void *data, size_t bytes, size_t *offset );
+
+	vsStreamingBuffer( const vsStreamingBuffer& other ) = delete;
+	vsStreamingBuffer& operator=( const vsStreamingBuffer& other ) = delete;
+
+public:
+
+	static vsStreamingBuffer * Instance() { return s_instance; }
+
+	vsStreamingBuffer( size_t bytesPerFrame = 4 * 1024 * 1024 );
+	~vsStreamingBuffer();
+
+	uint32_t	GetBufferID() const { return m_bufferID; }
+	bool		IsPersistent() const { return m_mapped != nullptr; }
+
+	// Count the frames we've built and drawn.  Data written for one frame
+	// must not be drawn during any other one.
+	uint32_t	GetFrame() const { return m_frame; }
+	uint32_t	GetDrawFrame() const { return m_drawFrame; }
+
+	// Copy 'bytes' from 'data' into the region of the frame being drawn, or
+	// of the frame being built, returning false if there's no room left in
+	// that frame.
+	bool		Upload( const void *data, size_t bytes, size_t *offset );
+	bool		UploadForNextFrame( const void *data, size_t bytes, size_t *offset );
+
+	// Called by the main thread once per frame, when it hands the frame it's
+	// built over to be drawn.
+	void		FrameSubmitted();
+
+	// Called once per frame, after we've finished drawing.
+	void		FrameRendered();
+
+	const Stats &	GetStats() const { return m_stats; }
+	void			ResetStats();
+};
+
+#endif // VS_STREAMINGBUFFER_H
+
@@ -10,6 +10,7 @@
 #include "VS_TextureInternal.h"
 
 #include "VS_Color.h"
+#include "VS_CookedTexture.h"
 #include "VS_FloatImage.h"
 #include "VS_Image.h"
 #include "VS_HalfIntImage.h"
@@ -17,6 +18,7 @@
 #include "VS_SingleFloatImage.h"
 #include "VS_RenderTarget.h"
 #include "VS_RenderBuffer.h"
+#include "VS_RenderThread.h"
 
 #include "VS/Files/VS_File.h"
 #include "VS/Memory/VS_Store.h"
@@ -43,6 +45,7 @@ vsTextureInternal::SetRenderTarget( vsRenderTarget* renderTarget, int surfaceBuf
 {
 	// to be used for deferred texture creation  (We went through the vsSurface
 	// constructor with a nullptr argument;  now we're providing the surface)
+	vsRenderThread::Sync();
 
 	m_renderTarget = renderTarget;
 	m_surfaceBuffer = surfaceBuffer;
@@ -65,6 +68,7 @@ vsTextureInternal::vsTextureInternal( const vsString &filename_in ):
 	vsResource(filename_in),
 	m_texture(0),
 	m_depth(false),
+	m_streaming(false),
 	m_premultipliedAlpha(false),
 	m_lockedSampling(false),
 	m_tbo(nullptr),
@@ -72,56 +76,86 @@ vsTextureInternal::vsTextureInternal( const vsString &filename_in ):
 	m_surfaceBuffer(0),
 	m_state(0)
 {
-	if ( vsFile::Exists(filename_in) )
+	vsCookedTexture *cooked = vsCookedTexture::OpenFor( filename_in );
+	if ( cooked )
 	{
-		GLuint t;
-		glGenTextures(1, &t);
-		m_texture = t;
-
-		glBindTexture(GL_TEXTURE_2D, m_texture);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		m_texture = cooked->Upload();
+		m_width = cooked->GetWidth();
+		m_height = cooked->GetHeight();
+		vsDelete( cooked );
+	}
+	else if ( vsFile::Exists(filename_in) )
+	{
+		int w = 0, h = 0;
+		unsigned char* data = DecodeFile( filename_in, &w, &h );
+		m_texture = UploadRGBA( data, w, h );
+		stbi_image_free(data);
 
-		vsFile img(filename_in, vsFile::MODE_Read);
-		vsStore *s = new vsStore( img.GetLength() );
-		img.Store(s);
+		m_width = w;
+		m_height = h;
+		// m_nearestSampling = false;
+	}
+}
 
-		int w,h,n;
+unsigned char*
+vsTextureInternal::DecodeFile( const vsString &filename, int *width, int *height )
+{
+	vsFile img(filename, vsFile::MODE_Read);
+	vsStore *s = new vsStore( img.GetLength() );
+	img.Store(s);
+
+	int n;
+
+	// glTexImage2D expects pixel data to start at the BOTTOM LEFT, but
+	// stbi_load functions give us the pixel data starting at the TOP LEFT.
+	// So we need to flip them here!
+	//
+	// ref:	https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexImage2D.xhtml
+	//
+	// (We set the per-thread version of the flag, since the texture streamer
+	// calls us from worker threads)
+
+	stbi_set_flip_vertically_on_load_thread(1);
+	unsigned char* data = stbi_load_from_memory( (uint8_t*)s->GetReadHead(), s->BytesLeftForReading(), width, height, &n, STBI_rgb_alpha );
+	if ( !data )
+	{
+		vsLog( "Failure while loading %s: %s", filename, stbi_failure_reason() );
+		*width = 0;
+		*height = 0;
+	}
 
-		// glTexImage2D expects pixel data to start at the BOTTOM LEFT, but
-		// stbi_load functions give us the pixel data starting at the TOP LEFT.
-		// So we need to flip them here!
-		//
-		// ref:	https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexImage2D.xhtml
+	vsDelete(s);
+	return data;
+}
 
-		stbi_set_flip_vertically_on_load(1);
-		unsigned char* data = stbi_load_from_memory( (uint8_t*)s->GetReadHead(), s->BytesLeftForReading(), &w, &h, &n, STBI_rgb_alpha );
-		if ( !data )
-			vsLog( "Failure while loading %s: %s", filename_in, stbi_failure_reason() );
+uint32_t
+vsTextureInternal::UploadRGBA( const unsigned char *pixels, int width, int height )
+{
+	GLuint t;
+	glGenTextures(1, &t);
 
-		vsDelete(s);
-		glTexImage2D(GL_TEXTURE_2D,
-				0,
-				GL_RGBA,
-				w, h,
-				0,
-				GL_RGBA,
-				GL_UNSIGNED_INT_8_8_8_8_REV,
-				data);
-		stbi_image_free(data);
+	glBindTexture(GL_TEXTURE_2D, t);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
-		m_width = w;
-		m_height = w;
+	glTexImage2D(GL_TEXTURE_2D,
+			0,
+			GL_RGBA,
+			width, height,
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_INT_8_8_8_8_REV,
+			pixels);
+	glGenerateMipmap(GL_TEXTURE_2D);
 
-		glGenerateMipmap(GL_TEXTURE_2D);
-		// m_nearestSampling = false;
-	}
+	return t;
 }
 
 vsTextureInternal::vsTextureInternal( const vsString&name, const vsArray<vsString> &mipmaps ):
 	vsResource(name),
 	m_texture(0),
 	m_depth(false),
+	m_streaming(false),
 	m_premultipliedAlpha(false),
 	m_lockedSampling(false),
 	m_tbo(nullptr),
@@ -174,6 +208,7 @@ vsTextureInternal::vsTextureInternal( const vsString &name, const vsImage *image
 	vsResource(name),
 	m_texture(0),
 	m_depth(false),
+	m_streaming(false),
 	m_premultipliedAlpha(false),
 	m_lockedSampling(false),
 	m_tbo(nullptr),
@@ -210,6 +245,7 @@ vsTextureInternal::vsTextureInternal( const vsString &name, const vsFloatImage *
 	vsResource(name),
 	m_texture(0),
 	m_depth(false),
+	m_streaming(false),
 	m_premultipliedAlpha(false),
 	m_lockedSampling(false),
 	m_tbo(nullptr),
@@ -246,6 +282,7 @@ vsTextureInternal::vsTextureInternal( const vsString &name, const vsHalfIntImage
 	vsResource(name),
 	m_texture(0),
 	m_depth(false),
+	m_streaming(false),
 	m_premultipliedAlpha(false),
 	m_lockedSampling(true),
 	m_tbo(nullptr),
@@ -282,6 +319,7 @@ vsTextureInternal::vsTextureInternal( const vsString &name, const vsHalfFloatIma
 	vsResource(name),
 	m_texture(0),
 	m_depth(false),
+	m_streaming(false),
 	m_premultipliedAlpha(false),
 	m_lockedSampling(true),
 	m_tbo(nullptr),
@@ -318,6 +356,7 @@ vsTextureInternal::vsTextureInternal( const vsString &name, const vsSingleFloatI
 	vsResource(name),
 	m_texture(0),
 	m_depth(false),
+	m_streaming(false),
 	m_premultipliedAlpha(false),
 	m_lockedSampling(false),
 	m_tbo(nullptr),
@@ -353,6 +392,8 @@ vsTextureInternal::vsTextureInternal( const vsString &name, const vsSingleFloatI
 vsTextureInternal::vsTextureInternal( const vsString &name, vsRenderBuffer *buffer ):
 	vsResource(name),
 	m_texture(0),
+	m_depth(false),
+	m_streaming(false),
 	m_premultipliedAlpha(false),
 	m_lockedSampling(false),
 	m_tbo(buffer),
@@ -369,6 +410,10 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsRenderBuffer *buff
 vsTextureInternal::vsTextureInternal( const vsString &name, uint32_t glTextureId ):
 	vsResource(name),
 	m_texture(glTextureId),
+	m_width(0),
+	m_height(0),
+	m_depth(false),
+	m_streaming(false),
 	m_premultipliedAlpha(false),
 	m_lockedSampling(false),
 	m_tbo(nullptr),
@@ -383,6 +428,7 @@ vsTextureInternal::vsTextureInternal( const vsString &name, uint32_t glTextureId
 void
 vsTextureInternal::Blit( vsImage *image, const vsVector2D &where)
 {
+	vsRenderThread::Sync();
 	glBindTexture(GL_TEXTURE_2D, m_texture);
 	glTexSubImage2D(GL_TEXTURE_2D,
 			0,
@@ -397,6 +443,7 @@ vsTextureInternal::Blit( vsImage *image, const vsVector2D &where)
 void
 vsTextureInternal::Blit( vsFloatImage *image, const vsVector2D &where)
 {
+	vsRenderThread::Sync();
 	glBindTexture(GL_TEXTURE_2D, m_texture);
 	glTexSubImage2D(GL_TEXTURE_2D,
 			0,
@@ -411,6 +458,7 @@ vsTextureInternal::Blit( vsFloatImage *image, const vsVector2D &where)
 void
 vsTextureInternal::Blit( vsSingleFloatImage *image, const vsVector2D& where)
 {
+	vsRenderThread::Sync();
 	glBindTexture(GL_TEXTURE_2D, m_texture);
 	glTexSubImage2D(GL_TEXTURE_2D,
 			0,
@@ -430,6 +478,7 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsRenderTarget *rend
 	m_width(0),
 	m_height(0),
 	m_depth(depth),
+	m_streaming(false),
 	m_premultipliedAlpha(true),
 	m_tbo(nullptr),
 	m_renderTarget(nullptr),
@@ -445,15 +494,35 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsRenderTarget *rend
 
 vsTextureInternal::~vsTextureInternal()
 {
-	GLuint t = m_texture;
-	glDeleteTextures(1, &t);
-	m_texture = 0;
+	// A pipelined frame might still be drawing with us.
+	vsRenderThread::Sync();
 
+	// while we're streaming, m_texture is the streamer's shared placeholder;
+	// that isn't ours to delete.
+	if ( !m_streaming )
+	{
+		GLuint t = m_texture;
+		glDeleteTextures(1, &t);
+	}
+	m_texture = 0;
 
 	vsDelete( m_tbo );
 	m_renderTarget = nullptr; // this doesn't belong to us;  don't destroy it!
 }
 
+void
+vsTextureInternal::FinishStreaming( uint32_t glTextureId, int width, int height )
+{
+	vsAssert( m_streaming, "FinishStreaming() called on a texture which wasn't streaming??" );
+	vsRenderThread::Sync();
+	m_texture = glTextureId;
+	m_glTextureWidth = width;
+	m_glTextureHeight = height;
+	m_width = width;
+	m_height = height;
+	m_streaming = false;
+}
+
 // void
 // vsTextureInternal::SetNearestSampling()
 // {
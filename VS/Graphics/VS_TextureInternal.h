@@ -33,6 +33,7 @@ class vsTextureInternal : public vsResource
 	int 		m_width;
 	int 		m_height;
     bool        m_depth;
+	bool		m_streaming;	// still loading in the background;  m_texture is a placeholder
 
 	bool		m_premultipliedAlpha;
 
@@ -75,6 +76,17 @@ public:
 
 	~vsTextureInternal();
 
+	// Loading from files, split into the part which any thread can do and the
+	// part which needs a GL context.  DecodeFile() returns RGBA pixels which
+	// must be freed with stbi_image_free(), or nullptr if it couldn't decode
+	// the file.  UploadRGBA() returns a new mipmapped GL texture.
+	static unsigned char*	DecodeFile( const vsString &filename, int *width, int *height );
+	static uint32_t			UploadRGBA( const unsigned char *pixels, int width, int height );
+
+	// Called by vsTextureStreamer once our real texture has been uploaded.
+	void		FinishStreaming( uint32_t glTextureId, int width, int height );
+	bool		IsStreaming() const { return m_streaming; }
+
 	void		PrepareToBind(); // called immediately before we're bound for rendering
 
 	void		Blit( vsImage *image, const vsVector2D& where);
@@ -121,6 +133,7 @@ public:
 	uint32_t		SafeAddColour(uint32_t a, uint32_t b);
 
 	friend class vsRenderTarget;
+	friend class vsTextureStreamer;
 };
 
 #endif // VS_TEXTUREINTERNAL_H
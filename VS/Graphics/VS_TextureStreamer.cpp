@@ -0,0 +1,299 @@
+/*
+ *  VS_TextureStreamer.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#include "VS_TextureStreamer.h"
+
+#include "VS_CookedTexture.h"
+#include "VS_TextureInternal.h"
+#include "VS_TextureManager.h"
+#include "VS_Renderer_OpenGL3.h"
+#include "VS_OpenGL.h"
+
+#include "VS/Files/VS_File.h"
+
+#include "stb_image.h"
+
+vsTextureStreamer * vsTextureStreamer::s_instance = nullptr;
+
+namespace
+{
+	// Room for every request which can be in flight at once;  see
+	// m_maxInFlight.
+	const int c_finishedQueueSize = 256;
+};
+
+vsTextureStreamer::Uploader::Uploader( vsTextureStreamer *streamer ):
+	vsTask( "Texture uploader" ),
+	m_streamer( streamer )
+{
+}
+
+int
+vsTextureStreamer::Uploader::Run()
+{
+	// We're woken whenever a decode job finishes, and once per frame when
+	// our upload allowance is topped up.
+	while ( m_streamer->m_uploadSignal.Wait() )
+	{
+		if ( m_streamer->m_exiting.load( std::memory_order_acquire ) )
+			break;
+		m_streamer->UploadDecoded();
+	}
+	return 0;
+}
+
+vsTextureStreamer::vsTextureStreamer( size_t uploadBudget ):
+	m_placeholder( 0 ),
+	m_uploadBudget( uploadBudget ),
+	m_maxInFlight( 0 ),
+	m_nextSequence( 0 ),
+	m_inFlight( 0 ),
+	m_uploadSignal( 0 ),
+	m_uploadAllowance( (int64_t)uploadBudget ),
+	m_exiting( false ),
+	m_finished( c_finishedQueueSize ),
+	m_uploader( nullptr )
+{
+	vsAssert(s_instance == nullptr, "Multiple vsTextureStreamers created??");
+	s_instance = this;
+
+	const unsigned char grey[4] = { 128, 128, 128, 255 };
+	m_placeholder = vsTextureInternal::UploadRGBA( grey, 1, 1 );
+
+	// Every decoded image sits in memory until it's uploaded, so don't let
+	// the decode jobs get too far ahead of the uploader.
+	m_maxInFlight = vsClamp( 2 * vsJobSystem::Instance()->GetWorkerCount(), 2, c_finishedQueueSize );
+
+	m_uploader = new Uploader( this );
+	m_uploader->Start();
+}
+
+vsTextureStreamer::~vsTextureStreamer()
+{
+	m_exiting.store( true, std::memory_order_release );
+
+	// let any decodes which have started finish;  nothing will upload them.
+	vsJobSystem::Instance()->Wait( &m_decodeCounter );
+
+	m_uploadSignal.Post();
+	m_uploader->Join();
+	vsDelete( m_uploader );
+	m_uploadSignal.Release();
+
+	// Anything which made it all the way through gets its real texture;  the
+	// rest are left with no texture at all, as if their file hadn't existed.
+	StreamRequest *request;
+	while ( m_finished.TryPop( request ) )
+		Finish( request );
+	for ( int i = 0; i < m_decoded.ItemCount(); i++ )
+	{
+		stbi_image_free( m_decoded[i]->pixels );
+		m_decoded[i]->pixels = nullptr;
+		vsDelete( m_decoded[i]->cooked );
+		m_decoded[i]->width = m_decoded[i]->height = 0;
+		Finish( m_decoded[i] );
+	}
+	m_decoded.Clear();
+	for ( int i = 0; i < m_waiting.ItemCount(); i++ )
+		Finish( m_waiting[i] );
+	m_waiting.Clear();
+
+	GLuint t = m_placeholder;
+	glDeleteTextures(1, &t);
+
+	vsAssert(s_instance == this, "vsTextureStreamer instance isn't me??");
+	s_instance = nullptr;
+}
+
+vsTextureInternal *
+vsTextureStreamer::Request( const vsString &filename, int priority )
+{
+	vsCache<vsTextureInternal> *cache = vsTextureManager::Instance();
+	if ( cache->Exists( filename ) )
+	{
+		vsTextureInternal *texture = cache->Get( filename );
+		if ( texture->IsStreaming() )
+		{
+			for ( int i = 0; i < m_waiting.ItemCount(); i++ )
+				if ( m_waiting[i]->texture == texture )
+					m_waiting[i]->priority = vsMax( m_waiting[i]->priority, priority );
+		}
+		return texture;
+	}
+
+	vsTextureInternal *texture = new vsTextureInternal( filename, m_placeholder );
+	texture->m_width = texture->m_height = 1;
+	texture->m_glTextureWidth = texture->m_glTextureHeight = 1;
+	texture->m_streaming = true;
+	cache->Add( texture );
+	texture->AddReference();
+
+	StreamRequest *request = new StreamRequest;
+	request->streamer = this;
+	request->texture = texture;
+	request->filename = filename;
+	request->priority = priority;
+	request->sequence = m_nextSequence++;
+	request->cooked = nullptr;
+	request->pixels = nullptr;
+	request->width = 0;
+	request->height = 0;
+	request->glTexture = 0;
+	m_waiting.AddItem( request );
+
+	return texture;
+}
+
+vsTextureStreamer::StreamRequest*
+vsTextureStreamer::ExtractHighestPriority( vsArray<StreamRequest*>& list )
+{
+	if ( list.IsEmpty() )
+		return nullptr;
+
+	StreamRequest *best = list[0];
+	for ( int i = 1; i < list.ItemCount(); i++ )
+	{
+		StreamRequest *r = list[i];
+		if ( r->priority > best->priority ||
+				( r->priority == best->priority && (int32_t)(r->sequence - best->sequence) < 0 ) )
+			best = r;
+	}
+	list.RemoveItem( best );
+	return best;
+}
+
+void
+vsTextureStreamer::FrameRendered()
+{
+	StreamRequest *request;
+	while ( m_finished.TryPop( request ) )
+	{
+		Finish( request );
+		m_inFlight--;
+	}
+
+	vsJobSystem *jobs = vsJobSystem::Instance();
+	while ( m_inFlight < m_maxInFlight && !m_waiting.IsEmpty() )
+	{
+		request = ExtractHighestPriority( m_waiting );
+		m_inFlight++;
+
+		request->job = vsJob( &DecodeJob, request, &m_decodeCounter );
+		if ( jobs->GetWorkerCount() > 0 )
+			jobs->Run( &request->job );
+		else
+			DecodeJob( &request->job );	// nobody else to do it, and we never Wait() on these.
+	}
+
+	// Top up this frame's upload allowance.  Anything the uploader didn't
+	// use last frame doesn't carry over, and anything it overspent (it
+	// always uploads whole textures) comes out of this frame's.
+	int64_t allowance = m_uploadAllowance.load( std::memory_order_relaxed );
+	while ( !m_uploadAllowance.compare_exchange_weak( allowance, vsMin( allowance, (int64_t)0 ) + (int64_t)m_uploadBudget, std::memory_order_relaxed ) )
+		;
+
+	if ( m_inFlight > 0 )
+		m_uploadSignal.Post();
+}
+
+void
+vsTextureStreamer::DecodeJob( vsJob *job )
+{
+	StreamRequest *request = (StreamRequest*)job->data;
+	vsTextureStreamer *streamer = request->streamer;
+
+	if ( !streamer->m_exiting.load( std::memory_order_relaxed ) )
+	{
+		request->cooked = vsCookedTexture::OpenFor( request->filename );
+		if ( request->cooked )
+		{
+			request->width = request->cooked->GetWidth();
+			request->height = request->cooked->GetHeight();
+		}
+		else if ( vsFile::Exists( request->filename ) )
+		{
+			request->pixels = vsTextureInternal::DecodeFile( request->filename, &request->width, &request->height );
+		}
+	}
+
+	{
+		vsScopedLock lock( streamer->m_decodedMutex );
+		streamer->m_decoded.AddItem( request );
+	}
+	streamer->m_uploadSignal.Post();
+}
+
+void
+vsTextureStreamer::UploadDecoded()
+{
+	vsRenderer_OpenGL3 *renderer = vsRenderer_OpenGL3::Instance();
+	vsArray<StreamRequest*> uploaded;
+	bool haveContext = false;
+
+	while ( m_uploadAllowance.load( std::memory_order_relaxed ) > 0 )
+	{
+		StreamRequest *request = nullptr;
+		{
+			vsScopedLock lock( m_decodedMutex );
+			request = ExtractHighestPriority( m_decoded );
+		}
+		if ( !request )
+			break;
+
+		if ( request->cooked || request->pixels )
+		{
+			if ( !haveContext )
+			{
+				renderer->SetLoadingContext();
+				haveContext = true;
+			}
+
+			int64_t bytes;
+			if ( request->cooked )
+			{
+				request->glTexture = request->cooked->Upload();
+				bytes = (int64_t)request->cooked->GetTotalBytes();
+				vsDelete( request->cooked );
+			}
+			else
+			{
+				request->glTexture = vsTextureInternal::UploadRGBA( request->pixels, request->width, request->height );
+				stbi_image_free( request->pixels );
+				request->pixels = nullptr;
+
+				// mipmaps add another third on top of the base level.
+				bytes = (int64_t)request->width * request->height * 4;
+				bytes += bytes / 3;
+			}
+			m_uploadAllowance.fetch_sub( bytes, std::memory_order_relaxed );
+		}
+		uploaded.AddItem( request );
+	}
+
+	// ClearLoadingContext() fences, so once we're past it the textures are
+	// safe to use from the main context.
+	if ( haveContext )
+		renderer->ClearLoadingContext();
+
+	for ( int i = 0; i < uploaded.ItemCount(); i++ )
+	{
+		// m_maxInFlight keeps this from ever filling up, but just in case.
+		while ( !m_finished.TryPush( uploaded[i] ) )
+			SDL_Delay(1);
+	}
+}
+
+void
+vsTextureStreamer::Finish( StreamRequest *request )
+{
+	request->texture->FinishStreaming( request->glTexture, request->width, request->height );
+	request->texture->ReleaseReference();
+	vsDelete( request );
+}
+
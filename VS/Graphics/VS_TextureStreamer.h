@@ -0,0 +1,121 @@
+/*
+ *  VS_TextureStreamer.h
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#ifndef VS_TEXTURESTREAMER_H
+#define VS_TEXTURESTREAMER_H
+
+#include "VS/Threads/VS_JobSystem.h"
+#include "VS/Threads/VS_LockFreeQueue.h"
+#include "VS/Threads/VS_Mutex.h"
+#include "VS/Threads/VS_Semaphore.h"
+#include "VS/Threads/VS_Task.h"
+#include "VS/Utils/VS_Array.h"
+
+class vsCookedTexture;
+class vsTextureInternal;
+
+// vsTextureStreamer loads textures from files in the background, so that
+// asking for a texture never stalls the main thread on file I/O or image
+// decoding.
+//
+// Request() immediately returns a vsTextureInternal which has been added to
+// the vsTextureManager, so anything which asks for a vsTexture of that name
+// will find it.  Until the real image has arrived, it's bound as a tiny
+// grey placeholder.
+//
+// Files are read and decoded (or for cooked textures, mapped) by vsJobSystem
+// jobs, and uploaded by our own thread on the renderer's loading GL context,
+// which is fenced before we hand the finished texture back to the main
+// thread.  Higher priority requests are decoded and uploaded first, and we
+// upload at most 'uploadBudget' bytes of pixels per frame, so that a burst
+// of requests doesn't cost the GPU a long stall.
+//
+// Request() and FrameRendered() must be called from the main thread.
+
+class vsTextureStreamer
+{
+	static vsTextureStreamer *s_instance;
+
+	struct StreamRequest
+	{
+		vsTextureStreamer *	streamer;
+		vsTextureInternal *	texture;	// we hold a reference to this until we're done
+		vsString			filename;
+		int					priority;
+		uint32_t			sequence;	// equal priorities are handled in the order they were requested
+		vsJob				job;
+
+		vsCookedTexture *	cooked;		// if there's a cooked version of the file
+		unsigned char *		pixels;		// otherwise, from vsTextureInternal::DecodeFile()
+		int					width;
+		int					height;
+		uint32_t			glTexture;
+	};
+
+	class Uploader : public vsTask
+	{
+		vsTextureStreamer *	m_streamer;
+
+	protected:
+		virtual int Run();
+
+	public:
+		Uploader( vsTextureStreamer *streamer );
+	};
+
+	uint32_t				m_placeholder;
+	size_t					m_uploadBudget;
+	int						m_maxInFlight;
+	uint32_t				m_nextSequence;
+
+	// main thread only
+	vsArray<StreamRequest*>	m_waiting;		// not yet given to a decode job
+	int						m_inFlight;		// decoding, decoded or uploading
+	vsJobCounter			m_decodeCounter;
+
+	// decode jobs -> uploader
+	vsMutex					m_decodedMutex;
+	vsArray<StreamRequest*>	m_decoded;
+	vsSemaphore				m_uploadSignal;
+	std::atomic<int64_t>	m_uploadAllowance;	// bytes we may upload before the next frame tops us up
+	std::atomic<bool>		m_exiting;
+
+	// uploader -> main thread
+	vsSPSCQueue<StreamRequest*> m_finished;
+
+	Uploader *				m_uploader;
+
+	static void				DecodeJob( vsJob *job );
+	void					UploadDecoded();	// uploader thread
+	void					Finish( StreamRequest *request );
+	static StreamRequest *	ExtractHighestPriority( vsArray<StreamRequest*>& list );
+
+public:
+
+	static vsTextureStreamer * Instance() { return s_instance; }
+
+	vsTextureStreamer( size_t uploadBudget = 8 * 1024 * 1024 );
+	~vsTextureStreamer();
+
+	// Returns the texture for 'filename', starting a background load if it
+	// isn't already loaded or loading.  Higher 'priority' values load first;
+	// requesting a texture which is still waiting to load will raise its
+	// priority to 'priority', but never lower it.
+	vsTextureInternal *	Request( const vsString &filename, int priority = 0 );
+
+	void	FrameRendered();	// called once per frame, after we've finished drawing
+
+	void	SetUploadBudget( size_t bytesPerFrame ) { m_uploadBudget = bytesPerFrame; }
+	size_t	GetUploadBudget() const { return m_uploadBudget; }
+
+	int		GetPendingCount() const { return m_waiting.ItemCount() + m_inFlight; }
+};
+
+#endif // VS_TEXTURESTREAMER_H
+
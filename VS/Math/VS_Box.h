@@ -89,6 +89,7 @@ public:
 	static vsBox3D CenteredBox( const vsVector3D &dimensions ) { vsBox3D result(vsVector3D::Zero, dimensions); result -= 0.5f * dimensions; return result; }
 
 	void Clear() { set = false; min = max = vsVector3D::Zero; }
+	bool IsSet() const { return set; }
 
 	const vsVector3D &	GetMin() const { return min; }
 	const vsVector3D &	GetMax() const { return max; }
@@ -138,6 +138,55 @@ vsFrustum::ClassifySphere( const vsVector3D &center, float radius ) const
 	return result;
 }
 
+int
+vsFrustum::CullSpheres( const float *x, const float *y, const float *z, const float *radius, int count, int *visible ) const
+{
+	// Convert our planes into (normal, offset) form once up front, so the
+	// per-sphere test is just a handful of multiply-adds.
+	float nx[6], ny[6], nz[6], d[6];
+	for ( int p = 0; p < 6; p++ )
+	{
+		nx[p] = m_planeNormal[p].x;
+		ny[p] = m_planeNormal[p].y;
+		nz[p] = m_planeNormal[p].z;
+		d[p] = -m_planeNormal[p].Dot( m_planePoint[p] );
+	}
+
+	// Work in blocks.  The first loop over each block has no branches and no
+	// dependencies between spheres, so the compiler is free to vectorise it;
+	// the second loop compacts the survivors without branching.
+	const int c_blockSize = 256;
+	uint8_t inside[c_blockSize];
+	int visibleCount = 0;
+
+	for ( int start = 0; start < count; start += c_blockSize )
+	{
+		int blockCount = vsMin( c_blockSize, count - start );
+		const float *bx = x + start;
+		const float *by = y + start;
+		const float *bz = z + start;
+		const float *br = radius + start;
+
+		for ( int i = 0; i < blockCount; i++ )
+		{
+			uint8_t in = 1;
+			for ( int p = 0; p < 6; p++ )
+			{
+				float distance = nx[p] * bx[i] + ny[p] * by[i] + nz[p] * bz[i] + d[p];
+				in &= (uint8_t)( distance >= -br[i] );
+			}
+			inside[i] = in;
+		}
+
+		for ( int i = 0; i < blockCount; i++ )
+		{
+			visible[visibleCount] = start + i;
+			visibleCount += inside[i];
+		}
+	}
+	return visibleCount;
+}
+
 vsFrustum::Classification
 vsFrustum::ClassifyBox3D( const vsBox3D &box ) const
 {
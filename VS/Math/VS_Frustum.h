@@ -37,6 +37,12 @@ public:
 	};
 	Classification ClassifyBox3D( const vsBox3D &box ) const;
 	Classification ClassifySphere( const vsVector3D &position, float radius ) const;
+
+	// Bulk sphere test, for large numbers of objects.  Sphere 'i' is centered
+	// at (x[i], y[i], z[i]) with radius 'radius[i]'.  Writes the index of every
+	// sphere which is at least partially inside the frustum into 'visible'
+	// (which must have room for 'count' entries), and returns how many it wrote.
+	int		CullSpheres( const float *x, const float *y, const float *z, const float *radius, int count, int *visible ) const;
 };
 
 #endif // VS_FRUSTUM_H
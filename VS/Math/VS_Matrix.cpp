@@ -11,6 +11,14 @@
 
 #include "VS_Quaternion.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VS_MATRIX_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define VS_MATRIX_NEON
+#include <arm_neon.h>
+#endif
+
 vsMatrix4x4 vsMatrix4x4::Identity;
 vsMatrix3x3 vsMatrix3x3::Identity;
 
@@ -561,6 +569,84 @@ vsMatrix4x4::ApplyRotationTo( const vsVector3D &v ) const
 	return result;
 }
 
+namespace
+{
+	// Shared by ApplyToArray() and ApplyRotationToArray().  Each vector is
+	// multiplied against the matrix columns in one SIMD register, which suits
+	// interleaved vertex data (where the vectors we want aren't next to each
+	// other) better than transposing four vertices at a time would.
+	//
+	// We load four floats but only store three, so we never touch the data
+	// after each vector;  but loading the final vector that way could read
+	// past the end of the array, so that one goes through the scalar code.
+	// We add things up in the same order as ApplyTo(), so results match it
+	// exactly.
+	template<bool translate>
+	void TransformArray( const vsMatrix4x4 &m, const char *in, char *out, int count, size_t stride )
+	{
+		vsAssert( stride >= sizeof(vsVector3D), "Vectors overlap??" );
+		int simdCount = count - 1;
+		int i = 0;
+
+#if defined(VS_MATRIX_SSE)
+		__m128 cx = _mm_loadu_ps( &m.x.x );
+		__m128 cy = _mm_loadu_ps( &m.y.x );
+		__m128 cz = _mm_loadu_ps( &m.z.x );
+		__m128 cw = _mm_loadu_ps( &m.w.x );
+		for ( ; i < simdCount; i++ )
+		{
+			__m128 v = _mm_loadu_ps( (const float*)(in + i*stride) );
+			__m128 r = _mm_mul_ps( cx, _mm_shuffle_ps( v, v, _MM_SHUFFLE(0,0,0,0) ) );
+			r = _mm_add_ps( r, _mm_mul_ps( cy, _mm_shuffle_ps( v, v, _MM_SHUFFLE(1,1,1,1) ) ) );
+			r = _mm_add_ps( r, _mm_mul_ps( cz, _mm_shuffle_ps( v, v, _MM_SHUFFLE(2,2,2,2) ) ) );
+			if ( translate )
+				r = _mm_add_ps( r, cw );
+
+			float *o = (float*)(out + i*stride);
+			_mm_storel_pi( (__m64*)o, r );
+			_mm_store_ss( o+2, _mm_movehl_ps( r, r ) );
+		}
+#elif defined(VS_MATRIX_NEON)
+		float32x4_t cx = vld1q_f32( &m.x.x );
+		float32x4_t cy = vld1q_f32( &m.y.x );
+		float32x4_t cz = vld1q_f32( &m.z.x );
+		float32x4_t cw = vld1q_f32( &m.w.x );
+		for ( ; i < simdCount; i++ )
+		{
+			float32x4_t v = vld1q_f32( (const float*)(in + i*stride) );
+			float32x4_t r = vmulq_n_f32( cx, vgetq_lane_f32( v, 0 ) );
+			r = vaddq_f32( r, vmulq_n_f32( cy, vgetq_lane_f32( v, 1 ) ) );
+			r = vaddq_f32( r, vmulq_n_f32( cz, vgetq_lane_f32( v, 2 ) ) );
+			if ( translate )
+				r = vaddq_f32( r, cw );
+
+			float *o = (float*)(out + i*stride);
+			vst1_f32( o, vget_low_f32( r ) );
+			vst1q_lane_f32( o+2, r, 2 );
+		}
+#endif
+
+		for ( ; i < count; i++ )
+		{
+			const vsVector3D &v = *(const vsVector3D*)(in + i*stride);
+			vsVector3D &o = *(vsVector3D*)(out + i*stride);
+			o = translate ? m.ApplyTo( v ) : m.ApplyRotationTo( v );
+		}
+	}
+};
+
+void
+vsMatrix4x4::ApplyToArray( const vsVector3D *in, vsVector3D *out, int count, size_t stride ) const
+{
+	TransformArray<true>( *this, (const char*)in, (char*)out, count, stride );
+}
+
+void
+vsMatrix4x4::ApplyRotationToArray( const vsVector3D *in, vsVector3D *out, int count, size_t stride ) const
+{
+	TransformArray<false>( *this, (const char*)in, (char*)out, count, stride );
+}
+
 vsMatrix4x4
 vsMatrix4x4::ApplyInverseTo( const vsMatrix4x4 &o ) const
 {
@@ -87,6 +87,14 @@ public:
 	vsVector3D		ApplyRotationTo( const vsVector3D &v ) const;
 	vsVector3D		ApplyInverseTo( const vsVector3D &v ) const;
 
+	// Bulk versions of ApplyTo() and ApplyRotationTo(), for transforming
+	// vertex data.  Reads 'count' vectors starting at 'in' and writes them
+	// starting at 'out';  'stride' is the distance in bytes from one vector
+	// to the next in both arrays, so these can work on a single attribute of
+	// interleaved vertices.  'in' and 'out' may be the same array.
+	void			ApplyToArray( const vsVector3D *in, vsVector3D *out, int count, size_t stride = sizeof(vsVector3D) ) const;
+	void			ApplyRotationToArray( const vsVector3D *in, vsVector3D *out, int count, size_t stride = sizeof(vsVector3D) ) const;
+
 	vsVector4D &	operator[](int n);
 
 	vsMatrix4x4	operator*( const vsMatrix4x4 &o ) const { return ApplyTo(o); }
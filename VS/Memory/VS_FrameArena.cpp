@@ -0,0 +1,127 @@
+/*
+ *  VS_FrameArena.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#include "VS_FrameArena.h"
+#include "VS_Heap.h"
+
+extern vsHeap *g_globalHeap;
+
+vsFrameArena * vsFrameArena::s_instance = nullptr;
+
+vsFrameArena::vsFrameArena( size_t bytesPerFrame, int frameCount ):
+	m_frame( new Frame[frameCount] ),
+	m_frameCount( frameCount ),
+	m_currentFrame( 0 ),
+	m_frameSize( bytesPerFrame ),
+	m_lastFrameBytes( 0 ),
+	m_highWaterMark( 0 ),
+	m_warnedOverflow( false )
+{
+	vsAssert(s_instance == nullptr, "Multiple vsFrameArenas created??");
+	vsAssert(frameCount > 0, "vsFrameArena needs at least one frame!");
+
+	for ( int i = 0; i < m_frameCount; i++ )
+	{
+		m_frame[i].memory = new char[m_frameSize];
+		m_frame[i].used = 0;
+		m_frame[i].overflowBytes = 0;
+	}
+
+	s_instance = this;
+}
+
+vsFrameArena::~vsFrameArena()
+{
+	PrintStatus();
+
+	for ( int i = 0; i < m_frameCount; i++ )
+	{
+		ResetFrame( m_frame[i] );
+		vsDeleteArray( m_frame[i].memory );
+	}
+	vsDeleteArray( m_frame );
+
+	vsAssert(s_instance == this, "vsFrameArena instance isn't me??");
+	s_instance = nullptr;
+}
+
+void *
+vsFrameArena::Alloc( size_t bytes, size_t alignment )
+{
+	Frame &frame = m_frame[m_currentFrame];
+
+	size_t start = (frame.used + alignment - 1) & ~(alignment - 1);
+	if ( start + bytes <= m_frameSize )
+	{
+		frame.used = start + bytes;
+		return frame.memory + start;
+	}
+
+	// Out of space in this frame's buffer.  Grab some more from the heap
+	// so we can keep going, and let somebody know they should make the arena
+	// bigger.
+	if ( !m_warnedOverflow )
+	{
+#ifdef _WIN32
+		vsLog("vsFrameArena:  Frame used more than its %lu bytes;  falling back to heap allocations.  Consider a bigger arena.", m_frameSize);
+#else
+		vsLog("vsFrameArena:  Frame used more than its %zu bytes;  falling back to heap allocations.  Consider a bigger arena.", m_frameSize);
+#endif
+		m_warnedOverflow = true;
+	}
+	// new[] gives us memory aligned for anything, which is all that anyone
+	// will be asking for.
+	vsHeap::Push(g_globalHeap);
+	char *chunk = new char[bytes];
+	frame.overflow.AddItem( chunk );
+	vsHeap::Pop(g_globalHeap);
+	frame.overflowBytes += bytes;
+	return chunk;
+}
+
+size_t
+vsFrameArena::GetBytesUsed() const
+{
+	const Frame &frame = m_frame[m_currentFrame];
+	return frame.used + frame.overflowBytes;
+}
+
+void
+vsFrameArena::ResetFrame( Frame& frame )
+{
+	for ( int i = 0; i < frame.overflow.ItemCount(); i++ )
+		vsDeleteArray( frame.overflow[i] );
+	frame.overflow.Clear();
+	frame.overflowBytes = 0;
+	frame.used = 0;
+}
+
+void
+vsFrameArena::FrameRendered()
+{
+	m_lastFrameBytes = GetBytesUsed();
+	m_highWaterMark = vsMax( m_highWaterMark, m_lastFrameBytes );
+
+	m_currentFrame = (m_currentFrame + 1) % m_frameCount;
+	ResetFrame( m_frame[m_currentFrame] );
+}
+
+void
+vsFrameArena::PrintStatus()
+{
+	vsLog(" >> FRAME ARENA STATUS");
+#ifdef _WIN32
+	vsLog(" >> Last frame used %lu / %lu bytes (%0.2f%% usage)", m_lastFrameBytes, m_frameSize, 100.0f*m_lastFrameBytes/m_frameSize);
+	vsLog(" >> Highwater usage %lu / %lu bytes (%0.2f%% usage)", m_highWaterMark, m_frameSize, 100.0f*m_highWaterMark/m_frameSize);
+#else
+	vsLog(" >> Last frame used %zu / %zu bytes (%0.2f%% usage)", m_lastFrameBytes, m_frameSize, 100.0f*m_lastFrameBytes/m_frameSize);
+	vsLog(" >> Highwater usage %zu / %zu bytes (%0.2f%% usage)", m_highWaterMark, m_frameSize, 100.0f*m_highWaterMark/m_frameSize);
+#endif
+}
+
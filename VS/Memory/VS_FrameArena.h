@@ -0,0 +1,105 @@
+/*
+ *  VS_FrameArena.h
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#ifndef VS_FRAMEARENA_H
+#define VS_FRAMEARENA_H
+
+#include "VS/Utils/VS_Array.h"
+#include <type_traits>
+
+// vsFrameArena hands out memory which only needs to live until the end of
+// the current frame;  stuff like the render queue's batch records or
+// temporary display lists.  Allocation just bumps a pointer, and nothing is
+// ever freed individually;  the whole frame's memory is thrown away at once.
+//
+// We keep several frames' worth of buffers and cycle through them, so
+// memory allocated during one frame is still valid for the next
+// 'frameCount-1' frames after it, in case something's still drawing from it.
+//
+// If a frame runs out of space we fall back to allocating extra chunks from
+// the global heap, which are freed when that frame's buffer is next reused.
+// (Not the game's heap, even while a game is running;  they outlive the
+// frame, and would otherwise show up as leaks when the game exits)  That's
+// slow, so watch the high water mark and size the arena to suit.
+//
+// Main thread only!
+
+// Alloc<T>() constructs its objects with placement new, which the debug
+// 'new' macro would break.
+#include "VS/VS_DisableDebugNew.h"
+
+class vsFrameArena
+{
+	static vsFrameArena *	s_instance;
+
+	struct Frame
+	{
+		char *			memory;
+		size_t			used;
+		vsArray<char*>	overflow;		// extra chunks we had to allocate once 'memory' ran out
+		size_t			overflowBytes;
+	};
+
+	Frame *		m_frame;
+	int			m_frameCount;
+	int			m_currentFrame;
+	size_t		m_frameSize;
+
+	size_t		m_lastFrameBytes;
+	size_t		m_highWaterMark;
+	bool		m_warnedOverflow;
+
+	void		ResetFrame( Frame& frame );
+
+public:
+
+	static vsFrameArena * Instance() { return s_instance; }
+
+	vsFrameArena( size_t bytesPerFrame = 1024 * 1024, int frameCount = 3 );
+	~vsFrameArena();
+
+	void *	Alloc( size_t bytes, size_t alignment = 16 );
+
+	// Typed allocation.  Objects are default-constructed, but are never
+	// destructed, so we only accept types for which that's okay.
+	template<typename T>
+	T *		Alloc( int count = 1 )
+	{
+		static_assert( std::is_trivially_destructible<T>::value, "vsFrameArena never destroys the objects it allocates" );
+		T *result = (T*)Alloc( sizeof(T) * count, alignof(T) );
+		for ( int i = 0; i < count; i++ )
+			new (&result[i]) T;
+		return result;
+	}
+
+	// Copy an array into memory which will last for this frame.
+	template<typename T>
+	T *		Copy( const T *source, int count )
+	{
+		static_assert( std::is_trivially_copyable<T>::value, "vsFrameArena::Copy only copies plain data" );
+		T *result = (T*)Alloc( sizeof(T) * count, alignof(T) );
+		memcpy( result, source, sizeof(T) * count );
+		return result;
+	}
+
+	void		FrameRendered();	// called once per frame, after we've finished drawing
+
+	size_t		GetFrameSize() const { return m_frameSize; }
+	size_t		GetBytesUsed() const;						// so far this frame
+	size_t		GetLastFrameBytes() const { return m_lastFrameBytes; }
+	size_t		GetHighWaterMark() const { return m_highWaterMark; }	// most bytes used in any one frame
+	void		ResetHighWaterMark() { m_highWaterMark = 0; }
+
+	void		PrintStatus();
+};
+
+#include "VS/VS_EnableDebugNew.h"
+
+#endif // VS_FRAMEARENA_H
+
@@ -26,8 +26,248 @@ static vsHeap *	s_stack[MAX_HEAP_STACK] = {nullptr,nullptr,nullptr,nullptr};
 #undef malloc
 #undef free
 
+// Position of the lowest set bit.  'value' must not be zero!
+static inline int LowBitPosition( uint32_t value )
+{
+#ifdef MSVC
+	unsigned long result;
+	_BitScanForward( &result, value );
+	return (int)result;
+#else
+	return __builtin_ctz( value );
+#endif
+}
+
+// Position of the highest set bit.  'value' must not be zero!
+static inline int HighBitPosition( uint64_t value )
+{
+#ifdef MSVC
+	unsigned long result;
+	_BitScanReverse64( &result, value );
+	return (int)result;
+#else
+	return 63 - __builtin_clzll( value );
+#endif
+}
+
+#define HEAP_CACHE_CLASSES (16)		// blocks of up to 16 * 32 == 512 bytes (including header) get cached
+#define HEAP_CACHE_BATCH (16)		// how many blocks we move between a cache and its heap at a time
+#define HEAP_CACHE_MAX_BLOCKS (HEAP_CACHE_BATCH * 2)	// per size class
+
+// vsHeapThreadCache is a small per-thread stash of free blocks for one
+// vsHeap, sorted by size class.  Small allocations and frees on a thread
+// only touch its own cache;  we only lock the heap when the cache for a
+// size class runs dry (and we grab a batch of blocks from the heap) or
+// gets too full (and we give a batch back).
+//
+// Cached blocks stay 'used' and in the heap's block list the whole time, so
+// nothing can coalesce them out from under us.  They're flagged
+// 'm_cached' so that leak checks know to ignore them.  Since m_next is
+// already in use by the block list, we link cached blocks together through
+// the first bytes of their (unused) user area instead.
+//
+// Each heap keeps a list of the caches which are bound to it, so that when
+// it's destroyed it can take its blocks back from every thread, not just
+// the one destroying it.  That list, and which heap each cache is bound
+// to, only change while holding s_bindLock.  A thread's own allocations
+// and frees only read m_heap, and never touch a heap being destroyed
+// (that would be a bug anyway), so they don't need the lock.
+class vsHeapThreadCache
+{
+	std::atomic<vsHeap *>	m_heap;
+	memBlock *	m_bin[HEAP_CACHE_CLASSES];
+	int			m_count[HEAP_CACHE_CLASSES];
+	bool		m_destroyed;
+
+	vsHeapThreadCache *	m_nextBound;	// in m_heap's list of caches
+	vsHeapThreadCache *	m_prevBound;
+
+	static vsSpinlock	s_bindLock;
+
+	static int	GetClass( size_t size ) { return (int)(size >> 5) - 1; }
+	static memBlock *&	NextCached( memBlock *block ) { return *(memBlock **)((char *)block->m_start + sizeof(memBlock)); }
+
+	void	Bind( vsHeap *heap );
+	void	Release();	// give everything back to our heap.  Assumes s_bindLock is already locked
+	void	Refill( int sizeClass, size_t size );
+	void	Flush( int sizeClass, int count );
+
+public:
+	vsHeapThreadCache();
+	~vsHeapThreadCache();
+
+	memBlock *	Alloc( vsHeap *heap, size_t size );		// returns nullptr if we can't help
+	bool		Free( vsHeap *heap, memBlock *block );	// returns false if we can't take this block
+	void		Unbind();	// give everything back to our heap
+
+	static void	ReleaseAll( vsHeap *heap );	// take back every thread's blocks from 'heap'
+};
+
+static thread_local vsHeapThreadCache s_threadCache;
+vsSpinlock vsHeapThreadCache::s_bindLock;
+
+vsHeapThreadCache::vsHeapThreadCache():
+	m_heap(nullptr),
+	m_destroyed(false),
+	m_nextBound(nullptr),
+	m_prevBound(nullptr)
+{
+	for ( int i = 0; i < HEAP_CACHE_CLASSES; i++ )
+	{
+		m_bin[i] = nullptr;
+		m_count[i] = 0;
+	}
+}
+
+vsHeapThreadCache::~vsHeapThreadCache()
+{
+	Unbind();
+	// other thread-local destructors may still try to allocate or free after
+	// we're gone;  make sure they go straight to the heap.
+	m_destroyed = true;
+}
+
+void
+vsHeapThreadCache::Bind( vsHeap *heap )
+{
+	s_bindLock.Lock();
+	Release();
+	m_heap.store( heap, std::memory_order_relaxed );
+	m_prevBound = nullptr;
+	m_nextBound = heap->m_threadCaches;
+	if ( m_nextBound )
+		m_nextBound->m_prevBound = this;
+	heap->m_threadCaches = this;
+	s_bindLock.Unlock();
+}
+
+void
+vsHeapThreadCache::Unbind()
+{
+	if ( !m_heap.load( std::memory_order_relaxed ) )
+		return;
+
+	s_bindLock.Lock();
+	Release();
+	s_bindLock.Unlock();
+}
+
+void
+vsHeapThreadCache::Release()
+{
+	vsHeap *heap = m_heap.load( std::memory_order_relaxed );
+	if ( !heap )
+		return;
+
+	for ( int i = 0; i < HEAP_CACHE_CLASSES; i++ )
+		Flush( i, m_count[i] );
+
+	if ( m_prevBound )
+		m_prevBound->m_nextBound = m_nextBound;
+	else
+		heap->m_threadCaches = m_nextBound;
+	if ( m_nextBound )
+		m_nextBound->m_prevBound = m_prevBound;
+	m_nextBound = m_prevBound = nullptr;
+	m_heap.store( nullptr, std::memory_order_relaxed );
+}
+
+void
+vsHeapThreadCache::ReleaseAll( vsHeap *heap )
+{
+	// Other threads may still be holding blocks from this heap in their
+	// caches (job workers, for example, usually outlive the game heap), so
+	// we empty their caches for them.  They'll just rebind to whichever heap
+	// they allocate from next.
+	s_bindLock.Lock();
+	while ( heap->m_threadCaches )
+		heap->m_threadCaches->Release();
+	s_bindLock.Unlock();
+}
+
+void
+vsHeapThreadCache::Refill( int sizeClass, size_t size )
+{
+	vsHeap *heap = m_heap.load( std::memory_order_relaxed );
+	heap->m_lock.Lock();
+	for ( int i = 0; i < HEAP_CACHE_BATCH; i++ )
+	{
+		memBlock *block = heap->AllocBlock( size );
+		if ( !block )
+			break;
+		block->m_cached = true;
+		NextCached(block) = m_bin[sizeClass];
+		m_bin[sizeClass] = block;
+		m_count[sizeClass]++;
+	}
+	heap->m_lock.Unlock();
+}
+
+void
+vsHeapThreadCache::Flush( int sizeClass, int count )
+{
+	if ( count <= 0 )
+		return;
+
+	vsHeap *heap = m_heap.load( std::memory_order_relaxed );
+	heap->m_lock.Lock();
+	for ( int i = 0; i < count && m_bin[sizeClass]; i++ )
+	{
+		memBlock *block = m_bin[sizeClass];
+		m_bin[sizeClass] = NextCached(block);
+		m_count[sizeClass]--;
+
+		block->m_cached = false;
+		heap->FreeBlock( block );
+	}
+	heap->m_lock.Unlock();
+}
+
+memBlock *
+vsHeapThreadCache::Alloc( vsHeap *heap, size_t size )
+{
+	int sizeClass = GetClass( size );
+	if ( m_destroyed || sizeClass >= HEAP_CACHE_CLASSES )
+		return nullptr;
+
+	// We only cache blocks for one heap at a time;  if we're allocating from
+	// a different heap now, give our blocks back to the old one.
+	if ( m_heap.load( std::memory_order_relaxed ) != heap )
+		Bind( heap );
+
+	if ( !m_bin[sizeClass] )
+		Refill( sizeClass, size );
+
+	memBlock *block = m_bin[sizeClass];
+	if ( block )
+	{
+		m_bin[sizeClass] = NextCached(block);
+		m_count[sizeClass]--;
+		block->m_cached = false;
+	}
+	return block;
+}
+
+bool
+vsHeapThreadCache::Free( vsHeap *heap, memBlock *block )
+{
+	int sizeClass = GetClass( block->m_size );
+	if ( m_destroyed || m_heap.load( std::memory_order_relaxed ) != heap || sizeClass >= HEAP_CACHE_CLASSES )
+		return false;
+
+	block->m_cached = true;
+	NextCached(block) = m_bin[sizeClass];
+	m_bin[sizeClass] = block;
+	m_count[sizeClass]++;
+
+	if ( m_count[sizeClass] > HEAP_CACHE_MAX_BLOCKS )
+		Flush( sizeClass, HEAP_CACHE_BATCH );
+	return true;
+}
+
 vsHeap::vsHeap(vsString name, size_t size):
-	m_name(name)
+	m_name(name),
+	m_threadCaches(nullptr)
 {
 #ifdef VS_INTERNAL_ALLOCATORS
 	if ( s_current )
@@ -46,6 +286,7 @@ vsHeap::vsHeap(vsString name, size_t size):
 
 	m_endOfMemory = (void *)((char *)m_startOfMemory + size);
 	m_memorySize = size;
+	vsAssert( size < ((size_t)1 << (HEAP_FIRST_LEVEL_BINS + 7)), "Heap is too large for our free block bins!" );
 
 	m_memoryUsed = 0;
 	m_highWaterMark = 0;
@@ -53,6 +294,21 @@ vsHeap::vsHeap(vsString name, size_t size):
 
 	m_leakMark = 0;
 
+	for ( int i = 0; i < HEAP_FIRST_LEVEL_BINS; i++ )
+	{
+		for ( int j = 0; j < HEAP_SECOND_LEVEL_BINS; j++ )
+			m_freeBin[i][j] = nullptr;
+		m_secondLevelBitmap[i] = 0;
+	}
+	m_firstLevelBitmap = 0;
+
+#ifdef VS_HEAP_COMPACT_HEADERS
+	for ( int i = 0; i < HEAP_FILENAME_TABLE_SIZE; i++ )
+		m_filenameTable[i] = nullptr;
+	m_filenameTable[0] = "<unknown>";	// id 0 is for when the table is full
+	m_filenameCount = 1;
+#endif
+
 	//	for ( int i = 0; i < MAX_ALLOCATIONS; i++ )
 	//	{
 	//		m_unusedBlockList.Append( &m_blockStore[i] );
@@ -64,17 +320,20 @@ vsHeap::vsHeap(vsString name, size_t size):
 	iniBlock->m_size = m_memorySize;
 	iniBlock->m_sizeRequested = m_memorySize;
 	iniBlock->m_used = false;
+	iniBlock->m_cached = false;
 	iniBlock->m_next = nullptr;
 	iniBlock->m_prev = nullptr;
 	iniBlock->m_nextBlock = nullptr;
 	iniBlock->m_prevBlock = nullptr;
 
-	m_unusedBlockList.Append( iniBlock );
+	InsertFreeBlock( iniBlock );
 #endif // VS_INTERNAL_ALLOCATORS
 }
 
 vsHeap::~vsHeap()
 {
+	vsHeapThreadCache::ReleaseAll( this );
+
 	if ( s_current == this )
 	{
 	}
@@ -111,26 +370,116 @@ vsHeap::Pop( vsHeap *oldCurrent /* == nullptr */ )
 	s_current = s_stack[0];
 }
 
-memBlock *
-vsHeap::FindFreeMemBlockOfSize( size_t size )
+void
+vsHeap::GetBinForSize( size_t size, int &firstLevel, int &secondLevel )
 {
-	memBlock *block = m_unusedBlockList.m_next;
-	size_t largestBlockSize = 0;
-	bool foundMemBlockForAlloc = false;
+	// sizes are always multiples of 32, so the bottom five bits are useless
+	// to us.
+	if ( size < 256 )
+	{
+		firstLevel = 0;
+		secondLevel = (int)(size >> 5);
+	}
+	else
+	{
+		int highBit = HighBitPosition( size );
+		firstLevel = highBit - 7;
+		secondLevel = (int)(size >> (highBit - 3)) & (HEAP_SECOND_LEVEL_BINS-1);
+	}
+}
+
+void
+vsHeap::InsertFreeBlock( memBlock *block )
+{
+	int fl, sl;
+	GetBinForSize( block->m_size, fl, sl );
+
+	block->m_prev = nullptr;
+	block->m_next = m_freeBin[fl][sl];
+	if ( block->m_next )
+		block->m_next->m_prev = block;
+	m_freeBin[fl][sl] = block;
 
-	while(block)
+	m_firstLevelBitmap |= (1u << fl);
+	m_secondLevelBitmap[fl] |= (1u << sl);
+}
+
+void
+vsHeap::RemoveFreeBlock( memBlock *block )
+{
+	// NOTE:  Must be called BEFORE changing the block's size, since that's
+	// how we know which bin it's in!
+	int fl, sl;
+	GetBinForSize( block->m_size, fl, sl );
+
+	if ( block->m_next )
+		block->m_next->m_prev = block->m_prev;
+	if ( block->m_prev )
+		block->m_prev->m_next = block->m_next;
+	else
 	{
-		if ( block->m_used == false && block->m_size >= size )
+		m_freeBin[fl][sl] = block->m_next;
+		if ( !m_freeBin[fl][sl] )
 		{
-			return block;
+			m_secondLevelBitmap[fl] &= ~(1u << sl);
+			if ( !m_secondLevelBitmap[fl] )
+				m_firstLevelBitmap &= ~(1u << fl);
 		}
+	}
+	block->m_next = block->m_prev = nullptr;
+}
 
-		if ( block->m_used == false && block->m_size > largestBlockSize )
-			largestBlockSize = block->m_size;
+size_t
+vsHeap::GetLargestFreeBlockSize()
+{
+	if ( !m_firstLevelBitmap )
+		return 0;
 
-		block = block->m_next;
+	// the largest block must be in our highest occupied bin, but blocks
+	// within a bin aren't sorted, so we need to check them all.
+	int fl = HighBitPosition( m_firstLevelBitmap );
+	int sl = HighBitPosition( m_secondLevelBitmap[fl] );
+	size_t largestBlockSize = 0;
+	for ( memBlock *block = m_freeBin[fl][sl]; block; block = block->m_next )
+		largestBlockSize = vsMax( largestBlockSize, block->m_size );
+	return largestBlockSize;
+}
+
+memBlock *
+vsHeap::FindFreeMemBlockOfSize( size_t size )
+{
+	// Round our size up to the start of the next bin, so that every block
+	// in the bin we look in is guaranteed to be big enough.  This means we
+	// may skip over a block in our 'exact' bin which would have fit, but
+	// we never need to walk a bin's list.
+	size_t searchSize = size;
+	if ( searchSize >= 256 )
+		searchSize += ((size_t)1 << (HighBitPosition(searchSize) - 3)) - 1;
+
+	int fl, sl;
+	GetBinForSize( searchSize, fl, sl );
+
+	if ( fl < HEAP_FIRST_LEVEL_BINS )
+	{
+		uint32_t secondLevelMap = m_secondLevelBitmap[fl] & (~0u << sl);
+		if ( !secondLevelMap )
+		{
+			// nothing left in this first-level bin;  try the next larger
+			// first-level bin which has anything in it.
+			uint32_t firstLevelMap = ( fl+1 < HEAP_FIRST_LEVEL_BINS ) ? (m_firstLevelBitmap & (~0u << (fl+1))) : 0;
+			if ( firstLevelMap )
+			{
+				fl = LowBitPosition( firstLevelMap );
+				secondLevelMap = m_secondLevelBitmap[fl];
+			}
+		}
+		if ( secondLevelMap )
+			return m_freeBin[fl][ LowBitPosition( secondLevelMap ) ];
 	}
 
+	size_t largestBlockSize = GetLargestFreeBlockSize();
+	bool foundMemBlockForAlloc = false;
+
 #ifdef _WIN32
 	vsLog("Unable to find block of size %lu in heap of size %lu.  Largest block available is %lu.", size, m_memorySize, largestBlockSize);
 #else
@@ -140,16 +489,74 @@ vsHeap::FindFreeMemBlockOfSize( size_t size )
 	return nullptr;
 }
 
-void *
-vsHeap::Alloc(size_t size_requested, const char *file, int line, int allocType)
+#ifdef VS_HEAP_COMPACT_HEADERS
+uint16_t
+vsHeap::GetFilenameId( const char *filename )
 {
+	if ( !filename )
+		return 0;
+
+	// open addressing on the pointer itself;  we're only ever given
+	// __FILE__, so the same file always arrives with the same pointer.
+	// (Or at least, the same pointer per translation unit)
+	const int mask = HEAP_FILENAME_TABLE_SIZE-1;
+	const int firstSlot = (int)((((uintptr_t)filename) >> 3) * 2654435761U) & mask;
+
+	// Almost always we've seen this file before, so first look without
+	// locking.
+	for ( int slot = firstSlot; ; slot = (slot + 1) & mask )
+	{
+		const char *entry = m_filenameTable[slot].load( std::memory_order_acquire );
+		if ( entry == filename )
+			return (uint16_t)slot;
+		if ( entry == nullptr )
+			break;
+	}
+
 	m_lock.Lock();
+	uint16_t result = 0;
+	for ( int slot = firstSlot; ; slot = (slot + 1) & mask )
+	{
+		const char *entry = m_filenameTable[slot].load( std::memory_order_relaxed );
+		if ( entry == filename )
+		{
+			result = (uint16_t)slot;	// someone else added it while we weren't locked
+			break;
+		}
+		if ( entry == nullptr )
+		{
+			// keep the table at most 3/4 full, so probes stay short.
+			if ( m_filenameCount < (HEAP_FILENAME_TABLE_SIZE * 3) / 4 )
+			{
+				m_filenameTable[slot].store( filename, std::memory_order_release );
+				m_filenameCount++;
+				result = (uint16_t)slot;
+			}
+			break;
+		}
+	}
+	m_lock.Unlock();
+	return result;
+}
+#endif // VS_HEAP_COMPACT_HEADERS
 
-	size_t size = size_requested;
-	size += sizeof( memBlock ) + sizeof( unsigned long );		// we need to allocate enough space for our new 'memBlock' header, and some bytes on the end.
-	size = (size+31) & 0xffffffe0;								// round 'size' up to the nearest 32 bytes, to force alignment.
+const char *
+vsHeap::GetFilename( const memBlock *block ) const
+{
+#ifdef VS_HEAP_COMPACT_HEADERS
+	return m_filenameTable[block->m_filenameId].load( std::memory_order_acquire );
+#else
+	return block->m_filename;
+#endif
+}
 
+memBlock *
+vsHeap::AllocBlock( size_t size )
+{
 	memBlock *block = FindFreeMemBlockOfSize(size);
+	if ( !block )
+		return nullptr;
+	RemoveFreeBlock(block);
 
 	void * end = (void *)((char *)block->m_start + size);
 
@@ -162,38 +569,101 @@ vsHeap::Alloc(size_t size_requested, const char *file, int line, int allocType)
 		split->m_end = block->m_end;
 		split->m_size = block->m_size - size;
 		split->m_used = false;
+		split->m_cached = false;
 
 		block->AppendBlock(split);
 
 		block->m_end = end;
 		block->m_size = size;
 
-		m_unusedBlockList.Append(split);
-		//block->Append(split);
+		InsertFreeBlock(split);
 	}
-	block->Extract();
 	m_blockList.Append(block);
 
+	block->m_used = true;
+	block->m_cached = false;
+
+	m_memoryUsed += block->m_size;
+	if ( m_memoryUsed > m_highWaterMark )
+	{
+		m_highWaterMark = m_memoryUsed;
+		/*if ( m_highWaterMark > 1024 * 1024 )
+		  TraceMemoryBlocks();*/
+	}
+	return block;
+}
+
+void
+vsHeap::FreeBlock( memBlock *block )
+{
+	block->m_used = false;
+	m_memoryUsed -= block->m_size;
+
+	// the block is no longer in use, so it comes out of our used block list.
+	block->Extract();
+
+	// now check if we can merge together with the physically adjacent
+	// blocks on either side of us.
+	memBlock *nextBlock = block->m_nextBlock;
+	memBlock *prevBlock = block->m_prevBlock;
+
+	if ( nextBlock && !nextBlock->m_used )
+	{
+		// next block isn't being used;  let's merge it into us!
+		RemoveFreeBlock(nextBlock);
+		block->m_end = nextBlock->m_end;
+		block->m_size += nextBlock->m_size;
+
+		nextBlock->ExtractBlock();
+	}
+	if ( prevBlock && !prevBlock->m_used )
+	{
+		// previous block isn't being used;  let's merge ourself into it!
+		RemoveFreeBlock(prevBlock);
+		prevBlock->m_end = block->m_end;
+		prevBlock->m_size += block->m_size;
+		block->ExtractBlock();
+		block = prevBlock;
+	}
+
+	InsertFreeBlock(block);
+}
+
+void *
+vsHeap::Alloc(size_t size_requested, const char *file, int line, int allocType)
+{
+	size_t size = size_requested;
+	size += sizeof( memBlock ) + sizeof( unsigned long );		// we need to allocate enough space for our new 'memBlock' header, and some bytes on the end.
+	size = (size+31) & ~(size_t)31;								// round 'size' up to the nearest 32 bytes, to force alignment.
+
+	// small allocations come out of this thread's cache, if possible.  (But
+	// never nested heaps;  those are big and long-lived)
+	memBlock *block = nullptr;
+	if ( allocType != Type_Heap )
+		block = s_threadCache.Alloc( this, size );
+
+	if ( !block )
+	{
+		m_lock.Lock();
+		block = AllocBlock(size);
+		m_lock.Unlock();
+	}
+
+#ifdef VS_HEAP_COMPACT_HEADERS
+	block->m_filenameId = GetFilenameId( file );
+#else
 	if ( file )
 	{
 		strncpy( block->m_filename, file, 127 );
 	}
+#endif
 	block->m_line = line;
 	block->m_blockId = (int)m_totalAllocations++;
 	block->m_allocType = allocType;
 	block->m_sizeRequested = size_requested;
 
-	block->m_used = true;
 	void *result = (void *)((char *)block->m_start + sizeof(memBlock));
 
-	m_memoryUsed += block->m_size;
-	if ( m_memoryUsed > m_highWaterMark )
-	{
-		m_highWaterMark = m_memoryUsed;
-		/*if ( m_highWaterMark > 1024 * 1024 )
-		  TraceMemoryBlocks();*/
-	}
-
 	if ( allocType != Type_Heap )
 	{
 		// overwrite everything in the user area, to make it really obvious what
@@ -211,96 +681,53 @@ vsHeap::Alloc(size_t size_requested, const char *file, int line, int allocType)
 	unsigned long *safetyLong = (unsigned long *)safety;
 	*safetyLong = 0xeeeeeeee;
 
-	m_lock.Unlock();
-
 	return result;
 }
 
 void
 vsHeap::Free(void *p, int allocType)
 {
-	m_lock.Lock();
-
 	p = (void *)((char *)p - sizeof(memBlock));	// adjust pointer to point to the start of its memBlock header
 
 	memBlock *block = (memBlock *)p;
-	//memBlock *block = m_blockList.m_next;
-	//bool foundBlockToFree = false;
 
-	//while ( block )
-	//{
-	//	if ( block->m_start == p )
-	{
-		// make sure the user hasn't overwritten our code past the end of their memory block.
-		void * safety = (void *)((char *)block->m_end - sizeof(unsigned long));
-		unsigned long *safetyLong = (unsigned long *)safety;
-		vsAssert( *safetyLong == 0xeeeeeeee, "Buffer overflow detected!" );	// if we hit this assert, someone has overwritten the bounds of this memory buffer!
+	// make sure the user hasn't overwritten our code past the end of their memory block.
+	void * safety = (void *)((char *)block->m_end - sizeof(unsigned long));
+	unsigned long *safetyLong = (unsigned long *)safety;
+	vsAssert( *safetyLong == 0xeeeeeeee, "Buffer overflow detected!" );	// if we hit this assert, someone has overwritten the bounds of this memory buffer!
+	vsAssert( block->m_used && !block->m_cached, "Freeing a block which isn't allocated!" );
 
-		if( block->m_allocType != allocType )
+	if( block->m_allocType != allocType )
+	{
+		const char *allocFunction[] =
 		{
-			const char *allocFunction[] =
-			{
-				"vsHeap constructor",
-				"Static alloc",
-				"malloc",
-				"new",
-				"new []"
-			};
-			const char *freeFunction[] =
-			{
-				"vsHeap destructor",
-				"None",
-				"free",
-				"delete",
-				"delete []"
-			};
-			vsLog("Error:  Allocation from %s line %d was allocated using %s", block->m_filename, block->m_line, allocFunction[(int)block->m_allocType]);
-			vsLog("Error:   but was freed using %s;  should have been %s!", freeFunction[allocType], freeFunction[(int)block->m_allocType]);
-		}
-
-		// check if we can merge together with the prev or the next block.
-		void *	userArea = (void *)((char *)block->m_start + sizeof(memBlock));
-		size_t	userSize = block->m_size - sizeof(memBlock);
-		memset(userArea, 0xdddddddd, userSize );
-		block->m_used = false;
-		m_memoryUsed -= block->m_size;
-
-		memBlock *nextBlock = block->m_nextBlock;
-		memBlock *prevBlock = block->m_prevBlock;
-
-		if ( nextBlock && !nextBlock->m_used )
+			"vsHeap constructor",
+			"Static alloc",
+			"malloc",
+			"new",
+			"new []"
+		};
+		const char *freeFunction[] =
 		{
-			//memBlock *nextBlock = block->m_next;
-
-			// next block isn't being used;  let's merge it into us!
-			block->m_end = nextBlock->m_end;
-			block->m_size += nextBlock->m_size;
+			"vsHeap destructor",
+			"None",
+			"free",
+			"delete",
+			"delete []"
+		};
+		vsLog("Error:  Allocation from %s line %d was allocated using %s", GetFilename(block), block->m_line, allocFunction[(int)block->m_allocType]);
+		vsLog("Error:   but was freed using %s;  should have been %s!", freeFunction[allocType], freeFunction[(int)block->m_allocType]);
+	}
 
-			nextBlock->ExtractBlock();
-			nextBlock->Extract();
-		}
-		if ( prevBlock && prevBlock != &m_unusedBlockList && !prevBlock->m_used )
-		{
-			// previous block isn't being used;  let's merge ourself into it!
-			prevBlock->m_end = block->m_end;
-			prevBlock->m_size += block->m_size;
-			block->ExtractBlock();
-			block->Extract();
-			m_lock.Unlock();
-			return;
-		}
+	void *	userArea = (void *)((char *)block->m_start + sizeof(memBlock));
+	size_t	userSize = block->m_size - sizeof(memBlock);
+	memset(userArea, 0xdddddddd, userSize );
 
-		block->Extract();
-		m_unusedBlockList.Append(block);
-		//foundBlockToFree = true;
-		m_lock.Unlock();
+	if ( s_threadCache.Free( this, block ) )
 		return;
-	}
-	//	block = block->m_next;
-	//}
-
-	//vsAssert(foundBlockToFree, "Tried to free a block we didn't allocate!");	// tried to free a block we didn't know about!
 
+	m_lock.Lock();
+	FreeBlock(block);
 	m_lock.Unlock();
 }
 
@@ -311,17 +738,9 @@ vsHeap::PrintStatus()
 	vsLog(" >> MEMORY STATUS");
 
 	size_t bytesFree = m_memorySize - m_memoryUsed;
-	size_t largestBlock = 0;
-
-	memBlock *block = m_unusedBlockList.m_next;
-
-	while ( block )
-	{
-		if ( !block->m_used && block->m_size > largestBlock )
-			largestBlock = block->m_size;
-
-		block = block->m_next;
-	}
+	m_lock.Lock();
+	size_t largestBlock = GetLargestFreeBlockSize();
+	m_lock.Unlock();
 
 #ifdef _WIN32
 	vsLog(" >> Heap current usage %lu / %lu (%0.2f%% usage)", m_memoryUsed, m_memorySize, 100.0f*m_memoryUsed/m_memorySize);
@@ -345,14 +764,14 @@ vsHeap::CheckForLeaks()
 
 	while ( block )
 	{
-		if ( block->m_used && block->m_blockId > m_leakMark )
+		if ( block->m_used && !block->m_cached && block->m_blockId > m_leakMark )
 		{
 			if ( !foundLeak )
 			{
 				vsLog("\nERROR:  LEAKS DETECTED!\n-------------------\nLeaked blocks follow:\n");
 				foundLeak = true;
 			}
-			vsLog("[%s:%d] %s:%d : %d bytes", m_name.c_str(), block->m_blockId, block->m_filename, block->m_line, block->m_sizeRequested);
+			vsLog("[%s:%d] %s:%d : %d bytes", m_name.c_str(), block->m_blockId, GetFilename(block), block->m_line, block->m_sizeRequested);
 		}
 		block = block->m_next;
 	}
@@ -368,12 +787,12 @@ vsHeap::TraceMemoryBlocks()
 
 	while ( block )
 	{
-		if ( block->m_used )
+		if ( block->m_used && !block->m_cached )
 		{
 #ifdef _WIN32
-			vsLog("[%d] %s:%d : %lu bytes", block->m_blockId, block->m_filename, block->m_line, block->m_sizeRequested);
+			vsLog("[%d] %s:%d : %lu bytes", block->m_blockId, GetFilename(block), block->m_line, block->m_sizeRequested);
 #else
-			vsLog("[%d] %s:%d : %zu bytes", block->m_blockId, block->m_filename, block->m_line, block->m_sizeRequested);
+			vsLog("[%d] %s:%d : %zu bytes", block->m_blockId, GetFilename(block), block->m_line, block->m_sizeRequested);
 #endif
 		}
 		block = block->m_next;
@@ -388,9 +807,9 @@ vsHeap::PrintBlockList()
 	while ( block )
 	{
 #ifdef _WIN32
-		vsLog("[%d] %s:%d : %lu bytes", block->m_blockId, block->m_filename, block->m_line, block->m_sizeRequested);
+		vsLog("[%d] %s:%d : %lu bytes", block->m_blockId, GetFilename(block), block->m_line, block->m_sizeRequested);
 #else
-		vsLog("[%d] %s:%d : %zu bytes", block->m_blockId, block->m_filename, block->m_line, block->m_sizeRequested);
+		vsLog("[%d] %s:%d : %zu bytes", block->m_blockId, GetFilename(block), block->m_line, block->m_sizeRequested);
 #endif
 		block = block->m_next;
 	}
@@ -401,6 +820,7 @@ memBlock::memBlock():
 	m_end(0),
 	m_size(0),
 	m_used(false),
+	m_cached(false),
 	m_next(nullptr),
 	m_prev(nullptr)
 {
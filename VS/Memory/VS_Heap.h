@@ -11,6 +11,8 @@
 #define MEM_HEAP_H
 
 #include "VS/Threads/VS_Spinlock.h"
+#include "VS_Config.h"
+#include <atomic>
 
 
 class memBlock
@@ -23,12 +25,17 @@ public:
 	size_t		m_sizeRequested;
 	int			m_blockId;
 
+#ifdef VS_HEAP_COMPACT_HEADERS
+	uint16_t	m_filenameId;	// index into our vsHeap's filename table
+#else
 	char		m_filename[128];
+#endif
 	int			m_line;
 
 	char		m_allocType;
 
 	bool		m_used;
+	bool		m_cached;	// 'used' as far as the heap knows, but actually sitting unused in a thread's allocation cache
 
 	memBlock *	m_next;
 	memBlock *	m_prev;
@@ -54,6 +61,8 @@ enum
 	Type_NewArray
 };
 
+class vsHeapThreadCache;
+
 class vsHeap
 {
 #define MAX_ALLOCATIONS (4096)
@@ -65,20 +74,59 @@ class vsHeap
 
 	size_t	m_memoryUsed;
 	size_t	m_highWaterMark;
-	size_t	m_totalAllocations;
+	std::atomic<size_t>	m_totalAllocations;
 
 	int		m_leakMark;
 
 	memBlock	m_blockList;
-	memBlock	m_unusedBlockList;
 //	memBlock	m_blockStore[MAX_ALLOCATIONS];
 
+	// Free blocks are kept in bins by size.  The first level bins are by
+	// power of two, and each of those is split into eight evenly sized
+	// second level bins.  (Everything below 256 bytes goes into the first
+	// first-level bin, in 32 byte steps).  Bitmaps track which bins have
+	// any blocks in them, so we can find a free block big enough for any
+	// request without walking lists.
+#define HEAP_FIRST_LEVEL_BINS (32)
+#define HEAP_SECOND_LEVEL_BINS (8)
+	memBlock *	m_freeBin[HEAP_FIRST_LEVEL_BINS][HEAP_SECOND_LEVEL_BINS];
+	uint32_t	m_firstLevelBitmap;
+	uint8_t		m_secondLevelBitmap[HEAP_FIRST_LEVEL_BINS];
+
+#ifdef VS_HEAP_COMPACT_HEADERS
+	// Block headers just store an index into this table, instead of their
+	// own copy of the filename.  The entries are the __FILE__ pointers we
+	// were given, so we never copy the strings themselves.  Entries are
+	// never removed, so lookups don't need our lock;  only adding does.
+#define HEAP_FILENAME_TABLE_SIZE (4096)
+	std::atomic<const char *>	m_filenameTable[HEAP_FILENAME_TABLE_SIZE];
+	int				m_filenameCount;
+
+	uint16_t	GetFilenameId( const char *filename );
+#endif
+	const char *	GetFilename( const memBlock *block ) const;
+
 	static vsHeap * s_current;
 
+	static void	GetBinForSize( size_t size, int &firstLevel, int &secondLevel );
+	void		InsertFreeBlock( memBlock *block );
+	void		RemoveFreeBlock( memBlock *block );
+	size_t		GetLargestFreeBlockSize();
+
 	memBlock *	FindFreeMemBlockOfSize(size_t size);
 //	memBlock *	GetUnusedMemBlock();
 	vsSpinlock m_lock;
 
+	// Each thread keeps a small cache of recently freed small blocks, and
+	// only takes our lock to refill or flush that cache in batches.  Blocks
+	// sitting in those caches still count as 'used' from our point of view.
+	vsHeapThreadCache *	m_threadCaches;	// every thread cache currently holding our blocks
+
+	memBlock *	AllocBlock( size_t size );		// Assumes m_lock is already locked
+	void		FreeBlock( memBlock *block );	// Assumes m_lock is already locked
+
+	friend class vsHeapThreadCache;
+
 public:
 	vsHeap(vsString name, size_t bufferSize);
 	vsHeap(vsString name, void *buffer, int bufferSize);
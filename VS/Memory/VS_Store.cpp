@@ -332,6 +332,16 @@ vsStore::WriteVoidStar( void *v )
 	m_writeHead += sizeof(v);
 }
 
+char *
+vsStore::ReserveForWriting( size_t bytes )
+{
+	_EnsureBytesLeftForWriting( bytes );
+
+	char *result = m_writeHead;
+	m_writeHead += bytes;
+	return result;
+}
+
 
 
 int8_t
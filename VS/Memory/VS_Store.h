@@ -93,6 +93,8 @@ public:
 
 	void	WriteVoidStar(void *value);		// WARNING:  DO NOT USE THIS UNLESS YOU REALLY KNOW WHAT YOU'RE DOING!  :)
 
+	char *	ReserveForWriting( size_t bytes );	// advance the write head past 'bytes' uninitialised bytes, and return a pointer to them so they can be filled in place.
+
 	int8_t	ReadInt8();
 	uint8_t	ReadUint8();
 	uint8_t	PeekUint8();
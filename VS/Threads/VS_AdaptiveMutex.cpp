@@ -0,0 +1,93 @@
+//
+//  VS_AdaptiveMutex.cpp
+//  VectorStorm
+//
+//  Created by agent on 18/10/26.
+//  Copyright 2026 agent. All rights reserved.
+//
+
+#include "VS_AdaptiveMutex.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#undef PlaySound  // yay, Windows.
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <thread>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	// How many rounds of spinning we do before going to sleep.  Each round
+	// spins twice as long as the one before, up to a limit.
+	const int c_spinRounds = 10;
+	const int c_maxSpinsPerRound = 64;
+
+	inline void CpuRelax()
+	{
+#if defined(_MSC_VER) && ( defined(_M_IX86) || defined(_M_X64) )
+		_mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+		_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+		__asm__ __volatile__("yield");
+#endif
+	}
+};
+
+void
+vsAdaptiveMutex::LockSlow()
+{
+	int spins = 1;
+	for ( int round = 0; round < c_spinRounds; round++ )
+	{
+		for ( int i = 0; i < spins; i++ )
+			CpuRelax();
+		spins = vsMin( spins * 2, c_maxSpinsPerRound );
+
+		// only attempt the (expensive) exchange once the lock looks free.
+		if ( m_state.load( std::memory_order_relaxed ) == 0 && TryLock() )
+			return;
+	}
+
+	// Still held.  Mark the lock as having sleepers, and sleep until it's
+	// released.  If the exchange returns 0, the lock was free and we now
+	// own it (in state 2, so our Unlock() will do a possibly-unnecessary
+	// wake;  that's fine).
+	while ( m_state.exchange( 2, std::memory_order_acquire ) != 0 )
+		Sleep();
+}
+
+void
+vsAdaptiveMutex::Sleep()
+{
+	// Returns immediately if m_state isn't 2 any more.
+#if defined(_WIN32)
+	int expected = 2;
+	WaitOnAddress( &m_state, &expected, sizeof(expected), INFINITE );
+#elif defined(__linux__)
+	syscall( SYS_futex, reinterpret_cast<int*>(&m_state), FUTEX_WAIT_PRIVATE, 2, nullptr, nullptr, 0 );
+#else
+	std::this_thread::yield();
+#endif
+}
+
+void
+vsAdaptiveMutex::WakeOne()
+{
+#if defined(_WIN32)
+	WakeByAddressSingle( &m_state );
+#elif defined(__linux__)
+	syscall( SYS_futex, reinterpret_cast<int*>(&m_state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0 );
+#endif
+}
+
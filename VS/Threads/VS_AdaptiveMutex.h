@@ -0,0 +1,80 @@
+//
+//  VS_AdaptiveMutex.h
+//  VectorStorm
+//
+//  Created by agent on 18/10/26.
+//  Copyright 2026 agent. All rights reserved.
+//
+
+#ifndef VS_ADAPTIVEMUTEX_H
+#define VS_ADAPTIVEMUTEX_H
+
+#include <atomic>
+
+// vsAdaptiveMutex is a lock for short critical sections which might
+// occasionally be contended.  An uncontended Lock()/Unlock() pair is one
+// atomic operation each, with no system calls.  If the lock is held, we
+// spin for a little while (backing off as we go) in the hope that it's
+// released soon, and only then put the thread to sleep in the kernel
+// until the holder wakes us.
+//
+// That makes it a better choice than vsSpinlock (which never sleeps, so a
+// thread which is descheduled while holding it can stall every waiter for
+// a whole timeslice) and cheaper than vsMutex in the common case.
+//
+// Sleeping uses futexes on Linux and WaitOnAddress on Windows.  Elsewhere
+// we just yield the CPU in a loop.
+
+class vsAdaptiveMutex
+{
+	// 0: unlocked.  1: locked.  2: locked, and somebody may be asleep
+	// waiting for it.
+	std::atomic<int>	m_state;
+
+	void	LockSlow();
+	void	Sleep();
+	void	WakeOne();
+
+	vsAdaptiveMutex( const vsAdaptiveMutex& other ) = delete;
+	vsAdaptiveMutex& operator=( const vsAdaptiveMutex& other ) = delete;
+
+public:
+	vsAdaptiveMutex(): m_state(0) {}
+
+	bool TryLock()
+	{
+		int expected = 0;
+		return m_state.compare_exchange_strong( expected, 1, std::memory_order_acquire, std::memory_order_relaxed );
+	}
+
+	void Lock()
+	{
+		if ( !TryLock() )
+			LockSlow();
+	}
+
+	void Unlock()
+	{
+		if ( m_state.exchange( 0, std::memory_order_release ) == 2 )
+			WakeOne();
+	}
+};
+
+class vsAdaptiveScopedLock
+{
+	vsAdaptiveMutex& m_mutex;
+public:
+	vsAdaptiveScopedLock( vsAdaptiveMutex& m ):
+		m_mutex(m)
+	{
+		m_mutex.Lock();
+	}
+
+	~vsAdaptiveScopedLock()
+	{
+		m_mutex.Unlock();
+	}
+};
+
+#endif // VS_ADAPTIVEMUTEX_H
+
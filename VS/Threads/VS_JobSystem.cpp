@@ -0,0 +1,370 @@
+//
+//  VS_JobSystem.cpp
+//  VectorStorm
+//
+//  Created by agent on 18/10/26.
+//  Copyright 2026 agent. All rights reserved.
+//
+
+#include "VS_JobSystem.h"
+#include <SDL2/SDL_cpuinfo.h>
+#include <thread>
+
+vsJobSystem * vsJobSystem::s_instance = nullptr;
+
+namespace
+{
+	// Which deque belongs to this thread;  -1 if none does.
+	thread_local int s_jobThreadIndex = -1;
+
+	// Used to pick which deque to try stealing from first, so that idle
+	// threads don't all mob the same victim.
+	thread_local uint32_t s_stealSeed = 0;
+
+	// Most worker threads we'll start, and so also the most helper jobs a
+	// single ParallelFor will queue.
+	const int c_maxWorkers = 63;
+
+	// How many times an idle worker looks for work before going to sleep.
+	const int c_idleSpins = 32;
+};
+
+vsJobCounter::~vsJobCounter()
+{
+	vsAssert( IsDone(), "vsJobCounter destroyed while jobs are still using it!" );
+}
+
+void
+vsJobCounter::Add()
+{
+	if ( m_count.fetch_add( 1, std::memory_order_acq_rel ) == 0 && m_parent )
+		m_parent->Add();
+}
+
+void
+vsJobCounter::Finish()
+{
+	// Once our count hits zero, whoever is waiting on us may destroy us, so
+	// grab our parent pointer before that can happen.
+	vsJobCounter *parent = m_parent;
+	if ( m_count.fetch_sub( 1, std::memory_order_acq_rel ) == 1 && parent )
+		parent->Finish();
+}
+
+vsJobSystem::Deque::Deque():
+	m_top(0),
+	m_bottom(0)
+{
+	for ( int i = 0; i < c_capacity; i++ )
+		m_job[i].store( nullptr, std::memory_order_relaxed );
+}
+
+bool
+vsJobSystem::Deque::Push( vsJob *job )
+{
+	int64_t bottom = m_bottom.load( std::memory_order_relaxed );
+	int64_t top = m_top.load( std::memory_order_acquire );
+	if ( bottom - top >= c_capacity )
+		return false;
+
+	m_job[bottom & (c_capacity-1)].store( job, std::memory_order_relaxed );
+	m_bottom.store( bottom+1, std::memory_order_release );	// publishes the job to thieves
+	return true;
+}
+
+vsJob *
+vsJobSystem::Deque::Pop()
+{
+	int64_t bottom = m_bottom.load( std::memory_order_relaxed ) - 1;
+	m_bottom.store( bottom, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	int64_t top = m_top.load( std::memory_order_relaxed );
+
+	if ( top > bottom )
+	{
+		// empty
+		m_bottom.store( bottom+1, std::memory_order_relaxed );
+		return nullptr;
+	}
+
+	vsJob *job = m_job[bottom & (c_capacity-1)].load( std::memory_order_relaxed );
+	if ( top == bottom )
+	{
+		// This is the last job, so we're racing any thieves for it.
+		if ( !m_top.compare_exchange_strong( top, top+1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+			job = nullptr;
+		m_bottom.store( bottom+1, std::memory_order_relaxed );
+	}
+	return job;
+}
+
+vsJob *
+vsJobSystem::Deque::Steal()
+{
+	int64_t top = m_top.load( std::memory_order_acquire );
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	int64_t bottom = m_bottom.load( std::memory_order_acquire );
+
+	if ( top >= bottom )
+		return nullptr;
+
+	vsJob *job = m_job[top & (c_capacity-1)].load( std::memory_order_relaxed );
+	if ( !m_top.compare_exchange_strong( top, top+1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+		return nullptr;	// somebody else got it first
+	return job;
+}
+
+vsJobSystem::Worker::Worker( vsJobSystem *system, int index ):
+	vsTask( vsFormatString("Worker %d", index) ),
+	m_system( system ),
+	m_index( index )
+{
+}
+
+int
+vsJobSystem::Worker::Run()
+{
+	s_jobThreadIndex = m_index;
+	s_stealSeed = m_index;
+
+	int idle = 0;
+	while ( !m_system->m_exiting.load( std::memory_order_acquire ) )
+	{
+		vsJob *job = m_system->FindJob( m_index );
+		if ( job )
+		{
+			m_system->Execute( job );
+			idle = 0;
+			continue;
+		}
+
+		if ( ++idle < c_idleSpins )
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Nothing to do.  Announce that we're going to sleep, then look one
+		// more time;  anybody who queued a job before seeing our announcement
+		// will have put it where we're about to look, and anybody after will
+		// wake us up.
+		m_system->m_sleepingWorkers.fetch_add( 1, std::memory_order_seq_cst );
+		job = m_system->FindJob( m_index );
+		if ( job )
+		{
+			m_system->m_sleepingWorkers.fetch_sub( 1, std::memory_order_relaxed );
+			m_system->Execute( job );
+			idle = 0;
+			continue;
+		}
+
+		bool awake = m_system->m_workAvailable.Wait();
+		m_system->m_sleepingWorkers.fetch_sub( 1, std::memory_order_relaxed );
+		if ( !awake )
+			break;
+		idle = 0;
+	}
+	return 0;
+}
+
+vsJobSystem::vsJobSystem( int workerCount ):
+	m_deque( nullptr ),
+	m_worker( nullptr ),
+	m_workerCount( workerCount ),
+	m_workAvailable( 0 ),
+	m_sleepingWorkers( 0 ),
+	m_exiting( false )
+{
+	vsAssert(s_instance == nullptr, "Multiple vsJobSystems created??");
+	s_instance = this;
+
+	if ( m_workerCount < 0 )
+		m_workerCount = SDL_GetCPUCount() - 1;
+	m_workerCount = vsClamp( m_workerCount, 0, c_maxWorkers );
+
+	// deque 0 is ours;  workers get the rest.
+	m_deque = new Deque[m_workerCount+1];
+	s_jobThreadIndex = 0;
+
+	m_worker = new Worker*[m_workerCount];
+	for ( int i = 0; i < m_workerCount; i++ )
+	{
+		m_worker[i] = new Worker( this, i+1 );
+		m_worker[i]->Start();
+	}
+
+	vsLog("vsJobSystem:  Started %d worker threads", m_workerCount);
+}
+
+vsJobSystem::~vsJobSystem()
+{
+	m_exiting.store( true, std::memory_order_release );
+
+	// one post for each worker, in case they were just about to go to sleep.
+	for ( int i = 0; i < m_workerCount; i++ )
+		m_workAvailable.Post();
+	for ( int i = 0; i < m_workerCount; i++ )
+	{
+		m_worker[i]->Join();
+		vsDelete( m_worker[i] );
+	}
+	m_workAvailable.Release();
+
+	vsDeleteArray( m_worker );
+	vsDeleteArray( m_deque );
+	s_jobThreadIndex = -1;
+
+	vsAssert(s_instance == this, "vsJobSystem instance isn't me??");
+	s_instance = nullptr;
+}
+
+int
+vsJobSystem::GetThreadIndex()
+{
+	return s_jobThreadIndex;
+}
+
+void
+vsJobSystem::Run( vsJob *job )
+{
+	if ( job->counter )
+		job->counter->Add();
+
+	bool queued;
+	int index = GetThreadIndex();
+	if ( index >= 0 )
+	{
+		queued = m_deque[index].Push( job );
+	}
+	else
+	{
+		m_sharedQueueLock.Lock();
+		queued = m_sharedQueue.Push( job );
+		m_sharedQueueLock.Unlock();
+	}
+
+	if ( queued )
+		WakeWorkers( 1 );
+	else
+		Execute( job );	// queue's full;  just do it now.
+}
+
+void
+vsJobSystem::Run( vsJob::Function function, void *data, vsJobCounter *counter )
+{
+	vsJob *job = new vsJob( function, data, counter );
+	job->deleteWhenDone = true;
+	Run( job );
+}
+
+void
+vsJobSystem::WakeWorkers( int count )
+{
+	// Pairs with the fence in Worker::Run();  either that worker sees the
+	// job we just queued, or we see that it's asleep.
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	int sleeping = m_sleepingWorkers.load( std::memory_order_relaxed );
+	count = vsMin( count, sleeping );
+	for ( int i = 0; i < count; i++ )
+		m_workAvailable.Post();
+}
+
+vsJob *
+vsJobSystem::FindJob( int threadIndex )
+{
+	vsJob *job = nullptr;
+	if ( threadIndex >= 0 )
+	{
+		job = m_deque[threadIndex].Pop();
+		if ( job )
+			return job;
+	}
+
+	job = m_sharedQueue.Steal();
+	if ( job )
+		return job;
+
+	int dequeCount = m_workerCount+1;
+	s_stealSeed = s_stealSeed * 1664525 + 1013904223;
+	int start = (s_stealSeed >> 16) % dequeCount;
+	for ( int i = 0; i < dequeCount; i++ )
+	{
+		int victim = (start + i) % dequeCount;
+		if ( victim == threadIndex )
+			continue;
+		job = m_deque[victim].Steal();
+		if ( job )
+			return job;
+	}
+	return nullptr;
+}
+
+void
+vsJobSystem::Execute( vsJob *job )
+{
+	// Once the counter is finished, the job may be destroyed by whoever
+	// owns it, so we mustn't touch it after that.
+	vsJobCounter *counter = job->counter;
+	job->function( job );
+	if ( job->deleteWhenDone )
+		vsDelete( job );
+	if ( counter )
+		counter->Finish();
+}
+
+void
+vsJobSystem::Wait( vsJobCounter *counter )
+{
+	int index = GetThreadIndex();
+	while ( !counter->IsDone() )
+	{
+		vsJob *job = FindJob( index );
+		if ( job )
+			Execute( job );
+		else
+			std::this_thread::yield();
+	}
+}
+
+void
+vsJobSystem::ParallelForJob( vsJob *job )
+{
+	RunParallelForChunks( (ParallelForData*)job->data );
+}
+
+void
+vsJobSystem::RunParallelForChunks( ParallelForData *data )
+{
+	while(1)
+	{
+		int begin = data->next.fetch_add( data->grainSize, std::memory_order_relaxed );
+		if ( begin >= data->end )
+			break;
+		int end = vsMin( begin + data->grainSize, data->end );
+		data->function( data->body, begin, end );
+	}
+}
+
+void
+vsJobSystem::ParallelFor_Internal( ParallelForData *data )
+{
+	int itemCount = data->end - data->next.load( std::memory_order_relaxed );
+	int chunkCount = (itemCount + data->grainSize - 1) / data->grainSize;
+
+	// We'll work on this ourselves, so we only want help with the chunks
+	// beyond the first.  Each helper just keeps claiming chunks until there
+	// are none left, so one per worker is plenty.
+	int helperCount = vsMin( m_workerCount, chunkCount-1 );
+
+	vsJobCounter counter;
+	vsJob helper[c_maxWorkers];
+	for ( int i = 0; i < helperCount; i++ )
+	{
+		helper[i] = vsJob( &ParallelForJob, data, &counter );
+		Run( &helper[i] );
+	}
+
+	RunParallelForChunks( data );
+	Wait( &counter );
+}
+
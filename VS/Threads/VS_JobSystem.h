@@ -0,0 +1,206 @@
+//
+//  VS_JobSystem.h
+//  VectorStorm
+//
+//  Created by agent on 18/10/26.
+//  Copyright 2026 agent. All rights reserved.
+//
+
+#ifndef VS_JOBSYSTEM_H
+#define VS_JOBSYSTEM_H
+
+#include "VS_Task.h"
+#include "VS_Semaphore.h"
+#include "VS_Spinlock.h"
+#include <atomic>
+
+// vsJobSystem runs small pieces of work ("jobs") on a fixed pool of worker
+// threads, one per hardware thread (less one for the main thread).
+//
+// Every worker has its own deque of jobs.  A thread pushes the jobs it
+// creates onto the bottom of its own deque and pops them back off from there,
+// so related work tends to stay on one core.  Idle workers steal jobs from
+// the top of other threads' deques.  The thread which created the job system
+// (normally the main thread) owns a deque too, so that it can hand out work
+// and help out with it while it waits.  Jobs queued from any other thread go
+// onto a shared queue instead.
+//
+// Completion is tracked with vsJobCounters.  Each job may name a counter;
+// the counter goes up when the job is queued and down when it finishes, and
+// Wait() keeps running other jobs until the counter reaches zero.  A counter
+// can also have a parent counter, which it holds open for as long as the
+// child counter has work outstanding, so a job can spawn sub-jobs and the
+// code waiting on the parent will also wait for all of those.
+//
+// Jobs shouldn't block on anything other than Wait().  Nothing here allocates
+// memory per job, except for the convenience version of Run().
+
+class vsJobCounter
+{
+	std::atomic<int>	m_count;
+	vsJobCounter *		m_parent;
+
+	void Add();
+	void Finish();
+
+public:
+	vsJobCounter( vsJobCounter *parent = nullptr ): m_count(0), m_parent(parent) {}
+	~vsJobCounter();
+
+	bool IsDone() const { return m_count.load( std::memory_order_acquire ) == 0; }
+
+	friend class vsJobSystem;
+};
+
+struct vsJob
+{
+	typedef void (*Function)( vsJob *job );
+
+	Function		function;
+	void *			data;
+	vsJobCounter *	counter;
+	bool			deleteWhenDone;	// was allocated by vsJobSystem::Run(), not by our caller
+
+	vsJob(): function(nullptr), data(nullptr), counter(nullptr), deleteWhenDone(false) {}
+	vsJob( Function function_, void *data_, vsJobCounter *counter_ = nullptr ):
+		function(function_),
+		data(data_),
+		counter(counter_),
+		deleteWhenDone(false)
+	{
+	}
+};
+
+class vsJobSystem
+{
+	static vsJobSystem *s_instance;
+
+	// Chase-Lev work-stealing deque.  Only the owning thread may Push() and
+	// Pop();  any thread may Steal().
+	class Deque
+	{
+		static const int c_capacity = 4096;	// must be a power of two
+
+		std::atomic<int64_t>	m_top;
+		char					m_padding[64];	// keep thieves' and owner's indices on different cache lines
+		std::atomic<int64_t>	m_bottom;
+		std::atomic<vsJob*>		m_job[c_capacity];
+
+	public:
+		Deque();
+
+		bool	Push( vsJob *job );	// returns false if we're full
+		vsJob *	Pop();
+		vsJob *	Steal();
+	};
+
+	class Worker : public vsTask
+	{
+		vsJobSystem *	m_system;
+		int				m_index;
+
+	protected:
+		virtual int Run();
+
+	public:
+		Worker( vsJobSystem *system, int index );
+	};
+
+	Deque *				m_deque;		// one per thread;  [0] belongs to the thread which created us
+	Worker **			m_worker;
+	int					m_workerCount;
+
+	Deque				m_sharedQueue;	// jobs queued by threads with no deque of their own
+	vsSpinlock			m_sharedQueueLock;
+
+	vsSemaphore			m_workAvailable;
+	std::atomic<int>	m_sleepingWorkers;
+	std::atomic<bool>	m_exiting;
+
+	vsJob *	FindJob( int threadIndex );
+	void	Execute( vsJob *job );
+	void	WakeWorkers( int count );
+
+	static int GetThreadIndex();
+
+	// ParallelFor support;  'helperCount' jobs plus the calling thread all
+	// take chunks of the range from 'next' until there are none left.
+	struct ParallelForData
+	{
+		std::atomic<int>	next;
+		int					end;
+		int					grainSize;
+		void				(*function)( const void *body, int begin, int end );
+		const void *		body;
+	};
+	static void	ParallelForJob( vsJob *job );
+	static void	RunParallelForChunks( ParallelForData *data );
+	void		ParallelFor_Internal( ParallelForData *data );
+
+	template<typename F>
+	static void CallRangeBody( const void *body, int begin, int end )
+	{
+		(*(const F*)body)( begin, end );
+	}
+
+	template<typename F>
+	struct EachIndex
+	{
+		const F *body;
+		void operator()( int begin, int end ) const
+		{
+			for ( int i = begin; i < end; i++ )
+				(*body)(i);
+		}
+	};
+
+public:
+
+	static vsJobSystem * Instance() { return s_instance; }
+
+	// 'workerCount' less than zero means "one per hardware thread, less one
+	// for the calling thread".
+	vsJobSystem( int workerCount = -1 );
+	~vsJobSystem();
+
+	int		GetWorkerCount() const { return m_workerCount; }
+
+	// Queue up a job.  The vsJob must stay valid until it has finished running.
+	void	Run( vsJob *job );
+
+	// Convenience version which allocates the vsJob for you, and deletes it
+	// after it has run.
+	void	Run( vsJob::Function function, void *data, vsJobCounter *counter );
+
+	// Runs other jobs until 'counter' reaches zero.  Safe to call from inside
+	// a job, or from any thread.
+	void	Wait( vsJobCounter *counter );
+
+	// Calls body(begin, end) for consecutive sub-ranges of [begin, end), each
+	// at most 'grainSize' long, spread across the worker threads and this one.
+	// Returns once every sub-range has been processed.
+	template<typename F>
+	void	ParallelForRange( int begin, int end, int grainSize, const F& body )
+	{
+		if ( begin >= end )
+			return;
+		ParallelForData data;
+		data.next = begin;
+		data.end = end;
+		data.grainSize = ( grainSize > 1 ) ? grainSize : 1;
+		data.function = &CallRangeBody<F>;
+		data.body = &body;
+		ParallelFor_Internal( &data );
+	}
+
+	// Calls body(i) for every i in [begin, end), in chunks of 'grainSize'.
+	template<typename F>
+	void	ParallelFor( int begin, int end, int grainSize, const F& body )
+	{
+		EachIndex<F> each = { &body };
+		ParallelForRange( begin, end, grainSize, each );
+	}
+};
+
+#endif // VS_JOBSYSTEM_H
+
@@ -0,0 +1,190 @@
+//
+//  VS_LockFreeQueue.h
+//  VectorStorm
+//
+//  Created by agent on 18/10/26.
+//  Copyright 2026 agent. All rights reserved.
+//
+
+#ifndef VS_LOCKFREEQUEUE_H
+#define VS_LOCKFREEQUEUE_H
+
+#include "VS/Math/VS_Math.h"
+#include <atomic>
+
+// Bounded FIFO queues for handing items from one thread to another without
+// taking a lock.  Both have a fixed capacity (rounded up to a power of two),
+// and TryPush() returns false instead of waiting if the queue is full;  it's
+// up to the caller to decide whether to retry, drop the item or do the work
+// itself.
+//
+// vsSPSCQueue may only be pushed to from one thread and popped from one
+// (other) thread at a time.  vsMPSCQueue may be pushed to from any number
+// of threads, but still only popped from one.
+
+template<typename T>
+class vsSPSCQueue
+{
+	T *						m_item;
+	uint32_t				m_mask;
+
+	// The producer and consumer each keep a private copy of the other's
+	// index, and only re-read the shared one when that copy says they've run
+	// out of room (or of items).  The padding keeps the two sides' data on
+	// separate cache lines.
+	char					m_padding0[64];
+	std::atomic<uint32_t>	m_head;			// next item to pop;  written by the consumer
+	uint32_t				m_cachedTail;
+	char					m_padding1[64];
+	std::atomic<uint32_t>	m_tail;			// next slot to push into;  written by the producer
+	uint32_t				m_cachedHead;
+	char					m_padding2[64];
+
+	vsSPSCQueue( const vsSPSCQueue& other ) = delete;
+	vsSPSCQueue& operator=( const vsSPSCQueue& other ) = delete;
+
+public:
+
+	vsSPSCQueue( int capacity ):
+		m_head(0),
+		m_cachedTail(0),
+		m_tail(0),
+		m_cachedHead(0)
+	{
+		int size = vsNextPowerOfTwo( vsMax(capacity, 2) );
+		m_item = new T[size];
+		m_mask = size-1;
+	}
+
+	~vsSPSCQueue()
+	{
+		vsDeleteArray( m_item );
+	}
+
+	int		GetCapacity() const { return m_mask+1; }
+
+	// Producer thread only.
+	bool	TryPush( const T& item )
+	{
+		uint32_t tail = m_tail.load( std::memory_order_relaxed );
+		if ( tail - m_cachedHead > m_mask )
+		{
+			m_cachedHead = m_head.load( std::memory_order_acquire );
+			if ( tail - m_cachedHead > m_mask )
+				return false;
+		}
+		m_item[tail & m_mask] = item;
+		m_tail.store( tail+1, std::memory_order_release );
+		return true;
+	}
+
+	// Consumer thread only.
+	bool	TryPop( T& item )
+	{
+		uint32_t head = m_head.load( std::memory_order_relaxed );
+		if ( head == m_cachedTail )
+		{
+			m_cachedTail = m_tail.load( std::memory_order_acquire );
+			if ( head == m_cachedTail )
+				return false;
+		}
+		item = std::move( m_item[head & m_mask] );
+		m_head.store( head+1, std::memory_order_release );
+		return true;
+	}
+};
+
+// Dmitry Vyukov's bounded queue.  Every slot carries a sequence number which
+// tells producers whether it's free to be written, and the consumer whether
+// it has been.  Producers only contend with each other on 'm_tail', and the
+// consumer never touches anything the producers write except the slots
+// themselves.
+template<typename T>
+class vsMPSCQueue
+{
+	struct Slot
+	{
+		std::atomic<uint32_t>	sequence;
+		T						item;
+	};
+
+	Slot *					m_slot;
+	uint32_t				m_mask;
+
+	char					m_padding0[64];
+	std::atomic<uint32_t>	m_tail;			// next slot to push into;  shared by the producers
+	char					m_padding1[64];
+	uint32_t				m_head;			// next item to pop;  consumer only
+	char					m_padding2[64];
+
+	vsMPSCQueue( const vsMPSCQueue& other ) = delete;
+	vsMPSCQueue& operator=( const vsMPSCQueue& other ) = delete;
+
+public:
+
+	vsMPSCQueue( int capacity ):
+		m_tail(0),
+		m_head(0)
+	{
+		int size = vsNextPowerOfTwo( vsMax(capacity, 2) );
+		m_slot = new Slot[size];
+		m_mask = size-1;
+		for ( int i = 0; i < size; i++ )
+			m_slot[i].sequence.store( i, std::memory_order_relaxed );
+	}
+
+	~vsMPSCQueue()
+	{
+		vsDeleteArray( m_slot );
+	}
+
+	int		GetCapacity() const { return m_mask+1; }
+
+	// Any thread.
+	bool	TryPush( const T& item )
+	{
+		uint32_t tail = m_tail.load( std::memory_order_relaxed );
+		while(1)
+		{
+			Slot &slot = m_slot[tail & m_mask];
+			int32_t diff = (int32_t)( slot.sequence.load( std::memory_order_acquire ) - tail );
+			if ( diff == 0 )
+			{
+				// slot is free;  try to claim it.
+				if ( m_tail.compare_exchange_weak( tail, tail+1, std::memory_order_relaxed ) )
+				{
+					slot.item = item;
+					slot.sequence.store( tail+1, std::memory_order_release );
+					return true;
+				}
+				// somebody else claimed it first, and 'tail' now holds the new value.
+			}
+			else if ( diff < 0 )
+			{
+				// slot still holds an item from one lap ago;  we're full.
+				return false;
+			}
+			else
+			{
+				tail = m_tail.load( std::memory_order_relaxed );
+			}
+		}
+	}
+
+	// Consumer thread only.  Note that items are popped in the order their
+	// slots were claimed, so a producer which has claimed a slot but not yet
+	// filled it will hold up the items behind it until it does.
+	bool	TryPop( T& item )
+	{
+		Slot &slot = m_slot[m_head & m_mask];
+		if ( slot.sequence.load( std::memory_order_acquire ) != m_head+1 )
+			return false;
+		item = std::move( slot.item );
+		slot.sequence.store( m_head + m_mask + 1, std::memory_order_release );
+		m_head++;
+		return true;
+	}
+};
+
+#endif // VS_LOCKFREEQUEUE_H
+
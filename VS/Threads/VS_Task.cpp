@@ -8,19 +8,19 @@
 
 #include "VS_Task.h"
 #include <SDL2/SDL_thread.h>
-#include <map>
 
 namespace
 {
-	std::map<SDL_threadID, int> s_threadTable;
-	int s_nextId = 0;
+	// Each thread learns its own id when it starts, so looking it up never
+	// needs to touch anything shared with other threads.
+	thread_local int s_threadId = -1;
+	std::atomic<int> s_nextId(0);
 };
 
 void vsTask_Init()
 {
 	// register the main thread so we recognise it in future
-	SDL_threadID id = SDL_ThreadID();
-	s_threadTable[id] = s_nextId++;
+	s_threadId = s_nextId++;
 }
 
 int vsTask::DoStartThread(void* arg)
@@ -28,13 +28,10 @@ int vsTask::DoStartThread(void* arg)
 	int result = 0;
 	vsTask *task = (vsTask*)arg;
 
-	SDL_threadID id = SDL_ThreadID();
-	s_threadTable[id] = s_nextId++;
+	s_threadId = s_nextId++;
 
-	task->m_done = false;
 	result = task->Run();
 	task->m_done = true;
-	task->m_thread = 0L;
 
 	return result;
 }
@@ -48,9 +45,13 @@ vsTask::vsTask( const vsString& name ):
 
 vsTask::~vsTask()
 {
-	if ( !m_done && m_thread != 0 )
+	if ( m_thread != 0 )
 	{
-		SDL_DetachThread(m_thread);
+		// if the thread has already finished, this just cleans it up.
+		if ( m_done )
+			SDL_WaitThread(m_thread, nullptr);
+		else
+			SDL_DetachThread(m_thread);
 		m_thread = 0;
 	}
 }
@@ -61,14 +62,19 @@ vsTask::Start()
 	m_thread = SDL_CreateThread( DoStartThread, m_name.c_str(), (void*)this );
 }
 
-int
-vsTask::GetCurrentThreadId()
+void
+vsTask::Join()
 {
-	SDL_threadID id = SDL_ThreadID();
-	if ( s_threadTable.find(id) != s_threadTable.end() )
+	if ( m_thread != 0 )
 	{
-		return s_threadTable[id];
+		SDL_WaitThread(m_thread, nullptr);
+		m_thread = 0;
 	}
-	return -1;
+}
+
+int
+vsTask::GetCurrentThreadId()
+{
+	return s_threadId;
 }
 
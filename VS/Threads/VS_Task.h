@@ -9,6 +9,8 @@
 #ifndef VS_TASK_H
 #define VS_TASK_H
 
+#include <atomic>
+
 struct SDL_Thread;
 
 void vsTask_Init();
@@ -17,7 +19,7 @@ class vsTask
 {
 	SDL_Thread *m_thread;
 	vsString m_name;
-	bool m_done;
+	std::atomic<bool> m_done;
 
 	static int DoStartThread(void* arg);
 
@@ -36,6 +38,9 @@ public:
 	void Start();
 	bool IsDone() { return m_done; }
 
+	// Blocks until the thread's Run() function has returned.
+	void Join();
+
 	static int GetCurrentThreadId();
 };
 
@@ -139,8 +139,9 @@ void handler(int sig) {
 			fprintf(stderr, "Caught %d\n", sig);
 			break;
 	}
-	// print out all the frames to stderr
-
+	// get out any log messages which are still queued up, then print out
+	// all the frames to stderr
+	vsLog_CrashFlush();
 	vsBacktrace();
 	exit(1);
 }
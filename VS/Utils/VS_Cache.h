@@ -10,7 +10,7 @@
 #ifndef VS_CACHE_H
 #define VS_CACHE_H
 
-// #include "VS_HashTable.h"
+#include "VS/Utils/VS_HashTable.h"
 #include "VS/Utils/VS_Singleton.h"
 #include "VS/Utils/VS_Debug.h"
 
@@ -79,15 +79,11 @@ public:
 	vsString			m_key;
 	uint32_t				m_keyHash;
 
-	vsCacheEntry<T> *	m_next;
+	vsCacheEntry() { m_item = nullptr; m_key = vsEmptyString; m_keyHash = 0; }
+	vsCacheEntry( T * object, const vsString &key, int keyHash ) { m_item = object; m_key = key; m_keyHash = keyHash; }
 
-	vsCacheEntry() { m_item = nullptr; m_key = vsEmptyString; m_keyHash = 0; m_next = nullptr; }
-	vsCacheEntry( T * object, const vsString &key, int keyHash ) { m_item = object; m_key = key; m_keyHash = keyHash, m_next = nullptr; }
-
-	~vsCacheEntry()
-	{
-		vsDelete( m_item );
-	}
+	// Entries get moved around inside the table, so they don't own their
+	// item;  vsCache deletes items itself as it removes their entries.
 
 	T *		GetItem()		{ return m_item; }
 };
@@ -96,107 +92,61 @@ template <typename T>
 class vsCache : public vsSingleton< vsCache<T> >
 {
 protected:
-	vsCacheEntry<T>		*m_bucket;
-	int					m_bucketCount;
+	vsOpenHashTable< vsCacheEntry<T> >	m_table;
 
-	// we're going to need to shift our results to the right to give ourselves
-	// the right number of bits to index into a bucket.  Our hashes are 32-bit,
-	// so if we have two buckets, we need to shift right by 31 bits.  If we have
-	// four buckets, we need to shift right by 30 bits.  And so on.
-	int					m_shift;
-
-	uint32_t HashToBucket(uint32_t hash)
-	{
-		// Fibonocci hash.  We're going to multiply by
-		// (uint32_t::max / golden_ratio) (adjusted to be odd),
-		// and then shift down to produce the right number of bits.
-		//
-		const uint32_t factor = 2654435839U;
-		return (hash * factor) >> m_shift;
-	}
-
-	vsCacheEntry<T>*		FindHashEntry( const vsString &key )
+	int		FindSlot( const vsString &key ) const
 	{
 		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = HashToBucket(hash);
-
-		vsCacheEntry<T> *ent = m_bucket[bucket].m_next;
-		while( ent )
-		{
-			if ( ent->m_keyHash == hash && ent->m_key == key )
-			{
-				return ent;
-			}
-			ent = ent->m_next;
-		}
-		return nullptr;
+		return m_table.Find( hash, [&key]( const vsCacheEntry<T>& ent )
+				{
+					return ent.m_key == key;
+				});
 	}
 
-
 	void	Remove( T* item )
 	{
-		vsString &key = item->GetName();
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = HashToBucket(hash);
-
-		vsCacheEntry<T> *ent = &m_bucket[bucket];
-		while( ent->m_next )
+		int slot = FindSlot( item->GetName() );
+		if ( slot >= 0 )
 		{
-			if ( ent->m_next->m_keyHash == hash && ent->m_next->m_key == key )
-			{
-				vsCacheEntry<T> *toDelete = ent->m_next;
-				ent->m_next = toDelete->m_next;
-				vsDelete( toDelete );
-				break;
-			}
+			vsDelete( m_table.GetSlot(slot).m_item );
+			m_table.Erase( slot );
 		}
 	}
 
+	// The returned entry is only valid until the next Add or Remove.
 	vsCacheEntry<T> *	Find( const vsString &key )
 	{
-		vsCacheEntry<T> *ent = FindHashEntry(key);
-		if ( ent )
+		int slot = FindSlot(key);
+		if ( slot >= 0 )
 		{
-			return ent;
+			return &m_table.GetSlot(slot);
 		}
 		return nullptr;
 	}
 
 public:
 
-	vsCache(int bucketCount)
+	// 'bucketCount' is now just the initial capacity;  the table grows as
+	// needed.
+	vsCache(int bucketCount):
+		m_table(bucketCount)
 	{
-		m_bucketCount = vsNextPowerOfTwo(bucketCount);
-		m_shift = 32 - vsHighBitPosition(m_bucketCount);
-
-		m_bucket = new vsCacheEntry<T>[m_bucketCount];
 	}
 
 	~vsCache()
 	{
-		for ( int i = 0; i < m_bucketCount; i++ )
+		for ( int i = 0; i < m_table.SlotCount(); i++ )
 		{
-			while ( m_bucket[i].m_next )
-			{
-				vsCacheEntry<T> *toDelete = m_bucket[i].m_next;
-				m_bucket[i].m_next = toDelete->m_next;
-
-				vsDelete( toDelete );
-			}
+			if ( m_table.IsSlotUsed(i) )
+				vsDelete( m_table.GetSlot(i).m_item );
 		}
-		vsDeleteArray( m_bucket );
 	}
 
 	void	Add( T* item )
 	{
 		const vsString &key = item->GetName();
 		uint32_t hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		vsCacheEntry<T> *ent = new vsCacheEntry<T>( item, key, hash );
-
-		int bucket = HashToBucket(hash);
-
-		ent->m_next = m_bucket[bucket].m_next;
-		m_bucket[bucket].m_next = ent;
+		m_table.Insert( hash, vsCacheEntry<T>( item, key, hash ) );
 	}
 
 	T *	Get( const vsString &name )
@@ -210,14 +160,14 @@ public:
 		{
 			T *object = new T(name);
 			Add( object );
-			return Get( name );
+			return object;
 		}
 	}
 
 	// returns true if we have this item in the cache, false otherwise.
 	bool Exists( const vsString &name )
 	{
-		return (nullptr != Find( name ));
+		return (FindSlot( name ) >= 0);
 	}
 
 	void	Release( T* object )
@@ -226,7 +176,7 @@ public:
 		vsAssert(ce, "Error:  released object wasn't actually in cache??");
 		if ( ce )
 		{
-			ce->ReleaseReference();
+			ce->m_item->ReleaseReference();
 
 			if ( ce->m_item->IsTransient() &&
 					ce->m_item->GetReferenceCount() == 0 )
@@ -238,34 +188,23 @@ public:
 
 	void	CollectGarbage()
 	{
-		for ( int i = 0; i < m_bucketCount; i++ )
+		int slot = 0;
+		while ( slot < m_table.SlotCount() )
 		{
-			vsCacheEntry<T> *ent = &m_bucket[i];
-			while( ent->m_next )
+			// Erasing a slot pulls the following entries back into it, so
+			// only move on once we've kept whatever is in this slot.
+			if ( m_table.IsSlotUsed(slot) &&
+					m_table.GetSlot(slot).m_item->GetReferenceCount() == 0 )
 			{
-				vsCacheEntry<T> *toDelete = ent->m_next;
-				if ( toDelete->m_item->GetReferenceCount() == 0 )
-				{
-					ent->m_next = toDelete->m_next;
-
-					vsDelete( toDelete );
-				}
-				else
-				{
-					ent = ent->m_next;
-				}
+				vsDelete( m_table.GetSlot(slot).m_item );
+				m_table.Erase( slot );
+			}
+			else
+			{
+				slot++;
 			}
 		}
 	}
-
-	/*
-	void	Add( T* object )
-	{
-		vsCacheEntry<T> *ce = m_table.FindItem( object->GetName() );
-		vsAssert(!ce, "Error:  released object wasn't actually in cache??");
-
-		m_table.AddItemWithKey( new vsCacheEntry<T>(object), object->GetName() );
-	}*/
 };
 
 #endif // VS_CACHE_H
@@ -14,6 +14,7 @@
 #include "VS_TextureManager.h"
 #include "VS_TextureInternal.h"
 #include "VS_RenderTarget.h"
+#include "VS_RenderThread.h"
 
 #include "VS_File.h"
 #include "VS_Store.h"
@@ -42,6 +43,10 @@ vsFloatImage::vsFloatImage(unsigned int width, unsigned int height):
 }
 
 vsFloatImage::vsFloatImage( const vsString &filename ):
+	m_pixel(nullptr),
+	m_pixelCount(0),
+	m_width(0),
+	m_height(0),
 	m_pbo(0),
 	m_sync(0)
 {
@@ -53,11 +58,14 @@ vsFloatImage::vsFloatImage( const vsString &filename ):
 
 	int w,h,n;
 	unsigned char* data = stbi_load_from_memory( (uint8_t*)s->GetReadHead(), s->BytesLeftForReading(), &w, &h, &n, STBI_rgb_alpha );
-	if ( !data )
-		vsLog( "Failure: %s", stbi_failure_reason() );
-
 	vsDelete(s);
 
+	if ( !data )
+	{
+		vsLog( "Image load failure: %s", stbi_failure_reason() );
+		return;
+	}
+
 	m_width = w;
 	m_height = h;
 
@@ -107,6 +115,8 @@ vsFloatImage::~vsFloatImage()
 void
 vsFloatImage::Read( vsTexture *texture )
 {
+	vsRenderThread::Sync();
+
 	// GL_CHECK_SCOPED("vsFloatImage");
 
 	if ( m_width != (unsigned int)texture->GetResource()->GetWidth() ||
@@ -163,6 +173,8 @@ vsFloatImage::Read( vsTexture *texture )
 void
 vsFloatImage::AsyncRead( vsTexture *texture )
 {
+	vsRenderThread::Sync();
+
 	// GL_CHECK_SCOPED("AsyncRead");
 	if ( m_pbo == 0 )
 		glGenBuffers(1, &m_pbo);
@@ -197,6 +209,8 @@ vsFloatImage::AsyncRead( vsTexture *texture )
 void
 vsFloatImage::AsyncReadRenderTarget(vsRenderTarget *target, int buffer)
 {
+	vsRenderThread::Sync();
+
 	if ( m_pbo == 0 )
 		glGenBuffers(1, &m_pbo);
 	else
@@ -42,6 +42,8 @@ public:
     vsFloatImage( vsTexture *texture );
 	~vsFloatImage();
 
+	bool			IsOK() const { return m_pixel != nullptr; }
+
 	int				GetWidth() const { return m_width; }
 	int				GetHeight() const { return m_height; }
 
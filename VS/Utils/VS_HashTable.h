@@ -12,6 +12,10 @@
 
 #include "VS/Utils/VS_Debug.h"
 #include "VS/Math/VS_Math.h"
+#include "VS/Utils/VS_OpenHashTable.h"
+
+#include <string.h>
+#include <string_view>
 
 uint32_t vsCalculateHash(const char * data, uint32_t len);
 
@@ -23,198 +27,100 @@ public:
 	vsString			m_key;
 	uint32_t				m_keyHash;
 
-	vsHashEntry<T> *	m_next;
-
-	vsHashEntry(): m_key() { m_keyHash = 0, m_next = nullptr; }
-	vsHashEntry( const T &t, const vsString &key, int keyHash ) : m_item(t) { m_key = key; m_keyHash = keyHash, m_next = nullptr; }
-	vsHashEntry( const vsHashEntry& o ) :
-		m_item(o.m_item),
-		m_key(o.m_key),
-		m_keyHash(o.m_keyHash),
-		m_next(nullptr)
-	{
-		if ( o.m_next )
-			m_next = new vsHashEntry<T>( *o.m_next );
-	}
+	vsHashEntry(): m_key() { m_keyHash = 0; }
+	vsHashEntry( const T &t, const vsString &key, int keyHash ) : m_item(t) { m_key = key; m_keyHash = keyHash; }
 };
 
 template <typename T>
 class vsHashTable
 {
-	vsHashEntry<T>		*m_bucket;
-	int					m_bucketCount;
+	vsOpenHashTable< vsHashEntry<T> >	m_table;
 
-	// we're going to need to shift our results to the right to give ourselves
-	// the right number of bits to index into a bucket.  Our hashes are 32-bit,
-	// so if we have two buckets, we need to shift right by 31 bits.  If we have
-	// four buckets, we need to shift right by 30 bits.  And so on.
-	int					m_shift;
-
-	uint32_t HashToBucket(uint32_t hash) const
+	// Keys may be looked up as any string-ish type;  we compare the raw
+	// characters instead of building a temporary vsString.
+	int		FindSlot( const char *key, size_t length ) const
 	{
-		// Fibonocci hash.  We're going to multiply by
-		// (uint32_t::max / golden_ratio) (adjusted to be odd),
-		// and then shift down to produce the right number of bits.
-		//
-		const uint32_t factor = 2654435839U;
-		return (hash * factor) >> m_shift;
+		uint32_t  hash = vsCalculateHash(key, (uint32_t)length);
+		return m_table.Find( hash, [&]( const vsHashEntry<T>& ent )
+				{
+					return ent.m_key.length() == length &&
+						memcmp( ent.m_key.data(), key, length ) == 0;
+				});
 	}
 
-	const vsHashEntry<T>*		FindHashEntry( const vsString &key ) const
+	const T *		FindItem( const char *key, size_t length ) const
 	{
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = HashToBucket(hash);
-
-		vsHashEntry<T> *ent = m_bucket[bucket].m_next;
-		while( ent )
+		int slot = FindSlot(key, length);
+		if ( slot >= 0 )
 		{
-			if ( ent->m_keyHash == hash && ent->m_key == key )
-			{
-				return ent;
-			}
-			ent = ent->m_next;
+			return &m_table.GetSlot(slot).m_item;
 		}
 		return nullptr;
 	}
 
-	vsHashEntry<T>*		FindHashEntry( const vsString &key )
+	T *		FindItem( const char *key, size_t length )
 	{
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = HashToBucket(hash);
-
-		vsHashEntry<T> *ent = m_bucket[bucket].m_next;
-		while( ent )
+		int slot = FindSlot(key, length);
+		if ( slot >= 0 )
 		{
-			if ( ent->m_keyHash == hash && ent->m_key == key )
-			{
-				return ent;
-			}
-			ent = ent->m_next;
+			return &m_table.GetSlot(slot).m_item;
 		}
 		return nullptr;
 	}
 
 public:
 
-	vsHashTable(int bucketCount)
+	// 'bucketCount' is now just the initial capacity;  the table grows as
+	// needed.
+	vsHashTable(int bucketCount):
+		m_table(bucketCount)
 	{
-		m_bucketCount = vsNextPowerOfTwo(bucketCount);
-		m_shift = 32 - vsHighBitPosition(m_bucketCount);
-
-		m_bucket = new vsHashEntry<T>[m_bucketCount];
-	}
-
-	vsHashTable(const vsHashTable& other):
-		m_bucketCount( other.m_bucketCount ),
-		m_shift( other.m_shift )
-	{
-		m_bucket = new vsHashEntry<T>[m_bucketCount];
-		for ( int i = 0; i < m_bucketCount; i++ )
-		{
-			if ( other.m_bucket[i].m_next )
-				m_bucket[i].m_next = new vsHashEntry<T>(*other.m_bucket[i].m_next);
-		}
-	}
-
-	~vsHashTable()
-	{
-		Clear();
-		vsDeleteArray( m_bucket );
 	}
 
 	void Clear()
 	{
-		for ( int i = 0; i < m_bucketCount; i++ )
-		{
-			while ( m_bucket[i].m_next )
-			{
-				vsHashEntry<T> *toDelete = m_bucket[i].m_next;
-				m_bucket[i].m_next = toDelete->m_next;
-
-				vsDelete( toDelete );
-			}
-		}
+		m_table.Clear();
 	}
 
 	void	AddItemWithKey( const T &item, const vsString &key )
 	{
 		uint32_t hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		vsHashEntry<T> *ent = new vsHashEntry<T>( item, key, hash );
-
-		int bucket = HashToBucket(hash);
-
-		ent->m_next = m_bucket[bucket].m_next;
-		m_bucket[bucket].m_next = ent;
+		m_table.Insert( hash, vsHashEntry<T>( item, key, hash ) );
 	}
 
 	void	RemoveItemWithKey( const T &item, const vsString &key )
 	{
 		// [TODO] We should verify that the element we remove is actually this item!
 		UNUSED(item);
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = HashToBucket(hash);
-		bool found = false;
-
-		vsHashEntry<T> *ent = &m_bucket[bucket];
-		while( ent->m_next )
-		{
-			if ( ent->m_next->m_keyHash == hash && ent->m_next->m_key == key )
-			{
-				vsHashEntry<T> *toDelete = ent->m_next;
-				ent->m_next = toDelete->m_next;
-				found = true;
-
-				vsDelete( toDelete );
-				break;
-			}
-			ent = ent->m_next;
-		}
-		vsAssert(found, "Error: couldn't find key??");
+		int slot = FindSlot(key.c_str(), key.length());
+		vsAssert(slot >= 0, "Error: couldn't find key??");
+		if ( slot >= 0 )
+			m_table.Erase(slot);
 	}
 
-	const T *		FindItem( const vsString &key ) const
-	{
-		const vsHashEntry<T> *ent = FindHashEntry(key);
-		if ( ent )
-		{
-			return &ent->m_item;
-		}
-		return nullptr;
-	}
+	// Pointers returned from FindItem are only valid until the next time
+	// an item is added to or removed from the table.
+	const T *		FindItem( const vsString &key ) const { return FindItem( key.c_str(), key.length() ); }
+	const T *		FindItem( const char *key ) const { return FindItem( key, strlen(key) ); }
+	const T *		FindItem( std::string_view key ) const { return FindItem( key.data(), key.length() ); }
 
-	T *		FindItem( const vsString &key )
-	{
-		vsHashEntry<T> *ent = FindHashEntry(key);
-		if ( ent )
-		{
-			return &ent->m_item;
-		}
-		return nullptr;
-	}
+	T *		FindItem( const vsString &key ) { return FindItem( key.c_str(), key.length() ); }
+	T *		FindItem( const char *key ) { return FindItem( key, strlen(key) ); }
+	T *		FindItem( std::string_view key ) { return FindItem( key.data(), key.length() ); }
 
 	T& operator[]( const vsString& key )
 	{
 		T* result = FindItem(key);
 		if ( result )
 			return *result;
-		T newItem;
-		AddItemWithKey( newItem, key );
-		return *FindItem(key);
+		uint32_t hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
+		int slot = m_table.Insert( hash, vsHashEntry<T>( T(), key, hash ) );
+		return m_table.GetSlot(slot).m_item;
 	}
 
 	int GetHashEntryCount() const
 	{
-		int count = 0;
-		for ( int i = 0; i < m_bucketCount; i++ )
-		{
-			vsHashEntry<T>* shuttle = m_bucket[i].m_next;
-			while ( shuttle )
-			{
-				count++;
-				shuttle = shuttle->m_next;
-			}
-		}
-		return count;
+		return m_table.Count();
 	}
 
 	// This 'i' value is NOT CONSTANT.  As things are added and removed
@@ -223,15 +129,13 @@ public:
 	const vsHashEntry<T>* GetHashEntry(int i) const
 	{
 		int count = i;
-		for ( int i = 0; i < m_bucketCount; i++ )
+		for ( int slot = 0; slot < m_table.SlotCount(); slot++ )
 		{
-			vsHashEntry<T>* shuttle = m_bucket[i].m_next;
-			while ( shuttle )
+			if ( m_table.IsSlotUsed(slot) )
 			{
 				if ( count == 0 )
-					return shuttle;
+					return &m_table.GetSlot(slot);
 				count--;
-				shuttle = shuttle->m_next;
 			}
 		}
 		return nullptr;
@@ -239,23 +143,15 @@ public:
 
 	bool operator==( const vsHashTable<T>& other ) const
 	{
-		if ( m_bucketCount != other.m_bucketCount )
+		if ( m_table.Count() != other.m_table.Count() )
 			return false;
-		for ( int i = 0; i < m_bucketCount; i++ )
+		for ( int slot = 0; slot < m_table.SlotCount(); slot++ )
 		{
-			vsHashEntry<T>* shuttle = m_bucket[i].m_next;
-			vsHashEntry<T>* oshuttle = other.m_bucket[i].m_next;
-			while( shuttle && oshuttle )
-			{
-				if ( shuttle->m_item != oshuttle->m_item ||
-						shuttle->m_key != oshuttle->m_key )
-					return false;
-				shuttle = shuttle->m_next;
-				oshuttle = oshuttle->m_next;
-			}
-			// now if we didn't reach the end of the bucket at the same time on
-			// both, that's also a failure
-			if ( shuttle || oshuttle )
+			if ( !m_table.IsSlotUsed(slot) )
+				continue;
+			const vsHashEntry<T>& ent = m_table.GetSlot(slot);
+			const T* otherItem = other.FindItem( ent.m_key );
+			if ( !otherItem || ent.m_item != *otherItem )
 				return false;
 		}
 		return true;
@@ -21,130 +21,79 @@ public:
 	vsString			m_key;
 	uint32_t				m_keyHash;
 
-	vsHashStoreEntry<T> *	m_next;
-
-	vsHashStoreEntry() : m_item(nullptr) { m_key = vsEmptyString; m_keyHash = 0, m_next = nullptr; }
-	vsHashStoreEntry( T *t, const vsString &key, int keyHash ) : m_item(t) { m_key = key; m_keyHash = keyHash, m_next = nullptr; }
+	vsHashStoreEntry() : m_item(nullptr) { m_key = vsEmptyString; m_keyHash = 0; }
+	vsHashStoreEntry( T *t, const vsString &key, int keyHash ) : m_item(t) { m_key = key; m_keyHash = keyHash; }
 };
 
 template <typename T>
 class vsHashTableStore
 {
-	vsHashStoreEntry<T>		*m_bucket;
-	int					m_bucketCount;
+	vsOpenHashTable< vsHashStoreEntry<T> >	m_table;
 
-	vsHashStoreEntry<T>*		FindHashEntry( const vsString &key )
+	int		FindSlot( const vsString &key ) const
 	{
 		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = hash % m_bucketCount;
-
-		vsHashStoreEntry<T> *ent = m_bucket[bucket].m_next;
-		while( ent )
-		{
-			if ( ent->m_keyHash == hash && ent->m_key == key )
-			{
-				return ent;
-			}
-			ent = ent->m_next;
-		}
-		return nullptr;
+		return m_table.Find( hash, [&key]( const vsHashStoreEntry<T>& ent )
+				{
+					return ent.m_key == key;
+				});
 	}
 
-	const vsHashStoreEntry<T>*		FindHashEntry( const vsString &key ) const
-	{
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = hash % m_bucketCount;
-
-		vsHashStoreEntry<T> *ent = m_bucket[bucket].m_next;
-		while( ent )
-		{
-			if ( ent->m_keyHash == hash && ent->m_key == key )
-			{
-				return ent;
-			}
-			ent = ent->m_next;
-		}
-		return nullptr;
-	}
+	// the store owns its items, so it mustn't be copied.
+	vsHashTableStore( const vsHashTableStore& other );
+	vsHashTableStore& operator=( const vsHashTableStore& other );
 
 public:
 
-	vsHashTableStore(int bucketCount)
+	vsHashTableStore(int bucketCount):
+		m_table(bucketCount)
 	{
-		m_bucketCount = bucketCount;
-
-		m_bucket = new vsHashStoreEntry<T>[m_bucketCount];
 	}
 
 	~vsHashTableStore()
 	{
-		for ( int i = 0; i < m_bucketCount; i++ )
+		for ( int i = 0; i < m_table.SlotCount(); i++ )
 		{
-			while ( m_bucket[i].m_next )
-			{
-				vsHashStoreEntry<T> *toDelete = m_bucket[i].m_next;
-				m_bucket[i].m_next = toDelete->m_next;
-
-				vsDelete( toDelete->m_item );
-				vsDelete( toDelete );
-			}
+			if ( m_table.IsSlotUsed(i) )
+				vsDelete( m_table.GetSlot(i).m_item );
 		}
-		vsDeleteArray( m_bucket );
 	}
 
 	void	AddItemWithKey( T* item, const vsString &key )
 	{
 		uint32_t hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		vsHashStoreEntry<T> *ent = new vsHashStoreEntry<T>( item, key, hash );
-
-		int bucket = hash % m_bucketCount;
-
-		ent->m_next = m_bucket[bucket].m_next;
-		m_bucket[bucket].m_next = ent;
+		m_table.Insert( hash, vsHashStoreEntry<T>( item, key, hash ) );
 	}
 
 	void	RemoveItemWithKey( T* item, const vsString &key )
 	{
 		// [TODO] We should be testing that the object we're removing is actually this item!
 		UNUSED(item);
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = hash % m_bucketCount;
-		bool found = false;
-
-		vsHashStoreEntry<T> *ent = &m_bucket[bucket];
-		while( ent->m_next )
+		int slot = FindSlot(key);
+		vsAssert(slot >= 0, "Error: couldn't find key??");
+		if ( slot >= 0 )
 		{
-			if ( ent->m_next->m_keyHash == hash && ent->m_next->m_key == key )
-			{
-				vsHashStoreEntry<T> *toDelete = ent->m_next;
-				ent->m_next = toDelete->m_next;
-				found = true;
-
-				vsDelete( toDelete->m_item );
-				vsDelete( toDelete );
-				break;
-			}
-			ent = ent->m_next;
+			vsDelete( m_table.GetSlot(slot).m_item );
+			m_table.Erase(slot);
 		}
-		vsAssert(found, "Error: couldn't find key??");
 	}
 
 	T *		FindItem( const vsString &key )
 	{
-		vsHashStoreEntry<T> *ent = FindHashEntry(key);
-		if ( ent )
+		int slot = FindSlot(key);
+		if ( slot >= 0 )
 		{
-			return ent->m_item;
+			return m_table.GetSlot(slot).m_item;
 		}
 		return nullptr;
 	}
 
 	const T *		FindItem( const vsString &key ) const
 	{
-		const vsHashStoreEntry<T> *ent = FindHashEntry(key);
-		if ( ent )
+		int slot = FindSlot(key);
+		if ( slot >= 0 )
 		{
-			return ent->m_item;
+			return m_table.GetSlot(slot).m_item;
 		}
 		return nullptr;
 	}
@@ -14,6 +14,7 @@
 #include "VS_TextureManager.h"
 #include "VS_TextureInternal.h"
 #include "VS_RenderTarget.h"
+#include "VS_RenderThread.h"
 
 #include "VS_File.h"
 #include "VS_Store.h"
@@ -162,6 +163,8 @@ vsImage::ReadFromFileData( const vsStore &filedata )
 void
 vsImage::Read( vsTexture *texture )
 {
+	vsRenderThread::Sync();
+
 	// GL_CHECK_SCOPED("vsImage");
 
 	if ( m_width != (unsigned int)texture->GetResource()->GetWidth() ||
@@ -255,6 +258,8 @@ vsImage::PrepForAsyncRead( vsTexture *texture )
 void
 vsImage::AsyncRead( vsTexture *texture )
 {
+	vsRenderThread::Sync();
+
 	PrepForAsyncRead(texture);
 
 	if ( m_sync != 0 )
@@ -277,6 +282,8 @@ vsImage::AsyncRead( vsTexture *texture )
 void
 vsImage::AsyncReadRenderTarget(vsRenderTarget *target, int buffer)
 {
+	vsRenderThread::Sync();
+
 	GL_CHECK_SCOPED("AsyncReadRenderTarget");
 	PrepForAsyncRead(target->Resolve(0));
 	GL_CHECK("Prepped");
@@ -12,6 +12,7 @@
 
 #include "VS/Utils/VS_Debug.h"
 #include "VS/Math/VS_Math.h"
+#include "VS/Utils/VS_OpenHashTable.h"
 
 uint32_t vsCalculateIntHash(uint32_t key);
 
@@ -22,149 +23,70 @@ public:
 	T					m_item;
 	uint32_t			m_key;
 
-	vsIntHashEntry<T> *	m_next;
-
-	vsIntHashEntry(): m_key(0), m_next(nullptr) {}
-	vsIntHashEntry( const T &t, uint32_t key ) : m_item(t), m_key(key), m_next(nullptr) {}
+	vsIntHashEntry(): m_key(0) {}
+	vsIntHashEntry( const T &t, uint32_t key ) : m_item(t), m_key(key) {}
 };
 
 template <typename T>
 class vsIntHashTable
 {
-	vsIntHashEntry<T>		*m_bucket;
-	int					m_bucketCount;
-
-	// we're going to need to shift our results to the right to give ourselves
-	// the right number of bits to index into a bucket.  Our hashes are 32-bit,
-	// so if we have two buckets, we need to shift right by 31 bits.  If we have
-	// four buckets, we need to shift right by 30 bits.  And so on.
-	int					m_shift;
-
-	uint32_t HashToBucket(uint32_t hash) const
-	{
-		// Fibonocci hash.  We're going to multiply by
-		// (uint32_t::max / golden_ratio) (adjusted to be odd),
-		// and then shift down to produce the right number of bits.
-		//
-		const uint32_t factor = 2654435839U;
-		return (hash * factor) >> m_shift;
-	}
-
-	const vsIntHashEntry<T>*		FindHashEntry(uint32_t key) const
-	{
-		uint32_t  hash = vsCalculateIntHash(key);
-		int bucket = HashToBucket(hash);
-
-		vsIntHashEntry<T> *ent = m_bucket[bucket].m_next;
-		while( ent )
-		{
-			if ( ent->m_key == hash && ent->m_key == key )
-			{
-				return ent;
-			}
-			ent = ent->m_next;
-		}
-		return nullptr;
-	}
+	vsOpenHashTable< vsIntHashEntry<T> >	m_table;
 
-	vsIntHashEntry<T>*		FindHashEntry(uint32_t key)
+	int		FindSlot( uint32_t key ) const
 	{
-		uint32_t  hash = vsCalculateIntHash(key);
-		int bucket = HashToBucket(hash);
-
-		vsIntHashEntry<T> *ent = m_bucket[bucket].m_next;
-		while( ent )
-		{
-			if ( ent->m_key == hash && ent->m_key == key )
-			{
-				return ent;
-			}
-			ent = ent->m_next;
-		}
-		return nullptr;
+		return m_table.Find( vsCalculateIntHash(key), [key]( const vsIntHashEntry<T>& ent )
+				{
+					return ent.m_key == key;
+				});
 	}
 
 public:
 
-	vsIntHashTable(int bucketCount)
+	// 'bucketCount' is now just the initial capacity;  the table grows as
+	// needed.
+	vsIntHashTable(int bucketCount):
+		m_table(bucketCount)
 	{
-		m_bucketCount = vsNextPowerOfTwo(bucketCount);
-		m_shift = 32 - vsHighBitPosition(m_bucketCount);
-
-		m_bucket = new vsIntHashEntry<T>[m_bucketCount];
-	}
-
-	~vsIntHashTable()
-	{
-		Clear();
-		vsDeleteArray( m_bucket );
 	}
 
 	void Clear()
 	{
-		for ( int i = 0; i < m_bucketCount; i++ )
-		{
-			while ( m_bucket[i].m_next )
-			{
-				vsIntHashEntry<T> *toDelete = m_bucket[i].m_next;
-				m_bucket[i].m_next = toDelete->m_next;
-
-				vsDelete( toDelete );
-			}
-		}
+		m_table.Clear();
 	}
 
 	void	AddItemWithKey( const T &item, uint32_t key)
 	{
-		vsIntHashEntry<T> *ent = new vsIntHashEntry<T>( item, key );
-
-		int bucket = HashToBucket(key);
-
-		ent->m_next = m_bucket[bucket].m_next;
-		m_bucket[bucket].m_next = ent;
+		m_table.Insert( vsCalculateIntHash(key), vsIntHashEntry<T>( item, key ) );
 	}
 
 	void	RemoveItemWithKey( const T &item, uint32_t key)
 	{
 		// [TODO] We should really be verifying that this item matches?
 		UNUSED(item);
-		uint32_t  hash = vsCalculateIntHash(key);
-		int bucket = HashToBucket(hash);
-		bool found = false;
-
-		vsIntHashEntry<T> *ent = &m_bucket[bucket];
-		while( ent->m_next )
-		{
-			if ( ent->m_next->m_key == hash && ent->m_next->m_key == key )
-			{
-				vsIntHashEntry<T> *toDelete = ent->m_next;
-				ent->m_next = toDelete->m_next;
-				found = true;
-
-				vsDelete( toDelete );
-				break;
-			}
-			ent = ent->m_next;
-		}
-		vsAssert(found, "Error: couldn't find key??");
+		int slot = FindSlot(key);
+		vsAssert(slot >= 0, "Error: couldn't find key??");
+		if ( slot >= 0 )
+			m_table.Erase(slot);
 	}
 
+	// Pointers returned from FindItem are only valid until the next time
+	// an item is added to or removed from the table.
 	const T *		FindItem( const uint32_t key ) const
 	{
-		const vsIntHashEntry<T> *ent = FindHashEntry(key);
-		if ( ent )
+		int slot = FindSlot(key);
+		if ( slot >= 0 )
 		{
-			return &ent->m_item;
+			return &m_table.GetSlot(slot).m_item;
 		}
 		return nullptr;
 	}
 
 	T *		FindItem( uint32_t key )
 	{
-		vsIntHashEntry<T> *ent = FindHashEntry(key);
-		if ( ent )
+		int slot = FindSlot(key);
+		if ( slot >= 0 )
 		{
-			return &ent->m_item;
+			return &m_table.GetSlot(slot).m_item;
 		}
 		return nullptr;
 	}
@@ -174,24 +96,13 @@ public:
 		T* result = FindItem(key);
 		if ( result )
 			return *result;
-		T newItem;
-		AddItemWithKey( newItem, key );
-		return *FindItem(key);
+		int slot = m_table.Insert( vsCalculateIntHash(key), vsIntHashEntry<T>( T(), key ) );
+		return m_table.GetSlot(slot).m_item;
 	}
 
 	int GetHashEntryCount() const
 	{
-		int count = 0;
-		for ( int i = 0; i < m_bucketCount; i++ )
-		{
-			vsIntHashEntry<T>* shuttle = m_bucket[i].m_next;
-			while ( shuttle )
-			{
-				count++;
-				shuttle = shuttle->m_next;
-			}
-		}
-		return count;
+		return m_table.Count();
 	}
 
 	// This 'i' value is NOT CONSTANT.  As things are added and removed
@@ -200,15 +111,13 @@ public:
 	const vsIntHashEntry<T>* GetHashEntry(int i) const
 	{
 		int count = i;
-		for ( int i = 0; i < m_bucketCount; i++ )
+		for ( int slot = 0; slot < m_table.SlotCount(); slot++ )
 		{
-			vsIntHashEntry<T>* shuttle = m_bucket[i].m_next;
-			while ( shuttle )
+			if ( m_table.IsSlotUsed(slot) )
 			{
 				if ( count == 0 )
-					return shuttle;
+					return &m_table.GetSlot(slot);
 				count--;
-				shuttle = shuttle->m_next;
 			}
 		}
 		return nullptr;
@@ -216,23 +125,15 @@ public:
 
 	bool operator==( const vsIntHashTable<T>& other ) const
 	{
-		if ( m_bucketCount != other.m_bucketCount )
+		if ( m_table.Count() != other.m_table.Count() )
 			return false;
-		for ( int i = 0; i < m_bucketCount; i++ )
+		for ( int slot = 0; slot < m_table.SlotCount(); slot++ )
 		{
-			vsIntHashEntry<T>* shuttle = m_bucket[i].m_next;
-			vsIntHashEntry<T>* oshuttle = other.m_bucket[i].m_next;
-			while( shuttle && oshuttle )
-			{
-				if ( shuttle->m_item != oshuttle->m_item ||
-						shuttle->m_key != oshuttle->m_key )
-					return false;
-				shuttle = shuttle->m_next;
-				oshuttle = oshuttle->m_next;
-			}
-			// now if we didn't reach the end of the bucket at the same time on
-			// both, that's also a failure
-			if ( shuttle || oshuttle )
+			if ( !m_table.IsSlotUsed(slot) )
+				continue;
+			const vsIntHashEntry<T>& ent = m_table.GetSlot(slot);
+			const T* otherItem = other.FindItem( ent.m_key );
+			if ( !otherItem || ent.m_item != *otherItem )
 				return false;
 		}
 		return true;
@@ -18,6 +18,10 @@
 #include "VS_Task.h"
 #include "VS_TimerSystem.h"
 #include "VS_Mutex.h"
+#include "VS_AdaptiveMutex.h"
+#include "VS_LockFreeQueue.h"
+#include "VS_Semaphore.h"
+#include <cstring>
 
 #ifdef MSVC
 #define vsprintf vsprintf_s
@@ -26,6 +30,167 @@
 static FILE* s_logFile = nullptr;
 static vsString prefPath;
 static vsMutex s_mutex;
+
+namespace
+{
+	// A preformatted line waiting to be written out in async mode.  Lines
+	// too long for 'text' get a malloc()ed copy in 'longText' instead;  we
+	// deliberately keep that out of vsHeap, as the writer thread may free it
+	// after the heap which was current when it was logged has gone away.
+	struct LogRecord
+	{
+		char	text[248];
+		char *	longText;
+	};
+
+	const int c_asyncQueueLength = 2048;
+	const uint32_t c_flushIntervalMs = 100;
+
+	class vsLogWriter : public vsTask
+	{
+	protected:
+		virtual int Run();
+	public:
+		std::atomic<bool> m_exit;
+
+		vsLogWriter(): vsTask("Log writer"), m_exit(false) {}
+	};
+
+	std::atomic<bool> s_async(false);
+	vsMPSCQueue<LogRecord> *s_queue = nullptr;
+	vsLogWriter *s_writer = nullptr;
+
+	// only one thread may pop records from 's_queue' at a time.
+	vsAdaptiveMutex s_drainLock;
+
+	// The writer sleeps on 's_wake' when the queue is empty, after raising
+	// 's_writerAsleep' so that the next thread to queue a record knows to
+	// wake it up.  Like 's_queue', it's created the first time we go async
+	// and never destroyed, since a thread which has just pushed a record may
+	// still be about to post to it.
+	vsSemaphore *s_wake = nullptr;
+	std::atomic<bool> s_writerAsleep(false);
+
+	std::atomic<uint32_t> s_droppedCount(0);
+	uint32_t s_reportedDroppedCount = 0;
+
+	bool QueueRecord( const vsString& msg )
+	{
+		LogRecord record;
+		if ( msg.size() < sizeof(record.text) )
+		{
+			memcpy( record.text, msg.c_str(), msg.size()+1 );
+			record.longText = nullptr;
+		}
+		else
+		{
+			record.text[0] = 0;
+			record.longText = (char*)malloc( msg.size()+1 );
+			memcpy( record.longText, msg.c_str(), msg.size()+1 );
+		}
+
+		if ( !s_queue->TryPush( record ) )
+		{
+			free( record.longText );
+			s_droppedCount.fetch_add( 1, std::memory_order_relaxed );
+			return false;
+		}
+
+		// Pairs with the fence in vsLogWriter::Run();  either the writer sees
+		// our record before it sleeps, or we see that it's asleep.
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		if ( s_writerAsleep.load( std::memory_order_relaxed ) &&
+				s_writerAsleep.exchange( false ) )
+			s_wake->Post();
+		return true;
+	}
+
+	// Writes out everything currently queued;  returns how many records that
+	// was.  Caller must hold both 's_drainLock' and 's_mutex'.
+	int WriteQueue()
+	{
+		if ( !s_queue )
+			return 0;
+
+		int count = 0;
+		LogRecord record;
+		while ( s_queue->TryPop( record ) )
+		{
+			const char* text = record.longText ? record.longText : record.text;
+			fputs( text, stdout );
+			if ( s_logFile )
+				fputs( text, s_logFile );
+			free( record.longText );
+			count++;
+		}
+
+		uint32_t dropped = s_droppedCount.load( std::memory_order_relaxed );
+		if ( dropped != s_reportedDroppedCount )
+		{
+			vsString msg = vsFormatString( "vsLog:  Dropped %u messages because the async log queue was full\n", dropped - s_reportedDroppedCount );
+			fputs( msg.c_str(), stdout );
+			if ( s_logFile )
+				fputs( msg.c_str(), s_logFile );
+			s_reportedDroppedCount = dropped;
+			count++;
+		}
+		return count;
+	}
+
+	int DrainQueue()
+	{
+		vsAdaptiveScopedLock drainLock(s_drainLock);
+		vsScopedLock lock(s_mutex);
+		return WriteQueue();
+	}
+
+	void FlushFiles()
+	{
+		vsScopedLock lock(s_mutex);
+		fflush( stdout );
+		if ( s_logFile )
+			fflush( s_logFile );
+	}
+
+	int vsLogWriter::Run()
+	{
+		uint32_t lastFlush = SDL_GetTicks();
+		bool dirty = false;
+		while ( !m_exit.load( std::memory_order_acquire ) )
+		{
+			if ( DrainQueue() )
+			{
+				dirty = true;
+				uint32_t now = SDL_GetTicks();
+				if ( now - lastFlush >= c_flushIntervalMs )
+				{
+					FlushFiles();
+					dirty = false;
+					lastFlush = now;
+				}
+				continue;
+			}
+
+			// Nothing left to write, so flush what we have and sleep until
+			// somebody queues something more.
+			if ( dirty )
+			{
+				FlushFiles();
+				dirty = false;
+				lastFlush = SDL_GetTicks();
+			}
+
+			s_writerAsleep.store( true );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			if ( DrainQueue() )
+				dirty = true;	// queued before we went to sleep
+			else if ( !m_exit.load( std::memory_order_acquire ) )
+				s_wake->Wait();
+			s_writerAsleep.store( false, std::memory_order_relaxed );
+		}
+		return 0;
+	}
+}
 // static PHYSFS_File* s_log = nullptr;
 // static vsFile *s_log = nullptr;
 
@@ -70,7 +235,67 @@ void vsLog_Start(const char* companyName, const char* title)
 
 void vsLog_End()
 {
-	fclose( s_logFile );
+	// Note that we keep 's_queue' and 's_wake' around;  other threads might
+	// still be about to push into them.
+	vsLog_SetAsync(false);
+
+	if ( s_logFile )
+		fclose( s_logFile );
+	s_logFile = nullptr;
+}
+
+void vsLog_SetAsync(bool async)
+{
+	if ( async == s_async.load() )
+		return;
+
+	if ( async )
+	{
+		// allocated from whichever heap is current, so turn async mode on
+		// during startup, not from inside a game's heap.
+		if ( !s_queue )
+			s_queue = new vsMPSCQueue<LogRecord>( c_asyncQueueLength );
+		if ( !s_wake )
+			s_wake = new vsSemaphore(0);
+		s_writer = new vsLogWriter;
+		s_writer->Start();
+		s_async.store( true, std::memory_order_release );
+	}
+	else
+	{
+		s_async.store( false, std::memory_order_release );
+		s_writer->m_exit.store( true, std::memory_order_release );
+		s_wake->Post();
+		s_writer->Join();
+		vsDelete( s_writer );
+		vsLog_Flush();
+	}
+}
+
+void vsLog_Flush()
+{
+	DrainQueue();
+	FlushFiles();
+}
+
+void vsLog_CrashFlush()
+{
+	// We may have crashed while some thread (maybe even this one) held one
+	// of these locks, so we never wait for them.  In sync mode there's
+	// nothing queued, and every line was flushed as it was written.
+	if ( !s_async.load( std::memory_order_acquire ) )
+		return;
+	if ( !s_drainLock.TryLock() )
+		return;
+	if ( s_mutex.TryLock() )
+	{
+		WriteQueue();
+		fflush( stdout );
+		if ( s_logFile )
+			fflush( s_logFile );
+		s_mutex.Unlock();
+	}
+	s_drainLock.Unlock();
 }
 
 void vsLog_Show()
@@ -97,6 +322,12 @@ void vsLog_(const char* file, int line, const vsString &str)
 	int threadId = vsTask::GetCurrentThreadId();
 	vsString msg( vsFormatString( "%d: %fs - %*s:%*d -- %s\n", threadId, time, 25, file, 4,line, str ) );
 
+	if ( s_async.load( std::memory_order_acquire ) )
+	{
+		QueueRecord( msg );
+		return;
+	}
+
 	{
 		vsScopedLock lock(s_mutex);
 
@@ -116,7 +347,7 @@ void vsErrorLog_(const char* file, int line, const vsString &str)
 	if ( vsTimerSystem::Instance() )
 		time = vsTimerSystem::Instance()->GetMicrosecondsSinceLaunch() / 1000000.f;
 
-	for ( const char* ptr = file; *file; ++ptr )
+	for ( const char* ptr = file; *ptr; ++ptr )
 		if ( *ptr == '/' || *ptr == '\\' )
 		{
 			file = ptr+1;
@@ -125,6 +356,11 @@ void vsErrorLog_(const char* file, int line, const vsString &str)
 	int threadId = vsTask::GetCurrentThreadId();
 	vsString msg( vsFormatString( "ERR: %d: %fs - %*s:%*d -- %s\n", threadId, time, 25, file, 4,line, str ) );
 
+	// errors are written straight away, after anything which was logged
+	// before them.
+	if ( s_async.load( std::memory_order_acquire ) )
+		vsLog_Flush();
+
 	{
 		vsScopedLock lock(s_mutex);
 
@@ -12,15 +12,32 @@
 
 // vsLog_Start() creates a file named "log.txt" in our current output directory.
 // All subsequent calls to vsLog() will write out text into that file, in addition
-// to the console.  vsLog_End() closes that file, and stops writing vsLog() messages
-// into it.  vsLog_Show() opens a finder/explorer/etc window in that directory.  We
-// use this when an assert is thrown, so that end-users can more easily find the
-// log file so they can e-mail it to us.  (TODO:  Consider whether we want to set
+// to the console.  vsLog_End() writes out anything still queued, closes that
+// file, and stops writing vsLog() messages into it;  vsSystem calls it during
+// shutdown.  vsLog_Show() opens a finder/explorer/etc window in that directory.
+// We use this when an assert is thrown, so that end-users can more easily find
+// the log file so they can e-mail it to us.  (TODO:  Consider whether we want to set
 // up a system which will cause asserts to submit logs to us anonymously, instead?)
 void vsLog_Start(const char* companyName, const char* title);
 void vsLog_End();
 void vsLog_Show();
 
+// In async mode, vsLog() just formats its message and queues it for a
+// background thread to write out, so callers never wait on the console or on
+// disk.  The log file is flushed every 100ms or so, instead of after every
+// line.  If messages arrive faster than they can be written and the queue
+// fills up, new messages are dropped and a count of them is logged later.
+// Error logs, asserts and crashes flush the queue synchronously first.
+void vsLog_SetAsync(bool async);
+
+// Write out anything queued in async mode, and flush the log file.
+void vsLog_Flush();
+
+// As vsLog_Flush(), but safe to call from a crash handler;  it does nothing
+// unless we're in async mode, and gives up instead of waiting if another
+// thread is busy writing to the log.
+void vsLog_CrashFlush();
+
 #include "Utils/fmt/printf.h"
 #include "Utils/fmt/format.h"
 
@@ -28,7 +45,7 @@ void vsLog_(const char*file, int line, const vsString& str);
 void vsErrorLog_(const char*file, int line, const vsString &str);
 
 #define vsLog(...) vsDoLog(__FILE__,__LINE__,__VA_ARGS__)
-#define vsErrorLog(...) vsDoErrorLog(__FILE__,__LINE__,_VA_ARGS__)
+#define vsErrorLog(...) vsDoErrorLog(__FILE__,__LINE__,__VA_ARGS__)
 
 template <typename S, typename... Args, typename Char = fmt::char_t<S> >
 void vsDoLog(const char* file, int line, S format, Args&&... args)
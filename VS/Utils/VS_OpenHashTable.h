@@ -0,0 +1,237 @@
+/*
+ *  VS_OpenHashTable.h
+ *  VectorStorm
+ *
+ *  Created by agent on 18/10/26.
+ *  Copyright 2026 agent. All rights reserved.
+ *
+ */
+
+#ifndef VS_OPENHASHTABLE_H
+#define VS_OPENHASHTABLE_H
+
+#include "VS/Utils/VS_Debug.h"
+#include "VS/Math/VS_Math.h"
+
+#include <utility>
+
+// vsOpenHashTable is the storage shared by vsHashTable, vsIntHashTable and
+// vsCache.  It's an open-addressing table using Robin Hood hashing:  entries
+// live directly in one flat array, with their hashes stored alongside in a
+// second array so that probing mostly touches just that.  It grows whenever
+// it becomes more than 80% full.
+//
+// It doesn't know anything about keys;  callers give it a hash and a
+// 'matches' functor for each lookup, which lets the wrapper classes look up
+// entries by whatever key type is convenient.
+//
+// Note that entries MOVE AROUND as other entries are added and removed, so
+// pointers into the table are only valid until the next add or remove.
+//
+// 'Entry' must be default-constructible and movable.
+
+template <typename Entry>
+class vsOpenHashTable
+{
+	uint32_t *	m_hash;		// 0 means the slot is empty
+	Entry *		m_entry;
+	int			m_capacity;	// always a power of two
+	int			m_count;
+
+	// we're going to need to shift our results to the right to give ourselves
+	// the right number of bits to index into a slot.  Our hashes are 32-bit,
+	// so if we have two slots, we need to shift right by 31 bits.  If we have
+	// four slots, we need to shift right by 30 bits.  And so on.
+	int			m_shift;
+
+	int IdealSlot( uint32_t hash ) const
+	{
+		// Fibonocci hash.  We're going to multiply by
+		// (uint32_t::max / golden_ratio) (adjusted to be odd),
+		// and then shift down to produce the right number of bits.
+		//
+		const uint32_t factor = 2654435839U;
+		return (int)((hash * factor) >> m_shift);
+	}
+
+	// how far is the entry in 'slot' from where it would ideally be?
+	int ProbeDistance( int slot ) const
+	{
+		return (slot - IdealSlot(m_hash[slot])) & (m_capacity-1);
+	}
+
+	void Allocate( int capacity )
+	{
+		m_capacity = vsMax( 8, vsNextPowerOfTwo(capacity) );
+		m_shift = 32 - vsHighBitPosition(m_capacity);
+		m_hash = new uint32_t[m_capacity];
+		m_entry = new Entry[m_capacity];
+		for ( int i = 0; i < m_capacity; i++ )
+			m_hash[i] = 0;
+		m_count = 0;
+	}
+
+	void Grow()
+	{
+		uint32_t *oldHash = m_hash;
+		Entry *oldEntry = m_entry;
+		int oldCapacity = m_capacity;
+
+		Allocate( oldCapacity * 2 );
+		for ( int i = 0; i < oldCapacity; i++ )
+		{
+			if ( oldHash[i] )
+				Insert( oldHash[i], std::move(oldEntry[i]) );
+		}
+		vsDeleteArray( oldHash );
+		vsDeleteArray( oldEntry );
+	}
+
+public:
+
+	// 0 is reserved to mark empty slots, so all hashes go through here.
+	static uint32_t ValidHash( uint32_t hash ) { return hash ? hash : 1; }
+
+	vsOpenHashTable( int initialCapacity )
+	{
+		Allocate( initialCapacity );
+	}
+
+	vsOpenHashTable( const vsOpenHashTable& other ):
+		m_capacity( other.m_capacity ),
+		m_count( other.m_count ),
+		m_shift( other.m_shift )
+	{
+		m_hash = new uint32_t[m_capacity];
+		m_entry = new Entry[m_capacity];
+		for ( int i = 0; i < m_capacity; i++ )
+		{
+			m_hash[i] = other.m_hash[i];
+			if ( m_hash[i] )
+				m_entry[i] = other.m_entry[i];
+		}
+	}
+
+	vsOpenHashTable& operator=( const vsOpenHashTable& other )
+	{
+		if ( this != &other )
+		{
+			vsOpenHashTable copy(other);
+			std::swap( m_hash, copy.m_hash );
+			std::swap( m_entry, copy.m_entry );
+			std::swap( m_capacity, copy.m_capacity );
+			std::swap( m_count, copy.m_count );
+			std::swap( m_shift, copy.m_shift );
+		}
+		return *this;
+	}
+
+	~vsOpenHashTable()
+	{
+		vsDeleteArray( m_hash );
+		vsDeleteArray( m_entry );
+	}
+
+	void Clear()
+	{
+		for ( int i = 0; i < m_capacity; i++ )
+		{
+			if ( m_hash[i] )
+			{
+				m_hash[i] = 0;
+				m_entry[i] = Entry();
+			}
+		}
+		m_count = 0;
+	}
+
+	int Count() const { return m_count; }
+
+	// Slots may be walked directly, for iterating over every entry.
+	int SlotCount() const { return m_capacity; }
+	bool IsSlotUsed( int slot ) const { return m_hash[slot] != 0; }
+	uint32_t GetSlotHash( int slot ) const { return m_hash[slot]; }
+	Entry& GetSlot( int slot ) { return m_entry[slot]; }
+	const Entry& GetSlot( int slot ) const { return m_entry[slot]; }
+
+	// Returns the slot holding an entry with this hash for which 'matches'
+	// returns true, or -1 if there isn't one.
+	template <typename Matcher>
+	int Find( uint32_t hash, const Matcher& matches ) const
+	{
+		hash = ValidHash(hash);
+		int mask = m_capacity-1;
+		int slot = IdealSlot(hash);
+		for ( int distance = 0; ; distance++ )
+		{
+			uint32_t slotHash = m_hash[slot];
+			// With Robin Hood hashing, once we find an entry which is closer
+			// to its ideal slot than we would be, our key can't be any
+			// further along.
+			if ( slotHash == 0 || ProbeDistance(slot) < distance )
+				return -1;
+			if ( slotHash == hash && matches( m_entry[slot] ) )
+				return slot;
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	// Adds an entry, and returns the slot it ended up in.  Doesn't check
+	// whether a matching entry already exists.
+	int Insert( uint32_t hash, Entry entry )
+	{
+		if ( (m_count+1) * 5 > m_capacity * 4 )
+			Grow();
+
+		hash = ValidHash(hash);
+		int mask = m_capacity-1;
+		int slot = IdealSlot(hash);
+		int result = -1;
+		for ( int distance = 0; ; distance++ )
+		{
+			if ( m_hash[slot] == 0 )
+			{
+				m_hash[slot] = hash;
+				m_entry[slot] = std::move(entry);
+				m_count++;
+				return ( result >= 0 ) ? result : slot;
+			}
+
+			// Steal the slot from any entry which is closer to its ideal
+			// slot than we are to ours, and carry on inserting that entry
+			// instead.
+			int slotDistance = ProbeDistance(slot);
+			if ( slotDistance < distance )
+			{
+				std::swap( hash, m_hash[slot] );
+				std::swap( entry, m_entry[slot] );
+				if ( result < 0 )
+					result = slot;
+				distance = slotDistance;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	void Erase( int slot )
+	{
+		// Backward-shift deletion;  pull each following entry back by one
+		// slot until we hit an empty slot or one which is already ideally
+		// placed.  This keeps probe sequences short without tombstones.
+		int mask = m_capacity-1;
+		int next = (slot + 1) & mask;
+		while ( m_hash[next] != 0 && ProbeDistance(next) > 0 )
+		{
+			m_hash[slot] = m_hash[next];
+			m_entry[slot] = std::move( m_entry[next] );
+			slot = next;
+			next = (next + 1) & mask;
+		}
+		m_hash[slot] = 0;
+		m_entry[slot] = Entry();
+		m_count--;
+	}
+};
+
+#endif // VS_OPENHASHTABLE_H
+
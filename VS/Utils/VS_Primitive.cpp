@@ -163,7 +163,7 @@ vsFragment *	vsMakeTexturedBox2D( const vsBox2D &box, vsMaterial *material, cons
 		0,2,1,3
 	};
 
-	vsDisplayList *list = new vsDisplayList(128);
+	vsDisplayList *list = new vsDisplayList(256);
 
 	if ( colorOverride )
 	{
@@ -202,7 +202,7 @@ vsFragment *	vsMakeTiledTexturedBox2D( const vsBox2D &box, vsMaterial *material,
 		0,2,1,3
 	};
 
-	vsDisplayList *list = new vsDisplayList(128);
+	vsDisplayList *list = new vsDisplayList(256);
 
 	if ( colorOverride )
 	{
@@ -769,7 +769,7 @@ vsFragment *	vsMakeTiledTexturedBox2D( const vsBox2D &box, const vsString &mater
 		0,2,1,3
 	};
 
-	vsDisplayList *list = new vsDisplayList(128);
+	vsDisplayList *list = new vsDisplayList(256);
 
 	if ( colorOverride )
 	{
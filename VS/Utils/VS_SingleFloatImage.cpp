@@ -14,6 +14,7 @@
 #include "VS_TextureManager.h"
 #include "VS_TextureInternal.h"
 #include "VS_RenderTarget.h"
+#include "VS_RenderThread.h"
 
 #include "VS_File.h"
 #include "VS_Store.h"
@@ -114,6 +115,8 @@ vsSingleFloatImage::~vsSingleFloatImage()
 void
 vsSingleFloatImage::Read( vsTexture *texture )
 {
+	vsRenderThread::Sync();
+
 	// GL_CHECK_SCOPED("vsSingleFloatImage");
 
 	if ( m_width != (unsigned int)texture->GetResource()->GetWidth() ||
@@ -171,6 +174,8 @@ vsSingleFloatImage::PrepForAsyncRead( vsTexture *texture )
 void
 vsSingleFloatImage::AsyncRead( vsTexture *texture )
 {
+	vsRenderThread::Sync();
+
 	PrepForAsyncRead( texture );
 	if ( m_sync != 0 )
 		glDeleteSync( m_sync );
@@ -193,6 +198,8 @@ vsSingleFloatImage::AsyncRead( vsTexture *texture )
 void
 vsSingleFloatImage::AsyncReadRenderTarget(vsRenderTarget *target, int buffer)
 {
+	vsRenderThread::Sync();
+
 	PrepForAsyncRead( target->GetTexture(0) );
 	if ( m_sync != 0 )
 		glDeleteSync( m_sync );
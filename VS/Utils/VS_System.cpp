@@ -17,8 +17,11 @@
 #include "VS_Random.h"
 #include "VS_Screen.h"
 #include "VS_DynamicBatchManager.h"
+#include "VS_FrameArena.h"
+#include "VS_JobSystem.h"
 #include "VS_SingletonManager.h"
 #include "VS_TextureManager.h"
+#include "VS_TextureStreamer.h"
 #include "VS_FileCache.h"
 #include "VS_File.h"
 #include "VS_ShaderCache.h"
@@ -274,6 +277,7 @@ vsSystem::vsSystem(const vsString& companyName, const vsString& title, int argc,
 	m_exitApplicationKeyEnabled( true ),
 	m_minBuffers(minBuffers),
 	m_orientation( Orientation_Normal ),
+	m_jobSystem( nullptr ),
 	m_title( title ),
 	m_screen( nullptr ),
 #ifdef _WIN32
@@ -293,6 +297,7 @@ vsSystem::vsSystem(const vsString& companyName, const vsString& title, int argc,
 	// Perform some basic initialisation
 	vsRandom::Init();
 	vsTask_Init();
+	m_jobSystem = new vsJobSystem;
 
 	vsLog("VectorStorm engine version %s",VS_VERSION);
 
@@ -351,6 +356,10 @@ vsSystem::~vsSystem()
 	vsShaderUniformRegistry::Shutdown();
 	vsShaderCache::Shutdown();
 	vsFileCache::Shutdown();
+	vsDelete( m_jobSystem );
+
+	// everybody who might log has stopped;  write out whatever's still queued.
+	vsLog_End();
 
 #if !TARGET_OS_IPHONE
 	SDL_Quit();
@@ -439,14 +448,18 @@ vsSystem::InitGameData()
 {
 	m_materialManager = new vsMaterialManager;
 	m_dynamicBatchManager = new vsDynamicBatchManager;
+	m_frameArena = new vsFrameArena;
+	m_textureStreamer = new vsTextureStreamer;
 }
 
 void
 vsSystem::DeinitGameData()
 {
+	vsDelete( m_textureStreamer );	// releases any textures still loading
 	vsDelete( m_materialManager );
 	m_textureManager->CollectGarbage();
 	vsDelete( m_dynamicBatchManager );
+	vsDelete( m_frameArena );
 }
 
 void
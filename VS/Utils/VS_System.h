@@ -14,12 +14,15 @@
 #include "Utils/VS_Array.h"
 
 class vsDynamicBatchManager;
+class vsFrameArena;
+class vsJobSystem;
 class vsMaterialManager;
 class vsPreferences;
 class vsPreferenceObject;
 class vsSystemPreferences;
 class vsScreen;
 class vsTextureManager;
+class vsTextureStreamer;
 struct SDL_Cursor;
 
 enum Weekday
@@ -84,6 +87,9 @@ class vsSystem
 	vsTextureManager *	m_textureManager;
 	vsMaterialManager *	m_materialManager;
 	vsDynamicBatchManager *m_dynamicBatchManager;
+	vsFrameArena *		m_frameArena;
+	vsTextureStreamer *	m_textureStreamer;
+	vsJobSystem *		m_jobSystem;
 
 	vsString			m_title;
 	vsScreen *			m_screen;
@@ -274,6 +274,21 @@ vsTimerSystem::EndGPUTime()
 	uint64_t now = GetMicroseconds();
 	m_gpuTime = (now - m_startGpu);
 
+	EnforceFPSMaximum( now );
+}
+
+void
+vsTimerSystem::EndPipelinedFrame( uint64_t drawTime, uint64_t gpuTime )
+{
+	m_drawTime = drawTime;
+	m_gpuTime = gpuTime;
+
+	EnforceFPSMaximum( GetMicroseconds() );
+}
+
+void
+vsTimerSystem::EnforceFPSMaximum( uint64_t now )
+{
 #if ENFORCE_FPS_MAXIMUM
 	{
 		int maxFPS = vsRenderer::Instance()->GetRefreshRate();
@@ -64,6 +64,8 @@ class vsTimerSystem : public coreGameSystem
 
 	bool m_firstFrame;
 
+	void EnforceFPSMaximum( uint64_t now );
+
 public:
 
 	vsTimerSystem();
@@ -86,6 +88,11 @@ public:
 	virtual void EndDrawTime(); // we've finished processing our display lists
 	virtual void EndGPUTime(); // OpenGL has returned control to our app
 
+	// When rendering is pipelined, we don't draw or swap ourselves;  instead,
+	// this is called once each frame has been handed to the render thread,
+	// with its timings for the last frame it finished.
+	void EndPipelinedFrame( uint64_t drawTime, uint64_t gpuTime );
+
 	uint64_t GetCurrentMillis() { return m_startCpu / 1000; }
 	unsigned int GetMissedFrameCount() { return m_missedFrames / 1000; }
 